@@ -52,6 +52,16 @@ void Action::clearCategoryModel()
     RemoteInterface::instance().m_categoryItems->setImages({});
 }
 
+void Action::requestCategories(int size)
+{
+    RemoteInterface::instance().requestCategories(m_searchInfo, size);
+}
+
+void Action::searchImages(int pageSize)
+{
+    RemoteInterface::instance().searchImages(m_searchInfo, pageSize);
+}
+
 
 
 
@@ -63,7 +73,7 @@ ShowOverviewAction::ShowOverviewAction(const SearchInfo& searchInfo)
 void ShowOverviewAction::execute()
 {
     int size = ScreenInfo::instance().overviewIconSize();
-    sendCommand(SearchRequest(SearchType::Categories, m_searchInfo, size));
+    requestCategories(size);
     setCurrentPage(Page::OverviewPage);
 }
 
@@ -101,7 +111,7 @@ ShowThumbnailsAction::ShowThumbnailsAction(const SearchInfo& searchInfo)
 
 void ShowThumbnailsAction::execute()
 {
-    sendCommand(SearchRequest(SearchType::Images, m_searchInfo));
+    searchImages(THUMBNAIL_PAGE_SIZE);
     RemoteInterface::instance().setActiveThumbnailModel(RemoteInterface::ModelType::Thumbnail);
     setCurrentPage(Page::ThumbnailsPage);
 
@@ -139,8 +149,9 @@ void DiscoverAction::execute()
 {
     RemoteInterface::instance().setActiveThumbnailModel(RemoteInterface::ModelType::Discovery);
 
+    // Discovery picks random images from the complete result.
     if (m_currentSelection.isEmpty())
-        sendCommand(SearchRequest(SearchType::Images, m_searchInfo));
+        searchImages(0);
     else
         m_model->setCurrentSelection(m_currentSelection, m_allImages);
 
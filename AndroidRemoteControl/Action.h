@@ -38,6 +38,8 @@ protected:
     void setCurrentPage(Page page);
     void sendCommand(const RemoteCommand& command);
     void clearCategoryModel();
+    void requestCategories(int size);
+    void searchImages(int pageSize);
     SearchInfo m_searchInfo;
 };
 
@@ -21,7 +21,7 @@
 using namespace RemoteControl;
 
 CategoryModel::CategoryModel(QObject *parent) :
-    QAbstractListModel(parent)
+    QAbstractListModel(parent), m_cache(20)
 {
 }
 
@@ -58,6 +58,40 @@ void CategoryModel::setCategories(const QList<Category>& categories)
     m_categories = categories;
     endResetModel();
     emit hasDataChanged();
+    ScreenInfo::instance().setCategoryCount(categories.count());
+}
+
+int CategoryModel::requestCategories(const QByteArray& key)
+{
+    m_pendingKeys.enqueue(key);
+    const CachedCategories* cached = m_cache.object(key);
+    if (!cached)
+        return -1;
+
+    setCategories(cached->categories);
+    return cached->generation;
+}
+
+void CategoryModel::setCategories(const CategoryListResult& result)
+{
+    // The server answers the requests in order.
+    if (m_pendingKeys.isEmpty())
+        return;
+    const QByteArray key = m_pendingKeys.dequeue();
+
+    // Unchanged categories are shown already, see requestCategories.
+    if (result.unchanged)
+        return;
+
+    m_cache.insert(key, new CachedCategories{result.categories, result.generation});
+    if (m_pendingKeys.isEmpty())
+        setCategories(result.categories);
+}
+
+void CategoryModel::clearCache()
+{
+    m_cache.clear();
+    m_pendingKeys.clear();
 }
 
 bool CategoryModel::hasData() const
@@ -20,7 +20,9 @@
 #define CATEGORYMODEL_H
 
 #include <QAbstractListModel>
+#include <QCache>
 #include <QList>
+#include <QQueue>
 
 #include "RemoteCommand.h"
 
@@ -42,11 +44,28 @@ public:
     void setCategories(const QList<Category>&);
     bool hasData() const;
 
+    /**
+     * @brief requestCategories is called when the categories for the given key are requested from the server.
+     * The categories of recent requests are cached, so going back to an overview page shows it at once,
+     * and the server only sends them again if the database has changed in the meantime.
+     * @return the generation of the cached categories, or -1 if there are none
+     */
+    int requestCategories(const QByteArray& key);
+    void setCategories(const CategoryListResult& result);
+    void clearCache();
+
 signals:
     void hasDataChanged();
 
 private:
+    struct CachedCategories {
+        QList<Category> categories;
+        int generation;
+    };
+
     QList<Category> m_categories;
+    QCache<QByteArray, CachedCategories> m_cache;
+    QQueue<QByteArray> m_pendingKeys;
 };
 
 }
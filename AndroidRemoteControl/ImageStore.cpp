@@ -20,9 +20,10 @@
 #include "RemoteInterface.h"
 #include "Settings.h"
 
-#include <QTimer>
 #include "RemoteImage.h"
+#include "ScreenInfo.h"
 #include <QMutexLocker>
+#include <algorithm>
 
 
 namespace RemoteControl {
@@ -45,25 +46,47 @@ void ImageStore::requestImage(RemoteImage* client, ImageId imageId, const QSize&
     QMutexLocker locker(&m_mutex);
 
     // This code is executed from paint, which is on the QML thread, we therefore need to get it on the GUI thread
-    // where out TCPSocket is located.
-    QTimer* timer = new QTimer;
-    timer->setSingleShot(true);
-
-    // There seems to be a path through QML where the client is deleted right after this request is send,
-    // therefore, have client as the third parameter to the connect below, as that will prevent the request in that setup.
-    connect(timer, &QTimer::timeout, client, [imageId,size,type,timer,client, this] () {
-        ThumbnailRequest request(imageId, size, type);
-
-        RemoteInterface::instance().sendCommand(request);
+    // where out TCPSocket is located. All requests made until then are sent together in ThumbnailBatchRequests.
+    m_pendingRequests.append({client, imageId, size, type});
+    if (m_pendingRequests.count() == 1)
+        QMetaObject::invokeMethod(this, "sendPendingRequests", Qt::QueuedConnection);
+}
 
-        RequestType key = qMakePair(imageId,type);
-        m_requestMap.insert(key, client);
-        m_reverseRequestMap.insert(client, key);
+void ImageStore::sendPendingRequests()
+{
+    struct Batch {
+        QList<ImageId> imageIds;
+        QSize size;
+        ViewType type;
+    };
+    QList<Batch> batches;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const PendingRequest& pending : m_pendingRequests) {
+            // There seems to be a path through QML where the client is deleted right after this request is send,
+            // therefore, check that the client is still alive.
+            if (!pending.client)
+                continue;
+
+            RequestType key = qMakePair(pending.imageId,pending.type);
+            m_requestMap.insert(key, pending.client);
+            m_reverseRequestMap.insert(pending.client, key);
+            connect(pending.client, &QObject::destroyed, this, &ImageStore::clientDeleted, Qt::UniqueConnection);
+
+            auto batch = std::find_if(batches.begin(), batches.end(), [&pending] (const Batch& batch) {
+                return batch.type == pending.type && batch.size == pending.size;
+            });
+            if (batch == batches.end())
+                batches.append({{pending.imageId}, pending.size, pending.type});
+            else
+                batch->imageIds.append(pending.imageId);
+        }
+        m_pendingRequests.clear();
+    }
 
-        connect(client, &QObject::destroyed, this, &ImageStore::clientDeleted);
-        timer->deleteLater();
-    });
-    timer->start(0);
+    for (const Batch& batch : batches)
+        RemoteInterface::instance().sendCommand(
+                    ThumbnailBatchRequest(batch.imageIds, batch.size, batch.type, ScreenInfo::instance().jpegQuality(batch.type)));
 }
 
 void ImageStore::updateImage(ImageId imageId, const QImage& image, const QString& label, ViewType type)
@@ -83,9 +106,11 @@ void ImageStore::updateImage(ImageId imageId, const QImage& image, const QString
 
 void RemoteControl::ImageStore::reset()
 {
+    QMutexLocker locker(&m_mutex);
     QList<RemoteImage*> keys = m_reverseRequestMap.keys();
     m_reverseRequestMap.clear();
     m_requestMap.clear();
+    m_pendingRequests.clear();
 }
 
 void ImageStore::clientDeleted()
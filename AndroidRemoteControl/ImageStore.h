@@ -24,6 +24,7 @@
 #include <QMap>
 #include "Types.h"
 #include <QMutex>
+#include <QPointer>
 
 namespace RemoteControl {
 class RemoteImage;
@@ -40,6 +41,7 @@ public:
 private slots:
     void reset();
     void clientDeleted();
+    void sendPendingRequests();
 
 private:
     explicit ImageStore();
@@ -47,6 +49,14 @@ private:
     using RequestType = QPair<ImageId,ViewType>;
     QMap<RequestType,RemoteImage*> m_requestMap;
     QMap<RemoteImage*,RequestType> m_reverseRequestMap;
+
+    struct PendingRequest {
+        QPointer<RemoteImage> client;
+        ImageId imageId;
+        QSize size;
+        ViewType type;
+    };
+    QList<PendingRequest> m_pendingRequests;
     QMutex m_mutex;
 };
 
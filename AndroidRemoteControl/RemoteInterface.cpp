@@ -77,6 +77,11 @@ void RemoteInterface::requestHomePageImages()
 void RemoteInterface::gotDisconnected()
 {
     setCurrentPage(Page::UnconnectedPage);
+
+    // The server may have been restarted when we connect again, so its generations and search ids start over.
+    m_categories->clearCache();
+    m_completeSearchId = -1;
+    m_completeSearchResult.clear();
 }
 
 void RemoteInterface::setHomePageImages(const StaticImageResult& command)
@@ -248,10 +253,14 @@ void RemoteInterface::handleCommand(const RemoteCommand& command)
 {
     if (command.commandType() == CommandType::ThumbnailResult)
         updateImage(static_cast<const ThumbnailResult&>(command));
+    else if (command.commandType() == CommandType::ThumbnailBatchResult)
+        updateImages(static_cast<const ThumbnailBatchResult&>(command));
     else if (command.commandType() == CommandType::CategoryListResult)
         updateCategoryList(static_cast<const CategoryListResult&>(command));
     else if (command.commandType() == CommandType::SearchResult)
         gotSearchResult(static_cast<const SearchResult&>(command));
+    else if (command.commandType() == CommandType::ImageSearchResult)
+        gotImageSearchResult(static_cast<const ImageSearchResult&>(command));
     else if (command.commandType() == CommandType::TimeCommand)
         ; // Used for debugging, it will print time stamp when decoded
     else if (command.commandType() == CommandType::ImageDetailsResult) {
@@ -271,10 +280,56 @@ void RemoteInterface::updateImage(const ThumbnailResult& command)
     ImageStore::instance().updateImage(command.imageId, command.image, command.label, command.type);
 }
 
+void RemoteInterface::updateImages(const ThumbnailBatchResult& command)
+{
+    for (const EncodedThumbnail& thumbnail : command.thumbnails)
+        ImageStore::instance().updateImage(thumbnail.imageId, QImage::fromData(thumbnail.data, "JPEG"), thumbnail.label, command.type);
+}
+
 void RemoteInterface::updateCategoryList(const CategoryListResult& command)
 {
-    ScreenInfo::instance().setCategoryCount(command.categories.count());
-    m_categories->setCategories(command.categories);
+    m_categories->setCategories(command);
+}
+
+void RemoteInterface::requestCategories(const SearchInfo& searchInfo, int size)
+{
+    const int generation = m_categories->requestCategories(searchInfo.key() + QByteArray::number(size));
+    sendCommand(SearchRequest(SearchType::Categories, searchInfo, size, generation));
+}
+
+void RemoteInterface::searchImages(const SearchInfo& searchInfo, int pageSize)
+{
+    ++m_searchId;
+    sendCommand(ImageSearchRequest(m_searchId, searchInfo, pageSize, m_completeSearchId));
+}
+
+void RemoteInterface::gotImageSearchResult(const ImageSearchResult& result)
+{
+    // Results of searches that were superseded by a newer one are of no interest.
+    if (result.searchId != m_searchId)
+        return;
+
+    QList<int> images = result.imageIds;
+    if (!result.baseMask.isEmpty()) {
+        for (int i = 0; i < m_completeSearchResult.count() && i/8 < result.baseMask.size(); ++i) {
+            if (result.baseMask[i/8] & (1 << (i%8)))
+                images.append(m_completeSearchResult[i]);
+        }
+    }
+
+    if (result.offset == 0 && images.count() == result.total)
+        m_activeThumbnailModel->setImages(images);
+    else if (result.offset == 0)
+        m_activeThumbnailModel->setFirstPage(result.searchId, images, result.total);
+    else {
+        m_activeThumbnailModel->addPage(result.searchId, result.offset, images);
+        images = m_activeThumbnailModel->images();
+    }
+
+    if (images.count() == result.total) {
+        m_completeSearchId = result.searchId;
+        m_completeSearchResult = images;
+    }
 }
 
 void RemoteInterface::gotSearchResult(const SearchResult& result)
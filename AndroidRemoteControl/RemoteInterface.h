@@ -110,8 +110,10 @@ private slots:
     void requestInitialData();
     void handleCommand(const RemoteCommand&);
     void updateImage(const ThumbnailResult&);
+    void updateImages(const ThumbnailBatchResult&);
     void updateCategoryList(const CategoryListResult&);
     void gotSearchResult(const SearchResult&);
+    void gotImageSearchResult(const ImageSearchResult&);
     void requestHomePageImages();
     void gotDisconnected();
 private:
@@ -120,6 +122,8 @@ private:
     void setCurrentPage(Page page);
     void setListCategoryValues(const QStringList& values);
     void setHomePageImages(const StaticImageResult& command);
+    void requestCategories(const SearchInfo& searchInfo, int size);
+    void searchImages(const SearchInfo& searchInfo, int pageSize);
 
     Client* m_connection = nullptr;
     CategoryModel* m_categories;
@@ -134,6 +138,10 @@ private:
     QImage m_discoveryImage;
     DiscoveryModel* m_discoveryModel;
     ThumbnailModel* m_activeThumbnailModel = nullptr;
+
+    int m_searchId = 0; // the last image search
+    int m_completeSearchId = -1; // the last image search we have the complete result for
+    QList<int> m_completeSearchResult;
 };
 
 }
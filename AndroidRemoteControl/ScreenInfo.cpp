@@ -123,4 +123,13 @@ int ScreenInfo::overviewSpacing() const
     return overviewIconSize()/2;
 }
 
+int ScreenInfo::jpegQuality(ViewType type) const
+{
+    if (type == ViewType::Images)
+        return 90;
+
+    // Compression artifacts are hard to see on a dense screen, so spend fewer bytes on each thumbnail there.
+    return m_dotsPerMM >= 12 ? 70 : 80;
+}
+
 } // namespace RemoteControl
@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include <QSize>
+#include "Types.h"
 class QScreen;
 
 namespace RemoteControl {
@@ -46,6 +47,7 @@ public:
 
     int overviewIconSize() const;
     int overviewSpacing() const;
+    int jpegQuality(ViewType type) const;
 
 signals:
     void overviewIconSizeChanged();    
@@ -17,6 +17,7 @@
 */
 
 #include "ImageStore.h"
+#include "RemoteInterface.h"
 #include "ThumbnailModel.h"
 
 namespace RemoteControl {
@@ -44,15 +45,58 @@ RoleMap ThumbnailModel::roleNames() const
 }
 
 void ThumbnailModel::setImages(const QList<int>& images)
+{
+    setFirstPage(-1, images, images.count());
+}
+
+void ThumbnailModel::setFirstPage(int searchId, const QList<int>& images, int total)
 {
     beginResetModel();
     m_images = images;
+    m_searchId = searchId;
+    m_total = total;
+    m_fetching = false;
     endResetModel();
 }
 
+void ThumbnailModel::addPage(int searchId, int offset, const QList<int>& images)
+{
+    if (searchId != m_searchId || offset != m_images.count() || images.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), m_images.count(), m_images.count() + images.count() - 1);
+    m_images.append(images);
+    endInsertRows();
+    m_fetching = false;
+}
+
+bool ThumbnailModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && m_images.count() < m_total;
+}
+
+void ThumbnailModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid() || m_fetching || m_images.count() >= m_total)
+        return;
+
+    m_fetching = true;
+    RemoteInterface::instance().sendCommand(ImageSearchPageRequest(m_searchId, m_images.count(), THUMBNAIL_PAGE_SIZE));
+}
+
 int ThumbnailModel::indexOf(int imageId)
 {
     return m_images.indexOf(imageId);
 }
 
+QList<int> ThumbnailModel::images() const
+{
+    return m_images;
+}
+
+int ThumbnailModel::total() const
+{
+    return m_total;
+}
+
 } // namespace RemoteControl
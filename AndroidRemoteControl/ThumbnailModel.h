@@ -23,6 +23,9 @@
 
 namespace RemoteControl {
 
+// The number of images requested at a time while scrolling through a search result.
+const int THUMBNAIL_PAGE_SIZE = 300;
+
 using RoleMap = QHash<int, QByteArray>;
 class ThumbnailModel : public QAbstractListModel
 {
@@ -35,9 +38,22 @@ public:
     RoleMap roleNames() const override;
     virtual void setImages(const QList<int>&image);
     int indexOf(int imageId);
+    QList<int> images() const;
+    int total() const;
+
+    /**
+     * Show the first page of a search result, the following pages are requested when the view scrolls to them.
+     */
+    void setFirstPage(int searchId, const QList<int>& images, int total);
+    void addPage(int searchId, int offset, const QList<int>& images);
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
 protected:
     QList<int> m_images;
+    int m_searchId = -1;
+    int m_total = 0;
+    bool m_fetching = false;
 };
 
 } // namespace RemoteControl
@@ -0,0 +1,134 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "ExtractVideoFramesJob.h"
+#include <KLocale>
+#include <ImageManager/VideoFrameExtractor.h>
+#include <ImageManager/VideoFrameCache.h>
+#include <ImageManager/ExtractOneVideoFrame.h>
+#include <ImageManager/ThumbnailCache.h>
+#include <MainWindow/DirtyIndicator.h>
+#include <DB/ImageDB.h>
+
+namespace BackgroundJobs {
+
+ExtractVideoFramesJob::ExtractVideoFramesJob(const DB::FileName& fileName, BackgroundTaskManager::Priority priority)
+    : JobInterface(priority), m_fileName(fileName), m_wasCanceled(false), m_extractor(nullptr)
+{
+}
+
+void ExtractVideoFramesJob::execute()
+{
+    if ( m_wasCanceled || ImageManager::VideoFrameCache::instance()->contains(m_fileName) ) {
+        emit completed();
+        return;
+    }
+
+    m_extractor = new ImageManager::VideoFrameExtractor(this);
+    connect(m_extractor, SIGNAL(frameExtracted(int,QImage)), this, SLOT(frameExtracted(int,QImage)));
+    connect(m_extractor, SIGNAL(finished(int)), this, SLOT(extractionFinished(int)));
+    connect(m_extractor, SIGNAL(failed()), this, SLOT(extractionFailed()));
+    // The cache does not store anything bigger, so there is no point in keeping the full frames around.
+    m_extractor->extract(m_fileName, m_fileName.info()->videoLength(), ImageManager::ThumbnailCache::thumbnailBuildSize());
+}
+
+QString ExtractVideoFramesJob::title() const
+{
+    return i18n("Extracting Thumbnails");
+}
+
+QString ExtractVideoFramesJob::details() const
+{
+    return m_fileName.relative();
+}
+
+QString ExtractVideoFramesJob::resourcePath() const
+{
+    return m_fileName.absolute();
+}
+
+void ExtractVideoFramesJob::cancel()
+{
+    if ( m_wasCanceled )
+        return;
+    m_wasCanceled = true;
+
+    // If the job is still waiting to be run, execute() takes care of it.
+    if ( !m_extractor )
+        return;
+
+    // Kill mplayer right away, rather than letting it run for a video nobody looks at anymore.
+    m_extractor->cancel();
+    m_extractor->deleteLater();
+    m_extractor = nullptr;
+    m_frames.clear();
+    emit completed();
+}
+
+void ExtractVideoFramesJob::frameExtracted(int index, const QImage& frame)
+{
+    if ( frame.isNull() )
+        return;
+
+    // The frames are converted in parallel, so they may arrive out of order.
+    if ( m_frames.size() <= index )
+        m_frames.resize(index + 1);
+    m_frames[index] = frame;
+    emit frameReady(index, frame);
+}
+
+void ExtractVideoFramesJob::extractionFinished(int length)
+{
+    m_extractor->deleteLater();
+    m_extractor = nullptr;
+
+    DB::ImageInfoPtr info = m_fileName.info();
+    // Only mark dirty if it is required
+    if ( length > 0 && info->videoLength() != length ) {
+        info->setVideoLength(length);
+        MainWindow::DirtyIndicator::markDirty();
+    }
+
+    // Short videos run out of frames before all steps are done, so repeat the last frame.
+    // If mplayer ran, but we got no frames at all, an empty entry avoids that we retry at the next start up.
+    if ( m_frames.count() < ImageManager::VideoFrameExtractor::NumberOfFrames ) {
+        ImageManager::ExtractOneVideoFrame::markShortVideo(m_fileName);
+        if ( !m_frames.isEmpty() ) {
+            const QImage lastFrame = m_frames.last();
+            for ( int index = m_frames.count(); index < ImageManager::VideoFrameExtractor::NumberOfFrames; ++index ) {
+                m_frames.append(lastFrame);
+                emit frameReady(index, lastFrame);
+            }
+        }
+    }
+    ImageManager::VideoFrameCache::instance()->insert(m_fileName, m_frames);
+    m_frames.clear();
+    emit completed();
+}
+
+void ExtractVideoFramesJob::extractionFailed()
+{
+    // mplayer is missing or broken; don't cache anything, so the frames are extracted once it works.
+    m_extractor->deleteLater();
+    m_extractor = nullptr;
+    m_frames.clear();
+    emit completed();
+}
+
+} // namespace BackgroundJobs
+// vi:expandtab:tabstop=4 shiftwidth=4:
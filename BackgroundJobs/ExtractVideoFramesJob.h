@@ -0,0 +1,77 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef BACKGROUNDJOBS_EXTRACTVIDEOFRAMESJOB_H
+#define BACKGROUNDJOBS_EXTRACTVIDEOFRAMESJOB_H
+
+#include <BackgroundTaskManager/JobInterface.h>
+#include <DB/FileName.h>
+#include <QImage>
+#include <QVector>
+
+namespace ImageManager { class VideoFrameExtractor; }
+
+namespace BackgroundJobs {
+
+/**
+  \brief \ref BackgroundTaskManager::JobInterface "background job" for extracting the frames used for thumbnail cycling.
+
+  All ten frames, as well as the length of the video, are extracted with a single
+  \ref ImageManager::VideoFrameExtractor run. Once all frames are in, they are stored in the
+  \ref ImageManager::VideoFrameCache in one go.
+  \see \ref videothumbnails
+*/
+class ExtractVideoFramesJob : public BackgroundTaskManager::JobInterface
+{
+    Q_OBJECT
+
+public:
+    ExtractVideoFramesJob(const DB::FileName& fileName, BackgroundTaskManager::Priority priority);
+    void execute() override;
+    QString title() const override;
+    QString details() const override;
+    QString resourcePath() const override;
+    /**
+     * @brief cancel stops the extraction, if it is running already.
+     * Neither frames nor the length are stored then, and frameReady is not emitted anymore.
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief frameReady is emitted for each frame as soon as it is extracted,
+     * so the frames can be shown before the extraction is completed.
+     */
+    void frameReady(int index, const QImage& frame);
+
+private slots:
+    void frameExtracted(int index, const QImage& frame);
+    void extractionFinished(int length);
+    void extractionFailed();
+
+private:
+    DB::FileName m_fileName;
+    bool m_wasCanceled;
+    ImageManager::VideoFrameExtractor* m_extractor;
+    QVector<QImage> m_frames;
+};
+
+} // namespace BackgroundJobs
+
+#endif // BACKGROUNDJOBS_EXTRACTVIDEOFRAMESJOB_H
+// vi:expandtab:tabstop=4 shiftwidth=4:
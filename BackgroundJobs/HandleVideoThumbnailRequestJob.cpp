@@ -49,6 +49,11 @@ QString HandleVideoThumbnailRequestJob::details() const
     return m_request->databaseFileName().relative();
 }
 
+QString HandleVideoThumbnailRequestJob::resourcePath() const
+{
+    return m_request->fileSystemFileName().absolute();
+}
+
 void HandleVideoThumbnailRequestJob::execute()
 {
     QImage image( pathForRequest(m_request->fileSystemFileName()).absolute());
@@ -36,6 +36,7 @@ public:
     explicit HandleVideoThumbnailRequestJob(ImageManager::ImageRequest* request, BackgroundTaskManager::Priority priority);
     QString title() const override;
     QString details() const override;
+    QString resourcePath() const override;
     static void saveFullScaleFrame( const DB::FileName& fileName, const QImage& image );
     static DB::FileName pathForRequest( const DB::FileName& fileName  );
     static DB::FileName frameName(const DB::FileName& videoName, int frameNumber );
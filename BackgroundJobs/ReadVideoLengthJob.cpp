@@ -46,6 +46,11 @@ QString BackgroundJobs::ReadVideoLengthJob::details() const
     return m_fileName.relative();
 }
 
+QString BackgroundJobs::ReadVideoLengthJob::resourcePath() const
+{
+    return m_fileName.absolute();
+}
+
 void BackgroundJobs::ReadVideoLengthJob::lengthFound(int length)
 {
     DB::ImageInfoPtr info = DB::ImageDB::instance()->info(m_fileName);
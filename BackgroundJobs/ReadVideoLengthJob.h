@@ -38,6 +38,7 @@ public:
     void execute() override;
     QString title() const override;
     QString details() const override;
+    QString resourcePath() const override;
 
 private slots:
     void lengthFound(int);
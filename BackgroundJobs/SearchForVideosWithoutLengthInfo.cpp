@@ -32,27 +32,34 @@
 BackgroundJobs::SearchForVideosWithoutLengthInfo::SearchForVideosWithoutLengthInfo()
     :BackgroundTaskManager::JobInterface(BackgroundTaskManager::BackgroundVideoInfoRequest)
 {
+    // The database must only be accessed from the main thread, so look it up here, and leave
+    // the slow part, checking the videos on disk, to execute().
+    const DB::FileNameList images = DB::ImageDB::instance()->images();
+    for ( const DB::FileName& image :  images ) {
+        const DB::ImageInfoPtr info = image.info();
+        if ( info->isVideo() && info->videoLength() == -1 )
+            m_videos.append( info->fileName() );
+    }
 }
 
 void BackgroundJobs::SearchForVideosWithoutLengthInfo::execute()
 {
-    const DB::FileNameList images = DB::ImageDB::instance()->images();
-    for ( const DB::FileName& image :  images ) {
-        const DB::ImageInfoPtr info = image.info();
-        if ( !info->isVideo() )
-            continue;
+    for ( const DB::FileName& video : m_videos ) {
         // silently ignore videos not (currently) on disk:
-        if ( ! info->fileName().exists() )
+        if ( ! video.exists() )
             continue;
-        int length = info->videoLength();
-        if ( length == -1 ) {
-            BackgroundTaskManager::JobManager::instance()->addJob(
-                        new BackgroundJobs::ReadVideoLengthJob(info->fileName(), BackgroundTaskManager::BackgroundVideoPreviewRequest));
-        }
+        BackgroundTaskManager::JobManager::instance()->addJob(
+                    new BackgroundJobs::ReadVideoLengthJob(video, BackgroundTaskManager::BackgroundVideoPreviewRequest));
     }
     emit completed();
 }
 
+bool BackgroundJobs::SearchForVideosWithoutLengthInfo::isThreadSafe() const
+{
+    // Works on the list of videos taken from the database when the job was created.
+    return true;
+}
+
 QString BackgroundJobs::SearchForVideosWithoutLengthInfo::title() const
 {
     return i18n("Search for videos without length information");
@@ -20,6 +20,7 @@
 #define SEARCHFORVIDEOSWITHOUTLENGTHINFO_H
 
 #include <BackgroundTaskManager/JobInterface.h>
+#include <DB/FileNameList.h>
 
 namespace BackgroundJobs {
 
@@ -34,6 +35,10 @@ public:
     void execute() override;
     QString title() const override;
     QString details() const override;
+    bool isThreadSafe() const override;
+
+private:
+    DB::FileNameList m_videos;
 };
 
 }
@@ -17,15 +17,14 @@
 */
 
 #include "SearchForVideosWithoutVideoThumbnailsJob.h"
-#include <BackgroundJobs/HandleVideoThumbnailRequestJob.h>
+#include <ImageManager/VideoFrameCache.h>
 #include <DB/ImageDB.h>
 #include <DB/ImageInfo.h>
 #include <QFile>
 #include <BackgroundTaskManager/JobManager.h>
 #include <klocale.h>
 #include <BackgroundTaskManager/JobInfo.h>
-#include "ExtractOneThumbnailJob.h"
-#include "ReadVideoLengthJob.h"
+#include "ExtractVideoFramesJob.h"
 
 using namespace BackgroundJobs;
 
@@ -42,18 +41,11 @@ void BackgroundJobs::SearchForVideosWithoutVideoThumbnailsJob::execute()
         if ( ! info->fileName().exists() )
             continue;
 
-        const DB::FileName thumbnailName = BackgroundJobs::HandleVideoThumbnailRequestJob::frameName(info->fileName(),9);
-        if ( thumbnailName.exists() )
+        if ( ImageManager::VideoFrameCache::instance()->contains(info->fileName()) )
             continue;
 
-        BackgroundJobs::ReadVideoLengthJob* readVideoLengthJob = new BackgroundJobs::ReadVideoLengthJob(info->fileName(), BackgroundTaskManager::BackgroundVideoPreviewRequest);
-
-        for (int i=0; i<10;++i) {
-            ExtractOneThumbnailJob* extractJob = new ExtractOneThumbnailJob( info->fileName(), i, BackgroundTaskManager::BackgroundVideoPreviewRequest );
-            extractJob->addDependency(readVideoLengthJob);
-        }
-
-        BackgroundTaskManager::JobManager::instance()->addJob( readVideoLengthJob);
+        BackgroundTaskManager::JobManager::instance()->addJob(
+                    new ExtractVideoFramesJob( info->fileName(), BackgroundTaskManager::BackgroundVideoPreviewRequest ) );
     }
     emit completed();
 }
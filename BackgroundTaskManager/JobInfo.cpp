@@ -25,7 +25,7 @@ namespace BackgroundTaskManager {
 int JobInfo::s_jobCounter = 0;
 
 JobInfo::JobInfo(BackgroundTaskManager::Priority priority)
-    : state(NotStarted), m_priority(priority), m_elapsed(0), m_jobIndex(++s_jobCounter)
+    : state(NotStarted), m_priority(priority), m_elapsed(0), m_queueLatency(0), m_worker(-1), m_jobIndex(++s_jobCounter)
 {
 }
 
@@ -34,6 +34,8 @@ JobInfo::JobInfo(const JobInfo *other)
     m_priority = other->m_priority;
     state = other->state;
     m_elapsed = other->m_elapsed;
+    m_queueLatency = other->m_queueLatency;
+    m_worker = other->m_worker;
     m_jobIndex = other->m_jobIndex;
 }
 
@@ -48,6 +50,8 @@ Priority JobInfo::priority() const
 
 void JobInfo::start()
 {
+    if ( m_queueTimer.isValid() )
+        m_queueLatency = m_queueTimer.elapsed();
     m_timer.start();
     state = Running;
 }
@@ -67,6 +71,35 @@ QString JobInfo::elapsed() const
     if ( state == Completed )
         time = m_elapsed;
 
+    return formatTime(time);
+}
+
+QString JobInfo::queueLatency() const
+{
+    if ( state != NotStarted )
+        return formatTime(m_queueLatency);
+    if ( m_queueTimer.isValid() )
+        return formatTime(m_queueTimer.elapsed());
+    return QString();
+}
+
+void JobInfo::markQueued()
+{
+    m_queueTimer.start();
+}
+
+int JobInfo::worker() const
+{
+    return m_worker;
+}
+
+void JobInfo::setWorker(int worker)
+{
+    m_worker = worker;
+}
+
+QString JobInfo::formatTime(qint64 time)
+{
     const int secs = time / 1000;
     const int part = (time % 1000) / 100;
 
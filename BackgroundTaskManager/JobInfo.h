@@ -43,8 +43,20 @@ public:
     State state;
 
     QString elapsed() const;
+    /**
+     * @brief queueLatency is the time the job spent in the queue of the JobManager before it was started.
+     */
+    QString queueLatency() const;
     int jobIndex() const;
 
+    /**
+     * @brief worker is the number of the JobManager's worker thread that runs the job,
+     * or -1 if it runs on the main thread.
+     */
+    int worker() const;
+    void setWorker(int worker);
+    void markQueued();
+
 protected slots:
     void start();
     void stop();
@@ -53,9 +65,14 @@ signals:
     void changed() const;
 
 private:
+    static QString formatTime(qint64 time);
+
     BackgroundTaskManager::Priority m_priority;
     QElapsedTimer m_timer;
     uint m_elapsed;
+    QElapsedTimer m_queueTimer;
+    uint m_queueLatency;
+    int m_worker;
     int m_jobIndex;
     static int s_jobCounter;
 };
@@ -32,6 +32,9 @@
 
   Each job must override \ref execute, and must emit the signal completed.
   Emitting the signal is crusial, as the JobManager will otherwise stall.
+
+  Jobs which return true from \ref isThreadSafe are executed on one of the worker threads
+  of the JobManager instead of the main thread.
 */
 
 BackgroundTaskManager::JobInterface::JobInterface(BackgroundTaskManager::Priority priority)
@@ -46,10 +49,38 @@ BackgroundTaskManager::JobInterface::~JobInterface()
 }
 
 void BackgroundTaskManager::JobInterface::start()
+{
+    markStarted();
+    execute();
+}
+
+/**
+ * @brief isThreadSafe tells whether \ref execute may be run on a worker thread.
+ *
+ * A thread-safe job must not touch any widgets, must not rely on an event loop in execute()
+ * (e.g. for running processes), and may only read from the database.
+ * The signal \ref completed is emitted from the worker thread, and must be emitted before execute() returns.
+ * Adding new jobs using JobManager::addJob is fine from any thread.
+ */
+bool BackgroundTaskManager::JobInterface::isThreadSafe() const
+{
+    return false;
+}
+
+/**
+ * @brief resourcePath is the file the job mainly reads from, used to schedule the disk it is stored on.
+ * Jobs that do not read any particular file return an empty string, which is the default.
+ * \see Utilities::ResourceScheduler
+ */
+QString BackgroundTaskManager::JobInterface::resourcePath() const
+{
+    return QString();
+}
+
+void BackgroundTaskManager::JobInterface::markStarted()
 {
     Debug("Starting Job (#%d): %s %s", jobIndex(), qPrintable(title()), qPrintable(details()));
     JobInfo::start();
-    execute();
 }
 
 void BackgroundTaskManager::JobInterface::addDependency(BackgroundTaskManager::JobInterface *job)
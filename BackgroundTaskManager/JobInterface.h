@@ -33,6 +33,8 @@ public:
     virtual ~JobInterface();
     void start();
     void addDependency(JobInterface* job);
+    virtual bool isThreadSafe() const;
+    virtual QString resourcePath() const;
 
 protected:
     virtual void execute() = 0;
@@ -44,6 +46,9 @@ private slots:
     void dependedJobCompleted();
 
 private:
+    friend class JobRunner;
+    void markStarted();
+
     int m_dependencies;
 };
 
@@ -18,8 +18,11 @@
 
 #include "JobManager.h"
 #include "JobInfo.h"
-#include <ImageManager/AsyncLoader.h>
+#include <Utilities/ResourceScheduler.h>
+#include <QMutexLocker>
+#include <QRunnable>
 #include <QThread>
+#include <QThreadPool>
 
 /**
   \class BackgroundTaskManager::JobManager
@@ -28,16 +31,58 @@
   This is the engine for running background jobs. Each job is a subclass of
   \ref BackgroundTaskManager::JobInterface. The jobs are added using \ref addJob.
 
-  Currently the jobs are executed one after the other on the main thread, but down the road I
-  imagine it will provide for running jobs on secondary threads. The jobs would need to
-  indicate that that is a possibility.
+  Jobs are started in order of their priority. Jobs which are \ref JobInterface::isThreadSafe "thread-safe"
+  are executed on a dedicated pool of worker threads, all other jobs are executed on the main thread.
+  Before a job is started, it must get a token from the \ref Utilities::ResourceScheduler,
+  which shares the cores and disks with the image loader threads of \ref ImageManager::AsyncLoader.
+  Jobs with a priority below BackgroundTask are foreground work, which preempts all background work.
 */
 
+namespace BackgroundTaskManager
+{
+/**
+ * The JobRunner executes a thread-safe job on one of the worker threads of the JobManager.
+ * The job is marked as started on the main thread, when the runner is created.
+ */
+class JobRunner : public QRunnable
+{
+public:
+    explicit JobRunner(JobInterface* job)
+        : m_job(job)
+    {
+        m_job->markStarted();
+    }
+
+    void run() override
+    {
+        // Like the image loader threads, the workers must not starve the GUI thread.
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+        m_job->execute();
+        // The job has emitted completed() by now, but only the runner knows when it is no longer used.
+        m_job->deleteLater();
+    }
+
+private:
+    JobInterface* m_job;
+};
+}
+
 BackgroundTaskManager::JobManager* BackgroundTaskManager::JobManager::s_instance = nullptr;
 
 BackgroundTaskManager::JobManager::JobManager() :
     m_isPaused(false)
 {
+    Utilities::ResourceScheduler* scheduler = Utilities::ResourceScheduler::instance();
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount( scheduler->cpuSlots() );
+    m_workers.fill( nullptr, scheduler->cpuSlots() );
+
+    // Tokens are mostly released by the image loader threads, so get back to the main thread,
+    // and only once for any number of releases until then.
+    scheduler->addReleaseListener( [this] {
+        if ( m_executeScheduled.testAndSetOrdered( 0, 1 ) )
+            QMetaObject::invokeMethod( this, "resourcesReleased", Qt::QueuedConnection );
+    } );
 }
 
 bool BackgroundTaskManager::JobManager::shouldExecute() const
@@ -45,16 +90,6 @@ bool BackgroundTaskManager::JobManager::shouldExecute() const
     return m_queue.hasForegroundTasks() || !m_isPaused;
 }
 
-int BackgroundTaskManager::JobManager::maxJobCount() const
-{
-    // See comment in ImageManager::AsyncLoader::init()
-    // We will at least have one active background task at the time, as some of them
-    // currently aren't that much for background stuff. The key example of this is generating video thumbnails.
-    const int max = qMin( 3, QThread::idealThreadCount() );
-    int count = qMax( 1, max - ImageManager::AsyncLoader::instance()->activeCount() - 1 );
-    return count;
-}
-
 void BackgroundTaskManager::JobManager::execute()
 {
     if ( m_queue.isEmpty() )
@@ -63,21 +98,69 @@ void BackgroundTaskManager::JobManager::execute()
     if ( !shouldExecute() )
         return;
 
-    while ( m_active.count() < maxJobCount() &&  !m_queue.isEmpty() ) {
+    while ( !m_queue.isEmpty() ) {
+        JobInterface* next = m_queue.peek(0);
+        int worker = -1;
+        if ( next->isThreadSafe() ) {
+            worker = m_workers.indexOf( nullptr );
+            if ( worker == -1 )
+                break;
+        }
+
+        const Utilities::ResourceScheduler::Priority priority = ( next->priority() < BackgroundTask )
+                ? Utilities::ResourceScheduler::Foreground : Utilities::ResourceScheduler::Background;
+        Utilities::ResourceScheduler::Token token = Utilities::ResourceScheduler::instance()->tryAcquire( priority, next->resourcePath() );
+        // We will at least have one active background task at the time, as the image loader would otherwise
+        // keep the jobs waiting as long as it has work, and some of them currently aren't that much for background stuff.
+        // The key example of this is generating video thumbnails.
+        if ( !token.isValid() && !m_active.isEmpty() )
+            break;
+
         JobInterface* job = m_queue.dequeue();
         connect(job,SIGNAL(completed()), this, SLOT(jobCompleted()));
         m_active.append(job);
+        m_tokens.insert(job, token);
+        job->setWorker(worker);
         emit jobStarted(job);
-        job->start();
+        if ( worker == -1 )
+            job->start();
+        else {
+            m_workers[worker] = job;
+            m_pool->start( new JobRunner(job) );
+        }
     }
 }
 
 void BackgroundTaskManager::JobManager::addJob(BackgroundTaskManager::JobInterface* job )
 {
+    if ( QThread::currentThread() != thread() ) {
+        // The job belongs to the worker thread that created it, which knows nothing about events.
+        job->moveToThread( thread() );
+        QMutexLocker locker( &m_pendingLock );
+        m_pendingJobs.append( job );
+        QMetaObject::invokeMethod( this, "addPendingJobs", Qt::QueuedConnection );
+        return;
+    }
+
+    job->markQueued();
     m_queue.enqueue(job, job->priority());
     execute();
 }
 
+void BackgroundTaskManager::JobManager::addPendingJobs()
+{
+    QList<JobInterface*> jobs;
+    {
+        QMutexLocker locker( &m_pendingLock );
+        jobs.swap( m_pendingJobs );
+    }
+    for ( JobInterface* job : jobs ) {
+        job->markQueued();
+        m_queue.enqueue(job, job->priority());
+    }
+    execute();
+}
+
 BackgroundTaskManager::JobManager *BackgroundTaskManager::JobManager::instance()
 {
     if ( !s_instance )
@@ -123,10 +206,33 @@ void BackgroundTaskManager::JobManager::jobCompleted()
     Q_ASSERT(job);
     emit jobEnded(job);
     m_active.removeAll(job);
-    job->deleteLater();
+    Utilities::ResourceScheduler::Token token = m_tokens.take(job);
+    Utilities::ResourceScheduler::instance()->release(token);
+
+    const int worker = m_workers.indexOf(job);
+    if ( worker == -1 )
+        job->deleteLater();
+    else
+        m_workers[worker] = nullptr; // the JobRunner deletes the job
+    execute();
+}
+
+void BackgroundTaskManager::JobManager::resourcesReleased()
+{
+    m_executeScheduled = 0;
     execute();
 }
 
+int BackgroundTaskManager::JobManager::workerCount() const
+{
+    return m_workers.count();
+}
+
+BackgroundTaskManager::JobInfo* BackgroundTaskManager::JobManager::workerJob(int worker) const
+{
+    return m_workers.value(worker);
+}
+
 void BackgroundTaskManager::JobManager::togglePaused()
 {
     m_isPaused = !m_isPaused;
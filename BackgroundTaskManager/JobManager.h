@@ -20,8 +20,15 @@
 #define JOBMANAGER_H
 
 #include <QObject>
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
 #include "JobInterface.h"
 #include "PriorityQueue.h"
+#include <Utilities/ResourceScheduler.h>
+
+class QThreadPool;
 
 namespace BackgroundTaskManager
 {
@@ -38,6 +45,11 @@ public:
     bool isPaused() const;
     bool hasActiveJobs() const;
     void togglePaused();
+    int workerCount() const;
+    /**
+     * @brief workerJob returns the job currently running on the given worker thread, or a null pointer if the worker is idle.
+     */
+    JobInfo* workerJob(int worker) const;
 
 signals:
     void jobStarted(JobInterface* job);
@@ -46,18 +58,25 @@ signals:
 private slots:
     void execute();
     void jobCompleted();
+    void addPendingJobs();
+    void resourcesReleased();
 
 private:
     JobManager();
     static JobManager* s_instance;
     bool shouldExecute() const;
 
-    int maxJobCount() const;
-
     bool m_isRunning;
     QList<JobInterface*> m_active;
     PriorityQueue m_queue;
     bool m_isPaused;
+    QThreadPool* m_pool;
+    QVector<JobInterface*> m_workers;
+    QHash<JobInterface*, Utilities::ResourceScheduler::Token> m_tokens;
+    QAtomicInt m_executeScheduled;
+    // jobs added from worker threads, waiting to be queued on the main thread:
+    QMutex m_pendingLock;
+    QList<JobInterface*> m_pendingJobs;
 };
 
 }
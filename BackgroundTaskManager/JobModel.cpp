@@ -57,7 +57,7 @@ int JobModel::rowCount(const QModelIndex& index) const
 
 int JobModel::columnCount(const QModelIndex &) const
 {
-    return 4;
+    return 6;
 }
 
 QVariant JobModel::data(const QModelIndex &index, int role) const
@@ -77,6 +77,8 @@ QVariant JobModel::data(const QModelIndex &index, int role) const
         case IDCol: return current->jobIndex();
         case TitleCol:   return current->title();
         case DetailsCol: return current->details();
+        case ThreadCol: return threadName(current);
+        case QueuedCol: return current->queueLatency();
         case ElapsedCol: return current->elapsed();
         default: return QVariant();
         }
@@ -97,6 +99,8 @@ QVariant JobModel::headerData(int section, Qt::Orientation orientation, int role
         case IDCol: return i18nc("@title:column Background job id","ID");
         case TitleCol:   return i18nc("@title:column Background job title","Title");
         case DetailsCol: return i18nc("@title:column Additional information on background job","Details");
+        case ThreadCol: return i18nc("@title:column Thread a background job runs on","Thread");
+        case QueuedCol: return i18nc("@title:column Time a background job waited before it was started","Queued");
         case ElapsedCol: return i18nc("@title:column Elapsed time","Elapsed");
         default: return QVariant();
     }
@@ -133,6 +137,15 @@ JobInfo* JobModel::info(int row) const
     return JobManager::instance()->futureJob(row);
 }
 
+QString JobModel::threadName(const JobInfo* info)
+{
+    if ( info->state == JobInfo::NotStarted )
+        return QString();
+    if ( info->worker() == -1 )
+        return i18nc("@item The thread of the user interface","Main");
+    return i18nc("@item A background thread","Worker %1", info->worker() + 1);
+}
+
 QPixmap JobModel::statusImage(JobInfo::State state) const
 {
     QColor color;
@@ -46,10 +46,11 @@ private slots:
     void jobStarted( JobInterface* job);
 
 private:
-    enum Column { IDCol = 0, TitleCol = 1, DetailsCol = 2, ElapsedCol = 3 };
+    enum Column { IDCol = 0, TitleCol = 1, DetailsCol = 2, ThreadCol = 3, QueuedCol = 4, ElapsedCol = 5 };
 
     JobInfo* info(int row) const;
     QPixmap statusImage( JobInfo::State state ) const;
+    static QString threadName( const JobInfo* info );
 
     QList<CompletedJobInfo*> m_previousJobs;
 };
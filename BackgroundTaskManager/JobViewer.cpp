@@ -21,6 +21,7 @@
 #include "ui_JobViewer.h"
 #include "JobModel.h"
 #include "JobManager.h"
+#include <QStringList>
 
 namespace BackgroundTaskManager {
 
@@ -33,6 +34,8 @@ JobViewer::JobViewer(QWidget *parent) :
     setWindowTitle(i18n("Background Job Viewer"));
     connect( ui->pause, SIGNAL(clicked()), this, SLOT(togglePause()));
     connect( ui->pushButton, SIGNAL(clicked()), this, SLOT(accept()));
+    connect( JobManager::instance(), SIGNAL(jobStarted(JobInterface*)), this, SLOT(updateThreadActivity()));
+    connect( JobManager::instance(), SIGNAL(jobEnded(JobInterface*)), this, SLOT(updateThreadActivity()));
 }
 
 void JobViewer::setVisible(bool b)
@@ -41,6 +44,7 @@ void JobViewer::setVisible(bool b)
         m_model = new JobModel(this);
         ui->view->setModel(m_model);
         updatePauseButton();
+        updateThreadActivity();
     }
     else {
         delete m_model;
@@ -51,7 +55,9 @@ void JobViewer::setVisible(bool b)
     ui->view->setColumnWidth(0, 50);
     ui->view->setColumnWidth(1, 300);
     ui->view->setColumnWidth(2, 300);
-    ui->view->setColumnWidth(3, 50);
+    ui->view->setColumnWidth(3, 70);
+    ui->view->setColumnWidth(4, 50);
+    ui->view->setColumnWidth(5, 50);
     KDialog::setVisible(b);
 }
 
@@ -61,6 +67,33 @@ void JobViewer::togglePause()
     updatePauseButton();
 }
 
+void JobViewer::updateThreadActivity()
+{
+    // only while the viewer is shown:
+    if ( !m_model )
+        return;
+
+    JobManager* manager = JobManager::instance();
+    int busy = 0;
+    for ( int i = 0; i < manager->workerCount(); ++i ) {
+        if ( manager->workerJob(i) )
+            ++busy;
+    }
+    const int mainThreadJobs = manager->activeJobCount() - busy;
+
+    QStringList workers;
+    for ( int i = 0; i < manager->workerCount(); ++i ) {
+        const JobInfo* job = manager->workerJob(i);
+        workers << ( job ? i18nc("@info Worker thread number and the title of the job it runs","%1: %2", i + 1, job->title())
+                         : i18nc("@info Worker thread number","%1: idle", i + 1) );
+    }
+
+    ui->threadActivity->setText( i18np("Main thread: 1 job", "Main thread: %1 jobs", mainThreadJobs)
+                                 + QString::fromLatin1("\n")
+                                 + i18n("Worker threads (%1 of %2 busy): %3", busy, manager->workerCount(),
+                                        workers.join(QString::fromLatin1(", "))) );
+}
+
 void JobViewer::updatePauseButton()
 {
     ui->pause->setText(JobManager::instance()->isPaused() ? i18n("Continue") : i18n("Pause"));
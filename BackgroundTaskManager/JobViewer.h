@@ -35,6 +35,7 @@ public:
 
 private slots:
     void togglePause();
+    void updateThreadActivity();
 
 private:
     void updatePauseButton();
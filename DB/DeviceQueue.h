@@ -0,0 +1,144 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef DEVICEQUEUE_H
+#define DEVICEQUEUE_H
+
+#include <QHash>
+#include <QList>
+#include <QQueue>
+
+namespace DB
+{
+
+/**
+ * @brief The DeviceQueue class queues work items per device, and hands them out in round robin order.
+ *
+ * At most maxActivePerDevice items of a device are handed out at a time; each item taken with
+ * \ref take must be reported back with \ref done. This is what MD5Calculator and DirectoryCrawler
+ * use to keep every device busy without having many threads seek on the same disk.
+ *
+ * The class is not thread-safe; the users guard it with their own mutex.
+ */
+template <typename T>
+class DeviceQueue
+{
+public:
+    typedef quint64 DeviceId;
+
+    explicit DeviceQueue( int maxActivePerDevice )
+        : m_maxActivePerDevice( qMax(1, maxActivePerDevice) ), m_nextDevice( 0 ) {}
+
+    void enqueue( DeviceId device, const T& item )
+    {
+        if ( !m_queues.contains( device ) )
+            m_devices.append( device );
+        m_queues[device].enqueue( item );
+    }
+
+    void enqueue( DeviceId device, const QList<T>& items )
+    {
+        if ( items.isEmpty() )
+            return;
+        if ( !m_queues.contains( device ) )
+            m_devices.append( device );
+        m_queues[device].append( items );
+    }
+
+    /**
+     * @brief take dequeues the next item of the next device that is not busy.
+     * @return false if there is no item, or all devices with items are busy
+     */
+    bool take( T& item, DeviceId& device )
+    {
+        // pick the devices in round robin order, skipping those that are busy:
+        for ( int i = 0; i < m_devices.size(); ++i ) {
+            const int index = ( m_nextDevice + i ) % m_devices.size();
+            const DeviceId candidate = m_devices.at( index );
+            if ( m_active.value( candidate ) >= m_maxActivePerDevice )
+                continue;
+
+            QQueue<T>& queue = m_queues[candidate];
+            item = queue.dequeue();
+            if ( queue.isEmpty() ) {
+                m_queues.remove( candidate );
+                m_devices.removeAt( index );
+                // the next device has moved up to this index:
+                m_nextDevice = index;
+            } else {
+                m_nextDevice = index + 1;
+            }
+            ++m_active[candidate];
+            device = candidate;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief done marks an item of the device, that was handed out by take(), as finished.
+     */
+    void done( DeviceId device )
+    {
+        if ( --m_active[device] <= 0 )
+            m_active.remove( device );
+    }
+
+    /**
+     * @return true if no items are queued; items that were taken but are not done yet don't count.
+     */
+    bool isEmpty() const
+    {
+        return m_devices.isEmpty();
+    }
+
+    /**
+     * @return the number of devices that have items queued
+     */
+    int deviceCount() const
+    {
+        return m_devices.size();
+    }
+
+    /**
+     * @brief clear removes all queued items.
+     * @return the removed items
+     */
+    QList<T> clear()
+    {
+        QList<T> items;
+        for ( auto it = m_queues.constBegin(); it != m_queues.constEnd(); ++it )
+            items.append( *it );
+        m_queues.clear();
+        m_devices.clear();
+        m_nextDevice = 0;
+        return items;
+    }
+
+private:
+    const int m_maxActivePerDevice;
+    QHash<DeviceId, QQueue<T> > m_queues;
+    QHash<DeviceId, int> m_active;
+    QList<DeviceId> m_devices;
+    int m_nextDevice;
+};
+
+}
+
+#endif /* DEVICEQUEUE_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
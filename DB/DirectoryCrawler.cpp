@@ -0,0 +1,394 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "DirectoryCrawler.h"
+#include "DirectorySnapshot.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#  include <sys/syscall.h>
+#endif
+
+namespace {
+// big enough to read most directories with a single call (and few NFS round trips):
+constexpr int LISTING_BUFFER_SIZE = 64 * 1024;
+// Subdirectories are opened relative to their parent as soon as they are found. If that would keep
+// too many directories open, they are queued by path instead and opened when they are crawled.
+constexpr int MAX_OPEN_DIRECTORIES = 256;
+
+#ifdef Q_OS_LINUX
+struct linux_dirent64
+{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+/**
+ * @brief forEachEntry calls func( name, type, inode ) for each entry of the open directory fd.
+ * The type is one of the DT_* constants, and may be DT_UNKNOWN if the file system doesn't provide it.
+ * The fd is not closed.
+ */
+template <typename Func>
+void forEachEntry( int fd, Func func )
+{
+#ifdef Q_OS_LINUX
+    QByteArray buffer( LISTING_BUFFER_SIZE, Qt::Uninitialized );
+    forever {
+        const long count = syscall( SYS_getdents64, fd, buffer.data(), buffer.size() );
+        if ( count < 0 && errno == EINTR )
+            continue;
+        if ( count <= 0 )
+            return;
+        for ( long offset = 0; offset < count; ) {
+            const linux_dirent64* entry = reinterpret_cast<const linux_dirent64*>( buffer.constData() + offset );
+            func( entry->d_name, entry->d_type, static_cast<quint64>( entry->d_ino ) );
+            offset += entry->d_reclen;
+        }
+    }
+#else
+    // fdopendir() takes ownership of the descriptor, so give it a copy:
+    const int copy = ::dup( fd );
+    if ( copy < 0 )
+        return;
+    DIR* dir = ::fdopendir( copy );
+    if ( !dir ) {
+        ::close( copy );
+        return;
+    }
+    while ( const dirent* entry = ::readdir( dir ) ) {
+#  ifdef _DIRENT_HAVE_D_TYPE
+        func( entry->d_name, entry->d_type, static_cast<quint64>( entry->d_ino ) );
+#  else
+        func( entry->d_name, DT_UNKNOWN, static_cast<quint64>( entry->d_ino ) );
+#  endif
+    }
+    ::closedir( dir );
+#endif
+}
+}
+
+/**
+ * @brief The Worker class crawls directories from the queues of the DirectoryCrawler until there are none left.
+ */
+class DB::DirectoryCrawler::Worker : public QRunnable
+{
+public:
+    explicit Worker( DirectoryCrawler* crawler ) : m_crawler( crawler ) {}
+
+    void run() override
+    {
+        Task task;
+        DeviceId device;
+        while ( m_crawler->takeNextTask( task, device ) ) {
+            m_crawler->processDirectory( task, device );
+            m_crawler->taskDone( device );
+        }
+    }
+
+private:
+    DirectoryCrawler* m_crawler;
+};
+
+DB::DirectoryCrawler::DirectoryCrawler( int maxReadsPerDevice )
+    : m_maxReadsPerDevice( qMax(1, maxReadsPerDevice) )
+    , m_skipSymlinks( false )
+    , m_snapshot( nullptr )
+    , m_queue( m_maxReadsPerDevice )
+    , m_pending( 0 )
+    , m_workers( 0 )
+    , m_openDirectories( 0 )
+    , m_canceled( 0 )
+{
+}
+
+DB::DirectoryCrawler::~DirectoryCrawler()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void DB::DirectoryCrawler::setExcludedNames( const QStringList& names )
+{
+    m_excludedNames = names.toSet();
+}
+
+void DB::DirectoryCrawler::setSkipSymlinks( bool skip )
+{
+    m_skipSymlinks = skip;
+}
+
+void DB::DirectoryCrawler::setSnapshot( const DirectorySnapshot* snapshot )
+{
+    m_snapshot = snapshot;
+}
+
+void DB::DirectoryCrawler::crawl( const QStringList& directories )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        m_canceled = 0;
+    }
+    for ( const QString& directory : directories ) {
+        struct stat buf;
+        if ( ::stat( QFile::encodeName( directory ).constData(), &buf ) != 0 || !S_ISDIR( buf.st_mode ) )
+            continue;
+        enqueue( Task{ directory, -1 }, buf.st_dev );
+    }
+}
+
+void DB::DirectoryCrawler::cancel()
+{
+    QMutexLocker locker( &m_mutex );
+    m_canceled = 1;
+    const QList<Task> tasks = m_queue.clear();
+    for ( const Task& task : tasks ) {
+        if ( task.fd >= 0 ) {
+            ::close( task.fd );
+            m_openDirectories.deref();
+        }
+    }
+    m_pending -= tasks.size();
+    m_entries.clear();
+    m_taskAvailable.wakeAll();
+    m_entryAvailable.wakeAll();
+}
+
+bool DB::DirectoryCrawler::isCanceled() const
+{
+    return m_canceled != 0;
+}
+
+bool DB::DirectoryCrawler::isFinished() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_pending == 0 && m_entries.isEmpty();
+}
+
+void DB::DirectoryCrawler::waitForEntries( int msecs )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_entries.isEmpty() && m_pending > 0 )
+        m_entryAvailable.wait( &m_mutex, msecs );
+}
+
+QList<DB::DirectoryCrawler::Entry> DB::DirectoryCrawler::takeEntries()
+{
+    QMutexLocker locker( &m_mutex );
+    QList<Entry> entries;
+    entries.swap( m_entries );
+    return entries;
+}
+
+void DB::DirectoryCrawler::enqueue( const Task& task, DeviceId device )
+{
+    bool startWorker = false;
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( isCanceled() ) {
+            if ( task.fd >= 0 ) {
+                ::close( task.fd );
+                m_openDirectories.deref();
+            }
+            return;
+        }
+        m_queue.enqueue( device, task );
+        ++m_pending;
+
+        // Workers exit when the queues are empty, so new ones are started as work shows up:
+        const int wanted = qMin( m_pool.maxThreadCount(), m_queue.deviceCount() * m_maxReadsPerDevice );
+        if ( m_workers < wanted ) {
+            ++m_workers;
+            startWorker = true;
+        }
+        m_taskAvailable.wakeOne();
+    }
+    if ( startWorker )
+        m_pool.start( new Worker( this ) );
+}
+
+bool DB::DirectoryCrawler::takeNextTask( Task& task, DeviceId& device )
+{
+    QMutexLocker locker( &m_mutex );
+    forever {
+        if ( isCanceled() || m_queue.isEmpty() ) {
+            --m_workers;
+            return false;
+        }
+
+        if ( m_queue.take( task, device ) )
+            return true;
+
+        // all devices with pending directories are busy:
+        m_taskAvailable.wait( &m_mutex );
+    }
+}
+
+void DB::DirectoryCrawler::taskDone( DeviceId device )
+{
+    QMutexLocker locker( &m_mutex );
+    m_queue.done( device );
+    --m_pending;
+    m_taskAvailable.wakeOne();
+    m_entryAvailable.wakeAll();
+}
+
+void DB::DirectoryCrawler::addEntries( const QList<Entry>& entries )
+{
+    if ( entries.isEmpty() )
+        return;
+
+    QMutexLocker locker( &m_mutex );
+    if ( isCanceled() )
+        return;
+    m_entries.append( entries );
+    m_entryAvailable.wakeAll();
+}
+
+void DB::DirectoryCrawler::processDirectory( Task task, DeviceId device )
+{
+    QList<Entry> entries;
+    QList< QPair<Task, DeviceId> > subdirectories;
+
+    // directories that were opened by their parent have already been inspected:
+    bool needsListing = true;
+    if ( task.fd < 0 ) {
+        task.fd = ::open( QFile::encodeName( task.path ).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        if ( task.fd < 0 )
+            return;
+        m_openDirectories.ref();
+        needsListing = inspectDirectory( task.fd, task.path, device, entries, subdirectories );
+    }
+
+    if ( needsListing && !isCanceled() )
+        listDirectory( task.fd, task.path, device, entries, subdirectories );
+    ::close( task.fd );
+    m_openDirectories.deref();
+
+    // The entries must be reported before the subdirectories are handed to other workers,
+    // so that the entry of a directory is always seen before the entries within it:
+    addEntries( entries );
+    for ( const auto& subdirectory : subdirectories )
+        enqueue( subdirectory.first, subdirectory.second );
+}
+
+bool DB::DirectoryCrawler::inspectDirectory( int fd, const QString& path, DeviceId& device,
+                                             QList<Entry>& entries, QList< QPair<Task, DeviceId> >& subdirectories )
+{
+    struct stat buf;
+    if ( ::fstat( fd, &buf ) != 0 )
+        return false;
+    device = buf.st_dev;
+
+    {
+        // guard against symlink loops and directories that are reachable twice:
+        QMutexLocker locker( &m_mutex );
+        const QPair<DeviceId, quint64> id( buf.st_dev, buf.st_ino );
+        if ( m_visited.contains( id ) )
+            return false;
+        m_visited.insert( id );
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.type = Directory;
+    entry.modificationTime = buf.st_mtime;
+    entry.inode = buf.st_ino;
+
+    if ( m_snapshot && m_snapshot->isUnchanged( path, entry.modificationTime, entry.inode ) ) {
+        entry.isUnchanged = true;
+        entries.append( entry );
+        for ( const QString& name : m_snapshot->entry( path ).subdirectories )
+            subdirectories.append( qMakePair( Task{ path + QString::fromLatin1("/") + name, -1 }, device ) );
+        return false;
+    }
+
+    entries.append( entry );
+    return true;
+}
+
+void DB::DirectoryCrawler::listDirectory( int fd, const QString& path, DeviceId device,
+                                          QList<Entry>& entries, QList< QPair<Task, DeviceId> >& subdirectories )
+{
+    const QString prefix = path + QString::fromLatin1("/");
+    forEachEntry( fd, [&]( const char* rawName, unsigned char type, quint64 inode ) {
+        if ( rawName[0] == '.' && ( rawName[1] == '\0' || ( rawName[1] == '.' && rawName[2] == '\0' ) ) )
+            return;
+        const QString name = QFile::decodeName( rawName );
+        if ( m_excludedNames.contains( name ) )
+            return;
+
+        // Only symbolic links and file systems that don't report the type need a stat():
+        struct stat buf;
+        bool haveStat = false;
+        if ( type == DT_UNKNOWN ) {
+            if ( ::fstatat( fd, rawName, &buf, AT_SYMLINK_NOFOLLOW ) != 0 )
+                return;
+            haveStat = true;
+            type = S_ISLNK( buf.st_mode ) ? DT_LNK : S_ISDIR( buf.st_mode ) ? DT_DIR : S_ISREG( buf.st_mode ) ? DT_REG : DT_UNKNOWN;
+        }
+        if ( type == DT_LNK ) {
+            if ( m_skipSymlinks || ::fstatat( fd, rawName, &buf, 0 ) != 0 )
+                return;
+            haveStat = true;
+            type = S_ISDIR( buf.st_mode ) ? DT_DIR : S_ISREG( buf.st_mode ) ? DT_REG : DT_UNKNOWN;
+        }
+
+        if ( type == DT_REG ) {
+            Entry entry;
+            entry.path = prefix + name;
+            entry.type = File;
+            entry.modificationTime = haveStat ? buf.st_mtime : 0;
+            entry.inode = haveStat ? buf.st_ino : inode;
+            entries.append( entry );
+        } else if ( type == DT_DIR ) {
+            const QString subdirectory = prefix + name;
+            if ( m_openDirectories >= MAX_OPEN_DIRECTORIES ) {
+                // most likely on the same device; the crawler only uses the device for scheduling:
+                subdirectories.append( qMakePair( Task{ subdirectory, -1 }, device ) );
+                return;
+            }
+
+            const int subdirectoryFd = ::openat( fd, rawName, O_RDONLY | O_DIRECTORY | O_CLOEXEC | ( m_skipSymlinks ? O_NOFOLLOW : 0 ) );
+            if ( subdirectoryFd < 0 )
+                return; // not readable
+            m_openDirectories.ref();
+
+            DeviceId subdirectoryDevice;
+            if ( inspectDirectory( subdirectoryFd, subdirectory, subdirectoryDevice, entries, subdirectories ) ) {
+                subdirectories.append( qMakePair( Task{ subdirectory, subdirectoryFd }, subdirectoryDevice ) );
+            } else {
+                ::close( subdirectoryFd );
+                m_openDirectories.deref();
+            }
+        }
+    } );
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,146 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef DIRECTORYCRAWLER_H
+#define DIRECTORYCRAWLER_H
+
+#include "DeviceQueue.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace DB
+{
+class DirectorySnapshot;
+
+/**
+ * @brief The DirectoryCrawler class walks directory trees on a pool of worker threads.
+ *
+ * Where FastDir lists a single directory, the crawler lists whole subtrees and reports every file and
+ * directory it finds. The type of an entry is taken from the directory listing itself (\c d_type),
+ * so only entries of unknown type and symbolic links need to be stat()ed. Subdirectories are opened
+ * relative to their parent (\c openat), and each device is crawled by at most maxReadsPerDevice
+ * threads at a time, which keeps network file systems busy without flooding the server.
+ *
+ * If a DirectorySnapshot is given, directories that are unchanged according to the snapshot are not
+ * listed; only their remembered subdirectories are crawled.
+ *
+ * Entries can be fetched while the crawl is still running. The entry of a directory is always reported
+ * before the entries within it:
+ * \code
+ * DB::DirectoryCrawler crawler;
+ * crawler.crawl( QStringList() << directory );
+ * while ( !crawler.isFinished() ) {
+ *     crawler.waitForEntries( 100 );
+ *     for ( const DB::DirectoryCrawler::Entry& entry : crawler.takeEntries() )
+ *         ...
+ * }
+ * \endcode
+ */
+class DirectoryCrawler
+{
+public:
+    enum EntryType { File, Directory };
+
+    struct Entry
+    {
+        QString path;
+        EntryType type = File;
+        /// the modification time; this is only known for directories and for entries that had to be stat()ed (0 otherwise)
+        qint64 modificationTime = 0;
+        quint64 inode = 0;
+        /// true for directories that were not listed because the snapshot says they are unchanged
+        bool isUnchanged = false;
+    };
+
+    explicit DirectoryCrawler( int maxReadsPerDevice = 4 );
+    ~DirectoryCrawler();
+
+    /**
+     * @brief setExcludedNames sets the names of files and directories which are skipped, wherever they are found.
+     */
+    void setExcludedNames( const QStringList& names );
+    void setSkipSymlinks( bool skip );
+    /**
+     * @brief setSnapshot makes the crawler skip unchanged directories.
+     * The snapshot must not be modified while the crawl is running.
+     */
+    void setSnapshot( const DirectorySnapshot* snapshot );
+
+    void crawl( const QStringList& directories );
+    void cancel();
+    bool isCanceled() const;
+    /**
+     * @return true, if all directories have been crawled and all entries have been taken.
+     */
+    bool isFinished() const;
+    /**
+     * @brief waitForEntries blocks until an entry is available or msecs milliseconds have passed.
+     */
+    void waitForEntries( int msecs );
+    QList<Entry> takeEntries();
+
+private:
+    class Worker;
+    typedef quint64 DeviceId;
+
+    /// a directory to crawl; fd is the already opened directory, or -1 if it still needs to be opened by path
+    struct Task
+    {
+        QString path;
+        int fd;
+    };
+
+    bool takeNextTask( Task& task, DeviceId& device );
+    void taskDone( DeviceId device );
+    void enqueue( const Task& task, DeviceId device );
+    void processDirectory( Task task, DeviceId device );
+    bool inspectDirectory( int fd, const QString& path, DeviceId& device,
+                           QList<Entry>& entries, QList< QPair<Task, DeviceId> >& subdirectories );
+    void listDirectory( int fd, const QString& path, DeviceId device,
+                        QList<Entry>& entries, QList< QPair<Task, DeviceId> >& subdirectories );
+    void addEntries( const QList<Entry>& entries );
+
+    const int m_maxReadsPerDevice;
+    QSet<QString> m_excludedNames;
+    bool m_skipSymlinks;
+    const DirectorySnapshot* m_snapshot;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_taskAvailable;
+    QWaitCondition m_entryAvailable;
+    DeviceQueue<Task> m_queue;
+    QSet< QPair<DeviceId, quint64> > m_visited;
+    int m_pending;
+    int m_workers;
+    QList<Entry> m_entries;
+    QAtomicInt m_openDirectories;
+    QAtomicInt m_canceled;
+    QThreadPool m_pool;
+};
+
+}
+
+#endif /* DIRECTORYCRAWLER_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
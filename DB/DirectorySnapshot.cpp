@@ -0,0 +1,201 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "DirectorySnapshot.h"
+
+#include "DB/FileNameList.h"
+#include "Settings/SettingsData.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+namespace {
+const quint32 SNAPSHOT_MAGIC = 0x4b504144; // "KPAD"
+// bump whenever the file format changes:
+const quint32 SNAPSHOT_VERSION = 2;
+}
+
+QString DB::DirectorySnapshot::s_databaseFile;
+QString DB::DirectorySnapshot::s_databaseStamp;
+
+QString DB::DirectorySnapshot::snapshotFile()
+{
+    return QDir( Settings::SettingsData::instance()->imageDirectory() ).absoluteFilePath( QString::fromLatin1( ".directorysnapshot" ) );
+}
+
+QString DB::DirectorySnapshot::settingsFingerprint()
+{
+    const Settings::SettingsData* settings = Settings::SettingsData::instance();
+    QStringList values;
+    values << settings->imageDirectory()
+           << settings->excludeDirectories()
+           << QString::number( settings->skipSymlinks() )
+           << QString::number( settings->skipRawIfOtherMatches() )
+           << QString::number( settings->ignoreFileExtension() );
+    return values.join( QString::fromLatin1( "\n" ) );
+}
+
+/**
+ * The size and modification time of the database file, or an empty string if it doesn't exist.
+ */
+QString DB::DirectorySnapshot::databaseStamp()
+{
+    const QFileInfo fi( s_databaseFile );
+    if ( s_databaseFile.isEmpty() || !fi.exists() )
+        return QString();
+    return QString::fromLatin1( "%1:%2" ).arg( fi.size() ).arg( fi.lastModified().toMSecsSinceEpoch() );
+}
+
+void DB::DirectorySnapshot::setDatabaseFile( const QString& fileName )
+{
+    s_databaseFile = fileName;
+    s_databaseStamp = databaseStamp();
+}
+
+void DB::DirectorySnapshot::databaseSaved()
+{
+    const QString previousStamp = s_databaseStamp;
+    s_databaseStamp = databaseStamp();
+
+    // Only a snapshot that belonged to the database we had loaded describes the database we just saved.
+    DirectorySnapshot snapshot;
+    QString stamp;
+    if ( !previousStamp.isEmpty() && snapshot.read( &stamp ) && stamp == previousStamp )
+        snapshot.write( s_databaseStamp );
+}
+
+void DB::DirectorySnapshot::load()
+{
+    QString stamp;
+    if ( !read( &stamp ) || stamp.isEmpty() || stamp != s_databaseStamp )
+        m_entries.clear();
+}
+
+void DB::DirectorySnapshot::save() const
+{
+    write( s_databaseStamp );
+}
+
+bool DB::DirectorySnapshot::read( QString* stamp )
+{
+    m_entries.clear();
+
+    QFile file( snapshotFile() );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QDataStream stream( &file );
+    quint32 magic;
+    quint32 version;
+    QString fingerprint;
+    stream >> magic >> version;
+    if ( magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION )
+        return false;
+    stream >> fingerprint >> *stamp;
+    if ( fingerprint != settingsFingerprint() )
+        return false;
+
+    qint32 count;
+    stream >> count;
+    for ( int i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+        QString directory;
+        Entry entry;
+        stream >> directory >> entry.modificationTime >> entry.inode >> entry.subdirectories;
+        m_entries.insert( directory, entry );
+    }
+
+    if ( stream.status() != QDataStream::Ok ) {
+        qWarning( "Ignoring damaged directory snapshot %s", qPrintable( file.fileName() ) );
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+void DB::DirectorySnapshot::write( const QString& stamp ) const
+{
+    QFile file( snapshotFile() );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        qWarning( "Unable to write directory snapshot %s", qPrintable( file.fileName() ) );
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << settingsFingerprint() << stamp << static_cast<qint32>( m_entries.size() );
+    for ( auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it ) {
+        stream << it.key() << it->modificationTime << it->inode << it->subdirectories;
+    }
+}
+
+void DB::DirectorySnapshot::invalidate( const DB::FileNameList& files )
+{
+    if ( !QFile::exists( snapshotFile() ) )
+        return;
+
+    DirectorySnapshot snapshot;
+    snapshot.load();
+    for ( const DB::FileName& fileName : files ) {
+        snapshot.removeEntry( QFileInfo( fileName.absolute() ).absolutePath() );
+    }
+    snapshot.save();
+}
+
+int DB::DirectorySnapshot::count() const
+{
+    return m_entries.count();
+}
+
+bool DB::DirectorySnapshot::contains( const QString& directory ) const
+{
+    return m_entries.contains( directory );
+}
+
+bool DB::DirectorySnapshot::isUnchanged( const QString& directory, qint64 modificationTime, quint64 inode ) const
+{
+    auto it = m_entries.constFind( directory );
+    return it != m_entries.constEnd() && it->modificationTime == modificationTime && it->inode == inode;
+}
+
+DB::DirectorySnapshot::Entry DB::DirectorySnapshot::entry( const QString& directory ) const
+{
+    return m_entries.value( directory );
+}
+
+void DB::DirectorySnapshot::setEntry( const QString& directory, const Entry& entry )
+{
+    m_entries.insert( directory, entry );
+}
+
+void DB::DirectorySnapshot::removeEntry( const QString& directory )
+{
+    m_entries.remove( directory );
+}
+
+void DB::DirectorySnapshot::retainOnly( const QSet<QString>& directories )
+{
+    for ( auto it = m_entries.begin(); it != m_entries.end(); ) {
+        if ( directories.contains( it.key() ) )
+            ++it;
+        else
+            it = m_entries.erase( it );
+    }
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
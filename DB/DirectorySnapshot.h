@@ -0,0 +1,103 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef DIRECTORYSNAPSHOT_H
+#define DIRECTORYSNAPSHOT_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+namespace DB
+{
+class FileNameList;
+
+/**
+ * @brief The DirectorySnapshot class remembers the state of every directory below the image root
+ * as it was when the directory was last searched for new files.
+ *
+ * A directory's modification time changes whenever an entry is added to, removed from or renamed within it.
+ * So if both modification time and inode number of a directory are unchanged, NewImageFinder does not need to
+ * list it or look at any of its files again - it only needs to descend into the subdirectories recorded here.
+ *
+ * The snapshot is stored in the image directory. It is only valid for the settings that influence the
+ * search for new files (e.g. the excluded directories), and is discarded when they change.
+ * It is also tied to the database file it describes by its size and modification time, so a restored or
+ * replaced index.xml is not combined with a snapshot taken for another one.
+ */
+class DirectorySnapshot
+{
+public:
+    struct Entry
+    {
+        qint64 modificationTime = 0;
+        quint64 inode = 0;
+        QStringList subdirectories;
+    };
+
+    void load();
+    void save() const;
+    /**
+     * @brief setDatabaseFile tells which database file the snapshots belong to.
+     * This must be called when the database is loaded.
+     */
+    static void setDatabaseFile( const QString& fileName );
+    /**
+     * @brief databaseSaved ties the stored snapshot to the database file that was just saved.
+     */
+    static void databaseSaved();
+    /** @return the number of directories in the snapshot. */
+    int count() const;
+    /**
+     * @brief invalidate removes the directories of the given files from the stored snapshot.
+     * This must be called when files are removed from the database but not from the disk,
+     * so that the next search finds them again.
+     */
+    static void invalidate( const DB::FileNameList& files );
+
+    bool contains( const QString& directory ) const;
+    /**
+     * @brief isUnchanged returns true if the directory is known, and modification time and inode still match.
+     */
+    bool isUnchanged( const QString& directory, qint64 modificationTime, quint64 inode ) const;
+    Entry entry( const QString& directory ) const;
+    void setEntry( const QString& directory, const Entry& entry );
+    void removeEntry( const QString& directory );
+    /**
+     * @brief retainOnly removes all entries for directories not contained in the given set.
+     */
+    void retainOnly( const QSet<QString>& directories );
+
+private:
+    static QString snapshotFile();
+    static QString settingsFingerprint();
+    static QString databaseStamp();
+    bool read( QString* stamp );
+    void write( const QString& stamp ) const;
+
+    static QString s_databaseFile;
+    // the stamp of the database file as it was loaded or last saved:
+    static QString s_databaseStamp;
+    QHash<QString, Entry> m_entries;
+};
+
+}
+
+#endif /* DIRECTORYSNAPSHOT_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
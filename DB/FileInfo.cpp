@@ -32,6 +32,13 @@ FileInfo FileInfo::read( const DB::FileName& fileName, DB::ExifMode mode )
     return FileInfo( fileName, mode );
 }
 
+#ifdef HAVE_EXIV2
+FileInfo FileInfo::read( const DB::FileName& fileName, DB::ExifMode mode, const Exiv2::ExifData& exifData )
+{
+    return FileInfo( fileName, mode, exifData );
+}
+#endif
+
 DB::FileInfo::FileInfo( const DB::FileName& fileName, DB::ExifMode mode )
     : m_angle(0)
 {
@@ -46,6 +53,17 @@ DB::FileInfo::FileInfo( const DB::FileName& fileName, DB::ExifMode mode )
         m_date = QFileInfo( fileName.absolute() ).lastModified();
 }
 
+#ifdef HAVE_EXIV2
+DB::FileInfo::FileInfo( const DB::FileName& fileName, DB::ExifMode mode, const Exiv2::ExifData& exifData )
+    : m_angle(0)
+{
+    parseEXIV2( exifData );
+
+    if ( updateDataFromFileTimeStamp(fileName,mode))
+        m_date = QFileInfo( fileName.absolute() ).lastModified();
+}
+#endif
+
 bool DB::FileInfo::updateDataFromFileTimeStamp(const DB::FileName& fileName, DB::ExifMode mode)
 {
     // If the date is valid from EXIF reading, then we should not use the time stamp from the file.
@@ -72,8 +90,11 @@ bool DB::FileInfo::updateDataFromFileTimeStamp(const DB::FileName& fileName, DB:
 #ifdef HAVE_EXIV2
 void DB::FileInfo::parseEXIV2( const DB::FileName& fileName )
 {
-    Exiv2::ExifData map = Exif::Info::instance()->metadata( fileName ).exif;
+    parseEXIV2( Exif::Info::instance()->metadata( fileName ).exif );
+}
 
+void DB::FileInfo::parseEXIV2( Exiv2::ExifData map )
+{
     // Date
     m_date = fetchEXIV2Date( map, "Exif.Photo.DateTimeOriginal" );
     if ( !m_date.isValid() ) {
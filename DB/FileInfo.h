@@ -36,13 +36,21 @@ class FileInfo
 {
 public:
     static FileInfo read( const DB::FileName& fileName, DB::ExifMode mode );
-    QDateTime dateTime() { return m_date; }
-    int angle() { return m_angle; };
-    QString description() {return m_description; }
+#ifdef HAVE_EXIV2
+    /**
+     * @brief read creates the file info from exif data that has already been read from the file.
+     * @param exifData the exif data of the file (or its .thm sidecar file, see Exif::Info::exifInfoFile())
+     */
+    static FileInfo read( const DB::FileName& fileName, DB::ExifMode mode, const Exiv2::ExifData& exifData );
+#endif
+    QDateTime dateTime() const { return m_date; }
+    int angle() const { return m_angle; };
+    QString description() const {return m_description; }
 
 protected:
 #ifdef HAVE_EXIV2
     void parseEXIV2( const DB::FileName& fileName );
+    void parseEXIV2( Exiv2::ExifData map );
     QDateTime fetchEXIV2Date( Exiv2::ExifData& map, const char* key );
 #endif
 
@@ -51,6 +59,9 @@ protected:
 
 private:
     FileInfo( const DB::FileName& fileName, DB::ExifMode mode );
+#ifdef HAVE_EXIV2
+    FileInfo( const DB::FileName& fileName, DB::ExifMode mode, const Exiv2::ExifData& exifData );
+#endif
     bool updateDataFromFileTimeStamp( const DB::FileName& fileName, DB::ExifMode mode);
     QDateTime m_date;
     int m_angle;
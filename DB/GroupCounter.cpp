@@ -31,45 +31,33 @@ using namespace DB;
  * categorizing. The class is instantiating with the category we currently
  * are counting items for.
  *
- * The class builds the inverse member map, that is a map pointing from items
- * to parent.
- *
- * As an example, imagine we have the following member map (stored in the
- * variable groupToMemberMap in  the code):
+ * The counter works on the DB::GroupGraph of the member map, which knows for every item
+ * all the groups it belongs to, directly or through subgroups. As an example, imagine we have
+ * the following member map:
  * \code
- *    { USA |-> [Chicago, Santa Clara],
+ *    { USA |-> [Chicago, California],
  *      California |-> [Santa Clara, Los Angeles] }
  * \endcode
  *
- * The inverse map (stored in m_memberToGroup in the code ) will then look
- * like this:
+ * The groups of the items will then look like this:
  * \code
  *  { Chicago |-> [USA],
- *    Sanata Clara |-> [ USA, California ],
- *    Los Angeless |-> [ California ] }
+ *    California |-> [USA],
+ *    Santa Clara |-> [ USA, California ],
+ *    Los Angeles |-> [ USA, California ] }
  * \endcode
+ *
+ * The graph is only referenced, so the member map must not be changed while counting.
+ * The groups of an item are expanded from the bitset into a list the first time the item is counted.
  */
 GroupCounter::GroupCounter( const QString& category )
+    : m_graph( DB::ImageDB::instance()->memberMap().groupGraph( category ) ), m_serial( 0 )
 {
-    const MemberMap map = DB::ImageDB::instance()->memberMap();
-    QMap<QString,StringSet> groupToMemberMap = map.groupMap(category);
-
-    m_memberToGroup.reserve( 2729 /* A large prime */ );
-    m_groupCount.reserve( 2729 /* A large prime */ );
-
-    // Populate the m_memberToGroup map
-    for( QMap<QString,StringSet>::Iterator groupToMemberIt= groupToMemberMap.begin()
-         ; groupToMemberIt != groupToMemberMap.end()
-         ; ++groupToMemberIt )
-    {
-        StringSet members = groupToMemberIt.value();
-        QString group = groupToMemberIt.key();
-
-        Q_FOREACH( const auto &member, members ) {
-            m_memberToGroup[member].append( group );
-        }
-        m_groupCount.insert( group, 0 );
-    }
+    const int count = m_graph.count();
+    m_groupsOf.resize( count );
+    m_expanded.resize( count );
+    m_groupCount.fill( 0, count );
+    m_lastCounted.fill( 0, count );
 }
 
 /**
@@ -77,29 +65,23 @@ GroupCounter::GroupCounter( const QString& category )
  * category in question is Places.
  * This function then increases m_groupCount with 1 for each of the groups the relavant items belongs to
  * Las Vegas might increase the m_groupCount[Nevada] by one.
- * The tricky part is to avoid increasing it by more than 1 per image, that is what the countedGroupDict is
- * used for.
+ * The tricky part is to avoid increasing it by more than 1 per image, that is what m_lastCounted is
+ * used for: it holds the serial number of the last image that was counted for each group.
  */
 void GroupCounter::count( const StringSet& categories )
 {
-    static StringSet countedGroupDict;
-
-    countedGroupDict.clear();
+    ++m_serial;
     for( StringSet::const_iterator categoryIt = categories.begin(); categoryIt != categories.end(); ++categoryIt ) {
-        if ( m_memberToGroup.contains(*categoryIt)) {
-            const QStringList groups = m_memberToGroup[*categoryIt];
-            for ( const QString& group : groups ) {
-                if ( !countedGroupDict.contains( group ) ) {
-                    countedGroupDict.insert( group );
-                    (m_groupCount[group])++;
-                }
+        const int id = m_graph.id( *categoryIt );
+        if ( id == -1 )
+            continue;
+
+        for ( int group : groupsOf( id ) ) {
+            if ( m_lastCounted[group] != m_serial ) {
+                m_lastCounted[group] = m_serial;
+                ++m_groupCount[group];
             }
         }
-        // The item Nevada should itself go into the group Nevada.
-        if ( !countedGroupDict.contains( *categoryIt ) && m_groupCount.contains( *categoryIt ) ) {
-             countedGroupDict.insert( *categoryIt);
-             (m_groupCount[*categoryIt])++;
-        }
     }
 }
 
@@ -107,10 +89,27 @@ QMap<QString,uint> GroupCounter::result()
 {
     QMap<QString,uint> res;
 
-    for( QHash<QString,uint>::const_iterator it = m_groupCount.constBegin(); it != m_groupCount.constEnd(); ++it) {
-        if ( it.value() != 0 )
-            res.insert( it.key(), it.value() );
+    for ( int id = 0; id < m_groupCount.count(); ++id ) {
+        if ( m_groupCount[id] != 0 )
+            res.insert( m_graph.name( id ), m_groupCount[id] );
     }
     return res;
 }
+
+const QVector<int>& GroupCounter::groupsOf( int id )
+{
+    if ( !m_expanded.testBit( id ) ) {
+        QVector<int>& groups = m_groupsOf[id];
+        // The item Nevada should itself go into the group Nevada.
+        if ( m_graph.isGroup( id ) )
+            groups.append( id );
+        const QBitArray& bits = m_graph.groups( id );
+        for ( int group = 0; group < bits.size(); ++group ) {
+            if ( bits.testBit( group ) )
+                groups.append( group );
+        }
+        m_expanded.setBit( id );
+    }
+    return m_groupsOf[id];
+}
 // vi:expandtab:tabstop=4 shiftwidth=4:
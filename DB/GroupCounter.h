@@ -19,7 +19,9 @@
 #ifndef GROUPCOUNTER_H
 #define GROUPCOUNTER_H
 #include "Settings/SettingsData.h"
-#include <QHash>
+#include "DB/GroupGraph.h"
+#include <QBitArray>
+#include <QVector>
 
 namespace DB
 {
@@ -33,9 +35,14 @@ public:
     QMap<QString,uint> result();
 
 private:
-    QHash<QString,QStringList> m_memberToGroup;
-    QHash<QString,uint> m_groupCount;
-
+    const QVector<int>& groupsOf( int id );
+
+    const GroupGraph& m_graph;
+    QVector< QVector<int> > m_groupsOf;
+    QBitArray m_expanded;
+    QVector<uint> m_groupCount;
+    QVector<int> m_lastCounted;
+    int m_serial;
 };
 
 }
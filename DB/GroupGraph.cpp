@@ -0,0 +1,214 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "GroupGraph.h"
+
+using namespace DB;
+
+void DB::GroupGraph::build( const QMap<QString,StringSet>& groupToMembers )
+{
+    m_ids.clear();
+    m_names.clear();
+    m_isGroup.clear();
+    m_directMembers.clear();
+    m_members.clear();
+    m_groups.clear();
+
+    for( QMap<QString,StringSet>::ConstIterator groupIt = groupToMembers.constBegin(); groupIt != groupToMembers.constEnd(); ++groupIt ) {
+        const int group = intern( groupIt.key() );
+        setBit( m_isGroup, group );
+        for( StringSet::const_iterator memberIt = groupIt.value().begin(); memberIt != groupIt.value().end(); ++memberIt )
+            setBit( m_directMembers[group], intern( *memberIt ) );
+    }
+
+    QBitArray done( count() );
+    for ( int id = 0; id < count(); ++id ) {
+        if ( !done.testBit( id ) )
+            computeMembers( id, done, nullptr );
+    }
+
+    // The groups of a tag are the transposition of the members of a group.
+    for ( int group = 0; group < count(); ++group ) {
+        const QBitArray& members = m_members[group];
+        for ( int member = 0; member < members.size(); ++member ) {
+            if ( members.testBit( member ) )
+                setBit( m_groups[member], group );
+        }
+    }
+}
+
+void DB::GroupGraph::addGroup( const QString& group )
+{
+    setBit( m_isGroup, intern( group ) );
+}
+
+/**
+ * Every group containing group (including group itself) gains item and all of its members,
+ * and item and all of its members gain those groups.
+ * The caller is responsible for not creating cycles.
+ */
+void DB::GroupGraph::addMember( const QString& group, const QString& item )
+{
+    const int groupId = intern( group );
+    const int itemId = intern( item );
+    setBit( m_isGroup, groupId );
+    setBit( m_directMembers[groupId], itemId );
+
+    QBitArray ancestors = m_groups[groupId];
+    setBit( ancestors, groupId );
+    QBitArray descendants = m_members[itemId];
+    setBit( descendants, itemId );
+
+    for ( int id = 0; id < ancestors.size(); ++id ) {
+        if ( ancestors.testBit( id ) )
+            m_members[id] |= descendants;
+    }
+    for ( int id = 0; id < descendants.size(); ++id ) {
+        if ( descendants.testBit( id ) )
+            m_groups[id] |= ancestors;
+    }
+}
+
+/**
+ * Removing an edge can't be done by clearing bits, as there may be other paths from a group to the item.
+ * Instead the members of group and of all groups containing it are computed anew from their direct members.
+ * Only the pairs of those groups and the former members of item can have changed in the inverse direction.
+ */
+void DB::GroupGraph::removeMember( const QString& group, const QString& item )
+{
+    const int groupId = id( group );
+    const int itemId = id( item );
+    if ( groupId == -1 || itemId == -1 || !contains( m_directMembers[groupId], itemId ) )
+        return;
+
+    m_directMembers[groupId].clearBit( itemId );
+
+    QBitArray ancestors = m_groups[groupId];
+    setBit( ancestors, groupId );
+    QBitArray descendants = m_members[itemId];
+    setBit( descendants, itemId );
+
+    QBitArray done( count() );
+    for ( int id = 0; id < ancestors.size(); ++id ) {
+        if ( ancestors.testBit( id ) && !done.testBit( id ) )
+            computeMembers( id, done, &ancestors );
+    }
+
+    for ( int ancestor = 0; ancestor < ancestors.size(); ++ancestor ) {
+        if ( !ancestors.testBit( ancestor ) )
+            continue;
+        for ( int descendant = 0; descendant < descendants.size(); ++descendant ) {
+            if ( !descendants.testBit( descendant ) )
+                continue;
+            if ( contains( m_members[ancestor], descendant ) )
+                setBit( m_groups[descendant], ancestor );
+            else if ( ancestor < m_groups[descendant].size() )
+                m_groups[descendant].clearBit( ancestor );
+        }
+    }
+}
+
+int DB::GroupGraph::count() const
+{
+    return m_names.count();
+}
+
+int DB::GroupGraph::id( const QString& name ) const
+{
+    return m_ids.value( name, -1 );
+}
+
+QString DB::GroupGraph::name( int id ) const
+{
+    return m_names[id];
+}
+
+QStringList DB::GroupGraph::names( const QBitArray& ids ) const
+{
+    QStringList result;
+    for ( int id = 0; id < ids.size(); ++id ) {
+        if ( ids.testBit( id ) )
+            result.append( m_names[id] );
+    }
+    return result;
+}
+
+bool DB::GroupGraph::isGroup( int id ) const
+{
+    return contains( m_isGroup, id );
+}
+
+const QBitArray& DB::GroupGraph::members( int id ) const
+{
+    return m_members[id];
+}
+
+const QBitArray& DB::GroupGraph::groups( int id ) const
+{
+    return m_groups[id];
+}
+
+bool DB::GroupGraph::contains( const QBitArray& ids, int id )
+{
+    return id >= 0 && id < ids.size() && ids.testBit( id );
+}
+
+int DB::GroupGraph::intern( const QString& name )
+{
+    QHash<QString,int>::const_iterator it = m_ids.constFind( name );
+    if ( it != m_ids.constEnd() )
+        return it.value();
+
+    const int id = m_names.count();
+    m_ids.insert( name, id );
+    m_names.append( name );
+    m_directMembers.append( QBitArray() );
+    m_members.append( QBitArray() );
+    m_groups.append( QBitArray() );
+    return id;
+}
+
+void DB::GroupGraph::setBit( QBitArray& ids, int id ) const
+{
+    if ( id >= ids.size() )
+        ids.resize( count() );
+    ids.setBit( id );
+}
+
+/**
+ * Computes the members of the group with the given id as the union of its direct members and their members.
+ * If scope is given, only the members of groups in scope are computed anew, the others are taken as they are.
+ * The done bit is set before recursing, so a cycle in a database that was loaded with one can't hang us.
+ */
+void DB::GroupGraph::computeMembers( int id, QBitArray& done, const QBitArray* scope )
+{
+    done.setBit( id );
+    QBitArray result;
+    const QBitArray& directMembers = m_directMembers[id];
+    for ( int member = 0; member < directMembers.size(); ++member ) {
+        if ( !directMembers.testBit( member ) )
+            continue;
+        if ( !done.testBit( member ) && ( !scope || contains( *scope, member ) ) )
+            computeMembers( member, done, scope );
+        result |= m_members[member];
+        setBit( result, member );
+    }
+    m_members[id] = result;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
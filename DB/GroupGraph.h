@@ -0,0 +1,85 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef DB_GROUPGRAPH_H
+#define DB_GROUPGRAPH_H
+
+#include "Utilities/Set.h"
+
+#include <QBitArray>
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+namespace DB {
+
+using Utilities::StringSet;
+
+/**
+ * @brief The GroupGraph class holds the member groups of one category as a directed acyclic graph over tag ids.
+ *
+ * Every tag that is a group or a member of a group gets an id. Besides the direct members of each group,
+ * the graph stores the transitive closure in both directions as bitsets indexed by id:
+ * all members of a group (members()) and all groups a tag belongs to (groups()).
+ *
+ * The graph is owned by MemberMap, which rebuilds it with build() and keeps it up to date using
+ * addGroup(), addMember() and removeMember() in between.
+ *
+ * Bitsets are not resized when new tags are added, so bits beyond their size count as cleared;
+ * use contains() rather than QBitArray::testBit().
+ */
+class GroupGraph
+{
+public:
+    void build( const QMap<QString,StringSet>& groupToMembers );
+    void addGroup( const QString& group );
+    void addMember( const QString& group, const QString& item );
+    void removeMember( const QString& group, const QString& item );
+
+    /** @return the number of tags in the graph. */
+    int count() const;
+    /** @return the id of the tag, or -1 if it is neither a group nor a member of a group. */
+    int id( const QString& name ) const;
+    QString name( int id ) const;
+    QStringList names( const QBitArray& ids ) const;
+    bool isGroup( int id ) const;
+    /** @return the ids of all members of the group with the given id, members of subgroups included. */
+    const QBitArray& members( int id ) const;
+    /** @return the ids of all groups the tag with the given id belongs to, directly or through subgroups. */
+    const QBitArray& groups( int id ) const;
+
+    static bool contains( const QBitArray& ids, int id );
+
+private:
+    int intern( const QString& name );
+    void setBit( QBitArray& ids, int id ) const;
+    void computeMembers( int id, QBitArray& done, const QBitArray* scope );
+
+    QHash<QString,int> m_ids;
+    QStringList m_names;
+    QBitArray m_isGroup;
+    QVector<QBitArray> m_directMembers;
+    QVector<QBitArray> m_members;
+    QVector<QBitArray> m_groups;
+};
+
+}
+
+#endif /* DB_GROUPGRAPH_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -40,6 +40,23 @@ ImageDB* DB::ImageDB::instance()
     return s_instance;
 }
 
+int ImageDB::s_writers = 0;
+
+ImageDB::WriteGuard::WriteGuard()
+{
+    ++s_writers;
+}
+
+ImageDB::WriteGuard::~WriteGuard()
+{
+    --s_writers;
+}
+
+bool ImageDB::isWriting()
+{
+    return s_writers > 0;
+}
+
 void ImageDB::setupXMLDB( const QString& configFile )
 {
     if (s_instance)
@@ -96,6 +113,24 @@ void ImageDB::slotRescan()
     emit totalChanged( totalCount() );
 }
 
+void ImageDB::slotFullRescan()
+{
+    bool newImages = NewImageFinder().findImages( NewImageFinder::FullScan );
+    if ( newImages )
+        markDirty();
+
+    emit totalChanged( totalCount() );
+}
+
+void ImageDB::slotRescanDirectories( const QStringList& directories )
+{
+    bool newImages = NewImageFinder().findImages( directories );
+    if ( newImages )
+        markDirty();
+
+    emit totalChanged( totalCount() );
+}
+
 void ImageDB::slotRecalcCheckSums(const DB::FileNameList& inputList)
 {
     DB::FileNameList list = inputList;
@@ -104,6 +139,7 @@ void ImageDB::slotRecalcCheckSums(const DB::FileNameList& inputList)
         md5Map()->clear();
     }
 
+    WriteGuard guard;
     bool d = NewImageFinder().calculateMD5sums( list, md5Map() );
     if ( d )
         markDirty();
@@ -23,6 +23,7 @@
 #include "DB/ImageInfoList.h"
 #include "DB/MediaCount.h"
 #include <DB/FileNameList.h>
+#include <QStringList>
 
 class QProgressBar;
 
@@ -47,10 +48,27 @@ public:
 
     DB::FileNameSet imagesWithMD5Changed();
 
+    /**
+     * @brief A WriteGuard marks a change to the database that is done in several steps, processing events
+     * in between, like importing a .kim file or searching for new images.
+     * Automatic rescans must wait until no such change is in progress, see \ref isWriting.
+     */
+    class WriteGuard
+    {
+    public:
+        WriteGuard();
+        ~WriteGuard();
+    private:
+        Q_DISABLE_COPY( WriteGuard )
+    };
+    static bool isWriting();
+
 public slots:
     void setDateRange( const ImageDate&, bool includeFuzzyCounts );
     void clearDateRange();
     virtual void slotRescan();
+    virtual void slotFullRescan();
+    virtual void slotRescanDirectories( const QStringList& directories );
     void slotRecalcCheckSums(const DB::FileNameList& selection);
     virtual MediaCount count( const ImageSearchInfo& info );
     virtual void slotReread( const DB::FileNameList& list, DB::ExifMode mode);
@@ -63,6 +81,7 @@ protected:
 private:
     static void connectSlots();
     static ImageDB* s_instance;
+    static int s_writers;
 
 protected:
     ImageDB();
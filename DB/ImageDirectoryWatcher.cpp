@@ -0,0 +1,228 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ImageDirectoryWatcher.h"
+
+#include "DB/DirectorySnapshot.h"
+#include "DB/FileName.h"
+#include "DB/ImageDB.h"
+#include "Settings/SettingsData.h"
+#include "Utilities/Util.h"
+
+#include <KDirWatch>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTimer>
+
+namespace {
+// the time to wait for further changes before the changed directories are searched:
+constexpr int RESCAN_DELAY_MS = 2000;
+// the interval of the periodic search if the image directory has too many directories to be watched:
+constexpr int POLL_INTERVAL_MS = 5 * 60 * 1000;
+
+// The files KPhotoAlbum writes into the image directory, relative to it.
+// Entries ending with a slash are directories, the others are prefixes of file names in the image directory,
+// so that backups and temporary files are covered as well.
+const char* const OWN_FILES[] = { ".thumbnails/", ".videoThumbnails/", "index.xml", ".#index.xml", "exif-info.db", ".directorysnapshot" };
+}
+
+DB::ImageDirectoryWatcher::ImageDirectoryWatcher( QObject* parent )
+    : QObject( parent )
+    , m_watch( nullptr )
+    , m_timer( new QTimer( this ) )
+    , m_pollTimer( new QTimer( this ) )
+{
+    m_timer->setSingleShot( true );
+    m_timer->setInterval( RESCAN_DELAY_MS );
+    connect( m_timer, SIGNAL(timeout()), this, SLOT(rescanPendingDirectories()) );
+
+    m_pollTimer->setInterval( POLL_INTERVAL_MS );
+    connect( m_pollTimer, SIGNAL(timeout()), this, SLOT(poll()) );
+}
+
+void DB::ImageDirectoryWatcher::setEnabled( bool enabled )
+{
+    if ( enabled == ( m_watch != nullptr || m_pollTimer->isActive() ) )
+        return;
+
+    if ( !enabled ) {
+        delete m_watch;
+        m_watch = nullptr;
+        m_pollTimer->stop();
+        m_timer->stop();
+        m_pendingDirectories.clear();
+        return;
+    }
+
+    m_imageDirectory = Utilities::stripEndingForwardSlash( Settings::SettingsData::instance()->imageDirectory() );
+    m_canonicalImageDirectory = QFileInfo( m_imageDirectory ).canonicalFilePath();
+
+    if ( hasTooManyDirectories() ) {
+        qWarning( "The image directory has too many directories to watch them all, searching it for new files every %d minutes instead.",
+                  POLL_INTERVAL_MS / 60000 );
+        m_pollTimer->start();
+        return;
+    }
+
+    m_watch = new KDirWatch( this );
+    connect( m_watch, SIGNAL(created(QString)), this, SLOT(pathCreated(QString)) );
+    connect( m_watch, SIGNAL(dirty(QString)), this, SLOT(pathDirty(QString)) );
+    m_watch->addDir( m_imageDirectory, KDirWatch::WatchFiles | KDirWatch::WatchSubDirs );
+}
+
+void DB::ImageDirectoryWatcher::pathCreated( const QString& path )
+{
+    pathChanged( path, true );
+}
+
+void DB::ImageDirectoryWatcher::pathDirty( const QString& path )
+{
+    pathChanged( path, false );
+}
+
+void DB::ImageDirectoryWatcher::pathChanged( const QString& changedPath, bool created )
+{
+    const QString path = toImageDirectoryPath( changedPath );
+    if ( path.isNull() || isExcluded( path ) || isOwnFile( path ) )
+        return;
+
+    QFileInfo fi( path );
+    if ( !fi.exists() )
+        return; // deleted files are not removed from the database
+
+    QString directory;
+    if ( fi.isDir() ) {
+        // A directory is dirty whenever anything within it changes, including the files we write ourselves.
+        // With inotify, new files are reported on their own, so only new directories are of interest.
+        if ( !created && m_watch->internalMethod() == KDirWatch::INotify )
+            return;
+        directory = path;
+    }
+    else {
+        const DB::FileName fileName = DB::FileName::fromAbsolutePath( path );
+        if ( !Utilities::canReadImage( fileName ) && !Utilities::isVideo( fileName ) )
+            return;
+        directory = path.left( path.lastIndexOf( QChar::fromLatin1('/') ) );
+    }
+
+    m_pendingDirectories.insert( directory );
+    m_timer->start();
+}
+
+void DB::ImageDirectoryWatcher::poll()
+{
+    m_pendingDirectories.insert( m_imageDirectory );
+    rescanPendingDirectories();
+}
+
+void DB::ImageDirectoryWatcher::rescanPendingDirectories()
+{
+    // Searching while the database is changed in several steps could add the same files twice,
+    // e.g. the files an import is just copying. The search processes events, so the timer may even
+    // fire while another search is running.
+    if ( DB::ImageDB::isWriting() ) {
+        m_timer->start();
+        return;
+    }
+
+    if ( m_pendingDirectories.isEmpty() )
+        return;
+
+    const QStringList directories = m_pendingDirectories.toList();
+    m_pendingDirectories.clear();
+    DB::ImageDB::instance()->slotRescanDirectories( directories );
+}
+
+/**
+ * Returns the path as it is below the image directory, or a null string if it isn't below the image directory.
+ * The watch may report paths through symlinks, so they are compared by their canonical path if they don't match
+ * as they are.
+ */
+QString DB::ImageDirectoryWatcher::toImageDirectoryPath( const QString& path ) const
+{
+    const QString stripped = Utilities::stripEndingForwardSlash( path );
+    if ( stripped == m_imageDirectory || stripped.startsWith( m_imageDirectory + QString::fromLatin1("/") ) )
+        return stripped;
+
+    const QString canonical = QFileInfo( stripped ).canonicalFilePath();
+    if ( canonical.isEmpty() || m_canonicalImageDirectory.isEmpty() )
+        return QString();
+    if ( canonical == m_canonicalImageDirectory || canonical.startsWith( m_canonicalImageDirectory + QString::fromLatin1("/") ) )
+        return m_imageDirectory + canonical.mid( m_canonicalImageDirectory.length() );
+    return QString();
+}
+
+bool DB::ImageDirectoryWatcher::isExcluded( const QString& path ) const
+{
+    const QStringList excluded = Settings::SettingsData::instance()->excludeDirectories().split( QString::fromLatin1(",") );
+    const QStringList components = path.mid( m_imageDirectory.length() ).split( QString::fromLatin1("/"), QString::SkipEmptyParts );
+    for ( const QString& component : components ) {
+        if ( excluded.contains( component ) || component == QString::fromLatin1("CategoryImages") )
+            return true;
+    }
+    return false;
+}
+
+bool DB::ImageDirectoryWatcher::isOwnFile( const QString& path ) const
+{
+    const QString relativePath = path.mid( m_imageDirectory.length() + 1 );
+    for ( const char* ownFile : OWN_FILES ) {
+        const QString name = QString::fromLatin1( ownFile );
+        if ( name.endsWith( QChar::fromLatin1('/') ) ) {
+            if ( relativePath.startsWith( name ) || relativePath == name.left( name.length() - 1 ) )
+                return true;
+        }
+        else if ( relativePath.startsWith( name ) && !relativePath.contains( QChar::fromLatin1('/') ) )
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Returns true if watching the image directory would take more than half of the inotify watches.
+ * The number of directories is taken from the DirectorySnapshot if there is one, otherwise they are counted.
+ */
+bool DB::ImageDirectoryWatcher::hasTooManyDirectories() const
+{
+    QFile file( QString::fromLatin1( "/proc/sys/fs/inotify/max_user_watches" ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false; // no inotify, KDirWatch uses whatever else is available
+
+    bool ok;
+    const int maxWatches = QString::fromLatin1( file.readAll().constData() ).trimmed().toInt( &ok );
+    if ( !ok )
+        return false;
+    const int budget = maxWatches / 2;
+
+    DB::DirectorySnapshot snapshot;
+    snapshot.load();
+    if ( snapshot.count() > 0 )
+        return snapshot.count() > budget;
+
+    int count = 0;
+    QDirIterator it( m_imageDirectory, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories );
+    while ( it.hasNext() && count <= budget ) {
+        it.next();
+        ++count;
+    }
+    return count > budget;
+}
+
+#include "ImageDirectoryWatcher.moc"
+// vi:expandtab:tabstop=4 shiftwidth=4:
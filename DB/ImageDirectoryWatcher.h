@@ -0,0 +1,79 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef IMAGEDIRECTORYWATCHER_H
+#define IMAGEDIRECTORYWATCHER_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class KDirWatch;
+class QTimer;
+
+namespace DB
+{
+
+/**
+ * @brief The ImageDirectoryWatcher class watches the image directory for changes,
+ * and searches changed directories for new files.
+ *
+ * Changes are collected for a short while before the search is started, so that copying
+ * a whole directory of images only results in a single search.
+ * Deleted files are not removed from the database; they are just reported as missing as usual.
+ * The files KPhotoAlbum writes into the image directory itself (index.xml, thumbnails, ...) are ignored.
+ *
+ * Watching a directory tree costs one inotify watch per directory. If the tree has more directories
+ * than we may use watches for, the whole image directory is searched periodically instead, which is cheap
+ * thanks to the DirectorySnapshot.
+ */
+class ImageDirectoryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageDirectoryWatcher( QObject* parent = nullptr );
+
+public slots:
+    void setEnabled( bool enabled );
+
+private slots:
+    void pathCreated( const QString& path );
+    void pathDirty( const QString& path );
+    void poll();
+    void rescanPendingDirectories();
+
+private:
+    void pathChanged( const QString& path, bool created );
+    QString toImageDirectoryPath( const QString& path ) const;
+    bool isExcluded( const QString& path ) const;
+    bool isOwnFile( const QString& path ) const;
+    bool hasTooManyDirectories() const;
+
+    KDirWatch* m_watch;
+    QTimer* m_timer;
+    QTimer* m_pollTimer;
+    QString m_imageDirectory;
+    QString m_canonicalImageDirectory;
+    QSet<QString> m_pendingDirectories;
+};
+
+}
+
+#endif /* IMAGEDIRECTORYWATCHER_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
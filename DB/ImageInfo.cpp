@@ -61,6 +61,28 @@ ImageInfo::ImageInfo( const DB::FileName& fileName, MediaType type, bool readExi
     m_delaySaving = false;
 }
 
+ImageInfo::ImageInfo( const DB::FileName& fileName, MediaType type, const MD5& md5sum, const DB::FileInfo& exifInfo )
+    :  m_imageOnDisk( YesOnDisk ), m_null( false ), m_size( -1, -1 ), m_type( type )
+      , m_rating(-1), m_stackId(0), m_stackOrder(0)
+      , m_videoLength(-1)
+      , m_locked(false), m_delaySaving( true )
+{
+    QFileInfo fi( fileName.absolute() );
+    m_label = fi.completeBaseName();
+    m_angle = 0;
+    m_md5sum = md5sum;
+
+    setFileName(fileName);
+
+    // the caller is responsible for adding the exif data to the exif database:
+    ExifMode mode = EXIFMODE_INIT;
+    mode &= ~EXIFMODE_DATABASE_UPDATE;
+    readExif(fileName, mode, exifInfo);
+
+    m_dirty = false;
+    m_delaySaving = false;
+}
+
 /** Change delaying of saving changes.
  *
  * Will save changes when set to false.
@@ -418,8 +440,11 @@ bool ImageInfo::isLocked() const
 
 void ImageInfo::readExif(const DB::FileName& fullPath, DB::ExifMode mode)
 {
-    DB::FileInfo exifInfo = DB::FileInfo::read( fullPath, mode );
+    readExif( fullPath, mode, DB::FileInfo::read( fullPath, mode ) );
+}
 
+void ImageInfo::readExif(const DB::FileName& fullPath, DB::ExifMode mode, const DB::FileInfo& exifInfo)
+{
     bool oldDelaySaving = m_delaySaving;
     delaySavingChanges(true);
 
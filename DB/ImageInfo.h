@@ -57,6 +57,7 @@ enum RotationMode {
 };
 
 using Utilities::StringSet;
+class FileInfo;
 class MemberMap;
 
 enum MediaType { Image = 0x01, Video = 0x02 };
@@ -68,6 +69,11 @@ class ImageInfo :public KShared {
 public:
     ImageInfo();
     explicit ImageInfo( const DB::FileName& fileName, MediaType type = Image, bool readExifInfo = true );
+    /**
+     * @brief ImageInfo creates the info for a new file from a checksum and exif information that have already been read.
+     * Unlike ImageInfo(fileName,type), this neither reads the file nor updates the exif database.
+     */
+    ImageInfo( const DB::FileName& fileName, MediaType type, const MD5& md5sum, const DB::FileInfo& exifInfo );
     ImageInfo( const DB::FileName& fileName,
                const QString& label,
                const QString& description,
@@ -94,6 +100,7 @@ public:
     ImageDate date() const;
     ImageDate& date();
     void readExif(const DB::FileName& fullPath, DB::ExifMode mode);
+    void readExif(const DB::FileName& fullPath, DB::ExifMode mode, const DB::FileInfo& exifInfo);
 
     void rotate( int degrees, RotationMode mode=RotateImageInfoAndAreas );
     int angle() const;
@@ -0,0 +1,219 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "MD5Calculator.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QString>
+
+#include <kmd5.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+// big enough to keep the number of syscalls low, small enough to keep the memory footprint per thread low:
+constexpr size_t READ_BLOCK_SIZE = 1024 * 1024;
+constexpr size_t READ_BLOCK_ALIGNMENT = 4096;
+}
+
+/**
+ * @brief The Worker class hashes files from the queues of the MD5Calculator until there are none left.
+ */
+class DB::MD5Calculator::Worker : public QRunnable
+{
+public:
+    explicit Worker( MD5Calculator* calculator ) : m_calculator( calculator ) {}
+
+    void run() override
+    {
+        DB::FileName fileName;
+        DeviceId device;
+        while ( m_calculator->takeNextFile( fileName, device ) ) {
+            m_calculator->fileDone( fileName, m_calculator->calculateMD5( fileName ), device );
+        }
+    }
+
+private:
+    MD5Calculator* m_calculator;
+};
+
+DB::MD5Calculator::MD5Calculator( int maxReadsPerDevice )
+    : m_maxReadsPerDevice( qMax(1, maxReadsPerDevice) )
+    , m_queue( m_maxReadsPerDevice )
+    , m_pending( 0 )
+    , m_canceled( 0 )
+{
+}
+
+DB::MD5Calculator::~MD5Calculator()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void DB::MD5Calculator::calculate( const DB::FileNameList& list )
+{
+    // Files in the same directory are virtually always on the same device,
+    // so only one stat() per directory is needed:
+    QHash<QString, DeviceId> deviceForDirectory;
+    QHash<DeviceId, QList<DB::FileName> > queues;
+    for ( const DB::FileName& fileName : list ) {
+        const QString directory = QFileInfo( fileName.absolute() ).path();
+        auto it = deviceForDirectory.constFind( directory );
+        if ( it == deviceForDirectory.constEnd() ) {
+            struct stat buf;
+            const DeviceId device = ::stat( QFile::encodeName( directory ).constData(), &buf ) == 0 ? buf.st_dev : 0;
+            it = deviceForDirectory.insert( directory, device );
+        }
+        queues[*it].append( fileName );
+    }
+
+    int workerCount = 0;
+    {
+        QMutexLocker locker( &m_mutex );
+        m_canceled = 0;
+        for ( auto it = queues.constBegin(); it != queues.constEnd(); ++it )
+            m_queue.enqueue( it.key(), *it );
+        m_pending += list.size();
+        workerCount = qMin( m_pool.maxThreadCount(), m_queue.deviceCount() * m_maxReadsPerDevice );
+        m_fileAvailable.wakeAll();
+    }
+
+    // Workers exit when the queues are empty, so there is no harm in starting more than currently needed:
+    for ( int i = m_pool.activeThreadCount(); i < workerCount; ++i )
+        m_pool.start( new Worker( this ) );
+}
+
+void DB::MD5Calculator::cancel()
+{
+    QMutexLocker locker( &m_mutex );
+    m_canceled = 1;
+    m_pending -= m_queue.clear().size();
+    m_results.clear();
+    m_fileAvailable.wakeAll();
+    m_resultAvailable.wakeAll();
+}
+
+bool DB::MD5Calculator::isCanceled() const
+{
+    return m_canceled != 0;
+}
+
+bool DB::MD5Calculator::isFinished() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_pending == 0 && m_results.isEmpty();
+}
+
+void DB::MD5Calculator::waitForResults( int msecs )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_results.isEmpty() && m_pending > 0 )
+        m_resultAvailable.wait( &m_mutex, msecs );
+}
+
+QList<DB::MD5Calculator::Result> DB::MD5Calculator::takeResults()
+{
+    QMutexLocker locker( &m_mutex );
+    QList<Result> results;
+    results.swap( m_results );
+    return results;
+}
+
+bool DB::MD5Calculator::takeNextFile( DB::FileName& fileName, DeviceId& device )
+{
+    QMutexLocker locker( &m_mutex );
+    forever {
+        if ( isCanceled() || m_queue.isEmpty() )
+            return false;
+
+        if ( m_queue.take( fileName, device ) )
+            return true;
+
+        // all devices with pending files are busy:
+        m_fileAvailable.wait( &m_mutex );
+    }
+}
+
+void DB::MD5Calculator::fileDone( const DB::FileName& fileName, const DB::MD5& md5, DeviceId device )
+{
+    QMutexLocker locker( &m_mutex );
+    m_queue.done( device );
+    --m_pending;
+    if ( !isCanceled() )
+        m_results.append( qMakePair( fileName, md5 ) );
+    m_fileAvailable.wakeOne();
+    m_resultAvailable.wakeAll();
+}
+
+DB::MD5 DB::MD5Calculator::calculateMD5( const DB::FileName& fileName ) const
+{
+    const int fd = ::open( QFile::encodeName( fileName.absolute() ).constData(), O_RDONLY );
+    if ( fd < 0 )
+        return DB::MD5();
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    (void) posix_fadvise( fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+#endif
+
+    void* buffer = nullptr;
+    if ( posix_memalign( &buffer, READ_BLOCK_ALIGNMENT, READ_BLOCK_SIZE ) != 0 ) {
+        ::close( fd );
+        return DB::MD5();
+    }
+
+    KMD5 md5calculator;
+    bool ok = true;
+    forever {
+        const ssize_t count = ::read( fd, buffer, READ_BLOCK_SIZE );
+        if ( count == 0 )
+            break;
+        if ( count < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            ok = false;
+            break;
+        }
+        md5calculator.update( static_cast<const char*>( buffer ), static_cast<int>( count ) );
+        if ( isCanceled() ) {
+            ok = false;
+            break;
+        }
+    }
+
+#ifdef POSIX_FADV_DONTNEED
+    // The data is not needed anymore, so don't let a full library scan evict everything else from the page cache:
+    (void) posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+#endif
+    ::close( fd );
+    free( buffer );
+
+    if ( !ok )
+        return DB::MD5();
+    return DB::MD5( QString::fromLatin1( md5calculator.hexDigest() ) );
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,105 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef MD5CALCULATOR_H
+#define MD5CALCULATOR_H
+
+#include "DeviceQueue.h"
+#include "MD5.h"
+#include "FileName.h"
+#include "FileNameList.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace DB
+{
+
+/**
+ * @brief The MD5Calculator class computes the MD5 sums of many files on a pool of worker threads.
+ *
+ * Files are grouped by the device they are stored on, and each device is read by at most
+ * maxReadsPerDevice threads at a time. This keeps rotating disks from seeking back and forth,
+ * while files on different devices are still read concurrently.
+ * Each file is read sequentially in large page-aligned blocks, and the kernel is told about the access pattern.
+ * The checksums are identical to the ones computed by Utilities::MD5Sum().
+ *
+ * Results can be fetched while the calculation is still running:
+ * \code
+ * DB::MD5Calculator calculator;
+ * calculator.calculate( list );
+ * while ( !calculator.isFinished() ) {
+ *     calculator.waitForResults( 100 );
+ *     for ( const DB::MD5Calculator::Result& result : calculator.takeResults() )
+ *         ...
+ * }
+ * \endcode
+ * Files that could not be read are reported with a null MD5.
+ */
+class MD5Calculator
+{
+public:
+    typedef QPair<DB::FileName, DB::MD5> Result;
+
+    explicit MD5Calculator( int maxReadsPerDevice = 2 );
+    ~MD5Calculator();
+
+    void calculate( const DB::FileNameList& list );
+    /**
+     * @brief cancel stops the calculation as soon as possible.
+     * Files that are currently being read are aborted, and results that have not been taken yet are discarded.
+     */
+    void cancel();
+    bool isCanceled() const;
+    /**
+     * @return true, if all files have been processed and all results have been taken.
+     */
+    bool isFinished() const;
+    /**
+     * @brief waitForResults blocks until a result is available or msecs milliseconds have passed.
+     */
+    void waitForResults( int msecs );
+    QList<Result> takeResults();
+
+private:
+    class Worker;
+    typedef quint64 DeviceId;
+
+    bool takeNextFile( DB::FileName& fileName, DeviceId& device );
+    void fileDone( const DB::FileName& fileName, const DB::MD5& md5, DeviceId device );
+    DB::MD5 calculateMD5( const DB::FileName& fileName ) const;
+
+    const int m_maxReadsPerDevice;
+    mutable QMutex m_mutex;
+    QWaitCondition m_fileAvailable;
+    QWaitCondition m_resultAvailable;
+    DeviceQueue<DB::FileName> m_queue;
+    int m_pending;
+    QList<Result> m_results;
+    QAtomicInt m_canceled;
+    QThreadPool m_pool;
+};
+
+}
+
+#endif /* MD5CALCULATOR_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -47,9 +47,11 @@ void MemberMap::deleteGroup( const QString& category, const QString& name )
 QStringList MemberMap::members( const QString& category, const QString& memberGroup, bool closure ) const
 {
     if ( closure ) {
-        if ( m_dirty )
-            calculate();
-        return m_closureMembers[category][memberGroup].toList();
+        const GroupGraph& graph = groupGraph( category );
+        const int id = graph.id( memberGroup );
+        if ( id == -1 )
+            return QStringList();
+        return graph.names( graph.members( id ) );
     }
     else
         return m_members[category][memberGroup].toList();
@@ -89,60 +91,38 @@ bool MemberMap::isGroup( const QString& category, const QString& item ) const
 */
 QMap<QString,StringSet> MemberMap::groupMap( const QString& category ) const
 {
-    if ( m_dirty )
-        calculate();
-
-    return m_closureMembers[category];
+    const GroupGraph& graph = groupGraph( category );
+    QMap<QString,StringSet> result;
+    for ( int id = 0; id < graph.count(); ++id ) {
+        if ( graph.isGroup( id ) )
+            result.insert( graph.name( id ), graph.names( graph.members( id ) ).toSet() );
+    }
+    return result;
 }
 
 /**
-   Calculates the closure for group, that is finds all members for group.
+   Returns the graph of the member groups of category, which holds the closure for every group, that is all members of the group.
    Imagine there is a group called USA, and that this groups has a group inside it called Califonia,
    Califonia consists of members San Fransisco and Los Angeless.
-   This function then maps USA to include Califonia, San Fransisco and Los Angeless.
+   The closure of USA then includes Califonia, San Fransisco and Los Angeless.
 */
-QStringList MemberMap::calculateClosure( QMap<QString,StringSet>& resultSoFar, const QString& category, const QString& group ) const
+const GroupGraph& MemberMap::groupGraph( const QString& category ) const
 {
-    resultSoFar[group] = StringSet(); // Prevent against cykles.
-    StringSet members = m_members[category][group];
-    StringSet result = members;
-    for( StringSet::const_iterator it = members.begin(); it != members.end(); ++it ) {
-        if ( resultSoFar.contains( *it ) ) {
-            result += resultSoFar[*it];
-        }
-        else if ( isGroup(category, *it ) ) {
-            result += calculateClosure( resultSoFar, category, *it ).toSet();
-        }
-    }
-
-    resultSoFar[group] = result;
-    return result.toList();
+    if ( m_dirty )
+        calculate();
+    return m_closures[category];
 }
 
 /**
-   This methods create the map _closureMembers from _members
+   This methods create the map m_closures from m_members
    This is simply to avoid finding the closure each and every time it is needed.
 */
 void MemberMap::calculate() const
 {
-    m_closureMembers.clear();
-    // run through all categories
+    m_closures.clear();
     for( QMap< QString,QMap<QString,StringSet> >::ConstIterator categoryIt= m_members.begin();
          categoryIt != m_members.end(); ++categoryIt ) {
-
-        QString category = categoryIt.key();
-        QMap<QString, StringSet> groupMap = categoryIt.value();
-
-        // Run through each of the groups for the given categories
-        for( QMap<QString,StringSet>::const_iterator groupIt= groupMap.constBegin()
-             ; groupIt != groupMap.constEnd()
-             ; ++groupIt )
-        {
-            QString group = groupIt.key();
-            if ( m_closureMembers[category].find( group ) == m_closureMembers[category].end() ) {
-                (void) calculateClosure( m_closureMembers[category], category, group );
-            }
-        }
+        m_closures[categoryIt.key()].build( categoryIt.value() );
     }
     m_dirty = false;
 }
@@ -168,7 +148,7 @@ void MemberMap::renameGroup( const QString& category, const QString& oldName, co
 }
 
 MemberMap::MemberMap( const MemberMap& other )
-    : QObject( nullptr ), m_members( other.memberMap() ), m_dirty( true ), m_loading( false )
+    : QObject( nullptr ), m_members( other.memberMap() ), m_dirty( other.m_dirty ), m_closures( other.m_closures ), m_loading( false )
 {
 }
 
@@ -210,7 +190,8 @@ MemberMap& MemberMap::operator=( const MemberMap& other )
 {
     if ( this != &other ) {
         m_members = other.memberMap();
-        m_dirty = true;
+        m_dirty = other.m_dirty;
+        m_closures = other.m_closures;
     }
     return *this;
 }
@@ -234,27 +215,8 @@ void MemberMap::addMemberToGroup( const QString& category, const QString& group,
     if (m_loading) {
         m_dirty = true;
     } else if (!m_dirty) {
-        // Update _closureMembers to avoid marking it dirty
-
-        QMap<QString, StringSet>& categoryClosure = m_closureMembers[category];
-
-        categoryClosure[group].insert(item);
-
-        QMap<QString, StringSet>::const_iterator
-            closureOfItem = categoryClosure.constFind(item);
-        const StringSet* closureOfItemPtr(nullptr);
-        if (closureOfItem != categoryClosure.constEnd()) {
-            closureOfItemPtr = &(*closureOfItem);
-            categoryClosure[group] += *closureOfItem;
-        }
-
-        for (QMap<QString, StringSet>::iterator i = categoryClosure.begin();
-             i != categoryClosure.end(); ++i)
-            if ((*i).contains(group)) {
-                (*i).insert(item);
-                if (closureOfItemPtr)
-                    (*i) += *closureOfItemPtr;
-            }
+        // Update the closures to avoid marking them dirty
+        m_closures[category].addMember( group, item );
     }
 
     if ( !m_loading )
@@ -264,9 +226,13 @@ void MemberMap::addMemberToGroup( const QString& category, const QString& group,
 void MemberMap::removeMemberFromGroup( const QString& category, const QString& group, const QString& item )
 {
     Q_ASSERT( m_members.contains(category) );
-    if ( m_members[category].contains( group ) )
+    if ( m_members[category].contains( group ) ) {
         m_members[category][group].remove( item );
-    m_dirty = true;
+        if ( m_loading )
+            m_dirty = true;
+        else if ( !m_dirty )
+            m_closures[category].removeMember( group, item );
+    }
     if ( !m_loading )
         emit dirty();
 }
@@ -275,6 +241,8 @@ void MemberMap::addGroup( const QString& category, const QString& group )
 {
     if ( ! m_members[category].contains( group ) ) {
         m_members[category].insert( group, StringSet() );
+        if ( !m_dirty )
+            m_closures[category].addGroup( group );
     }
     if ( !m_loading )
         emit dirty();
@@ -286,8 +254,8 @@ void MemberMap::renameCategory( const QString& oldName, const QString& newName )
         return;
     m_members[newName] = m_members[oldName];
     m_members.remove(oldName);
-    m_closureMembers[newName] = m_closureMembers[oldName];
-    m_closureMembers.remove(oldName);
+    m_closures[newName] = m_closures[oldName];
+    m_closures.remove(oldName);
     if ( !m_loading )
         emit dirty();
 }
@@ -295,7 +263,7 @@ void MemberMap::renameCategory( const QString& oldName, const QString& newName )
 void MemberMap::deleteCategory(const QString &category)
 {
     m_members.remove(category);
-    m_closureMembers.remove(category);
+    m_closures.remove(category);
     if ( !m_loading )
         emit dirty();
 }
@@ -323,10 +291,9 @@ bool DB::MemberMap::hasPath( const QString& category, const QString& from, const
         // Try to avoid calculate(), which is quite time consuming.
         return false;
     else {
-        // return members(category, from, true).contains(to);
-        if ( m_dirty )
-            calculate();
-        return m_closureMembers[category][from].contains(to);
+        const GroupGraph& graph = groupGraph( category );
+        const int fromId = graph.id( from );
+        return fromId != -1 && GroupGraph::contains( graph.members( fromId ), graph.id( to ) );
     }
 }
 
@@ -22,6 +22,7 @@
 #include <qmap.h>
 #include <qobject.h>
 #include "Utilities/Set.h"
+#include "GroupGraph.h"
 
 namespace DB
 {
@@ -64,9 +65,14 @@ public:
 
     virtual bool hasPath( const QString& category, const QString& from, const QString& to ) const;
 
+    /**
+     * @return the member groups of category with their closures.
+     * The reference stays valid until the member map is modified.
+     */
+    const GroupGraph& groupGraph( const QString& category ) const;
+
 protected:
     void calculate() const;
-    QStringList calculateClosure( QMap<QString,StringSet>& resultSoFar, const QString& category, const QString& group ) const;
 
 public slots:
     virtual void deleteCategory( const QString& category );
@@ -84,8 +90,9 @@ private:
 
     // These are the data structures used to develop closures, they are only
     // needed to speed up the program *SIGNIFICANTLY* ;-)
+    // While m_dirty is false, the graphs are kept up to date incrementally.
     mutable bool m_dirty;
-    mutable QMap<QString, QMap<QString,StringSet> > m_closureMembers;
+    mutable QMap<QString, GroupGraph> m_closures;
 
     bool m_loading;
 };
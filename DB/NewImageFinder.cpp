@@ -17,22 +17,30 @@
 */
 #include "NewImageFinder.h"
 #include "ImageManager/ThumbnailBuilder.h"
-#include "FastDir.h"
+#include "DirectoryCrawler.h"
 #include "ImageManager/ThumbnailCache.h"
 
+#include "DB/FileInfo.h"
 #include "DB/ImageDB.h"
 #include <qfileinfo.h>
+#include <QFile>
 #include <QStringList>
 #include <QProgressDialog>
+#include <QThread>
+#include <QtConcurrentMap>
 #include <klocale.h>
+#include <kmd5.h>
 #include <qapplication.h>
 #include <qeventloop.h>
 #include <kmessagebox.h>
+#include "DB/MD5Calculator.h"
 #include "DB/MD5Map.h"
 
 #include "config-kpa-exiv2.h"
 #ifdef HAVE_EXIV2
 #  include "Exif/Database.h"
+#  include "Exif/Info.h"
+#  include <exiv2/image.hpp>
 #endif
 
 #include "ImageManager/RawImageDecoder.h"
@@ -45,9 +53,131 @@
 #include <BackgroundJobs/SearchForVideosWithoutVideoThumbnailsJob.h>
 #include <QDebug>
 
+#include <algorithm>
+#include <time.h>
+
 using namespace DB;
 
-bool NewImageFinder::findImages()
+namespace {
+/**
+ * @brief The PreparedFile struct holds everything NewImageFinder::loadExtraFiles() needs to read from a new file.
+ * It is filled in by prepareFile() on a worker thread.
+ */
+struct PreparedFile
+{
+    DB::FileName fileName;
+    DB::MediaType type = DB::Image;
+    DB::MD5 md5;
+#ifdef HAVE_EXIV2
+    // the exif data of the file itself, as stored in the exif database:
+    Exiv2::ExifData exifData;
+    bool hasExifData = false;
+    // the exif data used for date, orientation and description, if it comes from another file (e.g. a .thm file):
+    Exiv2::ExifData infoExifData;
+    bool hasInfoFile = false;
+#endif
+};
+
+#ifdef HAVE_EXIV2
+/**
+ * Read the exif data from the mapped file, or from the file itself if it could not be mapped.
+ */
+void readExifData( PreparedFile& file, const uchar* data, qint64 size )
+{
+    try {
+        Exiv2::Image::AutoPtr image = data
+                ? Exiv2::ImageFactory::open( reinterpret_cast<const Exiv2::byte*>( data ), long( size ) )
+                : Exiv2::ImageFactory::open( QFile::encodeName( file.fileName.absolute() ).data() );
+        Q_ASSERT(image.get() != nullptr);
+        image->readMetadata();
+        file.exifData = image->exifData();
+        file.hasExifData = true;
+    }
+    catch (...)
+    {
+        qWarning("Error while reading exif information from %s", qPrintable(file.fileName.absolute()) );
+    }
+
+    const DB::FileName exifInfoFile = Exif::Info::instance()->exifInfoFile( file.fileName );
+    // all prepared files are kept until the last one is read, so don't keep a second copy of the exif data:
+    if ( exifInfoFile != file.fileName ) {
+        file.infoExifData = Exif::Info::instance()->metadata( exifInfoFile ).exif;
+        file.hasInfoFile = true;
+    }
+}
+#endif
+
+/**
+ * @brief prepareFile reads a new file once, and computes its checksum and exif data from the same bytes.
+ * This is run on a worker thread, so it must neither touch the image database nor the settings.
+ * The file is mapped into memory rather than read into a buffer, so the memory used does not depend on
+ * the size of the files. Files which can't be mapped are hashed in chunks, and exiv2 reads them itself.
+ */
+PreparedFile prepareFile( const QPair<DB::FileName, DB::MediaType>& pending )
+{
+    PreparedFile result;
+    result.fileName = pending.first;
+    result.type = pending.second;
+
+    QFile file( result.fileName.absolute() );
+    const uchar* data = nullptr;
+    qint64 size = 0;
+    if ( file.open( QIODevice::ReadOnly ) ) {
+        size = file.size();
+        if ( size > 0 )
+            data = file.map( 0, size );
+    }
+
+    if ( data ) {
+        KMD5 md5calculator( 0 /* char* */ );
+        // KMD5 takes an int length, so feed huge files in pieces:
+        const qint64 chunkSize = 64 * 1024 * 1024;
+        for ( qint64 offset = 0; offset < size; offset += chunkSize )
+            md5calculator.update( reinterpret_cast<const char*>( data + offset ), int( qMin( chunkSize, size - offset ) ) );
+        result.md5 = DB::MD5( QString::fromLatin1( md5calculator.hexDigest() ) );
+    } else {
+        result.md5 = Utilities::MD5Sum( result.fileName );
+    }
+
+#ifdef HAVE_EXIV2
+    readExifData( result, data, size );
+#endif
+    if ( data )
+        file.unmap( const_cast<uchar*>( data ) );
+    return result;
+}
+}
+
+bool NewImageFinder::s_isSearching = false;
+
+bool NewImageFinder::isSearching()
+{
+    return s_isSearching;
+}
+
+bool NewImageFinder::findImages( ScanMode mode )
+{
+    m_scanMode = mode;
+    return findImagesIn( QStringList() << Settings::SettingsData::instance()->imageDirectory(), true );
+}
+
+bool NewImageFinder::findImages( const QStringList& directories )
+{
+    m_scanMode = IncrementalScan;
+    const QString imageDir = Utilities::stripEndingForwardSlash(Settings::SettingsData::instance()->imageDirectory());
+
+    QStringList toSearch;
+    for ( const QString& directory : directories ) {
+        const QString dir = Utilities::stripEndingForwardSlash( directory );
+        if ( dir == imageDir || dir.startsWith( imageDir + QString::fromLatin1("/") ) )
+            toSearch.append( dir );
+    }
+    if ( toSearch.isEmpty() )
+        return false;
+    return findImagesIn( toSearch, false );
+}
+
+bool NewImageFinder::findImagesIn( const QStringList& directories, bool isRootScan )
 {
     // Load the information from the XML file.
     DB::FileNameSet loadedFiles;
@@ -60,9 +190,31 @@ bool NewImageFinder::findImages()
         loadedFiles.insert(fileName);
     }
 
+    DB::ImageDB::WriteGuard guard;
+    s_isSearching = true;
     m_pendingLoad.clear();
-    searchForNewFiles( loadedFiles, Settings::SettingsData::instance()->imageDirectory() );
+    m_loadCanceled = false;
+    m_visitedDirectories.clear();
+    m_snapshot.load();
+    m_scanStart = time( nullptr );
+    QStringList searchDirectories;
+    for ( const QString& directory : directories ) {
+        searchDirectories.append( Utilities::stripEndingForwardSlash( directory ) );
+        // directories that were explicitly asked for are reported as changed, so don't trust the snapshot for them:
+        if ( !isRootScan )
+            m_snapshot.removeEntry( searchDirectories.last() );
+    }
+    searchForNewFiles( loadedFiles, searchDirectories );
     loadExtraFiles();
+    s_isSearching = false;
+
+    // If loading was canceled, the new files are not in the database,
+    // so their directories must be listed again on the next scan.
+    if ( !m_loadCanceled ) {
+        if ( isRootScan )
+            m_snapshot.retainOnly( m_visitedDirectories );
+        m_snapshot.save();
+    }
 
     // Only build thumbnails for the newly found images
     if (! m_pendingLoad.isEmpty()) {
@@ -80,7 +232,7 @@ bool NewImageFinder::findImages()
     }
 
     // Man this is not super optimal, but will be changed onces the image finder moves to become a background task.
-    if ( ! MainWindow::FeatureDialog::mplayerBinary().isNull() ) {
+    if ( isRootScan && ! MainWindow::FeatureDialog::mplayerBinary().isNull() ) {
         BackgroundTaskManager::JobManager::instance()->addJob(
                 new BackgroundJobs::SearchForVideosWithoutVideoThumbnailsJob );
     }
@@ -91,53 +243,82 @@ bool NewImageFinder::findImages()
 }
 
 
-void NewImageFinder::searchForNewFiles( const DB::FileNameSet& loadedFiles, QString directory )
+void NewImageFinder::searchForNewFiles( const DB::FileNameSet& loadedFiles, const QStringList& directories )
 {
-    qApp->processEvents( QEventLoop::AllEvents );
-    directory = Utilities::stripEndingForwardSlash(directory);
-
-    const QString imageDir = Utilities::stripEndingForwardSlash(Settings::SettingsData::instance()->imageDirectory());
-
-    FastDir dir( directory );
-    const QStringList dirList = dir.entryList( );
     ImageManager::RAWImageDecoder dec;
-    QStringList excluded;
-    excluded << Settings::SettingsData::instance()->excludeDirectories();
-    excluded = excluded.at(0).split(QString::fromLatin1(","));
-
-    bool skipSymlinks = Settings::SettingsData::instance()->skipSymlinks();
+    QStringList excluded = Settings::SettingsData::instance()->excludeDirectories().split(QString::fromLatin1(","));
+    excluded << QString::fromLatin1("CategoryImages");
 
-    for( QStringList::const_iterator it = dirList.constBegin(); it != dirList.constEnd(); ++it ) {
-        const DB::FileName file = DB::FileName::fromAbsolutePath(directory + QString::fromLatin1("/") + *it);
-    if ( (*it) == QString::fromLatin1(".") || (*it) == QString::fromLatin1("..") ||
-                excluded.contains( (*it) ) || loadedFiles.contains( file ) ||
-                dec._skipThisFile(loadedFiles, file) ||
-                (*it) == QString::fromLatin1("CategoryImages") )
-        continue;
+    DirectoryCrawler crawler;
+    crawler.setExcludedNames( excluded );
+    crawler.setSkipSymlinks( Settings::SettingsData::instance()->skipSymlinks() );
+    if ( m_scanMode == IncrementalScan )
+        crawler.setSnapshot( &m_snapshot );
+    crawler.crawl( directories );
 
-        QFileInfo fi( file.absolute() );
+    // the directories that were listed, to be remembered in the snapshot once the crawl is done:
+    QHash<QString, DirectorySnapshot::Entry> listedDirectories;
+    QSet<QString> directoriesWithNewFiles;
 
-        if ( !fi.isReadable() )
-            continue;
-        if ( skipSymlinks && fi.isSymLink() )
-            continue;
-
-        if ( fi.isFile() ) {
-            if ( ! DB::ImageDB::instance()->isBlocking( file ) ) {
-                if ( Utilities::canReadImage(file) )
-                    m_pendingLoad.append( qMakePair( file, DB::Image ) );
-                else if ( Utilities::isVideo( file ) )
-                    m_pendingLoad.append( qMakePair( file, DB::Video ) );
+    while ( !crawler.isFinished() ) {
+        qApp->processEvents( QEventLoop::AllEvents );
+        crawler.waitForEntries( 100 );
+
+        for ( const DirectoryCrawler::Entry& entry : crawler.takeEntries() ) {
+            const int separator = entry.path.lastIndexOf( QChar::fromLatin1('/') );
+            const QString parent = entry.path.left( separator );
+
+            if ( entry.type == DirectoryCrawler::Directory ) {
+                m_visitedDirectories.insert( entry.path );
+                // the entry of the parent directory is always reported first:
+                auto parentEntry = listedDirectories.find( parent );
+                if ( parentEntry != listedDirectories.end() )
+                    parentEntry->subdirectories.append( entry.path.mid( separator + 1 ) );
+                if ( !entry.isUnchanged ) {
+                    DirectorySnapshot::Entry& snapshotEntry = listedDirectories[entry.path];
+                    snapshotEntry.modificationTime = entry.modificationTime;
+                    snapshotEntry.inode = entry.inode;
+                }
+                continue;
             }
-        } else if ( fi.isDir() )  {
-            searchForNewFiles( loadedFiles, file.absolute() );
+
+            const DB::FileName file = DB::FileName::fromAbsolutePath( entry.path );
+            if ( loadedFiles.contains( file ) || dec._skipThisFile( loadedFiles, file ) )
+                continue;
+            if ( DB::ImageDB::instance()->isBlocking( file ) || !QFileInfo( entry.path ).isReadable() )
+                continue;
+
+            if ( Utilities::canReadImage(file) )
+                m_pendingLoad.append( qMakePair( file, DB::Image ) );
+            else if ( Utilities::isVideo( file ) )
+                m_pendingLoad.append( qMakePair( file, DB::Video ) );
+            else
+                continue;
+            directoriesWithNewFiles.insert( parent );
         }
     }
+
+    // The crawler reports files in no particular order; keep the order of new images stable:
+    std::sort( m_pendingLoad.begin(), m_pendingLoad.end(),
+               []( const QPair<DB::FileName, DB::MediaType>& a, const QPair<DB::FileName, DB::MediaType>& b ) {
+        return a.first.absolute() < b.first.absolute();
+    } );
+
+    for ( auto it = listedDirectories.constBegin(); it != listedDirectories.constEnd(); ++it ) {
+        // The modification time has a resolution of one second, so a file added to the directory
+        // within the same second as the scan could go unnoticed. Only remember directories that
+        // have been stable for a while.
+        // Directories with new files are not remembered either: the new files only stay known
+        // if the database is saved, so they have to be looked for again on the next scan.
+        if ( !directoriesWithNewFiles.contains( it.key() ) && it->modificationTime < static_cast<qint64>( m_scanStart ) - 1 )
+            m_snapshot.setEntry( it.key(), *it );
+        else
+            m_snapshot.removeEntry( it.key() );
+    }
 }
 
 void NewImageFinder::loadExtraFiles()
 {
-    // FIXME: should be converted to a threadpool for SMP stuff and whatnot :]
     QProgressDialog dialog;
     dialog.setLabelText( i18n("<p><b>Loading information from new files</b></p>"
                               "<p>Depending on the number of images, this may take some time.<br/>"
@@ -146,28 +327,66 @@ void NewImageFinder::loadExtraFiles()
     dialog.setMinimumDuration( 1000 );
 
     setupFileVersionDetection();
+#ifdef HAVE_EXIV2
+    // the worker threads use the instance, so make sure it is created on this thread:
+    (void) Exif::Info::instance();
+#endif
 
-    int count = 0;
-    ImageInfoList newImages;
-    for( LoadList::Iterator it = m_pendingLoad.begin(); it != m_pendingLoad.end(); ++it, ++count ) {
-        dialog.setValue( count ); // ensure to call setProgress(0)
+    // Reading the files is the slow part, and the only one which may be canceled. The worker threads read each
+    // file exactly once (see prepareFile()), in chunks, so that the next chunk is read while this thread collects
+    // the results of the current one. Nothing is changed in the database before all files are read, so canceling
+    // leaves the database just as it was.
+    const int chunkSize = qMax(1, QThread::idealThreadCount()) * 8;
+    QList<PreparedFile> preparedFiles;
+    QFuture<PreparedFile> pending = QtConcurrent::mapped( m_pendingLoad.mid( 0, chunkSize ), prepareFile );
+    for ( int start = 0; start < m_pendingLoad.size(); start += chunkSize ) {
+        dialog.setValue( start ); // ensure to call setProgress(0)
         qApp->processEvents( QEventLoop::AllEvents );
 
         if ( dialog.wasCanceled() )
         {
+            pending.cancel();
+            pending.waitForFinished();
             // clear the list of pending images, so that findImages() doesn't
             // try to build thumbnails for images w/o DB entry:
             m_pendingLoad.clear();
+            m_loadCanceled = true;
             return;
         }
-        // (*it).first: DB::FileName
-        // (*it).second: DB::MediaType
-        ImageInfoPtr info = loadExtraFile( (*it).first, (*it).second );
+
+        pending.waitForFinished();
+        preparedFiles.append( pending.results() );
+        if ( start + chunkSize < m_pendingLoad.size() )
+            pending = QtConcurrent::mapped( m_pendingLoad.mid( start + chunkSize, chunkSize ), prepareFile );
+    }
+
+    // Now the new files are committed in one go, which can't be canceled anymore.
+    dialog.setCancelButton( nullptr );
+    ImageInfoList newImages;
+#ifdef HAVE_EXIV2
+    QList< QPair<DB::FileName, Exiv2::ExifData> > newExifData;
+#endif
+    while ( !preparedFiles.isEmpty() ) {
+        const PreparedFile file = preparedFiles.takeFirst();
+        if ( handleIfImageHasBeenMoved( file.fileName, file.md5 ) )
+            continue;
+
+#ifdef HAVE_EXIV2
+        if ( file.hasExifData )
+            newExifData.append( qMakePair( file.fileName, file.exifData ) );
+        const DB::FileInfo exifInfo = DB::FileInfo::read( file.fileName, EXIFMODE_INIT, file.hasInfoFile ? file.infoExifData : file.exifData );
+#else
+        const DB::FileInfo exifInfo = DB::FileInfo::read( file.fileName, EXIFMODE_INIT );
+#endif
+        ImageInfoPtr info = loadExtraFile( file.fileName, file.type, file.md5, exifInfo );
         if ( info ) {
             markUnTagged(info);
             newImages.append(info);
         }
     }
+#ifdef HAVE_EXIV2
+    Exif::Database::instance()->add( newExifData );
+#endif
     DB::ImageDB::instance()->addImages( newImages );
 
     // I would have loved to do this in loadExtraFile, but the image has not been added to the database yet
@@ -178,7 +397,6 @@ void NewImageFinder::loadExtraFiles()
                         new BackgroundJobs::ReadVideoLengthJob(info->fileName(), BackgroundTaskManager::BackgroundVideoPreviewRequest));
         }
     }
-
 }
 
 void NewImageFinder::setupFileVersionDetection() {
@@ -190,14 +408,10 @@ void NewImageFinder::setupFileVersionDetection() {
     m_originalFileComponents = m_originalFileComponents.at(0).split(QString::fromLatin1(";"));
 }
 
-ImageInfoPtr NewImageFinder::loadExtraFile( const DB::FileName& newFileName, DB::MediaType type )
+ImageInfoPtr NewImageFinder::loadExtraFile( const DB::FileName& newFileName, DB::MediaType type, const MD5& sum, const DB::FileInfo& exifInfo )
 {
-    MD5 sum = Utilities::MD5Sum( newFileName );
-    if ( handleIfImageHasBeenMoved(newFileName, sum) )
-        return DB::ImageInfoPtr();
-
     // check to see if this is a new version of a previous image
-    ImageInfoPtr info = ImageInfoPtr(new ImageInfo( newFileName, type ));
+    ImageInfoPtr info = ImageInfoPtr(new ImageInfo( newFileName, type, sum, exifInfo ));
     ImageInfoPtr originalInfo;
     DB::FileName originalFileName;
 
@@ -247,8 +461,6 @@ ImageInfoPtr NewImageFinder::loadExtraFile( const DB::FileName& newFileName, DB:
         }
     }
 
-    // also inserts image into exif db if present:
-    info->setMD5Sum(sum);
     DB::ImageDB::instance()->md5Map()->insert( sum, info->fileName());
 
     if (originalInfo &&
@@ -328,7 +540,6 @@ bool  NewImageFinder::calculateMD5sums(
     DB::MD5Map* md5Map,
     bool* wasCanceled)
 {
-    // FIXME: should be converted to a threadpool for SMP stuff and whatnot :]
     QProgressDialog dialog;
     dialog.setLabelText(
         i18np("<p><b>Calculating checksum for %1 file</b></p>","<p><b>Calculating checksums for %1 files</b></p>", list.size())
@@ -342,34 +553,42 @@ bool  NewImageFinder::calculateMD5sums(
     DB::FileNameList cantRead;
     bool dirty = false;
 
-    for (const FileName& fileName : list) {
-        if ( count % 10 == 0 ) {
-            dialog.setValue( count ); // ensure to call setProgress(0)
-            qApp->processEvents( QEventLoop::AllEvents );
+    // the checksums are calculated on worker threads, and handled here as they come in:
+    MD5Calculator calculator;
+    calculator.calculate( list );
+
+    while ( !calculator.isFinished() ) {
+        calculator.waitForResults( 100 );
 
-            if ( dialog.wasCanceled() ) {
-                if ( wasCanceled )
-                    *wasCanceled = true;
-                return dirty;
+        for ( const MD5Calculator::Result& result : calculator.takeResults() ) {
+            const FileName& fileName = result.first;
+            const MD5& md5 = result.second;
+            if (md5.isNull()) {
+                cantRead << fileName;
+                continue;
             }
-        }
 
-        MD5 md5 = Utilities::MD5Sum( fileName );
-        if (md5.isNull()) {
-            cantRead << fileName;
-            continue;
-        }
+            ImageInfoPtr info = ImageDB::instance()->info(fileName);
+            if  ( info->MD5Sum() != md5 ) {
+                info->setMD5Sum( md5 );
+                dirty = true;
+                ImageManager::ThumbnailCache::instance()->removeThumbnail(fileName);
+            }
+
+            md5Map->insert( md5, fileName );
 
-        ImageInfoPtr info = ImageDB::instance()->info(fileName);
-        if  ( info->MD5Sum() != md5 ) {
-            info->setMD5Sum( md5 );
-            dirty = true;
-            ImageManager::ThumbnailCache::instance()->removeThumbnail(fileName);
+            ++count;
         }
 
-        md5Map->insert( md5, fileName );
+        dialog.setValue( count + cantRead.size() );
+        qApp->processEvents( QEventLoop::AllEvents );
 
-        ++count;
+        if ( dialog.wasCanceled() ) {
+            calculator.cancel();
+            if ( wasCanceled )
+                *wasCanceled = true;
+            return dirty;
+        }
     }
     if ( wasCanceled )
         *wasCanceled = false;
@@ -21,30 +21,51 @@
 #include <QSet>
 #include "ImageInfo.h"
 #include "ImageInfoPtr.h"
+#include "DirectorySnapshot.h"
+#include <ctime>
 
 namespace DB
 {
 class MD5Map;
 class IdList;
+class FileInfo;
 class FileNameList;
 
 class NewImageFinder
 {
 public:
-    bool findImages();
+    enum ScanMode {
+        IncrementalScan, ///< skip directories that are unchanged since the last scan
+        FullScan ///< look at every directory, regardless of the directory snapshot
+    };
+    bool findImages( ScanMode mode = IncrementalScan );
+    /**
+     * @brief findImages searches only the given directories (and their subdirectories) for new files.
+     * Directories outside of the image directory are ignored.
+     */
+    bool findImages( const QStringList& directories );
+    static bool isSearching();
     bool calculateMD5sums(const DB::FileNameList& list, DB::MD5Map* map, bool* wasCanceled=nullptr);
 
 protected:
-    void searchForNewFiles( const DB::FileNameSet& loadedFiles, QString directory );
+    bool findImagesIn( const QStringList& directories, bool isRootScan );
+    void searchForNewFiles( const DB::FileNameSet& loadedFiles, const QStringList& directories );
     void setupFileVersionDetection();
     void loadExtraFiles();
-    ImageInfoPtr loadExtraFile( const DB::FileName& name, DB::MediaType type );
+    ImageInfoPtr loadExtraFile( const DB::FileName& name, DB::MediaType type, const MD5& sum, const DB::FileInfo& exifInfo );
     void markUnTagged( ImageInfoPtr info );
     bool handleIfImageHasBeenMoved( const DB::FileName& newFileName, const MD5& sum );
 
 private:
     typedef QList< QPair< DB::FileName, DB::MediaType > > LoadList;
     LoadList m_pendingLoad;
+    bool m_loadCanceled = false;
+
+    DirectorySnapshot m_snapshot;
+    ScanMode m_scanMode = IncrementalScan;
+    time_t m_scanStart = 0;
+    QSet<QString> m_visitedDirectories;
+    static bool s_isSearching;
 
     QString m_modifiedFileCompString;
     QRegExp m_modifiedFileComponent;
@@ -0,0 +1,296 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ColumnCache.h"
+
+#include "Exif/DatabaseElement.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSet>
+#include <QSqlQuery>
+#include <QVector>
+
+#include <limits>
+
+Exif::ColumnCache::ColumnCache()
+    : m_isLoaded(false)
+{
+}
+
+void Exif::ColumnCache::load( const QSqlDatabase& db, const Database::ElementList& elements, bool doUTF8Conversion )
+{
+    clear();
+
+    QStringList columns;
+    for( const DatabaseElement *e : elements )
+    {
+        columns.append( e->columnName() );
+    }
+
+    QSqlQuery query( db );
+    // we read every row exactly once:
+    query.setForwardOnly( true );
+    if ( !query.exec( QString::fromLatin1( "select filename, %1 from exif" ).arg( columns.join( QString::fromLatin1(", ") ) ) ) ) {
+        qWarning( "Error loading exif column cache: %s", qPrintable(query.lastError().text()) );
+        return;
+    }
+
+    m_columns = columns;
+    for( const DatabaseElement *e : elements )
+    {
+        if ( e->valueType() == QVariant::String )
+            m_stringColumns.insert( e->columnName(), StringColumn() );
+        else {
+            m_numericColumns.insert( e->columnName(), QVector<double>() );
+            m_numericTypes.insert( e->columnName(), e->valueType() );
+        }
+    }
+
+    // Without a unicode capable driver, strings come back as the UTF-8 bytes they were stored as:
+    QVector<bool> needsConversion( m_columns.size(), false );
+    if ( doUTF8Conversion ) {
+        for ( int i = 0; i < m_columns.size(); ++i )
+            needsConversion[i] = m_stringColumns.contains( m_columns.at(i) );
+    }
+
+    while ( query.next() ) {
+        const DB::FileName fileName = DB::FileName::fromAbsolutePath(
+                    doUTF8Conversion ? QString::fromUtf8( query.value(0).toByteArray() ) : query.value(0).toString() );
+        // rows of images outside the image root all map to the null file name, and would overwrite each other:
+        if ( fileName.isNull() )
+            continue;
+
+        const int ordinal = m_fileNames.size();
+        m_ordinals.insert( fileName, ordinal );
+        m_fileNames.append( fileName );
+        for ( int i = 0; i < m_columns.size(); ++i ) {
+            const QVariant value = query.value( i+1 );
+            if ( needsConversion[i] && !value.isNull() )
+                setValue( ordinal, i, QString::fromUtf8( value.toByteArray() ) );
+            else
+                setValue( ordinal, i, value );
+        }
+    }
+    m_isLoaded = true;
+}
+
+void Exif::ColumnCache::setValue( int ordinal, int columnIndex, const QVariant& value )
+{
+    const QString& column = m_columns.at( columnIndex );
+    const auto stringIt = m_stringColumns.find( column );
+    if ( stringIt != m_stringColumns.end() ) {
+        QVector<int>& ids = stringIt->ids;
+        const int id = value.isNull() ? -1 : stringIt->idFor( value.toString() );
+        if ( ordinal == ids.size() )
+            ids.append( id );
+        else
+            ids[ordinal] = id;
+        return;
+    }
+
+    QVector<double>& values = m_numericColumns[column];
+    const double number = value.isNull() ? std::numeric_limits<double>::quiet_NaN() : value.toDouble();
+    if ( ordinal == values.size() )
+        values.append( number );
+    else
+        values[ordinal] = number;
+}
+
+int Exif::ColumnCache::StringColumn::idFor( const QString& value )
+{
+    auto it = lookup.constFind( value );
+    if ( it == lookup.constEnd() ) {
+        it = lookup.insert( value, dictionary.size() );
+        dictionary.append( value );
+    }
+    return *it;
+}
+
+void Exif::ColumnCache::setRow( const DB::FileName& fileName, const QList<QVariant>& values )
+{
+    if ( !m_isLoaded )
+        return;
+    Q_ASSERT( values.size() == m_columns.size() );
+
+    int ordinal = m_ordinals.value( fileName, -1 );
+    if ( ordinal < 0 ) {
+        ordinal = m_fileNames.size();
+        m_ordinals.insert( fileName, ordinal );
+        m_fileNames.append( fileName );
+    }
+    for ( int i = 0; i < m_columns.size(); ++i ) {
+        setValue( ordinal, i, values.value(i) );
+    }
+}
+
+void Exif::ColumnCache::removeRow( const DB::FileName& fileName )
+{
+    if ( !m_isLoaded )
+        return;
+
+    const int ordinal = m_ordinals.value( fileName, -1 );
+    if ( ordinal < 0 )
+        return;
+
+    // move the last row into the freed slot to keep the columns dense:
+    const int last = m_fileNames.size() - 1;
+    if ( ordinal != last ) {
+        m_fileNames[ordinal] = m_fileNames[last];
+        m_ordinals[m_fileNames[ordinal]] = ordinal;
+        for ( auto it = m_numericColumns.begin(); it != m_numericColumns.end(); ++it )
+            (*it)[ordinal] = it->at(last);
+        for ( auto it = m_stringColumns.begin(); it != m_stringColumns.end(); ++it )
+            it->ids[ordinal] = it->ids.at(last);
+    }
+    m_ordinals.remove( fileName );
+    m_fileNames.resize( last );
+    for ( auto it = m_numericColumns.begin(); it != m_numericColumns.end(); ++it )
+        it->resize( last );
+    for ( auto it = m_stringColumns.begin(); it != m_stringColumns.end(); ++it )
+        it->ids.resize( last );
+}
+
+void Exif::ColumnCache::clear()
+{
+    m_isLoaded = false;
+    m_columns.clear();
+    m_fileNames.clear();
+    m_ordinals.clear();
+    m_numericColumns.clear();
+    m_numericTypes.clear();
+    m_stringColumns.clear();
+}
+
+bool Exif::ColumnCache::isLoaded() const
+{
+    return m_isLoaded;
+}
+
+int Exif::ColumnCache::size() const
+{
+    return m_fileNames.size();
+}
+
+int Exif::ColumnCache::ordinal( const DB::FileName& fileName ) const
+{
+    return m_ordinals.value( fileName, -1 );
+}
+
+DB::FileName Exif::ColumnCache::fileName( int ordinal ) const
+{
+    return m_fileNames.at( ordinal );
+}
+
+bool Exif::ColumnCache::hasColumn( const QString& column ) const
+{
+    return m_numericColumns.contains( column ) || m_stringColumns.contains( column );
+}
+
+QVariant Exif::ColumnCache::value( int ordinal, const QString& column ) const
+{
+    const auto numericIt = m_numericColumns.constFind( column );
+    if ( numericIt != m_numericColumns.constEnd() ) {
+        const double value = numericIt->at( ordinal );
+        if ( value != value )
+            return QVariant();
+        if ( m_numericTypes.value( column ) == QVariant::Int )
+            return QVariant( static_cast<int>( value ) );
+        return QVariant( value );
+    }
+
+    const auto stringIt = m_stringColumns.constFind( column );
+    if ( stringIt != m_stringColumns.constEnd() ) {
+        const int id = stringIt->ids.at( ordinal );
+        if ( id < 0 )
+            return QVariant();
+        return QVariant( stringIt->dictionary.at( id ) );
+    }
+    return QVariant();
+}
+
+QBitArray Exif::ColumnCache::allRows() const
+{
+    return QBitArray( size(), true );
+}
+
+void Exif::ColumnCache::filterString( const QString& column, const QStringList& values, bool matchEmpty, QBitArray& mask ) const
+{
+    const auto it = m_stringColumns.constFind( column );
+    if ( it == m_stringColumns.constEnd() ) {
+        mask.fill( false );
+        return;
+    }
+
+    // translate the values into dictionary ids, so the scan only compares integers:
+    QBitArray wanted( it->dictionary.size() + 1, false );
+    for ( const QString& value : values ) {
+        const int id = it->lookup.value( value, -1 );
+        if ( id >= 0 )
+            wanted.setBit( id+1 );
+    }
+    if ( matchEmpty ) {
+        wanted.setBit( 0 );
+        const int emptyId = it->lookup.value( QString(), -1 );
+        if ( emptyId >= 0 )
+            wanted.setBit( emptyId+1 );
+    }
+
+    const int *ids = it->ids.constData();
+    const int count = it->ids.size();
+    for ( int i = 0; i < count; ++i ) {
+        if ( mask.testBit(i) && !wanted.testBit( ids[i]+1 ) )
+            mask.clearBit(i);
+    }
+}
+
+void Exif::ColumnCache::filterStringPairs( const QString& firstColumn, const QString& secondColumn,
+                                           const QList< QPair<QString,QString> >& values, QBitArray& mask ) const
+{
+    const auto first = m_stringColumns.constFind( firstColumn );
+    const auto second = m_stringColumns.constFind( secondColumn );
+    if ( first == m_stringColumns.constEnd() || second == m_stringColumns.constEnd() ) {
+        mask.fill( false );
+        return;
+    }
+
+    QSet< QPair<int,int> > wanted;
+    for ( const auto& value : values ) {
+        const int firstId = first->lookup.value( value.first, -1 );
+        const int secondId = second->lookup.value( value.second, -1 );
+        if ( firstId >= 0 && secondId >= 0 )
+            wanted.insert( qMakePair( firstId, secondId ) );
+    }
+
+    const int count = first->ids.size();
+    for ( int i = 0; i < count; ++i ) {
+        if ( mask.testBit(i) && !wanted.contains( qMakePair( first->ids.at(i), second->ids.at(i) ) ) )
+            mask.clearBit(i);
+    }
+}
+
+DB::FileNameSet Exif::ColumnCache::fileNames( const QBitArray& mask ) const
+{
+    DB::FileNameSet result;
+    for ( int i = 0; i < mask.size(); ++i ) {
+        if ( mask.testBit(i) )
+            result.insert( m_fileNames.at(i) );
+    }
+    return result;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,138 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef EXIF_COLUMNCACHE_H
+#define EXIF_COLUMNCACHE_H
+
+#include <DB/FileName.h>
+#include "Exif/Database.h"
+
+#include <QBitArray>
+#include <QHash>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class QSqlDatabase;
+
+namespace Exif {
+
+/**
+ * @brief The ColumnCache class is an in-memory copy of the exif table, stored column by column.
+ *
+ * Each row of the exif table gets an ordinal, and every column is stored as an array indexed by that ordinal.
+ * Numeric columns are stored as doubles, with NaN representing a NULL value.
+ * String columns (camera make and model, lens) are stored as indices into a per-column dictionary,
+ * with -1 representing a NULL value.
+ *
+ * Filters are applied as linear scans over a column, narrowing down a mask of matching ordinals.
+ * This allows Exif::SearchInfo and Database::readFields() to work without any SQL round-trip.
+ *
+ * The cache is owned by Exif::Database, which loads it lazily and keeps it in sync with the exif table
+ * using setRow() and removeRow().
+ */
+class ColumnCache
+{
+public:
+    ColumnCache();
+    void load( const QSqlDatabase& db, const Database::ElementList& elements, bool doUTF8Conversion );
+    void clear();
+    bool isLoaded() const;
+    /**
+     * @brief setRow replaces or adds the row for the given file.
+     * @param values the column values in the order of the elements passed to load()
+     */
+    void setRow( const DB::FileName& fileName, const QList<QVariant>& values );
+    /**
+     * @brief removeRow removes the row for the given file.
+     * The last row is moved into the freed slot, so ordinals are only stable as long as the cache is not modified.
+     */
+    void removeRow( const DB::FileName& fileName );
+
+    /** @return the number of rows, i.e. the size of every column array. */
+    int size() const;
+    /** @return the ordinal for the given file, or -1 if the file is not in the cache. */
+    int ordinal( const DB::FileName& fileName ) const;
+    DB::FileName fileName( int ordinal ) const;
+    bool hasColumn( const QString& column ) const;
+    /**
+     * @return the value of the given column for the given row in the same format as the exif database would return it,
+     * or a null QVariant if the value is NULL.
+     */
+    QVariant value( int ordinal, const QString& column ) const;
+
+    /** @return a mask with one set bit per row. */
+    QBitArray allRows() const;
+    /**
+     * @brief filterNumeric clears the bit of every row for which pred( value ) is false.
+     * NULL values never match, just like in SQL.
+     */
+    template <class Predicate>
+    void filterNumeric( const QString& column, Predicate pred, QBitArray& mask ) const;
+    /**
+     * @brief filterString clears the bit of every row whose value is not in values.
+     * If matchEmpty is true, NULL values and empty strings match as well.
+     */
+    void filterString( const QString& column, const QStringList& values, bool matchEmpty, QBitArray& mask ) const;
+    /**
+     * @brief filterStringPairs clears the bit of every row for which the value pair of the two columns is not in values.
+     */
+    void filterStringPairs( const QString& firstColumn, const QString& secondColumn,
+                            const QList< QPair<QString,QString> >& values, QBitArray& mask ) const;
+    DB::FileNameSet fileNames( const QBitArray& mask ) const;
+
+private:
+    struct StringColumn
+    {
+        QVector<int> ids;
+        QStringList dictionary;
+        QHash<QString,int> lookup;
+        int idFor( const QString& value );
+    };
+
+    void setValue( int ordinal, int columnIndex, const QVariant& value );
+
+    bool m_isLoaded;
+    QStringList m_columns;
+    QVector<DB::FileName> m_fileNames;
+    QHash<DB::FileName,int> m_ordinals;
+    QHash<QString, QVector<double> > m_numericColumns;
+    QHash<QString, QVariant::Type> m_numericTypes;
+    QHash<QString, StringColumn> m_stringColumns;
+};
+
+template <class Predicate>
+void ColumnCache::filterNumeric( const QString& column, Predicate pred, QBitArray& mask ) const
+{
+    const auto it = m_numericColumns.constFind( column );
+    if ( it == m_numericColumns.constEnd() ) {
+        mask.fill( false );
+        return;
+    }
+    const double *values = it->constData();
+    const int count = it->size();
+    for ( int i = 0; i < count; ++i ) {
+        // NaN compares false to everything, so NULL values never match:
+        if ( mask.testBit(i) && !( values[i] == values[i] && pred( values[i] ) ) )
+            mask.clearBit(i);
+    }
+}
+
+} // namespace Exif
+
+#endif // EXIF_COLUMNCACHE_H
+// vi:expandtab:tabstop=4 shiftwidth=4:
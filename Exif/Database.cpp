@@ -18,6 +18,7 @@
 #include "Database.h"
 
 #include "DB/ImageDB.h"
+#include "Exif/ColumnCache.h"
 #include "Exif/DatabaseElement.h"
 #include "MainWindow/Window.h"
 #include "Settings/SettingsData.h"
@@ -36,6 +37,8 @@
 #include <QSqlDriver>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QThread>
+#include <QtConcurrentMap>
 
 using namespace Exif;
 
@@ -90,6 +93,59 @@ const Database::ElementList elements(int since=0)
 
     return elms;
 }
+
+// number of rows inserted per transaction when adding files in bulk
+constexpr int INSERT_TRANSACTION_SIZE = 500;
+
+/**
+ * @brief The ExifRow struct holds the column values of one exif table row.
+ * It is the result of reading the exif data of a file on a worker thread.
+ */
+struct ExifRow
+{
+    DB::FileName fileName;
+    QList<QVariant> values;
+    bool isValid = false;
+};
+
+/**
+ * @brief The ReadExifRow class reads the exif data of a file and converts it into column values.
+ * It is used with QtConcurrent::mapped, so it must not touch the database or any GUI object.
+ * Each invocation opens its own Exiv2::Image, so concurrent invocations do not share any Exiv2 state.
+ */
+class ReadExifRow
+{
+public:
+    typedef ExifRow result_type;
+
+    explicit ReadExifRow( const Database::ElementList& elements )
+        : m_elements( elements ) {}
+
+    ExifRow operator()( const DB::FileName& fileName ) const
+    {
+        ExifRow row;
+        row.fileName = fileName;
+        try {
+            Exiv2::Image::AutoPtr image = Exiv2::ImageFactory::open(fileName.absolute().toLocal8Bit().data());
+            Q_ASSERT(image.get() != nullptr);
+            image->readMetadata();
+            Exiv2::ExifData &exifData = image->exifData();
+            for( const DatabaseElement *e : m_elements )
+            {
+                row.values.append( e->valueFromExif( exifData ) );
+            }
+            row.isValid = true;
+        }
+        catch (...)
+        {
+            qWarning("Error while reading exif information from %s", qPrintable(fileName.absolute()) );
+        }
+        return row;
+    }
+
+private:
+    const Database::ElementList m_elements;
+};
 }
 
 Exif::Database* Exif::Database::s_instance = nullptr;
@@ -113,6 +169,8 @@ static void showError( QSqlQuery& query )
 
 Exif::Database::Database()
     : m_isOpen(false)
+    , m_insertQuery(nullptr)
+    , m_columnCache(nullptr)
 {
     m_db = QSqlDatabase::addDatabase( QString::fromLatin1( "QSQLITE" ), QString::fromLatin1( "exif" ) );
 }
@@ -127,6 +185,18 @@ void Exif::Database::openDatabase()
     else
         m_isOpen = true;
 
+    if ( m_isOpen ) {
+        // With a write-ahead log, a commit only appends to the log instead of rewriting pages,
+        // and with synchronous=NORMAL the log is only synced at checkpoints. An interrupted
+        // write may lose the last transactions, but it can not corrupt the database - which
+        // is fine for data that can be recreated from the images at any time.
+        QSqlQuery query( m_db );
+        if ( !query.exec( QString::fromLatin1( "PRAGMA journal_mode=WAL" ) ) )
+            qWarning( "Couldn't enable write-ahead log for exif db: %s", qPrintable(query.lastError().text()) );
+        if ( !query.exec( QString::fromLatin1( "PRAGMA synchronous=NORMAL" ) ) )
+            qWarning( "Couldn't set synchronous mode for exif db: %s", qPrintable(query.lastError().text()) );
+    }
+
     // If SQLite in Qt has Unicode feature, it will convert queries to
     // UTF-8 automatically. Otherwise we should do the conversion to
     // be able to store any Unicode character.
@@ -138,8 +208,22 @@ Exif::Database::~Database()
     // We have to close the database before destroying the QSqlDatabase object,
     // otherwise Qt screams and kittens might die (see QSqlDatabase's
     // documentation)
+    closeDatabase();
+    delete m_columnCache;
+}
+
+void Exif::Database::closeDatabase()
+{
+    if ( m_columnCache )
+        m_columnCache->clear();
+
+    // the prepared statement must not outlive the connection:
+    delete m_insertQuery;
+    m_insertQuery = nullptr;
+
     if ( m_db.isOpen() )
         m_db.close();
+    m_isOpen = false;
 }
 
 bool Exif::Database::isOpen() const
@@ -221,6 +305,71 @@ bool Exif::Database::add( const DB::FileName& fileName )
     }
 }
 
+int Exif::Database::add( const DB::FileNameList& list, QProgressDialog* progress )
+{
+    if ( !isUsable() || list.isEmpty() )
+        return 0;
+
+    // elements() must not be initialized concurrently, so fetch it before starting the workers:
+    const ReadExifRow reader( elements() );
+    // chunks are small enough to keep the GUI responsive, yet big enough to keep all cores busy:
+    const int chunkSize = qMax(1, QThread::idealThreadCount()) * 16;
+
+    int added = 0;
+    int processed = 0;
+    int uncommitted = 0;
+    bool inTransaction = m_db.transaction();
+
+    // The exif data of the next chunk is read while the rows of the current chunk are inserted:
+    QFuture<ExifRow> pending = QtConcurrent::mapped( list.mid( 0, chunkSize ), reader );
+    for ( int start = 0; start < list.size(); start += chunkSize ) {
+        pending.waitForFinished();
+        const QList<ExifRow> rows = pending.results();
+
+        const bool canceled = progress && progress->wasCanceled();
+        if ( !canceled && start + chunkSize < list.size() )
+            pending = QtConcurrent::mapped( list.mid( start + chunkSize, chunkSize ), reader );
+
+        for ( const ExifRow& row : rows ) {
+            if ( row.isValid && insertRow( row.fileName, row.values ) )
+                ++added;
+            if ( ++uncommitted >= INSERT_TRANSACTION_SIZE && inTransaction ) {
+                m_db.commit();
+                inTransaction = m_db.transaction();
+                uncommitted = 0;
+            }
+        }
+        processed += rows.size();
+
+        if ( progress ) {
+            progress->setValue( processed );
+            qApp->processEvents();
+        }
+        if ( canceled )
+            break;
+    }
+
+    if ( inTransaction )
+        m_db.commit();
+    return added;
+}
+
+int Exif::Database::add( const QList< QPair<DB::FileName, Exiv2::ExifData> >& list )
+{
+    if ( !isUsable() || list.isEmpty() )
+        return 0;
+
+    int added = 0;
+    const bool inTransaction = m_db.transaction();
+    for ( const auto& item : list ) {
+        if ( insert( item.first, item.second ) )
+            ++added;
+    }
+    if ( inTransaction )
+        m_db.commit();
+    return added;
+}
+
 void Exif::Database::remove( const DB::FileName& fileName )
 {
     if ( !isUsable() )
@@ -230,41 +379,66 @@ void Exif::Database::remove( const DB::FileName& fileName )
     query.bindValue( 0, fileName.absolute() );
     if ( !query.exec() )
         showError( query );
+    else if ( m_columnCache )
+        m_columnCache->removeRow( fileName );
 }
 
 bool Exif::Database::insert(const DB::FileName& filename, Exiv2::ExifData data )
 {
-    static QString _queryString;
     if ( !isUsable() )
         return false;
 
-    if (_queryString.isEmpty())
+    QList<QVariant> values;
+    for( const DatabaseElement *e : elements() )
     {
-        QStringList formalList;
-        Database::ElementList elms = elements();
-        for( const DatabaseElement *e : elms )
-        {
-            formalList.append( e->queryString() );
-        }
-        _queryString = QString::fromLatin1( "INSERT OR REPLACE into exif values (?, %1) " ).arg( formalList.join( QString::fromLatin1( ", " ) ) );
+        values.append( e->valueFromExif(data));
     }
+    return insertRow( filename, values );
+}
 
-    QSqlQuery query( _queryString, m_db );
-    query.bindValue(  0, filename.absolute() );
+bool Exif::Database::insertRow( const DB::FileName& filename, const QList<QVariant>& values )
+{
+    QSqlQuery *query = insertQuery();
+    if ( !query )
+        return false;
+
+    query->bindValue(  0, filename.absolute() );
     int i = 1;
-    for( const DatabaseElement *e : elements() )
+    for( const QVariant& value : values )
     {
-        query.bindValue( i++, e->valueFromExif(data));
+        query->bindValue( i++, value );
     }
 
-    if ( !query.exec() )
+    if ( !query->exec() )
     {
-        showError( query );
+        showError( *query );
         return false;
     } else {
+        if ( m_columnCache )
+            m_columnCache->setRow( filename, values );
         return true;
     }
+}
+
+QSqlQuery* Exif::Database::insertQuery()
+{
+    if ( !isUsable() )
+        return nullptr;
 
+    if ( !m_insertQuery )
+    {
+        QStringList formalList;
+        Database::ElementList elms = elements();
+        for( const DatabaseElement *e : elms )
+        {
+            formalList.append( e->queryString() );
+        }
+        // the statement is prepared once and reused for every insert:
+        m_insertQuery = new QSqlQuery( m_db );
+        m_insertQuery->prepare( QString::fromLatin1( "INSERT OR REPLACE into exif values (?, %1) " )
+                                .arg( formalList.join( QString::fromLatin1( ", " ) ) ) );
+    }
+    return m_insertQuery;
 }
 
 Exif::Database* Exif::Database::instance()
@@ -346,6 +520,27 @@ bool Exif::Database::readFields( const DB::FileName& fileName, ElementList &fiel
     if ( !isUsable() )
         return false;
 
+    const ColumnCache *cache = columnCache();
+    if ( cache )
+    {
+        bool allCached = true;
+        for( const DatabaseElement *e : fields )
+        {
+            allCached = allCached && cache->hasColumn( e->columnName() );
+        }
+        if ( allCached )
+        {
+            const int ordinal = cache->ordinal( fileName );
+            if ( ordinal < 0 )
+                return false;
+            for( DatabaseElement *e : fields )
+            {
+                e->setValue( cache->value( ordinal, e->columnName() ) );
+            }
+            return true;
+        }
+    }
+
     bool foundIt = false;
     QStringList fieldList;
     for( const DatabaseElement *e : fields )
@@ -377,6 +572,18 @@ bool Exif::Database::readFields( const DB::FileName& fileName, ElementList &fiel
     return foundIt;
 }
 
+const Exif::ColumnCache* Exif::Database::columnCache() const
+{
+    if ( !isUsable() || !::Settings::SettingsData::instance()->useExifColumnCache() )
+        return nullptr;
+
+    if ( !m_columnCache )
+        m_columnCache = new ColumnCache;
+    if ( !m_columnCache->isLoaded() )
+        m_columnCache->load( m_db, elements(), m_doUTF8Conversion );
+    return m_columnCache->isLoaded() ? m_columnCache : nullptr;
+}
+
 DB::FileNameSet Exif::Database::filesMatchingQuery( const QString& queryStr ) const
 {
     if ( !isUsable() )
@@ -470,42 +677,32 @@ void Exif::Database::recreate()
     // we want to go back to the original DB.
 
     const QString origBackup = exifDBFile() + QLatin1String(".bak");
-    m_db.close();
+    closeDatabase();
 
     QDir().remove(origBackup);
     QDir().rename(exifDBFile(), origBackup);
     init();
 
-    const DB::FileNameList allImages = DB::ImageDB::instance()->images();
+    DB::FileNameList images;
+    for (const DB::FileName& fileName : DB::ImageDB::instance()->images()) {
+        if (fileName.info()->mediaType() == DB::Image)
+            images.append(fileName);
+    }
+
     QProgressDialog dialog;
     dialog.setModal(true);
     dialog.setLabelText(i18n("Rereading EXIF information from all images"));
-    dialog.setMaximum(allImages.size());
-    // using a transaction here removes a *huge* overhead on the insert statements
-    m_db.transaction();
-    int i = 0;
-    for (const DB::FileName& fileName : allImages) {
-        const DB::ImageInfoPtr info = fileName.info();
-        dialog.setValue(i++);
-        if (info->mediaType() == DB::Image) {
-            add(fileName);
-        }
-        if ( i % 10 )
-            qApp->processEvents();
-        if (dialog.wasCanceled())
-            break;
-    }
+    dialog.setMaximum(images.size());
+    add(images, &dialog);
 
     // PENDING(blackie) We should count the amount of files that did not succeeded and warn the user.
     if (dialog.wasCanceled()) {
-        m_db.rollback();
-        m_db.close();
+        closeDatabase();
         QDir().remove(exifDBFile());
         QDir().rename(origBackup, exifDBFile());
         init();
     }
     else {
-        m_db.commit();
         QDir().remove(origBackup);
     }
 }
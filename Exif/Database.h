@@ -23,14 +23,18 @@
 #include <QList>
 #include <qpair.h>
 #include <DB/FileName.h>
+#include <DB/FileNameList.h>
 
 namespace Exiv2 { class ExifData; }
+class QProgressDialog;
+class QSqlQuery;
 
 typedef QPair<int,int> Rational;
 typedef QList<Rational> RationalList;
 
 namespace Exif
 {
+class ColumnCache;
 class DatabaseElement;
 
 // ============================================================================
@@ -83,6 +87,23 @@ public:
      * @return
      */
     bool add( const DB::FileName& fileName );
+    /**
+     * @brief add a list of files and their exif data to the database.
+     * The exif data is read on a thread pool, while the rows are inserted using a single
+     * prepared statement in transactions of several hundred rows each.
+     * Existing data for a file is replaced, just like in add(const DB::FileName&).
+     * @param list the files
+     * @param progress if not null, the dialog is updated while adding files,
+     * and adding stops once the dialog is canceled.
+     * @return the number of files that were successfully added.
+     */
+    int add( const DB::FileNameList& list, QProgressDialog* progress = nullptr );
+    /**
+     * @brief add the exif data of files that have already been read to the database, using a single transaction.
+     * @param list pairs of file name and exif data
+     * @return the number of files that were successfully added.
+     */
+    int add( const QList< QPair<DB::FileName, Exiv2::ExifData> >& list );
     void remove( const DB::FileName& fileName );
     /**
      * @brief readFields searches the exif database for a given file and fills the element list with values.
@@ -92,6 +113,11 @@ public:
      * @return true, if the fileName is found in the database, false otherwise.
      */
     bool readFields( const DB::FileName& fileName, ElementList &fields) const;
+    /**
+     * @brief columnCache returns an in-memory copy of the exif table, which is loaded on first use.
+     * @return the column cache, or a null pointer if the database is not usable or the cache is disabled.
+     */
+    const ColumnCache* columnCache() const;
     DB::FileNameSet filesMatchingQuery( const QString& query ) const;
     CameraList cameras() const;
     LensList lenses() const;
@@ -106,13 +132,18 @@ protected:
     void createMetadataTable(DBSchemaChangeType change);
     static QString connectionName();
     bool insert( const DB::FileName& filename, Exiv2::ExifData );
+    bool insertRow( const DB::FileName& filename, const QList<QVariant>& values );
+    QSqlQuery* insertQuery();
 
 private:
     bool m_isOpen;
     bool m_doUTF8Conversion;
+    QSqlQuery* m_insertQuery;
+    mutable ColumnCache* m_columnCache;
     Database();
     ~Database();
     void init();
+    void closeDatabase();
     static Database* s_instance;
     QSqlDatabase m_db;
 };
@@ -67,6 +67,11 @@ QString Exif::StringExifElement::queryString() const
     return QString::fromLatin1( "?" );
 }
 
+QVariant::Type Exif::StringExifElement::valueType() const
+{
+    return QVariant::String;
+}
+
 
 QVariant Exif::StringExifElement::valueFromExif(Exiv2::ExifData &data) const
 {
@@ -95,6 +100,11 @@ QString Exif::IntExifElement::queryString() const
     return QString::fromLatin1( "?" );
 }
 
+QVariant::Type Exif::IntExifElement::valueType() const
+{
+    return QVariant::Int;
+}
+
 
 QVariant Exif::IntExifElement::valueFromExif(Exiv2::ExifData &data) const
 {
@@ -125,6 +135,11 @@ QString Exif::RationalExifElement::queryString() const
     return QString::fromLatin1( "?" );
 }
 
+QVariant::Type Exif::RationalExifElement::valueType() const
+{
+    return QVariant::Double;
+}
+
 
 QVariant Exif::RationalExifElement::valueFromExif(Exiv2::ExifData &data) const
 {
@@ -186,6 +201,11 @@ QString Exif::LensExifElement::queryString() const
     return QString::fromLatin1( "?" );
 }
 
+QVariant::Type Exif::LensExifElement::valueType() const
+{
+    return QVariant::String;
+}
+
 
 QVariant Exif::LensExifElement::valueFromExif(Exiv2::ExifData &data) const
 {
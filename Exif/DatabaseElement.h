@@ -50,6 +50,11 @@ public:
      * @return The converted value, or an empty QVariant if the necessary data is not available.
      */
     virtual QVariant valueFromExif( Exiv2::ExifData& data ) const = 0;
+    /**
+     * @brief valueType
+     * @return the type of the QVariant returned by valueFromExif (QVariant::Int, QVariant::Double or QVariant::String).
+     */
+    virtual QVariant::Type valueType() const = 0;
     /**
      * @brief value
      * @see Database::readFields
@@ -71,6 +76,7 @@ public:
     QString createString() const override;
     QString queryString() const override;
     virtual QVariant valueFromExif( Exiv2::ExifData& data ) const override;
+    QVariant::Type valueType() const override;
 
 private:
     const char* m_tag;
@@ -84,6 +90,7 @@ public:
     QString createString() const override;
     QString queryString() const override;
     virtual QVariant valueFromExif( Exiv2::ExifData& data ) const override;
+    QVariant::Type valueType() const override;
 
 private:
     const char* m_tag;
@@ -106,6 +113,7 @@ public:
     QString createString() const override;
     QString queryString() const override;
     virtual QVariant valueFromExif( Exiv2::ExifData& data ) const override;
+    QVariant::Type valueType() const override;
 
 private:
     const char* m_tag;
@@ -125,6 +133,7 @@ public:
     QString createString() const override;
     QString queryString() const override;
     virtual QVariant valueFromExif( Exiv2::ExifData& data ) const override;
+    QVariant::Type valueType() const override;
 
 private:
     const char* m_tag;
@@ -184,7 +184,7 @@ Info::Info()
     m_keys = standardKeys();
 }
 
-void Exif::Info::writeInfoToFile( const DB::FileName& srcName, const QString& destName )
+void Exif::Info::writeInfoToFiles( const DB::FileName& srcName, const QStringList& destNames, const QString& description )
 {
     // Load Exif from source image
     Exiv2::Image::AutoPtr image =
@@ -192,13 +192,13 @@ void Exif::Info::writeInfoToFile( const DB::FileName& srcName, const QString& de
     image->readMetadata();
     Exiv2::ExifData data = image->exifData();
 
-    // Modify Exif information from database.
-    DB::ImageInfoPtr info = DB::ImageDB::instance()->info( srcName );
-    data["Exif.Image.ImageDescription"] = info->description().toLocal8Bit().data();
+    data["Exif.Image.ImageDescription"] = description.toLocal8Bit().data();
 
-    image = Exiv2::ImageFactory::open( QFile::encodeName(destName).data() );
-    image->setExifData(data);
-    image->writeMetadata();
+    for ( const QString& destName : destNames ) {
+        image = Exiv2::ImageFactory::open( QFile::encodeName(destName).data() );
+        image->setExifData(data);
+        image->writeMetadata();
+    }
 }
 
 /**
@@ -45,10 +45,17 @@ public:
     QMap<QString, QStringList> infoForDialog( const DB::FileName& fileName, const QString& charset );
     StringSet availableKeys();
     StringSet standardKeys();
-    void writeInfoToFile( const DB::FileName& srcName, const QString& destName );
+    /**
+     * @brief writeInfoToFiles copies the Exif information of the source image to each of the destination images,
+     * with the image description replaced by the given one.
+     * The database is not accessed, so this may be called from any thread.
+     */
+    void writeInfoToFiles( const DB::FileName& srcName, const QStringList& destNames, const QString& description );
     Metadata metadata( const DB::FileName& fileName );
-
-protected:
+    /**
+     * @brief exifInfoFile returns the file holding the exif information for the given file.
+     * This is the file itself, unless there is a .thm file with the same base name (as some cameras write for videos).
+     */
     DB::FileName exifInfoFile( const DB::FileName& fileName );
 
 private:
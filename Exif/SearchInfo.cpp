@@ -19,6 +19,7 @@
 #include "SearchInfo.h"
 #include <klocale.h>
 
+#include "Exif/ColumnCache.h"
 #include "Exif/Database.h"
 #include <DB/FileName.h>
 
@@ -30,6 +31,8 @@
  * The search is build, from \ref Exif::SearchDialog, using the functions addRangeKey(), addSearchKey(), and addCamara().
  * The search is stored in an instance of \ref DB::ImageSearchInfo, and may later be executed using search().
  * Once a search has been executed, the application may ask if a given image is in the search result using matches()
+ *
+ * If the \ref Exif::ColumnCache is available, the search is done by scanning its columns instead of querying the database.
  */
 void Exif::SearchInfo::addSearchKey( const QString& key, const IntList& values )
 {
@@ -133,18 +136,70 @@ void Exif::SearchInfo::search() const
     QString queryStr = buildQuery();
     m_emptyQuery = queryStr.isEmpty();
 
-    // ensure to do SQL queries as little as possible.
-    static QString lastQuery;
-    if ( queryStr == lastQuery )
+    if ( m_emptyQuery ) {
+        m_matches.clear();
+        m_lastQuery = queryStr;
         return;
-    lastQuery = queryStr;
+    }
 
-    m_matches.clear();
-    if ( m_emptyQuery )
+    // scanning the in-memory columns is cheap enough to always be done:
+    const ColumnCache *cache = Exif::Database::instance()->columnCache();
+    if ( cache ) {
+        m_matches = searchColumnCache( *cache );
+        m_lastQuery.clear();
+        return;
+    }
+
+    // ensure to do SQL queries as little as possible.
+    if ( queryStr == m_lastQuery )
         return;
+    m_lastQuery = queryStr;
+
     m_matches = Exif::Database::instance()->filesMatchingQuery( queryStr );
 }
 
+DB::FileNameSet Exif::SearchInfo::searchColumnCache( const ColumnCache& cache ) const
+{
+    QBitArray mask = cache.allRows();
+
+    for( IntKeyList::ConstIterator intIt = m_intKeys.begin(); intIt != m_intKeys.end(); ++intIt ) {
+        const IntList values = (*intIt).second;
+        if ( values.isEmpty() )
+            continue;
+        cache.filterNumeric( (*intIt).first, [&values](double value) { return values.contains( static_cast<int>( value ) ); }, mask );
+    }
+
+    // the bounds match the ones used by sqlForOneRangeItem():
+    for( const Range& range : m_rangeKeys ) {
+        const double min = range.min;
+        const double max = range.max;
+        if ( range.isLowerMin ) {
+            if ( range.isUpperMin )
+                cache.filterNumeric( range.key, [min](double value) { return value < min * 1.01 && value > 0; }, mask );
+            else if ( !range.isUpperMax )
+                cache.filterNumeric( range.key, [max](double value) { return value <= max * 1.01 && value > 0; }, mask );
+        }
+        else if ( range.isLowerMax )
+            cache.filterNumeric( range.key, [max](double value) { return value > max * 0.99; }, mask );
+        else if ( range.isUpperMax )
+            cache.filterNumeric( range.key, [min](double value) { return value >= min * 0.99; }, mask );
+        else
+            cache.filterNumeric( range.key, [min,max](double value) { return min * 0.99 <= value && value <= max * 1.01; }, mask );
+    }
+
+    if ( !m_cameras.isEmpty() )
+        cache.filterStringPairs( QString::fromLatin1( "Exif_Image_Make" ), QString::fromLatin1( "Exif_Image_Model" ), m_cameras, mask );
+
+    if ( !m_lenses.isEmpty() ) {
+        QStringList lenses = m_lenses;
+        // "None" matches null (=entry from old db schema) and empty string (=entry w/o exif lens info)
+        const bool matchNone = lenses.removeAll( i18nc("As in No persons, no locations etc.", "None" ) ) > 0;
+        cache.filterString( QString::fromLatin1( "Exif_Photo_LensModel" ), lenses, matchNone, mask );
+    }
+
+    return cache.fileNames( mask );
+}
+
 bool Exif::SearchInfo::matches( const DB::FileName& fileName ) const
 {
     if ( m_emptyQuery )
@@ -26,6 +26,8 @@
 
 namespace Exif {
 
+class ColumnCache;
+
 class SearchInfo  {
 public:
     typedef Database::CameraList CameraList;
@@ -59,6 +61,7 @@ protected:
     QString buildCameraSearchQuery() const;
     QString buildLensSearchQuery() const;
     QString sqlForOneRangeItem( const Range& ) const;
+    DB::FileNameSet searchColumnCache( const ColumnCache& cache ) const;
 
 private:
     typedef QList< QPair<QString, IntList> > IntKeyList;
@@ -68,6 +71,7 @@ private:
     LensList m_lenses;
     mutable DB::FileNameSet m_matches;
     mutable bool m_emptyQuery;
+    mutable QString m_lastQuery;
 };
 
 }
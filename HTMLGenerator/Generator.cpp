@@ -37,21 +37,43 @@
 #  include "Exif/Info.h"
 #endif
 #include "ImageSizeCheckBox.h"
+#include "ImageRenderTask.h"
+#include "PageRenderTask.h"
 #include "Setup.h"
 #include "MainWindow/Window.h"
 #include <KIO/CopyJob>
 #include <kstandarddirs.h>
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
 
 #include <krun.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+namespace
+{
+/**
+ * @brief sourceKey identifies the content of an image or video file for the manifest.
+ */
+QString sourceKey( const DB::FileName& fileName )
+{
+    const DB::MD5 md5 = fileName.info()->MD5Sum();
+    if ( !md5.isNull() )
+        return md5.toHexString();
+    // without a checksum, fall back to the time the file was last changed:
+    return QFileInfo( fileName.absolute() ).lastModified().toString( Qt::ISODate );
+}
+}
+
 HTMLGenerator::Generator::Generator( const Setup& setup, QWidget* parent )
-    : KProgressDialog( parent ), m_hasEnteredLoop( false )
+    : KProgressDialog( parent ), m_incremental( false ), m_pagesInFlight( 0 ), m_nextRender( 0 ), m_rendersInFlight( 0 ), m_hasEnteredLoop( false )
 {
     setLabelText( i18n("Generating images for HTML page ") );
     m_setup = setup;
     m_eventLoop = new QEventLoop;
+    m_renderPool = new QThreadPool( this );
     m_avconv = KStandardDirs::findExe( QString::fromLatin1( "avconv" ) );
     if ( m_avconv.isNull() )
         m_avconv = KStandardDirs::findExe( QString::fromLatin1( "ffmpeg" ) );
@@ -59,10 +81,23 @@ HTMLGenerator::Generator::Generator( const Setup& setup, QWidget* parent )
 
 HTMLGenerator::Generator::~Generator()
 {
+    // the render tasks write into the temporary directory, use our templates, and report back to us:
+    m_renderPool->waitForDone();
     delete m_eventLoop;
 }
 void HTMLGenerator::Generator::generate()
 {
+    const QString outputDir = m_setup.baseDir() + QString::fromLatin1( "/" ) + m_setup.outputDir();
+    m_incremental = m_setup.incrementalUpdate() && KUrl( outputDir ).isLocalFile();
+    if ( m_incremental ) {
+        // Update the existing gallery in place; only what changed since it was generated is written.
+        m_outputRoot = KUrl( outputDir ).toLocalFile( KUrl::AddTrailingSlash );
+        QDir().mkpath( m_outputRoot );
+        m_manifest.load( m_outputRoot );
+    }
+    else
+        m_outputRoot = m_tempDir.name();
+
     // Generate .kim file
     if ( m_setup.generateKimFile() ) {
         bool ok;
@@ -75,6 +110,7 @@ void HTMLGenerator::Generator::generate()
                                   destURL + QString::fromLatin1("/") + m_setup.outputDir(), true, &ok);
         if ( !ok )
             return;
+        m_manifest.record( kimFileName( true ), QByteArray() );
     }
 
     // prepare the progress dialog
@@ -85,6 +121,14 @@ void HTMLGenerator::Generator::generate()
 
     m_filenameMapper.reset();
 
+    // Parse the pages of the theme once; each page is then rendered from them on a worker thread.
+    QString themeDir, themeAuthor, themeName;
+    getThemeInfo( &themeDir, &themeName, &themeAuthor );
+    m_indexTemplate = loadTemplate( QString::fromLatin1( "%1mainpage.html" ).arg( themeDir ) );
+    m_pageTemplate = loadTemplate( QString::fromLatin1( "%1imagepage.html" ).arg( themeDir ) );
+    if ( m_indexTemplate.isEmpty() || m_pageTemplate.isEmpty() )
+        return;
+
     // Itertate over each of the image sizes needed.
      for( QList<ImageSizeCheckBox*>::ConstIterator sizeIt = m_setup.activeResolutions().begin();
          sizeIt != m_setup.activeResolutions().end(); ++sizeIt ) {
@@ -119,7 +163,9 @@ void HTMLGenerator::Generator::generate()
     if ( wasCancelled() )
         return;
 
-    if ( m_waitCounter > 0 ) {
+    renderImages();
+
+    if ( m_waitCounter > 0 || m_pagesInFlight > 0 ) {
         m_hasEnteredLoop = true;
         m_eventLoop->exec();
     }
@@ -132,8 +178,6 @@ void HTMLGenerator::Generator::generate()
         return;
 
     // Copy over the mainpage.css, imagepage.css
-    QString themeDir, themeAuthor, themeName;
-    getThemeInfo( &themeDir, &themeName, &themeAuthor );
     QDir dir( themeDir );
     QStringList files = dir.entryList( QDir::Files );
     if( files.count() < 1 )
@@ -144,17 +188,26 @@ void HTMLGenerator::Generator::generate()
             *it == QString::fromLatin1("mainpage.html") ||
             *it == QString::fromLatin1("imagepage.html")) continue;
         QString from = QString::fromLatin1("%1%2").arg( themeDir ).arg(*it);
-        QString to = m_tempDir.name() + QString::fromLatin1("/") + *it;
-        ok = Utilities::copy( from, to );
+        ok = copyToOutput( from, *it );
         if ( !ok ) {
-            KMessageBox::error( this, i18n("Error copying %1 to %2", from , to ) );
+            KMessageBox::error( this, i18n("Error copying %1 to %2", from , outputPath( *it ) ) );
             return;
         }
     }
 
+    // Remove what is left over from the previous generation, e.g. images which are no longer part of the gallery.
+    const QStringList staleFiles = m_manifest.staleFiles();
+    for ( const QString& file : staleFiles )
+        QFile::remove( outputPath( file ) );
+    if ( !m_manifest.save( m_outputRoot ) )
+        kWarning() << "Unable to write the manifest to" << m_outputRoot;
+
+    if ( m_incremental ) {
+        showBrowser();
+        return;
+    }
 
     // Copy files over to destination.
-    QString outputDir = m_setup.baseDir() + QString::fromLatin1( "/" ) + m_setup.outputDir();
     KIO::CopyJob* job = KIO::move( KUrl( m_tempDir.name() ), KUrl(outputDir) );
     connect( job, SIGNAL(result(KJob*)), this, SLOT(showBrowser()) );
 
@@ -164,38 +217,22 @@ void HTMLGenerator::Generator::generate()
 
 bool HTMLGenerator::Generator::generateIndexPage( int width, int height )
 {
-    QString themeDir, themeAuthor, themeName;
-    getThemeInfo( &themeDir, &themeName, &themeAuthor );
-    QString content = Utilities::readFile( QString::fromLatin1( "%1mainpage.html" ).arg( themeDir ) );
-    if ( content.isEmpty() )
-        return false;
-
-    // Adding the copyright comment after DOCTYPE not before (HTML standard requires the DOCTYPE to be first within the document)
-    QRegExp rx( QString::fromLatin1( "^(<!DOCTYPE[^>]*>)" ) );
-    int position;
-
-    rx.setCaseSensitivity( Qt::CaseInsensitive );
-    position = rx.indexIn( content );
-    if ( ( position += rx.matchedLength () ) < 0 )
-    content = QString::fromLatin1("<!--\nMade with KPhotoAlbum. (http://www.kphotoalbum.org/)\nCopyright &copy; Jesper K. Pedersen\nTheme %1 by %2\n-->\n").arg( themeName ).arg( themeAuthor ) + content;
-    else
-    content.insert( position, QString::fromLatin1("\n<!--\nMade with KPhotoAlbum. (http://www.kphotoalbum.org/)\nCopyright &copy; Jesper K. Pedersen\nTheme %1 by %2\n-->\n").arg( themeName ).arg( themeAuthor ) );
-
-    content.replace( QString::fromLatin1( "**DESCRIPTION**" ), m_setup.description() );
-    content.replace( QString::fromLatin1( "**TITLE**" ), m_setup.title() );
+    Template::Values values;
+    values.insert( QString::fromLatin1( "DESCRIPTION" ), m_setup.description() );
+    values.insert( QString::fromLatin1( "TITLE" ), m_setup.title() );
 
     QString copyright;
     if (!m_setup.copyright().isEmpty())
         copyright = QString::fromLatin1( "&#169; %1" ).arg( m_setup.copyright() );
     else
         copyright = QString::fromLatin1( "&nbsp;" );
-    content.replace( QString::fromLatin1( "**COPYRIGHT**" ), copyright );
+    values.insert( QString::fromLatin1( "COPYRIGHT" ), copyright );
 
     QString kimLink = QString::fromLatin1( "Share and Enjoy <a href=\"%1\">KPhotoAlbum export file</a>" ).arg( kimFileName( true ) );
     if ( m_setup.generateKimFile() )
-        content.replace( QString::fromLatin1( "**KIMFILE**" ), kimLink );
+        values.insert( QString::fromLatin1( "KIMFILE" ), kimLink );
     else
-        content.remove( QString::fromLatin1( "**KIMFILE**" ) );
+        values.insert( QString::fromLatin1( "KIMFILE" ), QString() );
     QDomDocument doc;
 
     QDomElement elm;
@@ -300,14 +337,14 @@ bool HTMLGenerator::Generator::generateIndexPage( int width, int height )
     }
     }
 
-    content.replace( QString::fromLatin1( "**THUMBNAIL-TABLE**" ), doc.toString() );
+    values.insert( QString::fromLatin1( "THUMBNAIL-TABLE" ), doc.toString() );
 
     images += QString::fromLatin1( "var enableVideo=%1\n" ).arg( enableVideo ? 1 : 0 );
-    content.replace( QString::fromLatin1( "**JSIMAGES**" ), images );
+    values.insert( QString::fromLatin1( "JSIMAGES" ), images );
     if (!first.isEmpty())
-    content.replace( QString::fromLatin1( "**FIRST**" ), first );
+    values.insert( QString::fromLatin1( "FIRST" ), first );
     if (!last.isEmpty())
-    content.replace( QString::fromLatin1( "**LAST**" ), last );
+    values.insert( QString::fromLatin1( "LAST" ), last );
 
     // -------------------------------------------------- Resolutions
     QString resolutions;
@@ -334,44 +371,24 @@ bool HTMLGenerator::Generator::generateIndexPage( int width, int height )
         }
     }
 
-    content.replace( QString::fromLatin1( "**RESOLUTIONS**" ), resolutions );
+    values.insert( QString::fromLatin1( "RESOLUTIONS" ), resolutions );
 
     if ( wasCancelled() )
         return false;
 
     // -------------------------------------------------- write to file
-    QString fileName = m_tempDir.name() + QString::fromLatin1("/index-%1.html" )
+    QString fileName = QString::fromLatin1("index-%1.html" )
                        .arg(ImageSizeCheckBox::text(width,height,true));
-    bool ok = writeToFile( fileName, content );
-
-    if ( !ok )
-        return false;
-
+    writePage( m_indexTemplate, values, fileName );
     return true;
 }
 
 bool HTMLGenerator::Generator::generateContentPage( int width, int height,
                                                     const DB::FileName& prev, const DB::FileName& current, const DB::FileName& next )
 {
-    QString themeDir, themeAuthor, themeName;
-    getThemeInfo( &themeDir, &themeName, &themeAuthor );
-    QString content = Utilities::readFile( QString::fromLatin1( "%1imagepage.html" ).arg( themeDir ));
-    if ( content.isEmpty() )
-        return false;
-
     DB::ImageInfoPtr info = current.info();
     const DB::FileName currentFile = info->fileName();
-
-    // Adding the copyright comment after DOCTYPE not before (HTML standard requires the DOCTYPE to be first within the document)
-    QRegExp rx( QString::fromLatin1( "^(<!DOCTYPE[^>]*>)" ) );
-    int position;
-
-    rx.setCaseSensitivity( Qt::CaseInsensitive );
-    position = rx.indexIn( content );
-    if ( ( position += rx.matchedLength () ) < 0 )
-    content = QString::fromLatin1("<!--\nMade with KPhotoAlbum. (http://www.kphotoalbum.org/)\nCopyright &copy; Jesper K. Pedersen\nTheme %1 by %2\n-->\n").arg( themeName ).arg( themeAuthor ) + content;
-    else
-    content.insert( position, QString::fromLatin1("\n<!--\nMade with KPhotoAlbum. (http://www.kphotoalbum.org/)\nCopyright &copy; Jesper K. Pedersen\nTheme %1 by %2\n-->\n").arg( themeName ).arg( themeAuthor ) );
+    Template::Values values;
 
     // TODO: Hardcoded non-standard category names is not good practice
     QString title = QString::fromLatin1("");
@@ -386,24 +403,31 @@ bool HTMLGenerator::Generator::generateContentPage( int width, int height,
             title = info->label();
         }
     }
-    content.replace( QString::fromLatin1( "**TITLE**" ), title );
+    values.insert( QString::fromLatin1( "TITLE" ), title );
 
 
+    // the image links to the next page, or back to the index from the last one:
+    QString nextPage;
+    if ( !next.isNull() )
+        nextPage = namePage(width, height, next);
+    else
+        nextPage = QString::fromLatin1( "index-%1.html" ).arg(ImageSizeCheckBox::text(width,height,true));
+
     // Image or video content
     if (Utilities::isVideo(currentFile)) {
         QString videoFile = createVideo( currentFile );
         QString videoBase = videoFile.replace( QRegExp( QString::fromLatin1("\\..*") ), QString::fromLatin1("") );
         if ( m_setup.inlineMovies() )
             if ( m_setup.html5Video() )
-                content.replace( QString::fromLatin1( "**IMAGE_OR_VIDEO**" ), QString::fromLatin1( "<video controls><source src=\"%4\" type=\"video/mp4\" /><source src=\"%5\" type=\"video/ogg\" /><object data=\"%1\"><img src=\"%2\" alt=\"download\"/></object></video><a href=\"%3\"><img src=\"download.png\" /></a>").arg( QString::fromLatin1("%1.mp4").arg( videoBase ) ).arg( createImage( current, 256 ) ).arg( QString::fromLatin1("%1.mp4").arg( videoBase ) ).arg( QString::fromLatin1("%1.mp4").arg( videoBase ) ).arg( QString::fromLatin1("%1.ogg").arg( videoBase ) ) );
+                values.insert( QString::fromLatin1( "IMAGE_OR_VIDEO" ), QString::fromLatin1( "<video controls><source src=\"%4\" type=\"video/mp4\" /><source src=\"%5\" type=\"video/ogg\" /><object data=\"%1\"><img src=\"%2\" alt=\"download\"/></object></video><a href=\"%3\"><img src=\"download.png\" /></a>").arg( QString::fromLatin1("%1.mp4").arg( videoBase ) ).arg( createImage( current, 256 ) ).arg( QString::fromLatin1("%1.mp4").arg( videoBase ) ).arg( QString::fromLatin1("%1.mp4").arg( videoBase ) ).arg( QString::fromLatin1("%1.ogg").arg( videoBase ) ) );
             else
-                content.replace( QString::fromLatin1( "**IMAGE_OR_VIDEO**" ), QString::fromLatin1( "<object data=\"%1\"><img src=\"%2\"/></object>" "<a href=\"%3\"><img src=\"download.png\"/></a>").arg(videoFile).arg( createImage( current, 256 ) ).arg( videoFile ) );
+                values.insert( QString::fromLatin1( "IMAGE_OR_VIDEO" ), QString::fromLatin1( "<object data=\"%1\"><img src=\"%2\"/></object>" "<a href=\"%3\"><img src=\"download.png\"/></a>").arg(videoFile).arg( createImage( current, 256 ) ).arg( videoFile ) );
         else
-            content.replace( QString::fromLatin1( "**IMAGE_OR_VIDEO**" ), QString::fromLatin1( "<a href=\"**NEXTPAGE**\"><img src=\"%2\"/></a>" "<a href=\"%1\"><img src=\"download.png\"/></a>").arg(videoFile).arg( createImage( current, 256 ) ) );
+            values.insert( QString::fromLatin1( "IMAGE_OR_VIDEO" ), QString::fromLatin1( "<a href=\"%3\"><img src=\"%2\"/></a>" "<a href=\"%1\"><img src=\"download.png\"/></a>").arg( videoFile, createImage( current, 256 ), nextPage ) );
     } else
-        content.replace( QString::fromLatin1( "**IMAGE_OR_VIDEO**" ),
-                         QString::fromLatin1( "<a href=\"**NEXTPAGE**\"><img src=\"%1\" alt=\"%1\"/></a>")
-                         .arg(createImage( current, width ) ) );
+        values.insert( QString::fromLatin1( "IMAGE_OR_VIDEO" ),
+                         QString::fromLatin1( "<a href=\"%2\"><img src=\"%1\" alt=\"%1\"/></a>")
+                         .arg( createImage( current, width ), nextPage ) );
 
 
     // -------------------------------------------------- Links
@@ -414,7 +438,7 @@ bool HTMLGenerator::Generator::generateContentPage( int width, int height,
         link = i18n( "<a href=\"%1\">prev</a>", namePage( width, height, prev));
     else
         link = i18n( "prev" );
-    content.replace( QString::fromLatin1( "**PREV**" ), link );
+    values.insert( QString::fromLatin1( "PREV" ), link );
 
     // PENDING(blackie) These next 5 line also exists exactly like that in HTMLGenerator::Generator::generateIndexPage. Please refactor.
     // prevfile
@@ -422,36 +446,31 @@ bool HTMLGenerator::Generator::generateContentPage( int width, int height,
         link = namePage( width, height, prev);
     else
         link = i18n( "prev" );
-    content.replace( QString::fromLatin1( "**PREVFILE**" ), link );
+    values.insert( QString::fromLatin1( "PREVFILE" ), link );
 
     // index link
     link = i18n( "<a href=\"index-%1.html\">index</a>", ImageSizeCheckBox::text(width,height,true));
-    content.replace( QString::fromLatin1( "**INDEX**" ), link );
+    values.insert( QString::fromLatin1( "INDEX" ), link );
 
     // indexfile
     link = QString::fromLatin1( "index-%1.html").arg(ImageSizeCheckBox::text(width,height,true));
-    content.replace( QString::fromLatin1( "**INDEXFILE**" ), link );
+    values.insert( QString::fromLatin1( "INDEXFILE" ), link );
 
     // Next Link
     if ( !next.isNull() )
         link = i18n( "<a href=\"%1\">next</a>", namePage( width, height, next));
     else
         link = i18n( "next" );
-    content.replace( QString::fromLatin1( "**NEXT**" ), link );
+    values.insert( QString::fromLatin1( "NEXT" ), link );
 
     // Nextfile
     if ( !next.isNull() )
         link = namePage(width, height, next);
     else
         link = i18n( "next" );
-    content.replace( QString::fromLatin1( "**NEXTFILE**" ), link );
+    values.insert( QString::fromLatin1( "NEXTFILE" ), link );
 
-    if ( !next.isNull() )
-        link = namePage(width, height, next);
-    else
-        link = QString::fromLatin1( "index-%1.html" ).arg(ImageSizeCheckBox::text(width,height,true));
-
-    content.replace( QString::fromLatin1( "**NEXTPAGE**" ), link );
+    values.insert( QString::fromLatin1( "NEXTPAGE" ), nextPage );
 
 
     // -------------------------------------------------- Resolutions
@@ -472,7 +491,7 @@ bool HTMLGenerator::Generator::generateContentPage( int width, int height,
                 resolutions += QString::fromLatin1( "<a href=\"%1\">%2</a>" ).arg( page ).arg( text );
         }
     }
-    content.replace( QString::fromLatin1( "**RESOLUTIONS**" ), resolutions );
+    values.insert( QString::fromLatin1( "RESOLUTIONS" ), resolutions );
 
     // -------------------------------------------------- Copyright
     QString copyright;
@@ -481,23 +500,20 @@ bool HTMLGenerator::Generator::generateContentPage( int width, int height,
         copyright = QString::fromLatin1( "&#169; %1" ).arg( m_setup.copyright() );
     else
         copyright = QString::fromLatin1( "&nbsp;" );
-    content.replace( QString::fromLatin1( "**COPYRIGHT**" ), QString::fromLatin1( "%1" ).arg( copyright ) );
+    values.insert( QString::fromLatin1( "COPYRIGHT" ), QString::fromLatin1( "%1" ).arg( copyright ) );
 
 
     // -------------------------------------------------- Description
     QString description = populateDescription(DB::ImageDB::instance()->categoryCollection()->categories(), info);
 
     if ( !description.isEmpty() )
-        content.replace( QString::fromLatin1( "**DESCRIPTION**" ), QString::fromLatin1( "<ul>\n%1\n</ul>" ).arg( description ) );
+        values.insert( QString::fromLatin1( "DESCRIPTION" ), QString::fromLatin1( "<ul>\n%1\n</ul>" ).arg( description ) );
     else
-        content.replace( QString::fromLatin1( "**DESCRIPTION**" ), QString::fromLatin1( "" ) );
+        values.insert( QString::fromLatin1( "DESCRIPTION" ), QString::fromLatin1( "" ) );
 
     // -------------------------------------------------- write to file
-    QString fileName = m_tempDir.name() + namePage( width, height, currentFile );
-    bool ok = writeToFile( fileName, content );
-    if ( !ok )
-        return false;
-
+    QString fileName = namePage( width, height, currentFile );
+    writePage( m_pageTemplate, values, fileName );
     return true;
 }
 
@@ -524,22 +540,72 @@ QString HTMLGenerator::Generator::nameImage( const DB::FileName& fileName, int s
         return QString::fromLatin1( "%1-%2.jpg" ).arg( base ).arg( size );
 }
 
+/**
+ * Only records that the given size of the image is needed; the images are written by \ref renderImages
+ * once all pages are generated, so each image only needs to be decoded once.
+ */
 QString HTMLGenerator::Generator::createImage( const DB::FileName& fileName, int size )
 {
-    DB::ImageInfoPtr info = fileName.info();
-    if ( m_generatedFiles.contains( qMakePair(fileName,size) ) ) {
-        m_waitCounter--;
+    QHash< DB::FileName, QList<int> >::iterator it = m_requestedSizes.find( fileName );
+    if ( it == m_requestedSizes.end() ) {
+        m_renderQueue.append( fileName );
+        m_requestedSizes.insert( fileName, QList<int>() << size );
     }
-    else {
+    else if ( it->contains( size ) )
+        m_waitCounter--;
+    else
+        it->append( size );
+
+    return nameImage( fileName, size );
+}
+
+/**
+ * Request the images recorded by \ref createImage from the image loader, at the largest size needed.
+ * All sizes are then written by an \ref ImageRenderTask on a worker thread.
+ * Only a few images are requested at a time, so decoded images don't pile up in memory
+ * when writing them is slower than loading them.
+ */
+void HTMLGenerator::Generator::renderImages()
+{
+    const int maxInFlight = 2 * m_renderPool->maxThreadCount();
+    while ( m_rendersInFlight < maxInFlight && m_nextRender < m_renderQueue.size() && !wasCancelled() ) {
+        const DB::FileName fileName = m_renderQueue.at( m_nextRender++ );
+
+        // only the sizes which are not up to date from a previous generation are rendered:
+        QList<int> sizes;
+        for ( int size : m_requestedSizes.value( fileName ) ) {
+            const QString name = nameImage( fileName, size );
+            QStringList inputs;
+            inputs << sourceKey( fileName ) << QString::number( fileName.info()->angle() ) << QString::number( size );
+            if ( !Utilities::isVideo( fileName ) )
+                inputs << fileName.info()->description(); // it is written into the Exif data
+            const QByteArray key = Manifest::keyFor( inputs );
+            m_manifest.record( name, key );
+            if ( m_manifest.isUpToDate( m_outputRoot, name, key ) )
+                m_waitCounter--;
+            else
+                sizes.append( size );
+        }
+        if ( sizes.isEmpty() )
+            continue;
+        m_requestedSizes[fileName] = sizes;
+
+        const int largest = sizes.contains( -1 ) ? -1 : *std::max_element( sizes.begin(), sizes.end() );
+
         ImageManager::ImageRequest* request =
-            new ImageManager::ImageRequest( fileName, QSize( size, size ),
-                                            info->angle(), this );
+            new ImageManager::ImageRequest( fileName, QSize( largest, largest ),
+                                            fileName.info()->angle(), this );
         request->setPriority( ImageManager::BatchTask );
-        ImageManager::AsyncLoader::instance()->load( request );
-        m_generatedFiles.insert( qMakePair( fileName, size ) );
+        if ( !ImageManager::AsyncLoader::instance()->load( request ) ) {
+            // the file is gone, so there is nothing to wait for:
+            delete request;
+            m_waitCounter -= sizes.count();
+            continue;
+        }
+        ++m_rendersInFlight;
     }
 
-    return nameImage( fileName, size );
+    exitLoopWhenDone();
 }
 
 QString HTMLGenerator::Generator::createVideo( const DB::FileName& fileName )
@@ -548,9 +614,20 @@ QString HTMLGenerator::Generator::createVideo( const DB::FileName& fileName )
     qApp->processEvents();
 
     QString baseName = nameImage( fileName, maxImageSize() );
-    QString destName = m_tempDir.name() + QString::fromLatin1("/") + baseName;
     if ( !m_copiedVideos.contains( fileName )) {
+        QStringList inputs;
+        inputs << sourceKey( fileName ) << QString::number( m_setup.html5VideoGenerate() );
+        const QByteArray key = Manifest::keyFor( inputs );
         if ( m_setup.html5VideoGenerate() ) {
+            const QString videoBase = QString( baseName ).replace( QRegExp( QString::fromLatin1("\\..*") ), QString() );
+            const QString mp4Name = videoBase + QString::fromLatin1(".mp4");
+            const QString oggName = videoBase + QString::fromLatin1(".ogg");
+            m_manifest.record( mp4Name, key );
+            m_manifest.record( oggName, key );
+            if ( m_manifest.isUpToDate( m_outputRoot, mp4Name, key ) && m_manifest.isUpToDate( m_outputRoot, oggName, key ) ) {
+                m_copiedVideos.insert( fileName );
+                return baseName;
+            }
             // TODO: shouldn't we use avconv library directly instead of KRun
             // TODO: should check that the avconv (ffmpeg takes the same parameters on older systems) and ffmpeg2theora exist
             // TODO: Figure out avconv parameters to get rid of ffmpeg2theora
@@ -558,13 +635,16 @@ QString HTMLGenerator::Generator::createVideo( const DB::FileName& fileName )
             KRun::runCommand(QString::fromLatin1("%1 -y -i %2  -vcodec libx264 -b 250k -bt 50k -acodec libfaac -ab 56k -ac 2 -s %3 %4")
                 .arg( m_avconv )
                 .arg( fileName.absolute() ).arg( QString::fromLatin1( "320x240" ) )
-                .arg( destName.replace( QRegExp( QString::fromLatin1("\\..*") ), QString::fromLatin1(".mp4") ) ),
+                .arg( outputPath( mp4Name ) ),
                      MainWindow::Window::theMainWindow() );
             KRun::runCommand(QString::fromLatin1("ffmpeg2theora -v 7 -o %1 -x %2 %3")
-                .arg( destName.replace( QRegExp( QString::fromLatin1("\\..*") ), QString::fromLatin1(".ogg") ) )
+                .arg( outputPath( oggName ) )
                 .arg( QString::fromLatin1( "320" ) ).arg( fileName.absolute() ), MainWindow::Window::theMainWindow() );
-        } else
-            Utilities::copy( fileName.absolute(), destName );
+        } else {
+            m_manifest.record( baseName, key );
+            if ( !m_manifest.isUpToDate( m_outputRoot, baseName, key ) )
+                Utilities::copy( fileName.absolute(), outputPath( baseName ) );
+        }
         m_copiedVideos.insert( fileName );
     }
     return baseName;
@@ -575,28 +655,70 @@ QString HTMLGenerator::Generator::kimFileName( bool relative )
     if ( relative )
         return QString::fromLatin1( "%2.kim" ).arg( m_setup.outputDir() );
     else
-        return QString::fromLatin1( "%1/%2.kim" ).arg( m_tempDir.name() ).arg( m_setup.outputDir() );
+        return outputPath( kimFileName( true ) );
+}
+
+/**
+ * Render the page from the template and write it on a worker thread; see \ref pageWritten.
+ */
+void HTMLGenerator::Generator::writePage( const Template& pageTemplate, const Template::Values& values, const QString& fileName )
+{
+    ++m_pagesInFlight;
+    m_renderPool->start( new PageRenderTask( this, &pageTemplate, values, &m_manifest, m_outputRoot, fileName ) );
 }
 
-bool HTMLGenerator::Generator::writeToFile( const QString& fileName, const QString& str )
+void HTMLGenerator::Generator::pageWritten( const QString& failedFile )
 {
-    QFile file(fileName);
-    if ( !file.open(QIODevice::WriteOnly) ) {
-        KMessageBox::error( this, i18n("Could not create file '%1'.",fileName),
+    --m_pagesInFlight;
+    if ( wasCancelled() )
+        return;
+
+    if ( !failedFile.isEmpty() ) {
+        slotCancelGenerate();
+        KMessageBox::error( this, i18n("Could not create file '%1'.",failedFile),
                             i18n("Could Not Create File") );
-        return false;
+        return;
     }
 
-    QByteArray data = translateToHTML(str).toUtf8();
-    file.write( data );
-    file.close();
-    return true;
+    exitLoopWhenDone();
 }
 
+void HTMLGenerator::Generator::exitLoopWhenDone()
+{
+    if ( m_waitCounter <= 0 && m_pagesInFlight == 0 && m_hasEnteredLoop )
+        m_eventLoop->exit();
+}
+
+/**
+ * Read a page of the theme, and add the copyright comment to it.
+ * Returns an empty template if the page can't be read.
+ */
+HTMLGenerator::Template HTMLGenerator::Generator::loadTemplate( const QString& fileName )
+{
+    QString themeDir, themeAuthor, themeName;
+    getThemeInfo( &themeDir, &themeName, &themeAuthor );
+    QString content = Utilities::readFile( fileName );
+    if ( content.isEmpty() )
+        return Template();
+
+    // Adding the copyright comment after DOCTYPE not before (HTML standard requires the DOCTYPE to be first within the document)
+    QRegExp rx( QString::fromLatin1( "^(<!DOCTYPE[^>]*>)" ) );
+    int position;
+
+    rx.setCaseSensitivity( Qt::CaseInsensitive );
+    position = rx.indexIn( content );
+    if ( ( position += rx.matchedLength () ) < 0 )
+    content = QString::fromLatin1("<!--\nMade with KPhotoAlbum. (http://www.kphotoalbum.org/)\nCopyright &copy; Jesper K. Pedersen\nTheme %1 by %2\n-->\n").arg( themeName ).arg( themeAuthor ) + content;
+    else
+    content.insert( position, QString::fromLatin1("\n<!--\nMade with KPhotoAlbum. (http://www.kphotoalbum.org/)\nCopyright &copy; Jesper K. Pedersen\nTheme %1 by %2\n-->\n").arg( themeName ).arg( themeAuthor ) );
+
+    return Template( content );
+}
 
 QString HTMLGenerator::Generator::translateToHTML( const QString& str )
 {
     QString res;
+    res.reserve( str.length() );
     for ( int i = 0 ; i < str.length() ; ++i ) {
         if ( str[i].unicode() < 128 )
             res.append( str[i] );
@@ -612,8 +734,8 @@ bool HTMLGenerator::Generator::linkIndexFile()
     ImageSizeCheckBox* resolution = m_setup.activeResolutions()[0];
     QString fromFile = QString::fromLatin1("index-%1.html" )
                        .arg(resolution->text(true));
-    QString destFile = m_tempDir.name() + QString::fromLatin1("/index.html");
-    bool ok = Utilities::copy( QFileInfo(destFile).path() + fromFile, destFile );
+    QString destFile = QString::fromLatin1("index.html");
+    bool ok = copyToOutput( outputPath( fromFile ), destFile );
     if ( !ok ) {
         KMessageBox::error( this, i18n("<p>Unable to copy %1 to %2</p>"
                             , fromFile , destFile ) );
@@ -634,39 +756,68 @@ void HTMLGenerator::Generator::slotCancelGenerate()
 void HTMLGenerator::Generator::pixmapLoaded(ImageManager::ImageRequest* request, const QImage& image)
 {
     const DB::FileName fileName = request->databaseFileName();
-    const QSize imgSize = request->size();
-    const bool loadedOK = request->loadedOK();
-
-    progressBar()->setValue( m_total - m_waitCounter );
-
-    m_waitCounter--;
+    if ( wasCancelled() )
+        return;
 
-    int size = imgSize.width();
-    QString file = m_tempDir.name() + QString::fromLatin1( "/" ) + nameImage( fileName, size );
+    QList<ImageRenderTask::Output> outputs;
+    for ( int size : m_requestedSizes.value( fileName ) )
+        outputs.append( qMakePair( size, outputPath( nameImage( fileName, size ) ) ) );
 
-    bool success = loadedOK && image.save( file, "JPEG" );
-    if ( !success ) {
-        // We better stop the imageloading. In case this is a full disk, we will just get all images loaded, while this
-        // error box is showing, resulting in a bunch of error messages, and memory running out due to all the hanging
-        // pixmapLoaded methods.
+    if ( !request->loadedOK() ) {
+        --m_rendersInFlight;
         slotCancelGenerate();
-        KMessageBox::error( this, i18n("Unable to write image '%1'.",file) );
+        KMessageBox::error( this, i18n("Unable to write image '%1'.", outputs.first().second) );
+        return;
     }
 
+    const bool writeExif = !Utilities::isVideo( fileName );
 #ifdef HAVE_EXIV2
-    if ( !Utilities::isVideo( fileName ) ) {
-        try {
-            Exif::Info::instance()->writeInfoToFile( fileName, file );
-        }
-        catch (...)
-        {
-        }
-    }
+    // make sure the instance is created here rather than on one of the worker threads:
+    Exif::Info::instance();
 #endif
+    m_renderPool->start( new ImageRenderTask( this, fileName, image, outputs, writeExif, fileName.info()->description() ) );
+}
 
-    if ( m_waitCounter == 0 && m_hasEnteredLoop) {
-        m_eventLoop->exit();
+void HTMLGenerator::Generator::imageRendered( const QString& failedFile, int count )
+{
+    --m_rendersInFlight;
+    if ( wasCancelled() )
+        return;
+
+    m_waitCounter -= count;
+    progressBar()->setValue( m_total - m_waitCounter );
+
+    if ( !failedFile.isEmpty() ) {
+        // We better stop the imageloading. In case this is a full disk, we will just get all images loaded, while this
+        // error box is showing, resulting in a bunch of error messages.
+        slotCancelGenerate();
+        KMessageBox::error( this, i18n("Unable to write image '%1'.", failedFile) );
+        return;
     }
+
+    renderImages();
+}
+
+QString HTMLGenerator::Generator::outputPath( const QString& fileName ) const
+{
+    return m_outputRoot + fileName;
+}
+
+/**
+ * Copy the file into the output directory, unless an identical copy is already there.
+ */
+bool HTMLGenerator::Generator::copyToOutput( const QString& from, const QString& fileName )
+{
+    QFile source( from );
+    if ( !source.open( QIODevice::ReadOnly ) )
+        return false;
+    const QByteArray key = Manifest::keyFor( source.readAll() );
+    source.close();
+
+    m_manifest.record( fileName, key );
+    if ( m_manifest.isUpToDate( m_outputRoot, fileName, key ) )
+        return true;
+    return Utilities::copy( from, outputPath( fileName ) );
 }
 
 int HTMLGenerator::Generator::calculateSteps()
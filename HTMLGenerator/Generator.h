@@ -24,10 +24,15 @@
 #include <KProgressDialog>
 #include "Utilities/UniqFilenameMapper.h"
 #include "Setup.h"
+#include "Manifest.h"
+#include "Template.h"
 #include <QEventLoop>
 #include <KTempDir>
 #include "Utilities/Set.h"
 #include <QPointer>
+#include <QHash>
+
+class QThreadPool;
 
 namespace DB { class Id; }
 
@@ -47,6 +52,8 @@ public:
 protected slots:
     void slotCancelGenerate();
     void showBrowser();
+    void imageRendered( const QString& failedFile, int count );
+    void pageWritten( const QString& failedFile );
 
 protected:
     bool generateIndexPage( int width, int height );
@@ -63,8 +70,12 @@ public:
     QString createVideo( const DB::FileName& fileName );
 
     QString kimFileName( bool relative );
-    bool writeToFile( const QString& fileName, const QString& str );
-    QString translateToHTML( const QString& );
+    /**
+     * @brief writePage renders the page and writes it to the output directory, unless an unchanged copy is already there.
+     * @param fileName the name of the file relative to the output directory
+     */
+    void writePage( const Template& pageTemplate, const Template::Values& values, const QString& fileName );
+    static QString translateToHTML( const QString& );
     int calculateSteps();
     void getThemeInfo( QString* baseDir, QString* name, QString* author );
 
@@ -74,12 +85,30 @@ public:
     void minImageSize( int& width, int& height);
 
 private:
+    void renderImages();
+    void exitLoopWhenDone();
+    Template loadTemplate( const QString& fileName );
+    QString outputPath( const QString& fileName ) const;
+    bool copyToOutput( const QString& from, const QString& fileName );
+
     Setup m_setup;
     int m_waitCounter;
     int m_total;
     KTempDir m_tempDir;
+    // the directory files are written to: the output directory itself when updating it in place, m_tempDir otherwise.
+    QString m_outputRoot;
+    bool m_incremental;
+    Manifest m_manifest;
+    Template m_indexTemplate;
+    Template m_pageTemplate;
+    int m_pagesInFlight;
     Utilities::UniqFilenameMapper m_filenameMapper;
-    QSet< QPair<DB::FileName,int> > m_generatedFiles;
+    // the sizes needed of each image, and the order in which they were first asked for:
+    QHash< DB::FileName, QList<int> > m_requestedSizes;
+    DB::FileNameList m_renderQueue;
+    int m_nextRender;
+    int m_rendersInFlight;
+    QThreadPool* m_renderPool;
     DB::FileNameSet m_copiedVideos;
     bool m_hasEnteredLoop;
     QPointer<QEventLoop> m_eventLoop;
@@ -39,6 +39,7 @@
 #include "DB/ImageDB.h"
 #include "Generator.h"
 #include "ImageSizeCheckBox.h"
+#include "Manifest.h"
 #include <KTextEdit>
 #include <QStringMatcher>
 #include <QHBoxLayout>
@@ -48,6 +49,7 @@ using namespace HTMLGenerator;
 HTMLDialog::HTMLDialog( QWidget* parent )
    : KPageDialog(parent)
    , m_list()
+   , m_incrementalUpdate( false )
 {
     setWindowTitle( i18n("HTML Export") );
     setButtons( KDialog::Ok | KDialog::Cancel | KDialog::Help );
@@ -407,7 +409,28 @@ bool HTMLDialog::checkVars()
 
 
     // test if destination directory exists.
+    m_incrementalUpdate = false;
     bool exists = KIO::NetAccess::exists( KUrl(outputDir), KIO::NetAccess::DestinationSide, MainWindow::Window::theMainWindow() );
+    const QString manifest = outputDir + QString::fromLatin1( "/" ) + Manifest::fileName();
+    if ( exists && KUrl(outputDir).isLocalFile()
+         && KIO::NetAccess::exists( KUrl(manifest), KIO::NetAccess::SourceSide, MainWindow::Window::theMainWindow() ) ) {
+        // A gallery generated by us, which can be updated in place.
+        const int answer = KMessageBox::questionYesNoCancel( this,
+                                                             i18n("<p>Output directory %1 already contains an HTML export.</p>"
+                                                                  "<p>Should it be updated? Only the images and pages that changed "
+                                                                  "are generated again. Otherwise, %2 is deleted first.</p>", outputDir, outputDir ),
+                                                             i18n("Directory Exists"),
+                                                             KGuiItem( i18n("Update") ), KStandardGuiItem::del() );
+        if ( answer == KMessageBox::Yes ) {
+            m_incrementalUpdate = true;
+            return true;
+        }
+        if ( answer == KMessageBox::No ) {
+            KIO::NetAccess::del( KUrl(outputDir), MainWindow::Window::theMainWindow() );
+            return true;
+        }
+        return false;
+    }
     if ( exists ) {
         int answer = KMessageBox::warningYesNo( this,
                                                 i18n("<p>Output directory %1 already exists. "
@@ -557,6 +580,7 @@ Setup HTMLGenerator::HTMLDialog::setup() const
     setup.setInlineMovies( m_inlineMovies->isChecked() );
     setup.setHtml5Video( m_html5Video->isChecked() );
     setup.setHtml5VideoGenerate( m_html5VideoGenerate->isChecked() );
+    setup.setIncrementalUpdate( m_incrementalUpdate );
     return setup;
 }
 
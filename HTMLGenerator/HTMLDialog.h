@@ -80,6 +80,7 @@ private:
     QMap< QString, QCheckBox* > m_whatToIncludeMap;
     QList<ImageSizeCheckBox*> m_sizeCheckBoxes;
     DB::FileNameList m_list;
+    bool m_incrementalUpdate;
 };
 
 }
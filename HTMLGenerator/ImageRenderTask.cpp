@@ -0,0 +1,78 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ImageRenderTask.h"
+#include <config-kpa-exiv2.h>
+#ifdef HAVE_EXIV2
+#  include "Exif/Info.h"
+#endif
+#include <QMetaObject>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+
+HTMLGenerator::ImageRenderTask::ImageRenderTask( QObject* receiver, const DB::FileName& source, const QImage& image,
+                                                 const QList<Output>& outputs, bool writeExif, const QString& description )
+    : m_receiver( receiver ), m_source( source ), m_image( image ), m_outputs( outputs ),
+      m_writeExif( writeExif ), m_description( description )
+{
+}
+
+void HTMLGenerator::ImageRenderTask::run()
+{
+    // The user is likely to keep on working while the export is running.
+    QThread::currentThread()->setPriority( QThread::LowPriority );
+
+    // Largest first (full size being -1), so each size can be scaled down from the previous one,
+    // which is much cheaper than scaling each of them from the decoded image.
+    std::sort( m_outputs.begin(), m_outputs.end(), []( const Output& a, const Output& b ) {
+        if ( a.first == -1 || b.first == -1 )
+            return a.first == -1 && b.first != -1;
+        return a.first > b.first;
+    } );
+
+    QString failedFile;
+    QStringList written;
+    QImage level = m_image;
+    for ( const Output& output : m_outputs ) {
+        const int size = output.first;
+        if ( size > 0 && qMax( level.width(), level.height() ) > size )
+            level = level.scaled( size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+        if ( !level.save( output.second, "JPEG" ) ) {
+            failedFile = output.second;
+            break;
+        }
+        written.append( output.second );
+    }
+    m_image = QImage();
+
+#ifdef HAVE_EXIV2
+    if ( m_writeExif && !written.isEmpty() ) {
+        try {
+            Exif::Info::instance()->writeInfoToFiles( m_source, written, m_description );
+        }
+        catch (...)
+        {
+        }
+    }
+#endif
+
+    QMetaObject::invokeMethod( m_receiver, "imageRendered", Qt::QueuedConnection,
+                               Q_ARG( QString, failedFile ), Q_ARG( int, m_outputs.count() ) );
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,64 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef HTMLGENERATOR_IMAGERENDERTASK_H
+#define HTMLGENERATOR_IMAGERENDERTASK_H
+
+#include <DB/FileName.h>
+#include <QImage>
+#include <QList>
+#include <QPair>
+#include <QRunnable>
+#include <QString>
+
+class QObject;
+
+namespace HTMLGenerator
+{
+
+/**
+ * @brief The ImageRenderTask writes all sizes of one image of the HTML export.
+ *
+ * The image is decoded only once, at the largest size that is needed. The task derives all smaller sizes
+ * from it by successive downscaling, encodes them as JPEG and copies the Exif information over.
+ * This is done on a worker thread; when done, the task calls the slot
+ * <tt>imageRendered(QString failedFile, int count)</tt> of the receiver on its thread.
+ */
+class ImageRenderTask : public QRunnable
+{
+public:
+    /// the size (-1 for full size) and file name of an image to write
+    typedef QPair<int, QString> Output;
+
+    ImageRenderTask( QObject* receiver, const DB::FileName& source, const QImage& image,
+                     const QList<Output>& outputs, bool writeExif, const QString& description );
+    void run() override;
+
+private:
+    QObject* m_receiver;
+    DB::FileName m_source;
+    QImage m_image;
+    QList<Output> m_outputs;
+    bool m_writeExif;
+    QString m_description;
+};
+
+}
+
+#endif /* HTMLGENERATOR_IMAGERENDERTASK_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,104 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "Manifest.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+// Bump this whenever the way files are generated changes, so all of them are generated again.
+const int FILEVERSION=1;
+
+QString HTMLGenerator::Manifest::fileName()
+{
+    return QString::fromLatin1( "kphotoalbum-manifest" );
+}
+
+void HTMLGenerator::Manifest::load( const QString& directory )
+{
+    m_previous.clear();
+    QFile file( directory + fileName() );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream stream( &file );
+    int version;
+    stream >> version;
+    if ( version != FILEVERSION )
+        return; // generate everything again
+
+    stream >> m_previous;
+    if ( stream.status() != QDataStream::Ok )
+        m_previous.clear();
+}
+
+bool HTMLGenerator::Manifest::save( const QString& directory ) const
+{
+    QFile file( directory + fileName() );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QMutexLocker locker( &m_lock );
+    QDataStream stream( &file );
+    stream << FILEVERSION << m_current;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool HTMLGenerator::Manifest::isUpToDate( const QString& directory, const QString& file, const QByteArray& key ) const
+{
+    QHash<QString, QByteArray>::const_iterator it = m_previous.constFind( file );
+    if ( it == m_previous.constEnd() || it.value() != key )
+        return false;
+    return QFileInfo( directory + file ).exists();
+}
+
+void HTMLGenerator::Manifest::record( const QString& file, const QByteArray& key )
+{
+    QMutexLocker locker( &m_lock );
+    m_current.insert( file, key );
+}
+
+QStringList HTMLGenerator::Manifest::staleFiles() const
+{
+    QMutexLocker locker( &m_lock );
+    QStringList result;
+    for ( QHash<QString, QByteArray>::const_iterator it = m_previous.constBegin(); it != m_previous.constEnd(); ++it ) {
+        if ( !m_current.contains( it.key() ) )
+            result.append( it.key() );
+    }
+    return result;
+}
+
+QByteArray HTMLGenerator::Manifest::keyFor( const QStringList& inputs )
+{
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    for ( const QString& input : inputs ) {
+        hash.addData( input.toUtf8() );
+        // separate the inputs, so ("ab","c") and ("a","bc") have different keys:
+        hash.addData( "\0", 1 );
+    }
+    return hash.result();
+}
+
+QByteArray HTMLGenerator::Manifest::keyFor( const QByteArray& content )
+{
+    return QCryptographicHash::hash( content, QCryptographicHash::Md5 );
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
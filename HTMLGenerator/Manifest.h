@@ -0,0 +1,80 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef HTMLGENERATOR_MANIFEST_H
+#define HTMLGENERATOR_MANIFEST_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+namespace HTMLGenerator
+{
+
+/**
+ * @brief The Manifest records which inputs each file of a generated HTML gallery was made from.
+ *
+ * It is stored in the output directory. When the gallery is generated again into the same directory,
+ * files whose inputs did not change are not generated again, and files which are no longer part of
+ * the gallery are deleted.
+ *
+ * The inputs of a file are summarized in a key, which is a hash over e.g. the MD5 sum of the image,
+ * its rotation, the size and the description for images, and over the content for pages and theme files.
+ *
+ * Files may be recorded from several threads at the same time.
+ */
+class Manifest
+{
+public:
+    static QString fileName();
+
+    /**
+     * @brief load reads the manifest of the previous generation from the given directory, if there is any.
+     */
+    void load( const QString& directory );
+    bool save( const QString& directory ) const;
+
+    /**
+     * @brief isUpToDate returns true if the file was generated from the same inputs last time, and still exists.
+     * @param file the name of the file relative to the output directory
+     */
+    bool isUpToDate( const QString& directory, const QString& file, const QByteArray& key ) const;
+    /**
+     * @brief record adds the file to the manifest being generated.
+     */
+    void record( const QString& file, const QByteArray& key );
+    /**
+     * @brief staleFiles returns the files of the previous generation which are not part of the current one.
+     */
+    QStringList staleFiles() const;
+
+    static QByteArray keyFor( const QStringList& inputs );
+    static QByteArray keyFor( const QByteArray& content );
+
+private:
+    QHash<QString, QByteArray> m_previous;
+    QHash<QString, QByteArray> m_current;
+    mutable QMutex m_lock;
+};
+
+}
+
+#endif /* HTMLGENERATOR_MANIFEST_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
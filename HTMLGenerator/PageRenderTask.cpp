@@ -0,0 +1,50 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "PageRenderTask.h"
+#include "Generator.h"
+#include "Manifest.h"
+#include <QFile>
+#include <QMetaObject>
+
+HTMLGenerator::PageRenderTask::PageRenderTask( QObject* receiver, const Template* pageTemplate, const Template::Values& values,
+                                               Manifest* manifest, const QString& outputRoot, const QString& fileName )
+    : m_receiver( receiver ), m_template( pageTemplate ), m_values( values ),
+      m_manifest( manifest ), m_outputRoot( outputRoot ), m_fileName( fileName )
+{
+}
+
+void HTMLGenerator::PageRenderTask::run()
+{
+    const QByteArray data = Generator::translateToHTML( m_template->render( m_values ) ).toUtf8();
+    m_values.clear();
+
+    QString failedFile;
+    const QByteArray key = Manifest::keyFor( data );
+    m_manifest->record( m_fileName, key );
+    if ( !m_manifest->isUpToDate( m_outputRoot, m_fileName, key ) ) {
+        QFile file( m_outputRoot + m_fileName );
+        if ( file.open( QIODevice::WriteOnly ) && file.write( data ) == data.size() )
+            file.close();
+        else
+            failedFile = file.fileName();
+    }
+
+    QMetaObject::invokeMethod( m_receiver, "pageWritten", Qt::QueuedConnection, Q_ARG( QString, failedFile ) );
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,59 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef HTMLGENERATOR_PAGERENDERTASK_H
+#define HTMLGENERATOR_PAGERENDERTASK_H
+
+#include "Template.h"
+#include <QRunnable>
+#include <QString>
+
+class QObject;
+
+namespace HTMLGenerator
+{
+class Manifest;
+
+/**
+ * @brief The PageRenderTask renders one page of the HTML export from its template and writes it.
+ *
+ * The page is only written when it differs from the one recorded in the manifest.
+ * This is done on a worker thread; when done, the task calls the slot
+ * <tt>pageWritten(QString failedFile)</tt> of the receiver on its thread.
+ * The template and the manifest must outlive the task.
+ */
+class PageRenderTask : public QRunnable
+{
+public:
+    PageRenderTask( QObject* receiver, const Template* pageTemplate, const Template::Values& values,
+                    Manifest* manifest, const QString& outputRoot, const QString& fileName );
+    void run() override;
+
+private:
+    QObject* m_receiver;
+    const Template* m_template;
+    Template::Values m_values;
+    Manifest* m_manifest;
+    QString m_outputRoot;
+    QString m_fileName;
+};
+
+}
+
+#endif /* HTMLGENERATOR_PAGERENDERTASK_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -19,7 +19,7 @@
 #include <QList>
 
 HTMLGenerator::Setup::Setup()
-    : m_images()
+    : m_images(), m_incrementalUpdate( false )
 {
     /* nop */
 }
@@ -206,4 +206,14 @@ bool HTMLGenerator::Setup::html5VideoGenerate() const
     return m_html5VideoGenerate;
 
 }
+
+void HTMLGenerator::Setup::setIncrementalUpdate( bool incrementalUpdate )
+{
+    m_incrementalUpdate = incrementalUpdate;
+}
+
+bool HTMLGenerator::Setup::incrementalUpdate() const
+{
+    return m_incrementalUpdate;
+}
 // vi:expandtab:tabstop=4 shiftwidth=4:
@@ -86,6 +86,13 @@ public:
     void setHtml5VideoGenerate( bool html5VideoGenerate );
     bool html5VideoGenerate() const;
 
+    /**
+     * @brief incrementalUpdate is true if an existing export in the output directory should be updated in place.
+     * \see Manifest
+     */
+    void setIncrementalUpdate( bool incrementalUpdate );
+    bool incrementalUpdate() const;
+
 private:
     QString m_title;
     QString m_baseDir;
@@ -105,6 +112,7 @@ private:
     bool m_inlineMovies;
     bool m_html5Video;
     bool m_html5VideoGenerate;
+    bool m_incrementalUpdate;
 };
 
 }
@@ -0,0 +1,108 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "Template.h"
+
+namespace
+{
+bool isTokenName( const QStringRef& name )
+{
+    if ( name.isEmpty() )
+        return false;
+    for ( int i = 0; i < name.length(); ++i ) {
+        const QChar ch = name.at( i );
+        if ( !( ( ch >= QLatin1Char('A') && ch <= QLatin1Char('Z') ) || ch.isDigit()
+                || ch == QLatin1Char('_') || ch == QLatin1Char('-') ) )
+            return false;
+    }
+    return true;
+}
+}
+
+HTMLGenerator::Template::Template()
+    : m_literalLength( 0 )
+{
+}
+
+HTMLGenerator::Template::Template( const QString& text )
+    : m_literalLength( 0 )
+{
+    const QString marker = QString::fromLatin1( "**" );
+    int literalStart = 0;
+    int pos = text.indexOf( marker );
+    while ( pos != -1 ) {
+        const int end = text.indexOf( marker, pos + 2 );
+        if ( end == -1 )
+            break;
+
+        const QStringRef name = text.midRef( pos + 2, end - pos - 2 );
+        if ( !isTokenName( name ) ) {
+            // e.g. "/** ... */" in a style sheet; the second marker may still start a token:
+            pos = text.indexOf( marker, pos + 1 );
+            continue;
+        }
+
+        if ( pos > literalStart ) {
+            const Segment literal = { text.mid( literalStart, pos - literalStart ), false };
+            m_segments.append( literal );
+            m_literalLength += literal.text.length();
+        }
+        const Segment token = { name.toString(), true };
+        m_segments.append( token );
+
+        literalStart = end + 2;
+        pos = text.indexOf( marker, literalStart );
+    }
+
+    if ( literalStart < text.length() ) {
+        const Segment literal = { text.mid( literalStart ), false };
+        m_segments.append( literal );
+        m_literalLength += literal.text.length();
+    }
+}
+
+bool HTMLGenerator::Template::isEmpty() const
+{
+    return m_segments.isEmpty();
+}
+
+QString HTMLGenerator::Template::render( const Values& values ) const
+{
+    int length = m_literalLength;
+    for ( const Segment& segment : m_segments ) {
+        if ( segment.isToken )
+            length += values.value( segment.text ).length() + 4;
+    }
+
+    QString result;
+    result.reserve( length );
+    for ( const Segment& segment : m_segments ) {
+        if ( !segment.isToken ) {
+            result += segment.text;
+            continue;
+        }
+
+        Values::const_iterator value = values.constFind( segment.text );
+        if ( value != values.constEnd() )
+            result += value.value();
+        else
+            result += QString::fromLatin1( "**%1**" ).arg( segment.text );
+    }
+    return result;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
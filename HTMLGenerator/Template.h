@@ -0,0 +1,67 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef HTMLGENERATOR_TEMPLATE_H
+#define HTMLGENERATOR_TEMPLATE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace HTMLGenerator
+{
+
+/**
+ * @brief The Template is a page of a theme, parsed once into literal text and the tokens to fill in.
+ *
+ * Tokens are written as <tt>**NAME**</tt> in the theme files, e.g. <tt>**TITLE**</tt> or <tt>**IMAGE_OR_VIDEO**</tt>.
+ * Rendering a page appends the literal text and the values of the tokens to a single buffer,
+ * instead of searching the whole page once for each of the tokens.
+ *
+ * A template is not modified by rendering, so it can be used by several threads at the same time.
+ */
+class Template
+{
+public:
+    typedef QHash<QString, QString> Values;
+
+    Template();
+    explicit Template( const QString& text );
+
+    bool isEmpty() const;
+    /**
+     * @brief render returns the page with each token replaced by its value.
+     * Tokens without a value are kept as they are written in the theme.
+     * Values are inserted as they are, i.e. they are not searched for tokens themselves.
+     */
+    QString render( const Values& values ) const;
+
+private:
+    struct Segment
+    {
+        QString text; // the literal text, or the name of the token
+        bool isToken;
+    };
+    QVector<Segment> m_segments;
+    int m_literalLength;
+};
+
+}
+
+#endif /* HTMLGENERATOR_TEMPLATE_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
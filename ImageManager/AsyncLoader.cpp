@@ -50,17 +50,20 @@ ImageManager::AsyncLoader* ImageManager::AsyncLoader::instance()
 void ImageManager::AsyncLoader::init()
 {
 
-    // Use up to three cores for thumbnail generation. No more than three as that
-    // likely will make it less efficient due to three cores hitting the harddisk at the same time.
-    // This might limit the throughput on SSD systems, but we likely have a few years before people
-    // put all of their pictures on SSDs.
+    // Start one loader thread per core. How many of them actually load at the same time is decided by
+    // the resource scheduler, which also limits the number of threads hitting the same disk,
+    // and shares the cores with the background jobs.
     // We need one more core in the computer for the GUI thread, but we won't dedicate it to GUI,
     // as that'd mean that a dual-core box would only have one core decoding images, which would be
     // suboptimal.
-    // In case of only one core in the computer, use one core for thumbnail generation
-    // TODO(isilmendil): It seems that many people have their images on NFS-mounts.
-    //                   Should we somehow detect this and allocate less threads there?
-    const int cores = qMax( 1, qMin( 3, QThread::idealThreadCount() ) );
+    Utilities::ResourceScheduler* scheduler = Utilities::ResourceScheduler::instance();
+    scheduler->addReleaseListener( [this] {
+        // resources are available again, so loader threads waiting for them should try again:
+        QMutexLocker locker( &m_lock );
+        m_sleepers.wakeAll();
+    } );
+
+    const int cores = scheduler->cpuSlots();
 
     for ( int i = 0; i < cores; ++i) {
         ImageLoaderThread* imageLoader = new ImageLoaderThread();
@@ -135,15 +138,44 @@ int ImageManager::AsyncLoader::activeCount() const
     return m_currentLoading.count();
 }
 
-ImageManager::ImageRequest* ImageManager::AsyncLoader::next()
+ImageManager::ImageRequest* ImageManager::AsyncLoader::next( Utilities::ResourceScheduler::Token* token )
 {
     QMutexLocker dummy( &m_lock );
-    ImageRequest* request = nullptr;
-    while ( !( request = m_loadList.popNext() ) )
-        m_sleepers.wait( &m_lock );
-    m_currentLoading.insert( request );
+    while ( true ) {
+        // A request waiting for a busy disk must not hold up the requests behind it for other disks,
+        // so look a bit further down the queue, and put the skipped requests back in their order.
+        QList<ImageRequest*> skipped;
+        ImageRequest* found = nullptr;
+        while ( skipped.count() < MAX_SKIPPED_REQUESTS ) {
+            ImageRequest* request = m_loadList.popNext();
+            if ( !request )
+                break;
+
+            // The user is waiting for visible thumbnails and the viewer, everything else is background work.
+            const Utilities::ResourceScheduler::Priority priority = ( request->priority() >= ThumbnailVisible )
+                    ? Utilities::ResourceScheduler::Foreground : Utilities::ResourceScheduler::Background;
+            bool ioBlocked;
+            *token = Utilities::ResourceScheduler::instance()->tryAcquire( priority, request->fileSystemFileName().absolute(), &ioBlocked );
+            if ( token->isValid() ) {
+                found = request;
+                break;
+            }
+            skipped.append( request );
+            // Without a CPU slot, none of the (less important) requests further down can be loaded either.
+            if ( !ioBlocked )
+                break;
+        }
+
+        for ( int i = skipped.count() - 1; i >= 0; --i )
+            m_loadList.requeue( skipped.at( i ) );
 
-    return request;
+        if ( found ) {
+            m_currentLoading.insert( found );
+            return found;
+        }
+        // No resources for any of them right now, so wait until either some are released or a more important request comes in.
+        m_sleepers.wait( &m_lock );
+    }
 }
 
 void ImageManager::AsyncLoader::customEvent( QEvent* ev )
@@ -177,8 +209,13 @@ void ImageManager::AsyncLoader::customEvent( QEvent* ev )
             image = m_brokenImage;
         }
 
-        if ( request->isThumbnailRequest() )
-            ImageManager::ThumbnailCache::instance()->insert( request->databaseFileName(), image );
+        if ( request->isThumbnailRequest() ) {
+            const ThumbnailCache::EncodedThumbnail thumbnail = iev->thumbnail();
+            if ( thumbnail.isEmpty() )
+                ImageManager::ThumbnailCache::instance()->insert( request->databaseFileName(), image );
+            else
+                ImageManager::ThumbnailCache::instance()->insert( request->databaseFileName(), thumbnail );
+        }
 
 
         if ( requestStillNeeded && request->client() ) {
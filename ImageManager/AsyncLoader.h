@@ -25,6 +25,7 @@
 #include <qimage.h>
 #include "RequestQueue.h"
 #include "enums.h"
+#include <Utilities/ResourceScheduler.h>
 
 namespace ImageManager
 {
@@ -57,7 +58,9 @@ private:
     friend class ImageLoaderThread;  // may call 'next()'
     void init();
 
-    ImageRequest* next();
+    ImageRequest* next( Utilities::ResourceScheduler::Token* token );
+    // how many requests waiting for a busy disk next() looks past, at most:
+    enum { MAX_SKIPPED_REQUESTS = 32 };
 
     static AsyncLoader* s_instance;
 
@@ -0,0 +1,176 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "ChunkedCacheStore.h"
+#include "ThumbnailMapping.h"
+#include <Settings/SettingsData.h>
+#include <QCache>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+const int MAXFILESIZE=32*1024*1024;
+
+ImageManager::ChunkedCacheStore::ChunkedCacheStore( const QString& directory, const QString& chunkPrefix, int mappedChunks )
+    : m_chunkPrefix( chunkPrefix ), m_currentFile(0), m_currentOffset(0)
+{
+    m_memcache = new QCache<int,ThumbnailMapping>( mappedChunks );
+    m_directory = QDir(Settings::SettingsData::instance()->imageDirectory()).absoluteFilePath( directory );
+    if ( !m_directory.endsWith( QLatin1Char('/') ) )
+        m_directory += QLatin1Char('/');
+    if ( !QFile::exists(m_directory) )
+        QDir().mkpath(m_directory);
+}
+
+ImageManager::ChunkedCacheStore::~ChunkedCacheStore()
+{
+    delete m_memcache;
+}
+
+bool ImageManager::ChunkedCacheStore::append( const QList<QByteArray>& blobs, QList<CacheFileInfo>* locations )
+{
+    QFile file( fileNameForIndex(m_currentFile) );
+    if ( ! file.open(QIODevice::ReadWrite ) )
+    {
+        qWarning("Failed to open cache file %s for inserting", qPrintable( file.fileName() ) );
+        return false;
+    }
+    if ( ! file.seek( m_currentOffset ) )
+    {
+        qWarning("Failed to seek in cache file %s", qPrintable( file.fileName() ) );
+        return false;
+    }
+
+    // purge in-memory cache for the current file:
+    m_memcache->remove( m_currentFile );
+
+    QList<CacheFileInfo> written;
+    int offset = m_currentOffset;
+    Q_FOREACH( const QByteArray& data, blobs ) {
+        const int size = data.size();
+        if ( file.write( data.data(), size ) != size )
+        {
+            qWarning("Failed to write data to cache file %s", qPrintable( file.fileName() ) );
+            return false;
+        }
+        written.append( CacheFileInfo( m_currentFile, offset, size ) );
+        offset += size;
+    }
+    if ( ! file.flush() )
+    {
+        qWarning("Failed to write data to cache file %s", qPrintable( file.fileName() ) );
+        return false;
+    }
+    file.close();
+
+    // Update offset
+    m_currentOffset = offset;
+    if ( m_currentOffset > MAXFILESIZE ) {
+        m_currentFile++;
+        m_currentOffset = 0;
+    }
+
+    if ( locations )
+        locations->append( written );
+    return true;
+}
+
+QByteArray ImageManager::ChunkedCacheStore::data( const CacheFileInfo& info ) const
+{
+    ThumbnailMapping *t = m_memcache->object(info.fileIndex);
+    if (!t || !t->isValid())
+    {
+        t = new ThumbnailMapping( fileNameForIndex( info.fileIndex ) );
+        if (!t->isValid())
+        {
+            qWarning("Failed to map cache file");
+            delete t;
+            return QByteArray();
+        }
+        m_memcache->insert(info.fileIndex,t);
+    }
+    if ( info.offset < 0 || info.size < 0 || info.offset + info.size > t->map.size() )
+        return QByteArray();
+    return t->map.mid( info.offset, info.size );
+}
+
+void ImageManager::ChunkedCacheStore::clear()
+{
+    for ( int i = 0; i <= m_currentFile; ++i )
+        QFile::remove( fileNameForIndex(i) );
+    m_currentFile = 0;
+    m_currentOffset = 0;
+    m_memcache->clear();
+}
+
+void ImageManager::ChunkedCacheStore::saveIndex( const QString& indexName, int version, const std::function<void(QDataStream&)>& writeEntries ) const
+{
+    QTemporaryFile file;
+    if ( !file.open() ) {
+        qWarning("Failed to create temporary file");
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << version
+           << m_currentFile
+           << m_currentOffset;
+    writeEntries( stream );
+    file.close();
+
+    const QString realFileName = path( indexName );
+    QFile::remove( realFileName );
+    if ( !file.copy( realFileName ) )
+        qWarning("Failed to copy the temporary file %s to %s", qPrintable( file.fileName() ), qPrintable( realFileName ) );
+
+    QFile realFile( realFileName );
+    realFile.open( QIODevice::ReadOnly );
+    realFile.setPermissions( QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup | QFile::WriteGroup | QFile::ReadOther );
+    realFile.close();
+}
+
+void ImageManager::ChunkedCacheStore::loadIndex( const QString& indexName, const QList<int>& supportedVersions,
+                                                 const std::function<void(QDataStream&, int version)>& readEntries )
+{
+    QFile file( path( indexName ) );
+    if ( !file.exists() )
+        return;
+
+    file.open(QIODevice::ReadOnly);
+    QDataStream stream(&file);
+    int version;
+    stream >> version;
+    if ( !supportedVersions.contains( version ) )
+        return; //Discard cache
+
+    stream >> m_currentFile
+           >> m_currentOffset;
+    readEntries( stream, version );
+}
+
+QString ImageManager::ChunkedCacheStore::path( const QString& fileName ) const
+{
+    return m_directory + fileName;
+}
+
+QString ImageManager::ChunkedCacheStore::fileNameForIndex( int index ) const
+{
+    return path( m_chunkPrefix + QString::number(index) );
+}
+// vi:expandtab:tabstop=4 shiftwidth=4:
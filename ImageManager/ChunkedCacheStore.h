@@ -0,0 +1,104 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef IMAGEMANAGER_CHUNKEDCACHESTORE_H
+#define IMAGEMANAGER_CHUNKEDCACHESTORE_H
+
+#include "CacheFileInfo.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <functional>
+
+class QDataStream;
+template <class Key, class T>
+class QCache;
+
+namespace ImageManager {
+
+class ThumbnailMapping;
+
+/**
+ * @brief The ChunkedCacheStore class holds the data of the on-disk caches in chunk files.
+ *
+ * Data is appended to numbered chunk files (e.g. \c thumb-0, \c thumb-1, ...) in a directory below
+ * the image root. A new chunk is started once the current one exceeds 32MB, to avoid a huge file
+ * changing over and over again, with a bad hit for backups. Chunks are memory mapped for reading,
+ * and the most recently used mappings are kept around.
+ *
+ * The store does not know what the data is; the caches built on it keep track of the
+ * \ref CacheFileInfo of their entries and save it in an index file via \ref saveIndex.
+ */
+class ChunkedCacheStore
+{
+public:
+    /**
+     * @param directory the directory of the cache, relative to the image root
+     * @param chunkPrefix the chunk files are named chunkPrefix followed by their number
+     * @param mappedChunks the number of chunk files to keep mapped into memory
+     */
+    ChunkedCacheStore( const QString& directory, const QString& chunkPrefix, int mappedChunks );
+    ~ChunkedCacheStore();
+
+    /**
+     * @brief append writes the blobs back to back into the current chunk file.
+     * @param locations if given, the location of each blob is appended to it
+     * @return false if the data could not be written
+     */
+    bool append( const QList<QByteArray>& blobs, QList<CacheFileInfo>* locations );
+    /**
+     * @brief data returns a copy of the data at the given location, or a null QByteArray if it cannot be read.
+     */
+    QByteArray data( const CacheFileInfo& info ) const;
+    /**
+     * @brief clear removes all chunk files.
+     */
+    void clear();
+
+    /**
+     * @brief saveIndex writes the index file of the cache.
+     * The version and the current write position of the store are written, followed by whatever writeEntries writes.
+     */
+    void saveIndex( const QString& indexName, int version, const std::function<void(QDataStream&)>& writeEntries ) const;
+    /**
+     * @brief loadIndex reads an index file written by saveIndex.
+     * If the index was written with one of the supportedVersions, the write position of the store is restored
+     * and readEntries is called to read the rest; otherwise the index is discarded.
+     */
+    void loadIndex( const QString& indexName, const QList<int>& supportedVersions,
+                    const std::function<void(QDataStream&, int version)>& readEntries );
+
+    /**
+     * @brief path returns the absolute path of a file in the cache directory.
+     */
+    QString path( const QString& fileName ) const;
+
+private:
+    QString fileNameForIndex( int index ) const;
+
+    QString m_directory;
+    QString m_chunkPrefix;
+    int m_currentFile;
+    int m_currentOffset;
+    mutable QCache<int,ThumbnailMapping> *m_memcache;
+};
+
+}
+
+#endif // IMAGEMANAGER_CHUNKEDCACHESTORE_H
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -39,6 +39,9 @@ class ExtractOneVideoFrame : public QObject
 public:
     static void extract(const DB::FileName& filename, double offset, QObject* receiver, const char* slot);
 
+    /** Set a token on videos we are unable to extract all thumbnails from. */
+    static void markShortVideo(const DB::FileName& fileName);
+
 private slots:
     void frameFetched();
     void handleError(QProcess::ProcessError);
@@ -50,7 +53,6 @@ private:
     ExtractOneVideoFrame(const DB::FileName& filename, double offset, QObject* receiver, const char* slot);
     void setupWorkingDirectory();
     void deleteWorkingDirectory();
-    void markShortVideo(const DB::FileName& fileName);
 
     QString m_workingDirectory;
     Utilities::Process* m_process;
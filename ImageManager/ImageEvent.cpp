@@ -18,8 +18,8 @@
 
 #include "ImageEvent.h"
 
-ImageManager::ImageEvent::ImageEvent( ImageRequest* request, const QImage& image )
-    : QEvent( static_cast<QEvent::Type>(ImageEventID) ), m_request( request ),  m_image( image )
+ImageManager::ImageEvent::ImageEvent( ImageRequest* request, const QImage& image, const ThumbnailCache::EncodedThumbnail& thumbnail )
+    : QEvent( static_cast<QEvent::Type>(ImageEventID) ), m_request( request ),  m_image( image ), m_thumbnail( thumbnail )
 {
     // PENDING(blackie): Investigate if this is still needed with Qt4.
     // We would like to use QDeepCopy, but that results in multiple
@@ -37,4 +37,9 @@ QImage ImageManager::ImageEvent::image()
 {
     return m_image;
 }
+
+ImageManager::ThumbnailCache::EncodedThumbnail ImageManager::ImageEvent::thumbnail() const
+{
+    return m_thumbnail;
+}
 // vi:expandtab:tabstop=4 shiftwidth=4:
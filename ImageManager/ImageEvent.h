@@ -21,6 +21,7 @@
 
 #include <QImage>
 #include <QEvent>
+#include "ThumbnailCache.h"
 
 namespace ImageManager {
 
@@ -28,13 +29,17 @@ class ImageRequest;
 
 class ImageEvent :public QEvent {
 public:
-    ImageEvent( ImageRequest* request, const QImage& image );
+    ImageEvent( ImageRequest* request, const QImage& image,
+                const ThumbnailCache::EncodedThumbnail& thumbnail = ThumbnailCache::EncodedThumbnail() );
     ImageRequest* loadInfo();
     QImage image();
+    /// the thumbnail encoded by the loader thread, for thumbnail requests
+    ThumbnailCache::EncodedThumbnail thumbnail() const;
 
 private:
     ImageRequest* m_request;
     QImage m_image;
+    ThumbnailCache::EncodedThumbnail m_thumbnail;
 };
 
 const int ImageEventID = 1001;
@@ -26,6 +26,9 @@
 
 #include <qapplication.h>
 #include <qfileinfo.h>
+#include <QBuffer>
+#include <QFile>
+#include <QImageReader>
 
 extern "C" {
  #include <limits.h>
@@ -53,23 +56,34 @@ namespace ImageManager
 void ImageManager::ImageLoaderThread::run()
 {
     while ( true ) {
-        ImageRequest* request = AsyncLoader::instance()->next();
+        Utilities::ResourceScheduler::Token token;
+        ImageRequest* request = AsyncLoader::instance()->next( &token );
         Q_ASSERT( request );
         bool ok;
 
-        QImage img = loadImage( request, ok );
+        QImage img = loadImage( request, ok, token );
 
+        ThumbnailCache::EncodedThumbnail thumbnail;
         if ( ok ) {
             img = scaleAndRotate( request, img );
+            // encoding all levels of the thumbnail is expensive, so leave only the writing to the GUI thread:
+            if ( request->isThumbnailRequest() )
+                thumbnail = ThumbnailCache::encode( img );
         }
+        Utilities::ResourceScheduler::instance()->release( token );
 
         request->setLoadedOK( ok );
-        ImageEvent* iew = new ImageEvent( request, img );
+        ImageEvent* iew = new ImageEvent( request, img, thumbnail );
         QApplication::postEvent( AsyncLoader::instance(),  iew );
     }
 }
 
-QImage ImageManager::ImageLoaderThread::loadImage( ImageRequest* request, bool& ok )
+/**
+ * Load the image. The file is read into memory first, so that the I/O slot of the token can be given back
+ * while the image is decoded. RAW files are decoded straight from the disk, so the slot is held for them,
+ * and regions are decoded from the disk as well, see below.
+ */
+QImage ImageManager::ImageLoaderThread::loadImage( ImageRequest* request, bool& ok, Utilities::ResourceScheduler::Token& token )
 {
     int dim = calcLoadSize( request );
     QSize fullSize;
@@ -79,13 +93,32 @@ QImage ImageManager::ImageLoaderThread::loadImage( ImageRequest* request, bool&
         return QImage();
 
     QImage img;
+    if ( request->region().isValid() ) {
+        // Only a part of the image is wanted (deep zoom in the viewer), which we can only do for JPEGs.
+        if ( !Utilities::isJPEG(request->fileSystemFileName()) )
+            return QImage();
+
+        // Regions are wanted from huge images, so the file is not read into memory;
+        // instead, the I/O slot is given back once the rows above the region are read.
+        int scaleDenominator = 1;
+        while ( scaleDenominator < 8 && request->region().width() >= 2 * scaleDenominator * request->width() )
+            scaleDenominator *= 2;
+        ok = Utilities::loadJPEGRegion( &img, request->fileSystemFileName(), &fullSize, request->region(), scaleDenominator,
+                                        [&token] { Utilities::ResourceScheduler::instance()->releaseIO( token ); } );
+        if ( ok )
+            request->setFullSize( fullSize );
+        return img;
+    }
+
+    QByteArray data;
     if (Utilities::isJPEG(request->fileSystemFileName())) {
-        ok = Utilities::loadJPEG(&img, request->fileSystemFileName(),  &fullSize, dim);
+        data = readFile( request, token );
+        ok = Utilities::loadJPEG(&img, data,  &fullSize, dim);
         if (ok == true)
             request->setFullSize( fullSize );
     }
 
-    else {
+    else if (Utilities::isRAW(request->fileSystemFileName())) {
         // At first, we have to give our RAW decoders a try. If we allowed
         // QImage's load() method, it'd for example load a tiny thumbnail from
         // NEF files, which is not what we want.
@@ -96,7 +129,12 @@ QImage ImageManager::ImageLoaderThread::loadImage( ImageRequest* request, bool&
 
     if (!ok) {
         // Now we can try QImage's stuff as a fallback...
-        ok = img.load( request->fileSystemFileName().absolute() );
+        if ( data.isNull() )
+            data = readFile( request, token );
+        // the suffix is a hint for the format, just like when loading from the file:
+        QBuffer buffer( &data );
+        QImageReader reader( &buffer, QFileInfo( request->fileSystemFileName().absolute() ).suffix().toLower().toLatin1() );
+        ok = reader.read( &img );
         if (ok)
             request->setFullSize( img.size() );
 
@@ -105,6 +143,17 @@ QImage ImageManager::ImageLoaderThread::loadImage( ImageRequest* request, bool&
     return img;
 }
 
+QByteArray ImageManager::ImageLoaderThread::readFile( ImageRequest* request, Utilities::ResourceScheduler::Token& token )
+{
+    QFile file( request->fileSystemFileName().absolute() );
+    QByteArray data;
+    if ( file.open( QIODevice::ReadOnly ) )
+        data = file.readAll();
+    // Decoding is CPU bound, so let the next request use the disk in the meantime:
+    Utilities::ResourceScheduler::instance()->releaseIO( token );
+    return data;
+}
+
 
 int ImageManager::ImageLoaderThread::calcLoadSize( ImageRequest* request )
 {
@@ -136,6 +185,10 @@ bool ImageManager::ImageLoaderThread::shouldImageBeScale( const QImage& img, Ima
     if ( request->width() == -1 )
         return false;
 
+    // Regions are delivered at the resolution libjpeg decoded them at.
+    if ( request->region().isValid() )
+        return false;
+
     if ( img.width() < request->width() && img.height() < request->height() ) {
         // The image is smaller than the requets.
         return request->doUpScale();
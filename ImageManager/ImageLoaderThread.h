@@ -21,6 +21,7 @@
 
 #include <qthread.h>
 #include <QImage>
+#include <Utilities/ResourceScheduler.h>
 
 namespace ImageManager
 {
@@ -31,7 +32,8 @@ class ThumbnailStorage;
 class ImageLoaderThread :public QThread {
 protected:
     virtual void run();
-    QImage loadImage( ImageRequest* request, bool& ok );
+    QImage loadImage( ImageRequest* request, bool& ok, Utilities::ResourceScheduler::Token& token );
+    QByteArray readFile( ImageRequest* request, Utilities::ResourceScheduler::Token& token );
     static int calcLoadSize( ImageRequest* request );
     QImage scaleAndRotate( ImageRequest* request, QImage img );
     bool shouldImageBeScale( const QImage& img, ImageRequest* request );
@@ -64,8 +64,12 @@ bool ImageManager::ImageRequest::operator<( const ImageRequest& other ) const
         return m_width < other.m_width;
     else if ( m_height != other.m_height )
         return m_height < other.m_height;
-    else
+    else if ( m_angle != other.m_angle )
         return m_angle < other.m_angle;
+    else if ( m_region.y() != other.m_region.y() )
+        return m_region.y() < other.m_region.y();
+    else
+        return m_region.x() < other.m_region.x();
 }
 
 bool ImageManager::ImageRequest::operator==( const ImageRequest& other ) const
@@ -74,7 +78,7 @@ bool ImageManager::ImageRequest::operator==( const ImageRequest& other ) const
     return ( m_null == other.m_null && databaseFileName() == other.databaseFileName() &&
              m_width == other.m_width && m_height == other.m_height &&
              m_angle == other.m_angle && m_client == other.m_client &&
-             m_priority == other.m_priority );
+             m_priority == other.m_priority && m_region == other.m_region );
 }
 
 ImageManager::ImageClientInterface* ImageManager::ImageRequest::client() const
@@ -137,6 +141,16 @@ bool ImageManager::ImageRequest::isThumbnailRequest() const
     return m_isThumbnailRequest;
 }
 
+void ImageManager::ImageRequest::setRegion( const QRect& region )
+{
+    m_region = region;
+}
+
+QRect ImageManager::ImageRequest::region() const
+{
+    return m_region;
+}
+
 DB::FileName ImageManager::ImageRequest::databaseFileName() const
 {
     return m_fileName;
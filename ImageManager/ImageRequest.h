@@ -19,6 +19,7 @@
 #define IMAGEREQUEST_H
 #include <qstring.h>
 #include <qsize.h>
+#include <qrect.h>
 #include <QHash>
 #include "enums.h"
 #include <DB/FileName.h>
@@ -81,6 +82,16 @@ public:
     void setIsThumbnailRequest( bool );
     bool isThumbnailRequest() const;
 
+    /**
+     * @brief Only load the given part of the image.
+     * The region is given in pixels of the full size, unrotated image. The
+     * loaded part is decoded at about \ref size(), and is neither rotated
+     * nor scaled afterwards.
+     * Region requests are only supported for JPEG images.
+     */
+    void setRegion( const QRect& region );
+    QRect region() const;
+
 private:
     bool m_null;
     DB::FileName m_fileName;
@@ -94,11 +105,13 @@ private:
     bool m_loadedOK;
     bool m_dontUpScale;
     bool m_isThumbnailRequest;
+    QRect m_region;
 };
 
 inline uint qHash(const ImageRequest& ir)
 {
-    return DB::qHash(ir.databaseFileName()) ^ ::qHash(ir.width()) ^ ::qHash(ir.angle());
+    return DB::qHash(ir.databaseFileName()) ^ ::qHash(ir.width()) ^ ::qHash(ir.angle())
+            ^ ::qHash(ir.region().x()) ^ ::qHash(ir.region().y() << 16);
 }
 
 }
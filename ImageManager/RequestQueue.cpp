@@ -64,6 +64,12 @@ ImageManager::ImageRequest* ImageManager::RequestQueue::popNext()
     return nullptr;
 }
 
+void ImageManager::RequestQueue::requeue( ImageRequest* request )
+{
+    m_queues[ request->priority() ].prepend( request );
+    m_uniquePending.insert( ImageRequestReference(request) );
+}
+
 void ImageManager::RequestQueue::cancelRequests( ImageClientInterface* client, StopAction action )
 {
     // remove from active map
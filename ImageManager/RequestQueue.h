@@ -44,6 +44,10 @@ public:
     // delete it.
     ImageRequest* popNext();
 
+    // Put a request returned by popNext() back to the front of its queue,
+    // e.g. because there are no resources to load it right now.
+    void requeue( ImageRequest* request );
+
     // Remove all pending requests from the given client.
     void cancelRequests( ImageClientInterface* client, StopAction action );
 
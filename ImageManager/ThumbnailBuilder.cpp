@@ -20,7 +20,6 @@
 #include <KLocale>
 #include "ImageManager/ThumbnailCache.h"
 #include "MainWindow/StatusBar.h"
-#include "ThumbnailView/CellGeometry.h"
 #include "ImageManager/AsyncLoader.h"
 #include "DB/ImageDB.h"
 #include "PreloadRequest.h"
@@ -100,6 +99,8 @@ void ImageManager::ThumbnailBuilder::doThumbnailBuild()
     m_isBuilding = true;
     int numberOfThumbnailsToBuild = 0;
 
+    // build the thumbnails big enough for all levels of the thumbnail cache:
+    const int buildSize = ImageManager::ThumbnailCache::thumbnailBuildSize();
     for (const DB::FileName& fileName : m_thumbnailsToBuild ) {
         DB::ImageInfoPtr info = fileName.info();
         if ( info->isNull())
@@ -107,7 +108,7 @@ void ImageManager::ThumbnailBuilder::doThumbnailBuild()
 
         ImageManager::ImageRequest* request
             = new ImageManager::PreloadRequest( fileName,
-                                              ThumbnailView::CellGeometry::preferredIconSize(), info->angle(),
+                                              QSize( buildSize, buildSize ), info->angle(),
                                               this );
         request->setIsThumbnailRequest(true);
         request->setPriority( ImageManager::BuildThumbnails );
@@ -17,67 +17,23 @@
 */
 #include "ThumbnailCache.h"
 #include <QBuffer>
-#include <QCache>
-#include <QTemporaryFile>
-#include <QDir>
+#include <QDataStream>
 #include <Settings/SettingsData.h>
 #include <QTimer>
 #include <QPixmap>
-#include <QFile>
+#include <DB/ImageInfo.h>
 
-// We split the thumbnails into chunks to avoid a huge file changing over and over again, with a bad hit for backups
-const int MAXFILESIZE=32*1024*1024;
-const int FILEVERSION=4;
+const int FILEVERSION=5;
+// the downscaled levels that are stored in addition to the inserted thumbnail:
+const int MIP_LEVELS[] = { 128, 256, 512 };
 // We map some thumbnail files into memory and manage them in a least-recently-used fashion
 const size_t LRU_SIZE=2;
 
-namespace ImageManager {
-/**
- * The ThumbnailMapping wraps the memory-mapped data of a QFile.
- * Upon initialization with a file name, the corresponding file is opened
- * and its contents mapped into memory (as a QByteArray).
- *
- * Deleting the ThumbnailMapping unmaps the memory and closes the file.
- */
-class ThumbnailMapping
-{
-public:
-    ThumbnailMapping(const QString &filename)
-        : file(filename),map(nullptr)
-    {
-        if ( !file.open( QIODevice::ReadOnly ) )
-            qWarning("Failed to open thumbnail file");
-
-        uchar * data = file.map( 0, file.size() );
-        if ( !data || QFile::NoError != file.error() )
-        {
-            qWarning("Failed to map thumbnail file");
-        }
-        else
-        {
-            map = QByteArray::fromRawData( reinterpret_cast<const char*>(data), file.size() );
-        }
-    }
-    bool isValid()
-    {
-        return !map.isEmpty();
-    }
-    // we need to keep the file around to keep the data mapped:
-    QFile file;
-    QByteArray map;
-};
-}
-
 ImageManager::ThumbnailCache* ImageManager::ThumbnailCache::s_instance = nullptr;
 
 ImageManager::ThumbnailCache::ThumbnailCache()
-    : m_currentFile(0), m_currentOffset(0), m_unsaved(0)
+    : m_store( QString::fromLatin1(".thumbnails/"), QString::fromLatin1("thumb-"), LRU_SIZE ), m_unsaved(0)
 {
-    m_memcache = new QCache<int,ThumbnailMapping>(LRU_SIZE);
-    const QString dir = thumbnailPath(QString());
-    if ( !QFile::exists(dir) )
-        QDir().mkpath(dir);
-
     load();
     m_timer = new QTimer;
     connect( m_timer, SIGNAL(timeout()), this, SLOT(save()));
@@ -85,77 +41,112 @@ ImageManager::ThumbnailCache::ThumbnailCache()
 
 ImageManager::ThumbnailCache::~ThumbnailCache()
 {
-    delete m_memcache;
 }
 
-void ImageManager::ThumbnailCache::insert( const DB::FileName& name, const QImage& image )
+int ImageManager::ThumbnailCache::thumbnailBuildSize()
 {
-    QFile file( fileNameForIndex(m_currentFile) );
-    if ( ! file.open(QIODevice::ReadWrite ) )
-    {
-        qWarning("Failed to open thumbnail file for inserting");
-        return;
-    }
-    if ( ! file.seek( m_currentOffset ) )
-    {
-        qWarning("Failed to seek in thumbnail file");
-        return;
+    // Always build the biggest fixed level, so changing the thumbnail size up to it, or showing the thumbnails
+    // bigger on a high resolution display, never needs the original images again.
+    // The levels are encoded on the image loader threads, so the extra levels don't cost the GUI thread anything.
+    const int largestLevel = MIP_LEVELS[ sizeof(MIP_LEVELS)/sizeof(MIP_LEVELS[0]) - 1 ];
+    return qMax( Settings::SettingsData::instance()->thumbnailSize(), largestLevel );
+}
+
+ImageManager::ThumbnailCache::EncodedThumbnail ImageManager::ThumbnailCache::encode( const QImage& image )
+{
+    // Each level is scaled from the next bigger one, which is much cheaper than scaling from the inserted image.
+    EncodedThumbnail levels;
+    auto addLevel = [&levels]( const QImage& level ) {
+        QByteArray data;
+        QBuffer buffer( &data );
+        bool OK = buffer.open( QIODevice::WriteOnly );
+        Q_ASSERT(OK); Q_UNUSED(OK);
+
+        OK = level.save( &buffer, "JPG" );
+        Q_ASSERT( OK );
+        levels.append( qMakePair( qMax( level.width(), level.height() ), data ) );
+    };
+
+    QImage level = image;
+    addLevel( level );
+    for ( int i = sizeof(MIP_LEVELS)/sizeof(MIP_LEVELS[0]) - 1; i >= 0; --i ) {
+        if ( MIP_LEVELS[i] >= qMax( level.width(), level.height() ) )
+            continue;
+        level = level.scaled( MIP_LEVELS[i], MIP_LEVELS[i], Qt::KeepAspectRatio, Qt::SmoothTransformation );
+        addLevel( level );
     }
+    return levels;
+}
 
-    // purge in-memory cache for the current file:
-    m_memcache->remove( m_currentFile );
-    QByteArray data;
-    QBuffer buffer( &data );
-    bool OK = buffer.open( QIODevice::WriteOnly );
-    Q_ASSERT(OK); Q_UNUSED(OK);
+void ImageManager::ThumbnailCache::insert( const DB::FileName& name, const QImage& image )
+{
+    insert( name, encode( image ) );
+}
 
-    OK = image.save( &buffer, "JPG" );
-    Q_ASSERT( OK );
+void ImageManager::ThumbnailCache::insert( const DB::FileName& name, const EncodedThumbnail& levels )
+{
+    QList<QByteArray> data;
+    for ( const auto& level : levels )
+        data.append( level.second );
 
-    const int size = data.size();
-    if ( ! ( file.write( data.data(), size ) == size && file.flush() ) )
-    {
-        qWarning("Failed to write image data to thumbnail file");
+    QList<CacheFileInfo> locations;
+    if ( !m_store.append( data, &locations ) )
         return;
-    }
-    file.close();
 
-    m_map.insert( name, CacheFileInfo( m_currentFile, m_currentOffset, size ) );
-
-    // Update offset
-    m_currentOffset += size;
-    if ( m_currentOffset > MAXFILESIZE ) {
-        m_currentFile++;
-        m_currentOffset = 0;
-    }
+    ThumbnailLevels levelInfos;
+    for ( int i = 0; i < levels.count(); ++i )
+        levelInfos.insert( levels[i].first, locations[i] );
+    m_map.insert( name, levelInfos );
 
     if ( ++m_unsaved > 100 )
         save();
     m_timer->start(1000);
+    emit thumbnailUpdated( name );
 }
 
-QString ImageManager::ThumbnailCache::fileNameForIndex( int index ) const
+QPixmap ImageManager::ThumbnailCache::lookup( const DB::FileName& name ) const
 {
-    return thumbnailPath(QString::fromLatin1("thumb-") + QString::number(index) );
+    const int size = Settings::SettingsData::instance()->thumbnailSize();
+    return lookup( name, QSize( size, size ) );
 }
 
-QPixmap ImageManager::ThumbnailCache::lookup( const DB::FileName& name ) const
+QPixmap ImageManager::ThumbnailCache::lookup( const DB::FileName& name, const QSize& size ) const
+{
+    const ThumbnailLevels levels = m_map.value( name );
+    if ( levels.isEmpty() )
+        return QPixmap();
+
+    // the smallest level that covers the requested size, or the biggest one available:
+    ThumbnailLevels::const_iterator it = levels.lowerBound( qMax( size.width(), size.height() ) );
+    if ( it == levels.constEnd() )
+        --it;
+    return loadLevel( it.value() );
+}
+
+QByteArray ImageManager::ThumbnailCache::lookupRawData( const DB::FileName& name, const QSize& size, int* levelSize ) const
 {
+    const ThumbnailLevels levels = m_map.value( name );
+    if ( levels.isEmpty() )
+        return QByteArray();
+
+    ThumbnailLevels::const_iterator it = levels.lowerBound( qMax( size.width(), size.height() ) );
+    if ( it == levels.constEnd() )
+        --it;
+    if ( levelSize )
+        *levelSize = it.key();
+    return levelData( it.value() );
+}
 
-    CacheFileInfo info = m_map[name];
+QByteArray ImageManager::ThumbnailCache::levelData( const CacheFileInfo& info ) const
+{
+    return m_store.data( info );
+}
 
-    ThumbnailMapping *t = m_memcache->object(info.fileIndex);
-    if (!t || !t->isValid())
-    {
-        t = new ThumbnailMapping( fileNameForIndex( info.fileIndex ) );
-        if (!t->isValid())
-        {
-            qWarning("Failed to map thumbnail file");
-            return QPixmap();
-        }
-        m_memcache->insert(info.fileIndex,t);
-    }
-    QByteArray array( t->map.mid(info.offset , info.size ) );
+QPixmap ImageManager::ThumbnailCache::loadLevel( const CacheFileInfo& info ) const
+{
+    QByteArray array = levelData( info );
+    if ( array.isNull() )
+        return QPixmap();
     QBuffer buffer( &array );
     buffer.open( QIODevice::ReadOnly );
     QImage image;
@@ -171,67 +162,55 @@ void ImageManager::ThumbnailCache::save() const
     m_timer->stop();
     m_unsaved = 0;
 
-    QTemporaryFile file;
-    if ( !file.open() ) {
-        qWarning("Failed to create temporary file");
-        return;
-    }
-
-    QDataStream stream(&file);
-    stream << FILEVERSION
-           << m_currentFile
-           << m_currentOffset
-           << m_map.count();
-
-    for( QMap<DB::FileName,CacheFileInfo>::ConstIterator it = m_map.begin(); it != m_map.end(); ++it ) {
-        const CacheFileInfo& cacheInfo = it.value();
-        stream << it.key().relative()
-               << cacheInfo.fileIndex
-               << cacheInfo.offset
-               << cacheInfo.size;
-    }
-    file.close();
-
-    const QString realFileName = thumbnailPath(QString::fromLatin1("thumbnailindex"));
-    QFile::remove( realFileName );
-    if ( !file.copy( realFileName ) )
-        qWarning("Failed to copy the temporary file %s to %s", qPrintable( file.fileName() ), qPrintable( realFileName ) );
-
-    QFile realFile( realFileName );
-    realFile.open( QIODevice::ReadOnly );
-    realFile.setPermissions( QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup | QFile::WriteGroup | QFile::ReadOther );
-    realFile.close();
+    m_store.saveIndex( QString::fromLatin1("thumbnailindex"), FILEVERSION, [this]( QDataStream& stream ) {
+        stream << m_map.count();
+        for( QMap<DB::FileName,ThumbnailLevels>::ConstIterator it = m_map.begin(); it != m_map.end(); ++it ) {
+            const ThumbnailLevels& levels = it.value();
+            stream << it.key().relative()
+                   << levels.count();
+            for( ThumbnailLevels::ConstIterator levelIt = levels.begin(); levelIt != levels.end(); ++levelIt ) {
+                const CacheFileInfo& cacheInfo = levelIt.value();
+                stream << levelIt.key()
+                       << cacheInfo.fileIndex
+                       << cacheInfo.offset
+                       << cacheInfo.size;
+            }
+        }
+    } );
 }
 
 void ImageManager::ThumbnailCache::load()
 {
-    QFile file( thumbnailPath( QString::fromLatin1("thumbnailindex")) );
-    if ( !file.exists() )
-        return;
-
-    file.open(QIODevice::ReadOnly);
-    QDataStream stream(&file);
-    int version;
-    stream >> version;
-    if ( version != FILEVERSION )
-        return; //Discard cache
-
-    int count;
-    stream >> m_currentFile
-           >> m_currentOffset
-           >> count;
-
-    for ( int i = 0; i < count; ++i ) {
-        QString name;
-        int fileIndex;
-        int offset;
-        int size;
-        stream >> name
-               >> fileIndex
-               >> offset
-               >> size;
-        m_map.insert( DB::FileName::fromRelativePath(name), CacheFileInfo( fileIndex, offset, size ) );
-    }
+    m_store.loadIndex( QString::fromLatin1("thumbnailindex"), QList<int>() << FILEVERSION << 4, [this]( QDataStream& stream, int version ) {
+        int count;
+        stream >> count;
+
+        // version 4 stored a single thumbnail per image, at the thumbnail size of the time:
+        const int version4LevelSize = Settings::SettingsData::instance()->thumbnailSize();
+
+        for ( int i = 0; i < count; ++i ) {
+            QString name;
+            int levelCount = 1;
+            stream >> name;
+            if ( version != 4 )
+                stream >> levelCount;
+
+            ThumbnailLevels levels;
+            for ( int level = 0; level < levelCount; ++level ) {
+                int levelSize = version4LevelSize;
+                int fileIndex;
+                int offset;
+                int size;
+                if ( version != 4 )
+                    stream >> levelSize;
+                stream >> fileIndex
+                       >> offset
+                       >> size;
+                levels.insert( levelSize, CacheFileInfo( fileIndex, offset, size ) );
+            }
+            m_map.insert( DB::FileName::fromRelativePath(name), levels );
+        }
+    } );
 }
 
 bool ImageManager::ThumbnailCache::contains( const DB::FileName& name ) const
@@ -239,13 +218,6 @@ bool ImageManager::ThumbnailCache::contains( const DB::FileName& name ) const
     return m_map.contains(name);
 }
 
-QString ImageManager::ThumbnailCache::thumbnailPath(const QString& file) const
-{
-    // Making it static is just an optimization.
-    static QString base = QDir(Settings::SettingsData::instance()->imageDirectory()).absoluteFilePath( QString::fromLatin1(".thumbnails/") );
-    return  base + file;
-}
-
 ImageManager::ThumbnailCache* ImageManager::ThumbnailCache::instance()
 {
     if (!s_instance)
@@ -261,18 +233,41 @@ void ImageManager::ThumbnailCache::deleteInstance()
 
 void ImageManager::ThumbnailCache::flush()
 {
-    for ( int i = 0; i <= m_currentFile; ++i )
-        QFile::remove( fileNameForIndex(i) );
-    m_currentFile = 0;
-    m_currentOffset = 0;
+    m_store.clear();
     m_map.clear();
-    m_memcache->clear();
     save();
+    emit cacheFlushed();
 }
 
 void ImageManager::ThumbnailCache::removeThumbnail( const DB::FileName& fileName )
 {
     m_map.remove( fileName );
     save();
+    emit thumbnailUpdated( fileName );
+}
+
+int ImageManager::ThumbnailCache::removeThumbnailsSmallerThan( int size )
+{
+    int count = 0;
+    for ( auto it = m_map.begin(); it != m_map.end(); ) {
+        const int largestLevel = it->isEmpty() ? 0 : ( it->constEnd() - 1 ).key();
+        if ( largestLevel < size ) {
+            // if the image itself is smaller, there is no point in building the thumbnail again:
+            const DB::ImageInfoPtr info = it.key().info();
+            const int imageSize = info.isNull() ? -1 : qMax( info->size().width(), info->size().height() );
+            if ( imageSize <= 0 || largestLevel < imageSize ) {
+                it = m_map.erase( it );
+                ++count;
+                continue;
+            }
+        }
+        ++it;
+    }
+
+    if ( count > 0 ) {
+        save();
+        emit cacheFlushed();
+    }
+    return count;
 }
 // vi:expandtab:tabstop=4 shiftwidth=4:
@@ -18,50 +18,101 @@
 #ifndef THUMBNAILCACHE_H
 #define THUMBNAILCACHE_H
 #include "CacheFileInfo.h"
+#include "ChunkedCacheStore.h"
 #include <QMap>
 #include <QImage>
+#include <QList>
+#include <QPair>
 #include <DB/FileName.h>
 
-template <class Key, class T>
-class QCache;
-
 namespace ImageManager {
 
-class ThumbnailMapping;
-
+/**
+ * @brief The ThumbnailCache class stores the thumbnails of all images on disk.
+ *
+ * For each image, a small pyramid of thumbnails is stored: the inserted image itself,
+ * plus downscaled versions for each of the fixed levels (128, 256 and 512 pixels) below it.
+ * Lookups return the smallest level which is at least as big as the requested size,
+ * so changing the thumbnail size does not require reading the original images again,
+ * as long as the new size is not bigger than the stored thumbnails.
+ *
+ * Scaling and encoding the levels is done by \ref encode, which the image loader threads call
+ * for the thumbnails they load, so that only writing the data is left for the GUI thread.
+ */
 class ThumbnailCache :public QObject
 {
     Q_OBJECT
 
 public:
+    /// the JPEG data of the levels of a thumbnail, along with the length of their longer side
+    typedef QList< QPair<int, QByteArray> > EncodedThumbnail;
+
     static ThumbnailCache* instance();
     static void deleteInstance();
     ThumbnailCache();
+    /**
+     * @brief thumbnailBuildSize is the size of the images which should be inserted into the cache.
+     * Inserting images of that size makes the cache able to serve all thumbnail sizes up to it.
+     */
+    static int thumbnailBuildSize();
+    /**
+     * @brief encode creates all levels of the thumbnail for the image.
+     * This function is thread-safe.
+     */
+    static EncodedThumbnail encode( const QImage& image );
     void insert( const DB::FileName& name, const QImage& image );
+    void insert( const DB::FileName& name, const EncodedThumbnail& thumbnail );
+    /**
+     * @brief lookup returns the stored thumbnail which is closest to the configured thumbnail size.
+     */
     QPixmap lookup( const DB::FileName& name ) const;
+    /**
+     * @brief lookup returns the smallest stored thumbnail which covers the given size.
+     * The thumbnail still needs to be scaled to the exact size.
+     */
+    QPixmap lookup( const DB::FileName& name, const QSize& size ) const;
+    /**
+     * @brief lookupRawData returns the JPEG data of the thumbnail that lookup() would return, without decoding it.
+     * @param levelSize if given, it is set to the length of the longer side of that thumbnail.
+     */
+    QByteArray lookupRawData( const DB::FileName& name, const QSize& size, int* levelSize = nullptr ) const;
     bool contains( const DB::FileName& name ) const;
     void load();
     void removeThumbnail( const DB::FileName& );
+    /**
+     * @brief removeThumbnailsSmallerThan removes all thumbnails that cannot serve the given size.
+     * Thumbnails of images that are smaller than the given size are kept.
+     * @return the number of removed thumbnails
+     */
+    int removeThumbnailsSmallerThan( int size );
 
 public slots:
     void save() const;
     void flush();
 
+signals:
+    /**
+     * @brief thumbnailUpdated is emitted when the thumbnail for the given file was replaced or removed.
+     */
+    void thumbnailUpdated( const DB::FileName& );
+    /**
+     * @brief cacheFlushed is emitted when all thumbnails were removed.
+     */
+    void cacheFlushed();
+
 private:
     ~ThumbnailCache();
-    QString fileNameForIndex( int index ) const;
-    QString thumbnailPath( const QString& fileName ) const;
+    QPixmap loadLevel( const CacheFileInfo& info ) const;
+    QByteArray levelData( const CacheFileInfo& info ) const;
+
+    /// the thumbnails of an image, keyed by the length of their longer side
+    typedef QMap<int, CacheFileInfo> ThumbnailLevels;
 
     static ThumbnailCache* s_instance;
-    QMap<DB::FileName, CacheFileInfo> m_map;
-    int m_currentFile;
-    int m_currentOffset;
+    QMap<DB::FileName, ThumbnailLevels> m_map;
+    ChunkedCacheStore m_store;
     QTimer* m_timer;
     mutable int m_unsaved;
-    /**
-     * Holds an in-memory cache of thumbnail files.
-     */
-    mutable QCache<int,ThumbnailMapping> *m_memcache;
 };
 
 }
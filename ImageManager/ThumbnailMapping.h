@@ -0,0 +1,64 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef THUMBNAILMAPPING_H
+#define THUMBNAILMAPPING_H
+
+#include <QByteArray>
+#include <QFile>
+
+namespace ImageManager
+{
+/**
+ * The ThumbnailMapping wraps the memory-mapped data of a QFile.
+ * Upon initialization with a file name, the corresponding file is opened
+ * and its contents mapped into memory (as a QByteArray).
+ *
+ * Deleting the ThumbnailMapping unmaps the memory and closes the file.
+ */
+class ThumbnailMapping
+{
+public:
+    ThumbnailMapping(const QString &filename)
+        : file(filename),map(nullptr)
+    {
+        if ( !file.open( QIODevice::ReadOnly ) )
+            qWarning("Failed to open thumbnail file");
+
+        uchar * data = file.map( 0, file.size() );
+        if ( !data || QFile::NoError != file.error() )
+        {
+            qWarning("Failed to map thumbnail file");
+        }
+        else
+        {
+            map = QByteArray::fromRawData( reinterpret_cast<const char*>(data), file.size() );
+        }
+    }
+    bool isValid()
+    {
+        return !map.isEmpty();
+    }
+    // we need to keep the file around to keep the data mapped:
+    QFile file;
+    QByteArray map;
+};
+}
+
+#endif /* THUMBNAILMAPPING_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
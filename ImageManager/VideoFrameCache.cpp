@@ -0,0 +1,254 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "VideoFrameCache.h"
+#include "ThumbnailCache.h"
+#include "VideoFrameExtractor.h"
+#include <BackgroundJobs/HandleVideoThumbnailRequestJob.h>
+#include <QBuffer>
+#include <QDataStream>
+#include <QFile>
+#include <QPainter>
+#include <QTimer>
+
+const int FILEVERSION=1;
+// Hovering usually moves from one video to its neighbours, which are most likely in the same chunk.
+const size_t LRU_SIZE=2;
+
+ImageManager::VideoFrameCache* ImageManager::VideoFrameCache::s_instance = nullptr;
+
+ImageManager::VideoFrameCache::VideoFrameCache()
+    : m_store( QString::fromLatin1(".videoThumbnails/"), QString::fromLatin1("frames-"), LRU_SIZE ), m_unsaved(0)
+{
+    load();
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect( m_timer, SIGNAL(timeout()), this, SLOT(save()));
+}
+
+ImageManager::VideoFrameCache::~VideoFrameCache()
+{
+    if ( m_unsaved > 0 )
+        save();
+}
+
+ImageManager::VideoFrameCache* ImageManager::VideoFrameCache::instance()
+{
+    if (!s_instance)
+        s_instance = new VideoFrameCache;
+    return s_instance;
+}
+
+void ImageManager::VideoFrameCache::deleteInstance()
+{
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+bool ImageManager::VideoFrameCache::insert( const DB::FileName& video, const QVector<QImage>& frames )
+{
+    Entry entry;
+
+    QImage first;
+    Q_FOREACH( const QImage& frame, frames ) {
+        if ( !frame.isNull() ) {
+            first = frame;
+            break;
+        }
+    }
+
+    if ( !first.isNull() ) {
+        const int buildSize = ThumbnailCache::thumbnailBuildSize();
+        entry.frameSize = first.size();
+        if ( qMax( first.width(), first.height() ) > buildSize )
+            entry.frameSize.scale( buildSize, buildSize, Qt::KeepAspectRatio );
+        entry.frameCount = frames.count();
+
+        // All frames go side by side into one image, so a lookup only needs to decode a single JPEG.
+        QImage strip( entry.frameSize.width() * entry.frameCount, entry.frameSize.height(), QImage::Format_RGB32 );
+        strip.fill( Qt::black );
+        QPainter painter( &strip );
+        painter.setRenderHint( QPainter::SmoothPixmapTransform );
+        QImage previous = first;
+        for ( int i = 0; i < entry.frameCount; ++i ) {
+            const QImage& frame = frames[i].isNull() ? previous : frames[i];
+            painter.drawImage( QRect( QPoint( i * entry.frameSize.width(), 0 ), entry.frameSize ), frame );
+            previous = frame;
+        }
+        painter.end();
+
+        QByteArray data;
+        QBuffer buffer( &data );
+        bool OK = buffer.open( QIODevice::WriteOnly );
+        Q_ASSERT(OK); Q_UNUSED(OK);
+        OK = strip.save( &buffer, "JPG" );
+        Q_ASSERT( OK );
+
+        QList<CacheFileInfo> locations;
+        if ( !m_store.append( QList<QByteArray>() << data, &locations ) )
+            return false;
+        entry.location = locations.first();
+    }
+
+    m_map.insert( video, entry );
+    scheduleSave();
+    return true;
+}
+
+QVector<QImage> ImageManager::VideoFrameCache::lookup( const DB::FileName& video )
+{
+    if ( !m_map.contains( video ) ) {
+        if ( hasLegacyFrames( video ) )
+            return migrateLegacyFrames( video );
+        return QVector<QImage>();
+    }
+
+    const Entry entry = m_map.value( video );
+    if ( entry.frameCount == 0 )
+        return QVector<QImage>();
+
+    QByteArray array = m_store.data( entry.location );
+    if ( array.isNull() )
+        return QVector<QImage>();
+    QBuffer buffer( &array );
+    buffer.open( QIODevice::ReadOnly );
+    QImage strip;
+    if ( !strip.load( &buffer, "JPG" ) )
+        return QVector<QImage>();
+
+    QVector<QImage> frames;
+    frames.reserve( entry.frameCount );
+    for ( int i = 0; i < entry.frameCount; ++i )
+        frames.append( strip.copy( QRect( QPoint( i * entry.frameSize.width(), 0 ), entry.frameSize ) ) );
+    return frames;
+}
+
+bool ImageManager::VideoFrameCache::contains( const DB::FileName& video ) const
+{
+    return m_map.contains( video ) || hasLegacyFrames( video );
+}
+
+void ImageManager::VideoFrameCache::remove( const DB::FileName& video )
+{
+    if ( m_map.remove( video ) > 0 )
+        scheduleSave();
+}
+
+int ImageManager::VideoFrameCache::thumbnailFrame( const DB::FileName& video ) const
+{
+    return m_map.value( video ).thumbnailFrame;
+}
+
+void ImageManager::VideoFrameCache::setThumbnailFrame( const DB::FileName& video, int frame )
+{
+    QMap<DB::FileName, Entry>::iterator it = m_map.find( video );
+    if ( it == m_map.end() )
+        return;
+    it->thumbnailFrame = frame;
+    scheduleSave();
+}
+
+bool ImageManager::VideoFrameCache::hasLegacyFrames( const DB::FileName& video ) const
+{
+    // older versions wrote the frames in order, so the last one tells whether extraction was completed:
+    const int lastFrame = VideoFrameExtractor::NumberOfFrames - 1;
+    return BackgroundJobs::HandleVideoThumbnailRequestJob::frameName( video, lastFrame ).exists();
+}
+
+QVector<QImage> ImageManager::VideoFrameCache::migrateLegacyFrames( const DB::FileName& video )
+{
+    QVector<QImage> frames;
+    for ( int i = 0; i < VideoFrameExtractor::NumberOfFrames; ++i ) {
+        const DB::FileName frameFile = BackgroundJobs::HandleVideoThumbnailRequestJob::frameName( video, i );
+        // empty files were written for videos without any frames:
+        frames.append( QImage( frameFile.absolute() ) );
+    }
+
+    bool anyFrame = false;
+    Q_FOREACH( const QImage& frame, frames )
+        anyFrame = anyFrame || !frame.isNull();
+    if ( !anyFrame )
+        frames.clear();
+
+    // Keep the old files if the frames could not be stored, so they are not lost and migrating is tried again next time:
+    if ( !insert( video, frames ) )
+        return frames;
+    for ( int i = 0; i < VideoFrameExtractor::NumberOfFrames; ++i )
+        QFile::remove( BackgroundJobs::HandleVideoThumbnailRequestJob::frameName( video, i ).absolute() );
+
+    return lookup( video );
+}
+
+void ImageManager::VideoFrameCache::scheduleSave()
+{
+    if ( ++m_unsaved > 100 )
+        save();
+    else
+        m_timer->start(1000);
+}
+
+void ImageManager::VideoFrameCache::save() const
+{
+    m_timer->stop();
+    m_unsaved = 0;
+
+    // Videos without frames are only remembered for this session, so extracting them is tried again
+    // after a restart, e.g. once a working mplayer is installed.
+    int count = 0;
+    Q_FOREACH( const Entry& entry, m_map )
+        if ( entry.frameCount > 0 )
+            ++count;
+
+    m_store.saveIndex( QString::fromLatin1("frameindex"), FILEVERSION, [this,count]( QDataStream& stream ) {
+        stream << count;
+        for( QMap<DB::FileName,Entry>::ConstIterator it = m_map.begin(); it != m_map.end(); ++it ) {
+            const Entry& entry = it.value();
+            if ( entry.frameCount == 0 )
+                continue;
+            stream << it.key().relative()
+                   << entry.location.fileIndex
+                   << entry.location.offset
+                   << entry.location.size
+                   << entry.frameCount
+                   << entry.frameSize
+                   << entry.thumbnailFrame;
+        }
+    } );
+}
+
+void ImageManager::VideoFrameCache::load()
+{
+    m_store.loadIndex( QString::fromLatin1("frameindex"), QList<int>() << FILEVERSION, [this]( QDataStream& stream, int ) {
+        int count;
+        stream >> count;
+        for ( int i = 0; i < count; ++i ) {
+            QString name;
+            Entry entry;
+            stream >> name
+                   >> entry.location.fileIndex
+                   >> entry.location.offset
+                   >> entry.location.size
+                   >> entry.frameCount
+                   >> entry.frameSize
+                   >> entry.thumbnailFrame;
+            // earlier indexes may still hold empty entries:
+            if ( entry.frameCount > 0 )
+                m_map.insert( DB::FileName::fromRelativePath(name), entry );
+        }
+    } );
+}
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,108 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef IMAGEMANAGER_VIDEOFRAMECACHE_H
+#define IMAGEMANAGER_VIDEOFRAMECACHE_H
+
+#include "CacheFileInfo.h"
+#include "ChunkedCacheStore.h"
+#include <DB/FileName.h>
+#include <QImage>
+#include <QMap>
+#include <QObject>
+#include <QSize>
+#include <QVector>
+
+class QTimer;
+
+namespace ImageManager {
+
+/**
+ * @brief The VideoFrameCache class stores the frames used for thumbnail cycling of videos.
+ *
+ * All frames of a video are stored as one horizontal strip, encoded as a single JPEG image.
+ * The strips are packed into chunk files (\c frames-N in the .videoThumbnails directory) by a
+ * \ref ChunkedCacheStore, which memory maps them on lookup, so getting all frames of a video takes a single read and decode.
+ *
+ * Frames which were stored as individual files by older versions are migrated on first access.
+ * \see \ref videothumbnails
+ */
+class VideoFrameCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static VideoFrameCache* instance();
+    static void deleteInstance();
+
+    /**
+     * @brief insert stores the given frames for the video, replacing any frames stored before.
+     * The frames are downscaled to ThumbnailCache::thumbnailBuildSize() if they are bigger.
+     * Inserting an empty list records that no frames could be extracted from the video.
+     * That is not saved, so it only lasts until the application is restarted.
+     * @return false if the frames could not be written to the cache
+     */
+    bool insert( const DB::FileName& video, const QVector<QImage>& frames );
+    /**
+     * @brief lookup returns the frames of the video, or an empty list if there are none.
+     */
+    QVector<QImage> lookup( const DB::FileName& video );
+    /**
+     * @brief contains returns true if frames were extracted for the video, either into this cache or as
+     * individual files by an older version.
+     */
+    bool contains( const DB::FileName& video ) const;
+    void remove( const DB::FileName& video );
+
+    /**
+     * @brief thumbnailFrame returns the index of the frame currently used as the thumbnail of the video,
+     * or -1 if none of the frames is used.
+     */
+    int thumbnailFrame( const DB::FileName& video ) const;
+    void setThumbnailFrame( const DB::FileName& video, int frame );
+
+public slots:
+    void save() const;
+
+private:
+    struct Entry
+    {
+        Entry() : frameCount(0), thumbnailFrame(-1) {}
+        CacheFileInfo location;
+        int frameCount;
+        QSize frameSize;
+        int thumbnailFrame;
+    };
+
+    VideoFrameCache();
+    ~VideoFrameCache();
+    void load();
+    bool hasLegacyFrames( const DB::FileName& video ) const;
+    QVector<QImage> migrateLegacyFrames( const DB::FileName& video );
+    void scheduleSave();
+
+    static VideoFrameCache* s_instance;
+    QMap<DB::FileName, Entry> m_map;
+    ChunkedCacheStore m_store;
+    QTimer* m_timer;
+    mutable int m_unsaved;
+};
+
+}
+
+#endif // IMAGEMANAGER_VIDEOFRAMECACHE_H
+// vi:expandtab:tabstop=4 shiftwidth=4:
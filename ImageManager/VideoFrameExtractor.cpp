@@ -0,0 +1,390 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "VideoFrameExtractor.h"
+#include <Utilities/Process.h>
+#include <MainWindow/FeatureDialog.h>
+#include <MainWindow/Window.h>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QRegExp>
+#include <QSocketNotifier>
+#include <QtConcurrentRun>
+#include <KDebug>
+#include <KLocale>
+#include <KMessageBox>
+
+extern "C" {
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+#define STR(x) QString::fromUtf8(x)
+
+namespace
+{
+inline uchar clamp( int value )
+{
+    return value < 0 ? 0 : ( value > 255 ? 255 : value );
+}
+
+/**
+ * Convert a planar YUV 4:2:0 frame (as written by mplayer's yuv4mpeg output) to RGB.
+ */
+QImage imageFromI420( const uchar* data, const QSize& size )
+{
+    const int width = size.width();
+    const int height = size.height();
+    const int chromaWidth = ( width + 1 ) / 2;
+    const int chromaHeight = ( height + 1 ) / 2;
+    const uchar* yPlane = data;
+    const uchar* uPlane = yPlane + width * height;
+    const uchar* vPlane = uPlane + chromaWidth * chromaHeight;
+
+    QImage image( size, QImage::Format_RGB32 );
+    if ( image.isNull() )
+        return image;
+
+    for ( int y = 0; y < height; ++y ) {
+        QRgb* out = reinterpret_cast<QRgb*>( image.scanLine(y) );
+        const uchar* yLine = yPlane + y * width;
+        const uchar* uLine = uPlane + ( y / 2 ) * chromaWidth;
+        const uchar* vLine = vPlane + ( y / 2 ) * chromaWidth;
+        for ( int x = 0; x < width; ++x ) {
+            // ITU-R BT.601
+            const int c = 298 * ( yLine[x] - 16 ) + 128;
+            const int d = uLine[x / 2] - 128;
+            const int e = vLine[x / 2] - 128;
+            out[x] = qRgb( clamp( ( c + 409 * e ) >> 8 ),
+                           clamp( ( c - 100 * d - 208 * e ) >> 8 ),
+                           clamp( ( c + 516 * d ) >> 8 ) );
+        }
+    }
+    return image;
+}
+}
+
+ImageManager::VideoFrameExtractor::VideoFrameExtractor( QObject* parent )
+    : QObject( parent ), m_state( Idle ), m_length( -1 ), m_process( nullptr ), m_pipe( -1 ),
+      m_notifier( nullptr ), m_headerRead( false ), m_frameCount( 0 ), m_maxFrameSize( -1 )
+{
+}
+
+ImageManager::VideoFrameExtractor::~VideoFrameExtractor()
+{
+    cleanup();
+}
+
+void ImageManager::VideoFrameExtractor::extract( const DB::FileName& fileName, int length, int maxFrameSize )
+{
+    cleanup();
+    m_fileName = fileName;
+    m_length = length;
+    m_maxFrameSize = maxFrameSize;
+
+    if ( MainWindow::FeatureDialog::mplayerBinary().isEmpty() ) {
+        emit failed();
+        return;
+    }
+
+    if ( m_length > 0 ) {
+        startExtraction();
+        return;
+    }
+
+    // We need the length up front to know how far to step between the frames.
+    m_state = ReadingLength;
+    m_process = new Utilities::Process( this );
+    m_process->setWorkingDirectory( QDir::tempPath() );
+    connect( m_process, SIGNAL(finished(int)), this, SLOT(processEnded()) );
+    connect( m_process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(handleError(QProcess::ProcessError)) );
+
+    QStringList arguments;
+    arguments << STR("-identify") << STR("-frames") << STR("0") << STR("-vc") << STR("null")
+              << STR("-vo") << STR("null") << STR("-ao") << STR("null") << fileName.absolute();
+    m_process->start( MainWindow::FeatureDialog::mplayerBinary(), arguments );
+}
+
+void ImageManager::VideoFrameExtractor::cancel()
+{
+    cleanup();
+}
+
+void ImageManager::VideoFrameExtractor::startExtraction()
+{
+    m_state = ExtractingFrames;
+    if ( !setupPipe() ) {
+        kWarning() << "Unable to create a pipe for extracting frames from" << m_fileName.absolute();
+        fail();
+        return;
+    }
+
+    m_process = new Utilities::Process( this );
+    m_process->setWorkingDirectory( m_workingDirectory );
+    connect( m_process, SIGNAL(finished(int)), this, SLOT(processEnded()) );
+    connect( m_process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(handleError(QProcess::ProcessError)) );
+
+    // -sstep skips the given number of seconds after each frame, so we get frames
+    // at the offsets 0, length/10, ..., 9*length/10 from a single pass.
+    const double step = double( m_length ) / NumberOfFrames;
+    QStringList arguments;
+    arguments << STR("-nosound") << STR("-identify") << STR("-sstep") << QString::number( step, 'f', 4 )
+              << STR("-frames") << QString::number( NumberOfFrames )
+              << STR("-vo") << STR("yuv4mpeg:file=%1").arg( m_workingDirectory + STR("/frames.y4m") )
+              << m_fileName.absolute();
+    m_process->start( MainWindow::FeatureDialog::mplayerBinary(), arguments );
+}
+
+/**
+ * Create a named pipe for mplayer to write the frames to. The pipe is opened
+ * non-blocking, so we don't wait for mplayer to open it for writing.
+ */
+bool ImageManager::VideoFrameExtractor::setupPipe()
+{
+    const QString tmpPath = STR("%1/KPA-XXXXXX").arg(QDir::tempPath());
+    QByteArray tmpPathBytes = QFile::encodeName( tmpPath );
+    if ( !mkdtemp( tmpPathBytes.data() ) )
+        return false;
+    m_workingDirectory = QFile::decodeName( tmpPathBytes );
+
+    const QByteArray pipeName = QFile::encodeName( m_workingDirectory + STR("/frames.y4m") );
+    if ( mkfifo( pipeName.constData(), 0600 ) != 0 )
+        return false;
+
+    m_pipe = ::open( pipeName.constData(), O_RDONLY | O_NONBLOCK );
+    if ( m_pipe < 0 )
+        return false;
+
+    m_buffer.clear();
+    m_headerRead = false;
+    m_frameSize = QSize();
+    m_frameCount = 0;
+    m_notifier = new QSocketNotifier( m_pipe, QSocketNotifier::Read, this );
+    connect( m_notifier, SIGNAL(activated(int)), this, SLOT(readFrames()) );
+    return true;
+}
+
+void ImageManager::VideoFrameExtractor::readFrames()
+{
+    if ( m_pipe < 0 )
+        return;
+
+    char buffer[64*1024];
+    while ( true ) {
+        const ssize_t count = ::read( m_pipe, buffer, sizeof(buffer) );
+        if ( count > 0 )
+            m_buffer.append( buffer, count );
+        else {
+            // End of file: mplayer closed the pipe.
+            if ( count == 0 && m_notifier )
+                m_notifier->setEnabled( false );
+            break;
+        }
+    }
+    parseFrames();
+}
+
+/**
+ * The yuv4mpeg stream is a header line ("YUV4MPEG2 W<width> H<height> ..."),
+ * followed by a "FRAME" line and the raw Y, U and V planes for each frame.
+ */
+void ImageManager::VideoFrameExtractor::parseFrames()
+{
+    if ( !m_headerRead ) {
+        const int end = m_buffer.indexOf( '\n' );
+        if ( end < 0 )
+            return;
+
+        const QList<QByteArray> tokens = m_buffer.left( end ).split( ' ' );
+        int width = 0;
+        int height = 0;
+        for ( const QByteArray& token : tokens ) {
+            if ( token.startsWith( 'W' ) )
+                width = token.mid(1).toInt();
+            else if ( token.startsWith( 'H' ) )
+                height = token.mid(1).toInt();
+        }
+        m_frameSize = QSize( width, height );
+        m_buffer.remove( 0, end + 1 );
+        m_headerRead = true;
+    }
+
+    if ( m_frameSize.isEmpty() ) {
+        m_buffer.clear();
+        return;
+    }
+
+    const int chromaSize = ( ( m_frameSize.width() + 1 ) / 2 ) * ( ( m_frameSize.height() + 1 ) / 2 );
+    const int frameBytes = m_frameSize.width() * m_frameSize.height() + 2 * chromaSize;
+    while ( true ) {
+        const int end = m_buffer.indexOf( '\n' );
+        if ( end < 0 || m_buffer.size() < end + 1 + frameBytes )
+            return;
+
+        if ( m_frameCount < NumberOfFrames )
+            startConversion( m_frameCount, m_buffer.mid( end + 1, frameBytes ) );
+        ++m_frameCount;
+        m_buffer.remove( 0, end + 1 + frameBytes );
+    }
+}
+
+/**
+ * Converting and scaling down a full size frame takes long enough to make the GUI stutter,
+ * so it is done on a worker thread; only the final frame is handed back to frameConverted().
+ */
+void ImageManager::VideoFrameExtractor::startConversion( int index, const QByteArray& data )
+{
+    QFutureWatcher<Frame>* watcher = new QFutureWatcher<Frame>( this );
+    connect( watcher, SIGNAL(finished()), this, SLOT(frameConverted()) );
+    m_conversions.append( watcher );
+    watcher->setFuture( QtConcurrent::run( &VideoFrameExtractor::convertFrame, index, data, m_frameSize, m_maxFrameSize ) );
+}
+
+/**
+ * Runs on a worker thread, so it must not touch the extractor.
+ */
+ImageManager::VideoFrameExtractor::Frame ImageManager::VideoFrameExtractor::convertFrame( int index, const QByteArray& data, const QSize& size, int maxSize )
+{
+    Frame frame;
+    frame.index = index;
+    frame.image = imageFromI420( reinterpret_cast<const uchar*>( data.constData() ), size );
+    if ( maxSize > 0 && qMax( size.width(), size.height() ) > maxSize )
+        frame.image = frame.image.scaled( maxSize, maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+    return frame;
+}
+
+void ImageManager::VideoFrameExtractor::frameConverted()
+{
+    QFutureWatcher<Frame>* watcher = static_cast<QFutureWatcher<Frame>*>( sender() );
+    m_conversions.removeOne( watcher );
+    watcher->deleteLater();
+
+    const Frame frame = watcher->result();
+    emit frameExtracted( frame.index, frame.image );
+
+    if ( m_state == ConvertingFrames && m_conversions.isEmpty() )
+        finish( m_length );
+}
+
+void ImageManager::VideoFrameExtractor::processEnded()
+{
+    const int length = lengthFromOutput();
+
+    if ( m_state == ReadingLength ) {
+        m_process->deleteLater();
+        m_process = nullptr;
+        if ( length <= 0 ) {
+            kWarning() << "Unable to determine the length of video file " << m_fileName.absolute();
+            finish( -1 );
+            return;
+        }
+        m_length = length;
+        startExtraction();
+        return;
+    }
+
+    // Pick up what is left in the pipe.
+    readFrames();
+    if ( length > 0 )
+        m_length = length;
+
+    if ( m_conversions.isEmpty() )
+        finish( m_length );
+    else
+        m_state = ConvertingFrames; // frameConverted() finishes once the last frame is in.
+}
+
+void ImageManager::VideoFrameExtractor::handleError( QProcess::ProcessError error )
+{
+    // Errors after start up are followed by processEnded()
+    if ( error != QProcess::FailedToStart )
+        return;
+
+    KMessageBox::information( MainWindow::Window::theMainWindow(),
+            i18n("<p>Error when extracting video thumbnails.<br/>Error was: %1</p>" , i18n("Failed to start") ),
+            QString(), QLatin1String("errorWhenRunningQProcessFromExtractOneVideoFrame"));
+    fail();
+}
+
+int ImageManager::VideoFrameExtractor::lengthFromOutput() const
+{
+    if ( !m_process )
+        return -1;
+
+    const QStringList list = m_process->stdout().split(QChar::fromLatin1('\n')).filter(STR("ID_LENGTH="));
+    if ( list.isEmpty() )
+        return -1;
+
+    const QRegExp regexp(STR("ID_LENGTH=([0-9.]+)"));
+    if ( !regexp.exactMatch( list.first().trimmed() ) )
+        return -1;
+
+    bool ok;
+    const double length = regexp.cap(1).toDouble(&ok);
+    return ok ? int( length ) : -1;
+}
+
+void ImageManager::VideoFrameExtractor::finish( int length )
+{
+    cleanup();
+    emit finished( length );
+}
+
+void ImageManager::VideoFrameExtractor::fail()
+{
+    cleanup();
+    emit failed();
+}
+
+void ImageManager::VideoFrameExtractor::cleanup()
+{
+    m_state = Idle;
+    if ( m_process ) {
+        disconnect( m_process, nullptr, this, nullptr );
+        if ( m_process->state() != QProcess::NotRunning )
+            m_process->kill();
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
+
+    delete m_notifier;
+    m_notifier = nullptr;
+    if ( m_pipe >= 0 ) {
+        ::close( m_pipe );
+        m_pipe = -1;
+    }
+    m_buffer.clear();
+
+    // Conversions still running just have their result thrown away.
+    qDeleteAll( m_conversions );
+    m_conversions.clear();
+
+    if ( !m_workingDirectory.isEmpty() ) {
+        QDir dir( m_workingDirectory );
+        dir.remove( STR("frames.y4m") );
+        dir.rmdir( m_workingDirectory );
+        m_workingDirectory.clear();
+    }
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,124 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef IMAGEMANAGER_VIDEOFRAMEEXTRACTOR_H
+#define IMAGEMANAGER_VIDEOFRAMEEXTRACTOR_H
+
+#include <QObject>
+#include <QProcess>
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <DB/FileName.h>
+class QSocketNotifier;
+
+namespace Utilities { class Process; }
+
+namespace ImageManager {
+
+/**
+  \brief Extract the frames for thumbnail cycling from a video with a single mplayer run.
+
+  mplayer steps through the video in \ref NumberOfFrames equal steps and writes the raw
+  frames in yuv4mpeg format into a named pipe, from which they are read as they arrive.
+  The length of the video is read from the same mplayer run. Only if the length of the
+  video is not known beforehand, mplayer needs to be run once more to find the step size.
+  The frames are converted to RGB and scaled down on worker threads.
+
+  \see \ref videothumbnails
+*/
+class VideoFrameExtractor : public QObject
+{
+    Q_OBJECT
+public:
+    enum { NumberOfFrames = 10 };
+
+    explicit VideoFrameExtractor( QObject* parent = nullptr );
+    ~VideoFrameExtractor() override;
+
+    /**
+     * @brief Start extracting the frames.
+     * @param fileName the video file
+     * @param length the length of the video in seconds, or -1 if unknown
+     * @param maxFrameSize frames bigger than maxFrameSize x maxFrameSize are scaled down to fit, -1 keeps the full size
+     */
+    void extract( const DB::FileName& fileName, int length, int maxFrameSize = -1 );
+
+    /**
+     * @brief Stop the extraction, killing mplayer if it is running.
+     * Neither frameExtracted(), finished() nor failed() are emitted afterwards.
+     */
+    void cancel();
+
+signals:
+    void frameExtracted( int index, const QImage& frame );
+    /**
+     * @brief Emitted when the extraction is done.
+     * @param length the length of the video in seconds, or -1 if it could not be determined.
+     */
+    void finished( int length );
+    /**
+     * @brief Emitted instead of finished() if mplayer could not be run at all.
+     * Nothing is known about the video then, so nothing should be cached for it.
+     */
+    void failed();
+
+private slots:
+    void processEnded();
+    void handleError( QProcess::ProcessError );
+    void readFrames();
+    void frameConverted();
+
+private:
+    struct Frame {
+        int index;
+        QImage image;
+    };
+    static Frame convertFrame( int index, const QByteArray& data, const QSize& size, int maxSize );
+    void startConversion( int index, const QByteArray& data );
+
+    void startExtraction();
+    void parseFrames();
+    void finish( int length );
+    void fail();
+    int lengthFromOutput() const;
+    bool setupPipe();
+    void cleanup();
+
+    enum State { Idle, ReadingLength, ExtractingFrames, ConvertingFrames };
+    State m_state;
+    DB::FileName m_fileName;
+    int m_length;
+    Utilities::Process* m_process;
+    QString m_workingDirectory;
+    int m_pipe;
+    QSocketNotifier* m_notifier;
+    QByteArray m_buffer;
+    bool m_headerRead;
+    QSize m_frameSize;
+    int m_frameCount;
+    int m_maxFrameSize;
+    QList<QFutureWatcher<Frame>*> m_conversions;
+};
+
+} // namespace ImageManager
+
+#endif // IMAGEMANAGER_VIDEOFRAMEEXTRACTOR_H
+// vi:expandtab:tabstop=4 shiftwidth=4:
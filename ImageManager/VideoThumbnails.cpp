@@ -17,11 +17,9 @@
 */
 
 #include "VideoThumbnails.h"
-#include <BackgroundJobs/HandleVideoThumbnailRequestJob.h>
+#include "VideoFrameCache.h"
 #include "VideoLengthExtractor.h"
-#include <QFile>
-#include <BackgroundJobs/ReadVideoLengthJob.h>
-#include <BackgroundJobs/ExtractOneThumbnailJob.h>
+#include <BackgroundJobs/ExtractVideoFramesJob.h>
 #include <BackgroundTaskManager/JobManager.h>
 #include <MainWindow/FeatureDialog.h>
 
@@ -29,7 +27,6 @@ ImageManager::VideoThumbnails::VideoThumbnails(QObject *parent) :
     QObject(parent), m_pendingRequest(false), m_index(0)
 {
     m_cache.resize(10);
-    m_activeRequests.reserve(10);
 }
 
 void ImageManager::VideoThumbnails::setVideoFile(const DB::FileName &fileName)
@@ -43,22 +40,17 @@ void ImageManager::VideoThumbnails::setVideoFile(const DB::FileName &fileName)
     if (MainWindow::FeatureDialog::mplayerBinary().isEmpty())
         return;
 
-    cancelPreviousJobs();
+    cancelPreviousJob();
     m_pendingRequest = false;
     for ( int i= 0; i < 10; ++i )
         m_cache[i] = QImage();
 
-    BackgroundJobs::ReadVideoLengthJob* lengthJob =
-            new BackgroundJobs::ReadVideoLengthJob(fileName, BackgroundTaskManager::ForegroundCycleRequest);
-
-    for (int i=0; i<10;++i) {
-        BackgroundJobs::ExtractOneThumbnailJob* extractJob =
-                new BackgroundJobs::ExtractOneThumbnailJob(fileName, i, BackgroundTaskManager::ForegroundCycleRequest);
-        extractJob->addDependency(lengthJob);
-        connect( extractJob, SIGNAL(completed()), this, SLOT(gotFrame()));
-        m_activeRequests.append( QPointer<BackgroundJobs::ExtractOneThumbnailJob>(extractJob) );
-    }
-    BackgroundTaskManager::JobManager::instance()->addJob(lengthJob);
+    // All frames (and the length of the video) come from a single job.
+    BackgroundJobs::ExtractVideoFramesJob* extractJob =
+            new BackgroundJobs::ExtractVideoFramesJob(fileName, BackgroundTaskManager::ForegroundCycleRequest);
+    connect( extractJob, SIGNAL(frameReady(int,QImage)), this, SLOT(gotFrame(int,QImage)));
+    m_activeRequest = extractJob;
+    BackgroundTaskManager::JobManager::instance()->addJob(extractJob);
 }
 
 void ImageManager::VideoThumbnails::requestNext()
@@ -74,12 +66,13 @@ void ImageManager::VideoThumbnails::requestNext()
     m_pendingRequest = true;
 }
 
-void ImageManager::VideoThumbnails::gotFrame()
+void ImageManager::VideoThumbnails::gotFrame(int index, const QImage& frame)
 {
-    const BackgroundJobs::ExtractOneThumbnailJob* job = qobject_cast<BackgroundJobs::ExtractOneThumbnailJob*>(sender());
-    const int index = job->index();
-    const DB::FileName thumbnailFile = BackgroundJobs::HandleVideoThumbnailRequestJob::frameName(m_videoFile, index);
-    m_cache[index]=QImage(thumbnailFile.absolute());
+    // A job for a previous video might still be running.
+    if ( sender() != m_activeRequest )
+        return;
+
+    m_cache[index] = frame;
 
     if ( m_pendingRequest ) {
         m_index = index;
@@ -89,26 +82,18 @@ void ImageManager::VideoThumbnails::gotFrame()
 
 bool ImageManager::VideoThumbnails::loadFramesFromCache(const DB::FileName& fileName)
 {
-    for (int i=0; i <10; ++i) {
-        const DB::FileName thumbnailFile = BackgroundJobs::HandleVideoThumbnailRequestJob::frameName(fileName, i);
-        if ( !thumbnailFile.exists())
-            return false;
+    const QVector<QImage> frames = VideoFrameCache::instance()->lookup(fileName);
+    if ( frames.count() != 10 )
+        return false;
 
-        QImage image(thumbnailFile.absolute());
-        if ( image.isNull() )
-            return false;
-
-        m_cache[i] = image;
-    }
+    m_cache = frames;
     return true;
 }
 
-void ImageManager::VideoThumbnails::cancelPreviousJobs()
+void ImageManager::VideoThumbnails::cancelPreviousJob()
 {
-    for ( const QPointer<BackgroundJobs::ExtractOneThumbnailJob>& job : m_activeRequests ) {
-        if (! job.isNull() )
-            job->cancel();
-    }
-    m_activeRequests.clear();
+    if ( !m_activeRequest.isNull() )
+        m_activeRequest->cancel();
+    m_activeRequest = nullptr;
 }
 // vi:expandtab:tabstop=4 shiftwidth=4:
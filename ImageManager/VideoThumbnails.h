@@ -24,7 +24,7 @@
 #include <DB/FileName.h>
 #include <QPointer>
 
-namespace BackgroundJobs { class ExtractOneThumbnailJob; }
+namespace BackgroundJobs { class ExtractVideoFramesJob; }
 
 namespace ImageManager {
 
@@ -49,16 +49,16 @@ signals:
     void frameLoaded( const QImage& );
 
 private slots:
-    void gotFrame();
+    void gotFrame(int index, const QImage& frame);
 
 private:
     bool loadFramesFromCache(const DB::FileName& fileName);
-    void cancelPreviousJobs();
+    void cancelPreviousJob();
 
     DB::FileName m_videoFile;
     QVector<QImage> m_cache;
     bool m_pendingRequest;
-    QVector< QPointer<BackgroundJobs::ExtractOneThumbnailJob> > m_activeRequests;
+    QPointer<BackgroundJobs::ExtractVideoFramesJob> m_activeRequest;
     int m_index;
 };
 
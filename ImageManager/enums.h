@@ -33,6 +33,7 @@ enum Priority {
                 *
                 * As they are requested by user, they are expected to finish
                 * sooner than invisible thumbnails */
+    ThumbnailPrefetch, /**< @short Thumbnail that is about to become visible, because the user is scrolling towards it */
     ThumbnailVisible, /**< @short Thumbnail visible on screen right now (might get invalidated later) */
     Viewer /**< @short Image is visible in the viewer right now */,
     LastPriority /**< @short Boundary for list of queues */
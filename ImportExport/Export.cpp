@@ -18,12 +18,10 @@
 
 #include "Export.h"
 #include <kfiledialog.h>
-#include <kzip.h>
 #include <qfileinfo.h>
 #include "Utilities/Util.h"
 #include <QProgressDialog>
 #include <klocale.h>
-#include <time.h>
 #include "ImageManager/AsyncLoader.h"
 #include "DB/ImageInfo.h"
 #include <qapplication.h>
@@ -33,8 +31,13 @@
 #include <qspinbox.h>
 
 #include <qradiobutton.h>
-#include <qbuffer.h>
+#include <QFile>
 #include "XMLHandler.h"
+#include "ExportTask.h"
+#include "ZipWriter.h"
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QThreadPool>
 #include <QVBoxLayout>
 #include <QGroupBox>
 #include <DB/FileNameList.h>
@@ -173,6 +176,9 @@ ImageFileLocation ExportConfig::imageFileLocation() const
 
 Export::~Export()
 {
+    // the tasks report back to us:
+    m_pool->waitForDone();
+    delete m_zip;
     delete m_eventLoop;
 }
 
@@ -186,15 +192,21 @@ Export::Export(
     bool doGenerateThumbnails,
     bool *ok)
     : m_ok( ok )
+    , m_compress( compress )
+    , m_nextFile( 0 )
+    , m_filesInFlight( 0 )
+    , m_scheduling( false )
+    , m_streaming( false )
+    , m_canceled( 0 )
     , m_maxSize( maxSize )
     , m_location( location )
     , m_eventLoop( new QEventLoop )
 {
     *ok = true;
+    m_pool = new QThreadPool( this );
     m_destdir = QFileInfo( zipFile ).path();
-    m_zip = new KZip( zipFile );
-    m_zip->setCompression( compress ? KZip::DeflateCompression : KZip::NoCompression );
-    if ( ! m_zip->open( QIODevice::WriteOnly ) ) {
+    m_zip = new ZipWriter( zipFile );
+    if ( ! m_zip->open() ) {
         KMessageBox::error( nullptr, i18n("Error creating zip file") );
         *ok = false;
         return;
@@ -221,22 +233,34 @@ Export::Export(
         copyImages( list );
     }
 
-    if ( m_ok && doGenerateThumbnails ) {
+    if ( *m_ok && doGenerateThumbnails ) {
         m_copyingFiles = false;
         generateThumbnails( list );
     }
 
-    if ( m_ok ) {
+    if ( *m_ok ) {
         // Create the index.xml file
         m_progressDialog->setLabelText(i18n("Creating index file"));
-        QByteArray indexml = XMLHandler().createIndexXML( list, baseUrl, m_location, &m_filenameMapper );
-        time_t t;
-        time(&t);
-        m_zip->writeFile( QString::fromLatin1( "index.xml" ), QString(), QString(), indexml.data(), indexml.size()-1 );
+        // The index is plain XML, so it is always worth compressing, even if the images are stored as they are:
+        QIODevice* index = m_zip->beginEntry( QString::fromLatin1( "index.xml" ), true );
+        XMLHandler().writeIndexXML( index, list, baseUrl, m_location, &m_filenameMapper );
+        const bool written = m_zip->endEntry();
 
        m_steps++;
        m_progressDialog->setValue( m_steps );
-        m_zip->close();
+        if ( !m_zip->close() || !written ) {
+            showWriteError( zipFile );
+            *m_ok = false;
+        }
+    }
+
+    if ( !*m_ok ) {
+        // without its index and central directory, the archive is of no use
+        // (a task may still be copying a file into it, though):
+        m_pool->waitForDone();
+        delete m_zip;
+        m_zip = nullptr;
+        QFile::remove( zipFile );
     }
 }
 
@@ -244,54 +268,59 @@ Export::Export(
 void Export::generateThumbnails(const DB::FileNameList& list)
 {
     m_progressDialog->setLabelText( i18n("Creating thumbnails") );
-    m_loopEntered = false;
     m_subdir = QString::fromLatin1( "Thumbnails/" );
-    m_filesRemaining = list.size(); // Used to break the event loop.
-    for (const DB::FileName& fileName : list) {
-        ImageManager::ImageRequest* request = new ImageManager::ImageRequest( fileName, QSize( 128, 128 ), fileName.info()->angle(), this );
-        request->setPriority( ImageManager::BatchTask );
-        ImageManager::AsyncLoader::instance()->load( request );
-    }
-    if ( m_filesRemaining > 0 ) {
-        m_loopEntered = true;
-        m_eventLoop->exec();
-    }
+    processFiles( list );
 }
 
 void Export::copyImages(const DB::FileNameList& list)
 {
     Q_ASSERT( m_location != ManualCopy );
 
-    m_loopEntered = false;
     m_subdir = QString::fromLatin1( "Images/" );
 
     m_progressDialog->setLabelText( i18n("Copying image files") );
+    processFiles( list );
+}
 
-    m_filesRemaining = 0;
-    for (const DB::FileName& fileName : list) {
-        QString file = fileName.absolute();
-        QString zippedName = m_filenameMapper.uniqNameFor(fileName);
-
-        if ( m_maxSize == -1 || Utilities::isVideo( fileName ) || Utilities::isRAW( fileName )) {
-            if ( QFileInfo( file ).isSymLink() )
-                file = QFileInfo(file).readLink();
-
-            if ( m_location == Inline )
-                m_zip->addLocalFile( file, QString::fromLatin1( "Images/" ) + zippedName );
-            else if ( m_location == AutoCopy )
-                Utilities::copy( file, m_destdir + QString::fromLatin1( "/" ) + zippedName );
-            else if ( m_location == Link )
-                Utilities::makeHardLink( file, m_destdir + QString::fromLatin1( "/" ) + zippedName );
-            else if ( m_location == Symlink )
-                Utilities::makeSymbolicLink( file, m_destdir + QString::fromLatin1( "/" ) + zippedName );
-
-            m_steps++;
-            m_progressDialog->setValue( m_steps );
+/**
+ * Work on the files until all of them are done, or the export is canceled.
+ */
+void Export::processFiles(const DB::FileNameList& list)
+{
+    m_loopEntered = false;
+    m_files = list;
+    m_nextFile = 0;
+    m_filesInFlight = 0;
+    scheduleFiles();
+    if ( *m_ok && ( m_filesInFlight > 0 || m_nextFile < m_files.size() ) ) {
+        m_loopEntered = true;
+        m_eventLoop->exec();
+    }
+}
+
+/**
+ * Start working on more files, as long as not too many are in the works already.
+ * Each of them is either loaded by the image loader (when it must be resized), or handed to an \ref ExportTask.
+ */
+void Export::scheduleFiles()
+{
+    if ( m_scheduling )
+        return; // called again from processEvents() below
+    m_scheduling = true;
+
+    const int maxInFlight = 2 * m_pool->maxThreadCount();
+    while ( *m_ok && m_filesInFlight < maxInFlight && m_nextFile < m_files.size() ) {
+        const DB::FileName fileName = m_files.at( m_nextFile++ );
+        if ( m_copyingFiles ) {
+            if ( !copyImage( fileName ) ) {
+                // only one file at a time can be copied into the archive; writeResults() resumes when it is done
+                --m_nextFile;
+                break;
+            }
         }
         else {
-            m_filesRemaining++;
-            ImageManager::ImageRequest* request =
-                new ImageManager::ImageRequest( DB::FileName::fromAbsolutePath(file), QSize( m_maxSize, m_maxSize ), 0, this );
+            ++m_filesInFlight;
+            ImageManager::ImageRequest* request = new ImageManager::ImageRequest( fileName, QSize( 128, 128 ), fileName.info()->angle(), this );
             request->setPriority( ImageManager::BatchTask );
             ImageManager::AsyncLoader::instance()->load( request );
         }
@@ -299,64 +328,180 @@ void Export::copyImages(const DB::FileNameList& list)
         // Test if the cancel button was pressed.
         qApp->processEvents( QEventLoop::AllEvents );
 
-        if ( m_progressDialog->wasCanceled() ) {
-            *m_ok = false;
-            return;
+        if ( m_progressDialog->wasCanceled() )
+            stop();
+    }
+
+    m_scheduling = false;
+    if ( m_loopEntered && ( !*m_ok || ( m_filesInFlight == 0 && m_nextFile >= m_files.size() ) ) )
+        m_eventLoop->exit();
+}
+
+/**
+ * Start exporting the file, unless it must wait for another file being copied into the archive.
+ */
+bool Export::copyImage(const DB::FileName& fileName)
+{
+    QString file = fileName.absolute();
+    QString zippedName = m_filenameMapper.uniqNameFor(fileName);
+
+    if ( m_maxSize == -1 || Utilities::isVideo( fileName ) || Utilities::isRAW( fileName )) {
+        if ( QFileInfo( file ).isSymLink() )
+            file = QFileInfo(file).readLink();
+
+        QString destination = m_destdir + QString::fromLatin1( "/" ) + zippedName;
+        if ( m_location == Inline ) {
+            destination = QString::fromLatin1( "Images/" ) + zippedName;
+            // e.g. videos are too large to be read into memory at once; the task copies them into the archive directly:
+            if ( QFileInfo( file ).size() > 32 * 1024 * 1024 ) {
+                if ( m_streaming )
+                    return false;
+                m_streaming = true;
+                ++m_filesInFlight;
+                m_pool->start( new ExportTask( this, QImage(), file, m_location, destination, shouldCompress( zippedName ), m_zip ) );
+                return true;
+            }
         }
+
+        ++m_filesInFlight;
+        m_pool->start( new ExportTask( this, QImage(), file, m_location, destination, shouldCompress( zippedName ) ) );
     }
-    if ( m_filesRemaining > 0 ) {
-        m_loopEntered = true;
-        m_eventLoop->exec();
+    else {
+        ++m_filesInFlight;
+        ImageManager::ImageRequest* request =
+            new ImageManager::ImageRequest( DB::FileName::fromAbsolutePath(file), QSize( m_maxSize, m_maxSize ), 0, this );
+        request->setPriority( ImageManager::BatchTask );
+        ImageManager::AsyncLoader::instance()->load( request );
     }
+    return true;
 }
 
 void Export::pixmapLoaded(ImageManager::ImageRequest* request, const QImage& image)
 {
     const DB::FileName fileName = request->databaseFileName();
-    if ( !request->loadedOK() )
+    if ( !*m_ok )
+        return;
+
+    if ( !request->loadedOK() ) {
+        // leave it out, rather than waiting for it forever:
+        --m_filesInFlight;
+        m_steps++;
+        m_progressDialog->setValue( m_steps );
+        scheduleFiles();
         return;
+    }
 
     const QString ext = (Utilities::isVideo( fileName ) || Utilities::isRAW( fileName )) ? QString::fromLatin1( "jpg" ) : QFileInfo( m_filenameMapper.uniqNameFor(fileName) ).completeSuffix();
 
     // Add the file to the zip archive
     QString zipFileName = QString::fromLatin1( "%1/%2.%3" ).arg( Utilities::stripEndingForwardSlash(m_subdir))
         .arg(QFileInfo( m_filenameMapper.uniqNameFor(fileName) ).baseName()).arg( ext );
-    QByteArray data;
-    QBuffer buffer( &data );
-    buffer.open( QIODevice::WriteOnly );
-    image.save( &buffer,  QFileInfo(zipFileName).suffix().toLower().toLatin1() );
 
+    // The image is encoded on a worker thread; see writeResults() for the rest.
     if ( m_location == Inline || !m_copyingFiles )
-        m_zip->writeFile( zipFileName, QString(), QString(), data, data.size() );
+        m_pool->start( new ExportTask( this, image, QString(), Inline, zipFileName, shouldCompress( zipFileName ) ) );
     else {
         QString file = m_destdir + QString::fromLatin1( "/" ) + m_filenameMapper.uniqNameFor(fileName);
-        QFile out( file );
-        if ( !out.open( QIODevice::WriteOnly ) ) {
-            KMessageBox::error( nullptr, i18n("Error writing file %1", file ) );
-            *m_ok = false;
+        m_pool->start( new ExportTask( this, image, QString(), m_location, file, false ) );
+    }
+}
+
+void Export::taskDone( const TaskResult& result )
+{
+    QMutexLocker locker( &m_resultsLock );
+    m_results.append( result );
+    if ( m_results.count() == 1 )
+        QMetaObject::invokeMethod( this, "writeResults", Qt::QueuedConnection );
+}
+
+/**
+ * Write the entries prepared by the \ref ExportTask%s to the archive.
+ */
+void Export::writeResults()
+{
+    QList<TaskResult> results;
+    {
+        QMutexLocker locker( &m_resultsLock );
+        results = m_results;
+        m_results.clear();
+    }
+
+    for ( const TaskResult& result : results ) {
+        if ( result.streamed ) {
+            m_streaming = false;
+            writeResult( result );
+            const QList<TaskResult> waiting = m_waitingResults;
+            m_waitingResults.clear();
+            for ( const TaskResult& waitingResult : waiting )
+                writeResult( waitingResult );
         }
-        out.write( data, data.size() );
-        out.close();
+        else if ( m_streaming && result.hasEntry )
+            m_waitingResults.append( result );
+        else
+            writeResult( result );
     }
 
-    qApp->processEvents( QEventLoop::AllEvents );
+    if ( m_progressDialog->wasCanceled() )
+        stop();
 
-    bool canceled = (!m_ok ||  m_progressDialog->wasCanceled());
+    scheduleFiles();
+}
 
-    if ( canceled ) {
-        *m_ok = false;
-        m_eventLoop->exit();
-        ImageManager::AsyncLoader::instance()->stop( this );
+void Export::writeResult( const TaskResult& result )
+{
+    --m_filesInFlight;
+    if ( !*m_ok )
         return;
+
+    if ( !result.failedFile.isEmpty() ) {
+        showWriteError( result.failedFile );
+        stop();
+    }
+    else if ( result.hasEntry && !m_zip->writeEntry( result.entry ) ) {
+        showWriteError( result.entry.name );
+        stop();
+    }
+    else {
+        m_steps++;
+        m_progressDialog->setValue( m_steps );
     }
+}
+
+bool Export::isCanceled() const
+{
+    return int( m_canceled ) != 0;
+}
 
-    m_steps++;
-    m_filesRemaining--;
-    m_progressDialog->setValue( m_steps );
+void Export::stop()
+{
+    if ( !*m_ok )
+        return;
+    *m_ok = false;
+    m_canceled.fetchAndStoreRelease( 1 );
+    ImageManager::AsyncLoader::instance()->stop( this );
+}
 
+void Export::showWriteError( const QString& fileName )
+{
+    if ( m_zip->isTooLarge() )
+        KMessageBox::error( nullptr, i18n("<p>The export is too large for a .kim file, which can hold at most 4 GB in up to 65535 files.</p>"
+                                          "<p>Please export fewer images, or do not include the images in the .kim file.</p>") );
+    else
+        KMessageBox::error( nullptr, i18n("Error writing file %1", fileName ) );
+}
 
-        if ( m_filesRemaining == 0 && m_loopEntered )
-            m_eventLoop->exit();
+/**
+ * Deflating images or videos, which are compressed already, only costs time.
+ */
+bool Export::shouldCompress( const QString& fileName ) const
+{
+    if ( !m_compress )
+        return false;
+    const QString ext = QFileInfo( fileName ).suffix().toLower();
+    if ( ext == QString::fromLatin1( "jpg" ) || ext == QString::fromLatin1( "jpeg" ) ||
+         ext == QString::fromLatin1( "png" ) || ext == QString::fromLatin1( "gif" ) )
+        return false;
+    return !Utilities::supportedVideoExtensions().contains( ext );
 }
 
 void Export::showUsageDialog()
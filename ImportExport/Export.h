@@ -22,24 +22,48 @@
 #include "ImageManager/ImageClientInterface.h"
 #include <KDialog>
 #include "Utilities/UniqFilenameMapper.h"
+#include "ZipWriter.h"
+#include <QAtomicInt>
 #include <QEventLoop>
+#include <QMutex>
+#include <QObject>
 #include <QPointer>
 #include <DB/FileNameList.h>
 
 class QRadioButton;
 class QSpinBox;
 class QCheckBox;
-class KZip;
 class QProgressDialog;
+class QThreadPool;
 
 namespace ImportExport
 {
 
 enum ImageFileLocation { Inline, ManualCopy, AutoCopy, Link, Symlink };
 
-class Export :public ImageManager::ImageClientInterface {
+/**
+ * @brief The Export writes a .kim file, along with the images if requested.
+ *
+ * Images are decoded by the image loader, and encoded and compressed by \ref ExportTask%s on a thread pool.
+ * Only a limited number of files is in the works at any time, so memory use doesn't grow with the
+ * number of images exported. The prepared entries are written to the archive by the \ref ZipWriter
+ * on the GUI thread, one after the other, and index.xml is streamed into it last.
+ * Files too large to be kept in memory are copied into the archive by an \ref ExportTask instead; while
+ * that is going on, the GUI thread leaves the archive alone and holds back the entries which are done meanwhile.
+ */
+class Export :public QObject, public ImageManager::ImageClientInterface {
+    Q_OBJECT
 
 public:
+    /// what an \ref ExportTask hands back
+    struct TaskResult
+    {
+        QString failedFile;
+        bool hasEntry;
+        bool streamed; ///< the task copied the file into the archive itself
+        ZipWriter::Entry entry;
+    };
+
     static void imageExport(const DB::FileNameList& list);
 
     Export( const DB::FileNameList& list, const QString& zipFile,
@@ -54,16 +78,49 @@ public:
     // ImageManager::ImageClient callback.
     void pixmapLoaded(ImageManager::ImageRequest* request, const QImage& image) override;
 
+    /**
+     * @brief taskDone is called by the \ref ExportTask%s when done, on their thread.
+     */
+    void taskDone( const TaskResult& result );
+
+    /**
+     * @brief isCanceled tells whether the export was stopped. This function is thread-safe.
+     */
+    bool isCanceled() const;
+
 protected:
     void generateThumbnails(const DB::FileNameList& list);
     void copyImages(const DB::FileNameList& list);
 
+private slots:
+    void writeResults();
+
 private:
+    void processFiles( const DB::FileNameList& list );
+    void scheduleFiles();
+    bool copyImage( const DB::FileName& fileName );
+    void writeResult( const TaskResult& result );
+    void stop();
+    void showWriteError( const QString& fileName );
+    bool shouldCompress( const QString& fileName ) const;
+
     bool* m_ok;
-    int m_filesRemaining;
     int m_steps;
     QProgressDialog* m_progressDialog;
-    KZip* m_zip;
+    ZipWriter* m_zip;
+    bool m_compress;
+    QThreadPool* m_pool;
+    // the files of the current step, and how many of them are being worked on:
+    DB::FileNameList m_files;
+    int m_nextFile;
+    int m_filesInFlight;
+    bool m_scheduling;
+    QMutex m_resultsLock;
+    QList<TaskResult> m_results;
+    // set while an ExportTask copies a file into the archive, along with the results which must wait for it:
+    bool m_streaming;
+    QList<TaskResult> m_waitingResults;
+    QAtomicInt m_canceled;
     int m_maxSize;
     QString m_subdir;
     bool m_loopEntered;
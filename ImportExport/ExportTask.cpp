@@ -0,0 +1,105 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ExportTask.h"
+#include "Utilities/Util.h"
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+ImportExport::ExportTask::ExportTask( Export* exporter, const QImage& image, const QString& source,
+                                      ImageFileLocation location, const QString& destination, bool compress, ZipWriter* zip )
+    : m_exporter( exporter ), m_image( image ), m_source( source ), m_location( location ),
+      m_destination( destination ), m_compress( compress ), m_zip( zip )
+{
+}
+
+void ImportExport::ExportTask::run()
+{
+    // The user is likely to keep on working while the export is running.
+    QThread::currentThread()->setPriority( QThread::LowPriority );
+
+    Export::TaskResult result;
+    result.hasEntry = false;
+    result.streamed = ( m_zip != nullptr );
+
+    if ( m_zip ) {
+        copyIntoArchive( &result );
+        m_exporter->taskDone( result );
+        return;
+    }
+
+    const bool resized = !m_image.isNull();
+    QByteArray data;
+    if ( resized ) {
+        QBuffer buffer( &data );
+        buffer.open( QIODevice::WriteOnly );
+        if ( !m_image.save( &buffer, QFileInfo( m_destination ).suffix().toLower().toLatin1() ) )
+            result.failedFile = m_destination;
+        m_image = QImage();
+    }
+    else if ( m_location == Inline ) {
+        QFile file( m_source );
+        if ( !file.open( QIODevice::ReadOnly ) ) {
+            // files which can't be read have always been left out silently:
+            m_exporter->taskDone( result );
+            return;
+        }
+        data = file.readAll();
+    }
+
+    if ( result.failedFile.isEmpty() ) {
+        if ( m_location == Inline ) {
+            result.entry = ZipWriter::prepareEntry( m_destination, data, m_compress );
+            result.hasEntry = true;
+        }
+        else if ( resized ) {
+            QFile out( m_destination );
+            if ( !out.open( QIODevice::WriteOnly ) || out.write( data ) != data.size() )
+                result.failedFile = m_destination;
+        }
+        // failing to copy or link the original files has never been treated as an error:
+        else if ( m_location == AutoCopy )
+            Utilities::copy( m_source, m_destination );
+        else if ( m_location == Link )
+            Utilities::makeHardLink( m_source, m_destination );
+        else if ( m_location == Symlink )
+            Utilities::makeSymbolicLink( m_source, m_destination );
+    }
+
+    m_exporter->taskDone( result );
+}
+
+void ImportExport::ExportTask::copyIntoArchive( Export::TaskResult* result )
+{
+    QFile file( m_source );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return; // files which can't be read have always been left out silently
+
+    QIODevice* entry = m_zip->beginEntry( m_destination, m_compress );
+    while ( !file.atEnd() && !m_exporter->isCanceled() ) {
+        const QByteArray buffer = file.read( 1024 * 1024 );
+        if ( buffer.isEmpty() || entry->write( buffer ) != buffer.size() )
+            break;
+    }
+    const bool complete = file.atEnd();
+    if ( !m_zip->endEntry() || !complete )
+        result->failedFile = m_destination;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
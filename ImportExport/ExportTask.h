@@ -0,0 +1,66 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef IMPORTEXPORT_EXPORTTASK_H
+#define IMPORTEXPORT_EXPORTTASK_H
+
+#include "Export.h"
+#include "ZipWriter.h"
+#include <QImage>
+#include <QRunnable>
+#include <QString>
+
+namespace ImportExport
+{
+
+/**
+ * @brief The ExportTask does the expensive part of exporting one file on a worker thread.
+ *
+ * Depending on the location, it either prepares an entry of the .kim file (encoding the image, or reading
+ * the file, and compressing it), or writes the file next to the .kim file.
+ * Entries are handed back to the Export, which writes them to the archive one after the other.
+ * Files too large for that are copied into the archive by the task itself.
+ */
+class ExportTask : public QRunnable
+{
+public:
+    /**
+     * @param image the resized image to write, or a null image to export the source file as it is
+     * @param destination the name of the entry in the archive for Inline, the file to write otherwise
+     * @param zip if set, the source file is copied into this archive right away; the Export must not use it until the task is done
+     */
+    ExportTask( Export* exporter, const QImage& image, const QString& source,
+                ImageFileLocation location, const QString& destination, bool compress, ZipWriter* zip = nullptr );
+    void run() override;
+
+private:
+    void copyIntoArchive( Export::TaskResult* result );
+
+    Export* m_exporter;
+    QImage m_image;
+    QString m_source;
+    ImageFileLocation m_location;
+    QString m_destination;
+    bool m_compress;
+    ZipWriter* m_zip;
+};
+
+}
+
+#endif /* IMPORTEXPORT_EXPORTTASK_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -19,6 +19,7 @@
 #include "KimFileReader.h"
 #include "ImportDialog.h"
 #include <QCheckBox>
+#include <QPushButton>
 #include "MiniViewer.h"
 #include <QImage>
 #include <kio/netaccess.h>
@@ -27,10 +28,33 @@
 using namespace ImportExport;
 
 ImageRow::ImageRow( DB::ImageInfoPtr info, ImportDialog* import, KimFileReader* kimFileReader, QWidget* parent )
-    : QObject( parent ), m_info( info ), m_import(import), m_kimFileReader( kimFileReader )
+    : QObject( parent ), m_info( info ), m_import(import), m_kimFileReader( kimFileReader ), m_thumbnail( nullptr ), m_thumbnailLoaded( false )
 {
     m_checkbox = new QCheckBox( QString(), parent );
     m_checkbox->setChecked( true );
+
+    if ( kimFileReader->hasThumbnails() ) {
+        // The thumbnail is loaded by the ImportDialog once the row is scrolled into view.
+        m_thumbnail = new QPushButton( parent );
+        m_thumbnail->setIconSize( QSize( 128, 128 ) );
+        connect( m_thumbnail, SIGNAL(clicked()), this, SLOT(showImage()) );
+    }
+}
+
+void ImageRow::loadThumbnail()
+{
+    if ( !m_thumbnail || m_thumbnailLoaded )
+        return;
+    m_thumbnailLoaded = true;
+
+    const QPixmap pixmap = m_kimFileReader->loadThumbnail( m_info->fileName().relative() );
+    if ( pixmap.isNull() ) {
+        m_thumbnail->setText( m_info->label() );
+    }
+    else {
+        m_thumbnail->setIcon( pixmap );
+        m_thumbnail->setIconSize( pixmap.size() );
+    }
 }
 
 void ImageRow::showImage()
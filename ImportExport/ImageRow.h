@@ -22,6 +22,7 @@
 #include <QObject>
 
 class QCheckBox;
+class QPushButton;
 namespace ImportExport
 {
 class ImportDialog;
@@ -39,9 +40,15 @@ public:
     DB::ImageInfoPtr m_info;
     ImportDialog* m_import;
     KimFileReader* m_kimFileReader;
+    QPushButton* m_thumbnail;
+
+    void loadThumbnail();
 
 protected slots:
     void showImage();
+
+private:
+    bool m_thumbnailLoaded;
 };
 
 }
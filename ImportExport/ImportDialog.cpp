@@ -39,6 +39,9 @@
 #include "XMLDB/Database.h"
 #include <QComboBox>
 #include <QScrollArea>
+#include <QScrollBar>
+#include <QTimer>
+#include <QEvent>
 #include <KMessageBox>
 
 using Utilities::StringSet;
@@ -48,7 +51,7 @@ using namespace ImportExport;
 
 
 ImportDialog::ImportDialog( QWidget* parent )
-    :KAssistantDialog( parent ), m_hasFilled( false ), m_md5CheckPage(nullptr)
+    :KAssistantDialog( parent ), m_imagesScrollArea( nullptr ), m_hasFilled( false ), m_md5CheckPage(nullptr)
 {
 }
 
@@ -170,13 +173,8 @@ void ImportDialog::createImagesPage()
         ImageRow* ir = new ImageRow( info, this, m_kimFileReader, container );
         lay3->addWidget( ir->m_checkbox, row, 0 );
 
-        QPixmap pixmap = m_kimFileReader->loadThumbnail( info->fileName().relative() );
-         if ( !pixmap.isNull() ) {
-            QPushButton* but = new QPushButton( container );
-            but->setIcon( pixmap );
-            but->setIconSize( pixmap.size() );
-            lay3->addWidget( but, row, 1 );
-            connect( but, SIGNAL(clicked()), ir, SLOT(showImage()) );
+        if ( ir->m_thumbnail ) {
+            lay3->addWidget( ir->m_thumbnail, row, 1 );
         }
         else {
             QLabel* label = new QLabel( info->label() );
@@ -188,9 +186,48 @@ void ImportDialog::createImagesPage()
         m_imagesSelect.append( ir );
     }
 
+    // Thumbnails are only loaded for the rows that are scrolled into view, so opening a huge .kim file stays fast.
+    m_imagesScrollArea = top;
+    top->viewport()->installEventFilter( this );
+    connect( top->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(loadVisibleThumbnails()) );
+
     addPage( top, i18n("Select Which Images to Import") );
 }
 
+bool ImportDialog::eventFilter( QObject* watched, QEvent* event )
+{
+    if ( m_imagesScrollArea && watched == m_imagesScrollArea->viewport()
+         && ( event->type() == QEvent::Show || event->type() == QEvent::Resize ) )
+        QTimer::singleShot( 0, this, SLOT(loadVisibleThumbnails()) );
+    return KAssistantDialog::eventFilter( watched, event );
+}
+
+void ImportDialog::loadVisibleThumbnails()
+{
+    if ( !m_imagesScrollArea || !m_kimFileReader->hasThumbnails() )
+        return;
+
+    // The area of the container that is visible, extended by a page in each direction to have the
+    // neighbouring thumbnails ready when scrolling.
+    const int page = m_imagesScrollArea->viewport()->height();
+    const int top = -m_imagesScrollArea->widget()->y() - page;
+    const int bottom = -m_imagesScrollArea->widget()->y() + 2 * page;
+
+    // The rows are laid out top to bottom, so find the first visible one by bisection.
+    int first = 0;
+    int last = m_imagesSelect.count();
+    while ( first < last ) {
+        const int middle = ( first + last ) / 2;
+        if ( m_imagesSelect[middle]->m_thumbnail->geometry().bottom() < top )
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    for ( int i = first; i < m_imagesSelect.count() && m_imagesSelect[i]->m_thumbnail->y() <= bottom; ++i )
+        m_imagesSelect[i]->loadThumbnail();
+}
+
 void ImportDialog::createDestination()
 {
     QWidget* top = new QWidget( this );
@@ -26,6 +26,7 @@
 
 class KTemporaryFile;
 class KLineEdit;
+class QScrollArea;
 
 namespace DB
 {
@@ -63,6 +64,7 @@ protected:
     void selectImage( bool on );
     DB::ImageInfoList selectedImages() const;
     void possiblyAddMD5CheckPage();
+    bool eventFilter( QObject* watched, QEvent* event ) override;
 
 protected slots:
     void slotEditDestination();
@@ -71,6 +73,7 @@ protected slots:
     void slotSelectAll();
     void slotSelectNone();
     void slotHelp();
+    void loadVisibleThumbnails();
 
 signals:
     void failedToCopy( QStringList files );
@@ -84,6 +87,7 @@ private:
     ImportMatcher* m_categoryMatcher;
     ImportMatchers m_matchers;
     QList< ImageRow* > m_imagesSelect;
+    QScrollArea* m_imagesScrollArea;
     KTemporaryFile* m_tmp;
     bool m_externalSource;
     KUrl m_kimFile;
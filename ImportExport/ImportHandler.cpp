@@ -19,7 +19,10 @@
 
 #include <QApplication>
 #include <QFile>
+#include <QMetaObject>
+#include <QMutexLocker>
 #include <QProgressDialog>
+#include <QThreadPool>
 #include <klocale.h>
 #include <kio/netaccess.h>
 #include <kio/jobuidelegate.h>
@@ -30,6 +33,7 @@
 #include "Utilities/Util.h"
 #include "KimFileReader.h"
 #include "ImportSettings.h"
+#include "ImportTask.h"
 #include "MainWindow/Window.h"
 #include "DB/ImageDB.h"
 #include "Browser/BrowserWidget.h"
@@ -50,17 +54,24 @@ using namespace ImportExport;
 ImportExport::ImportHandler::ImportHandler()
     : m_fileMapper(nullptr), m_finishedPressed(false), m_progress(0), m_reportUnreadableFiles( true )
     , m_eventLoop( new QEventLoop )
+    , m_extractionsPending( 0 ), m_extractionFailed( false )
 
 {
+    m_pool = new QThreadPool( this );
 }
 
 ImportHandler::~ImportHandler() {
+    // the tasks report back to us:
+    m_canceled = 1;
+    m_pool->waitForDone();
     delete m_fileMapper;
     delete m_eventLoop;
 }
 
 bool ImportExport::ImportHandler::exec( const ImportSettings& settings, KimFileReader* kimFileReader )
 {
+    // the image directory watcher must not add the files while we are copying them:
+    DB::ImageDB::WriteGuard guard;
     m_settings = settings;
     m_kimFileReader = kimFileReader;
     m_finishedPressed = true;
@@ -140,6 +151,10 @@ void ImportExport::ImportHandler::copyNextFromExternal()
         aCopyFailed( tried );
 }
 
+/**
+ * Extract the images which are not in the database yet from the .kim file.
+ * Which images these are is decided up front, and then all of them are extracted by \ref ImportTask%s on a thread pool.
+ */
 bool ImportExport::ImportHandler::copyFilesFromZipFile()
 {
     DB::ImageInfoList images = m_settings.selectedImages();
@@ -147,33 +162,88 @@ bool ImportExport::ImportHandler::copyFilesFromZipFile()
     m_totalCopied = 0;
     m_progress = new KProgressDialog( MainWindow::Window::theMainWindow(), i18n("Copying Images") );
     m_progress->progressBar()->setMinimum( 0 );
-    m_progress->progressBar()->setMaximum( 2 * m_pendingCopies.count() );
+    m_progress->progressBar()->setMaximum( 2 * images.count() );
     m_progress->show();
 
+    m_canceled = 0;
+    m_extractionFailed = false;
+    m_md5Sums.clear();
+    const QString kimFile = m_kimFileReader->fileName();
+    QList<ImportTask*> tasks;
     for( DB::ImageInfoListConstIterator it = images.constBegin(); it != images.constEnd(); ++it ) {
-        if ( !isImageAlreadyInDB( *it ) ) {
-            const DB::FileName fileName = (*it)->fileName();
-            QByteArray data = m_kimFileReader->loadImage( fileName.relative() );
-            if ( data.isNull() )
-                return false;
-            QString newName = m_fileMapper->uniqNameFor(fileName);
-
-            QFile out( newName );
-            if ( !out.open( QIODevice::WriteOnly ) ) {
-                KMessageBox::error( MainWindow::Window::theMainWindow(), i18n("Error when writing image %1", newName ) );
-                return false;
-            }
-            out.write( data, data.size() );
-            out.close();
+        if ( isImageAlreadyInDB( *it ) ) {
+            ++m_totalCopied;
+            continue;
         }
 
-        qApp->processEvents();
-        m_progress->progressBar()->setValue( ++m_totalCopied );
-        if ( m_progress->wasCancelled() ) {
+        const DB::FileName fileName = (*it)->fileName();
+        KimFileReader::Location location;
+        if ( !m_kimFileReader->locateImage( fileName.relative(), &location ) ) {
+            qDeleteAll( tasks );
             return false;
         }
+        tasks.append( new ImportTask( this, fileName, kimFile, location, m_fileMapper->uniqNameFor(fileName), &m_canceled ) );
+    }
+    m_progress->progressBar()->setValue( m_totalCopied );
+
+    m_extractionsPending = tasks.count();
+    for ( ImportTask* task : tasks )
+        m_pool->start( task );
+    if ( m_extractionsPending > 0 )
+        m_eventLoop->exec();
+
+    // make sure no task is still writing when we return:
+    if ( m_extractionFailed )
+        m_pool->waitForDone();
+    return !m_extractionFailed;
+}
+
+void ImportExport::ImportHandler::imageExtracted( const DB::FileName& fileName, const QString& md5, const QString& failedFile )
+{
+    const Extraction extraction = { fileName, md5, failedFile };
+    QMutexLocker locker( &m_extractedLock );
+    m_extracted.append( extraction );
+    if ( m_extracted.count() == 1 )
+        QMetaObject::invokeMethod( this, "processExtractedImages", Qt::QueuedConnection );
+}
+
+void ImportExport::ImportHandler::processExtractedImages()
+{
+    QList<Extraction> extracted;
+    {
+        QMutexLocker locker( &m_extractedLock );
+        extracted = m_extracted;
+        m_extracted.clear();
+    }
+
+    for ( const Extraction& extraction : extracted ) {
+        --m_extractionsPending;
+        if ( m_extractionFailed )
+            continue;
+
+        if ( !extraction.failedFile.isEmpty() ) {
+            m_extractionFailed = true;
+            m_canceled = 1;
+            if ( extraction.failedFile == m_kimFileReader->fileName() )
+                KMessageBox::error( MainWindow::Window::theMainWindow(),
+                                    i18n("Error reading %1 from file %2; it is likely that the file is broken.",
+                                         extraction.fileName.relative(), extraction.failedFile ) );
+            else
+                KMessageBox::error( MainWindow::Window::theMainWindow(), i18n("Error when writing image %1", extraction.failedFile ) );
+            continue;
+        }
+
+        m_md5Sums.insert( extraction.fileName, DB::MD5( extraction.md5 ) );
+        m_progress->progressBar()->setValue( ++m_totalCopied );
     }
-    return true;
+
+    if ( !m_extractionFailed && m_progress->wasCancelled() ) {
+        m_extractionFailed = true;
+        m_canceled = 1;
+    }
+
+    if ( m_extractionFailed || m_extractionsPending == 0 )
+        m_eventLoop->exit();
 }
 
 void ImportExport::ImportHandler::updateDB()
@@ -193,6 +263,7 @@ void ImportExport::ImportHandler::updateDB()
     DB::ImageInfoList images = m_settings.selectedImages();
     for( DB::ImageInfoListConstIterator it = images.constBegin(); it != images.constEnd(); ++it ) {
         DB::ImageInfoPtr info = *it;
+        const DB::FileName importedName = info->fileName();
         if ( len != 0) {
             // exchange prefix:
             QString name = m_settings.destination() + info->fileName().absolute().mid(len);
@@ -205,7 +276,7 @@ void ImportExport::ImportHandler::updateDB()
             updateInfo( matchingInfoFromDB( info ), info );
         } else {
             Debug() << "Adding ImageInfo for " << info->fileName().absolute();
-            addNewRecord( info );
+            addNewRecord( info, m_md5Sums.value( importedName ) );
         }
 
         m_progress->progressBar()->setValue( ++m_totalCopied );
@@ -301,7 +372,7 @@ void ImportExport::ImportHandler::updateInfo( DB::ImageInfoPtr dbInfo, DB::Image
     updateCategories( newInfo, dbInfo, false );
 }
 
-void ImportExport::ImportHandler::addNewRecord( DB::ImageInfoPtr info )
+void ImportExport::ImportHandler::addNewRecord( DB::ImageInfoPtr info, const DB::MD5& md5Sum )
 {
     const DB::FileName importName = info->fileName();
 
@@ -310,7 +381,8 @@ void ImportExport::ImportHandler::addNewRecord( DB::ImageInfoPtr info )
     updateInfo->setDescription( info->description() );
     updateInfo->setDate( info->date() );
     updateInfo->setAngle( info->angle() );
-    updateInfo->setMD5Sum( Utilities::MD5Sum( updateInfo->fileName() ) );
+    // extracting the image from the .kim file computed the sum already:
+    updateInfo->setMD5Sum( md5Sum.isNull() ? Utilities::MD5Sum( updateInfo->fileName() ) : md5Sum );
 
 
     DB::ImageInfoList list;
@@ -19,14 +19,20 @@
 #define IMPORTHANDLER_H
 
 #include "ImportSettings.h"
+#include <QAtomicInt>
 #include <QEventLoop>
+#include <QHash>
+#include <QMutex>
 #include <QPointer>
+#include "DB/FileName.h"
 #include "DB/ImageInfoPtr.h"
+#include "DB/MD5.h"
 
 namespace KIO { class FileCopyJob; }
 class KJob;
 namespace Utilities { class UniqFilenameMapper; }
 class KProgressDialog;
+class QThreadPool;
 
 namespace ImportExport {
 class KimFileReader;
@@ -43,6 +49,13 @@ public:
     ~ImportHandler();
     bool exec( const ImportSettings& settings, KimFileReader* kimFileReader );
 
+    /**
+     * @brief imageExtracted is called by the \ref ImportTask%s when done, on their thread.
+     * @param md5 the MD5 sum of the extracted image, empty if it could not be extracted
+     * @param failedFile the file which could not be read or written, if any
+     */
+    void imageExtracted( const DB::FileName& fileName, const QString& md5, const QString& failedFile );
+
 private:
     void copyFromExternal();
     void copyNextFromExternal();
@@ -53,12 +66,13 @@ private slots:
     void stopCopyingImages();
     void aCopyFailed( QStringList files );
     void aCopyJobCompleted( KJob* );
+    void processExtractedImages();
 
 private:
     bool isImageAlreadyInDB( const DB::ImageInfoPtr& info );
     DB::ImageInfoPtr matchingInfoFromDB( const DB::ImageInfoPtr& info );
     void updateInfo( DB::ImageInfoPtr dbInfo, DB::ImageInfoPtr newInfo );
-    void addNewRecord( DB::ImageInfoPtr newInfo );
+    void addNewRecord( DB::ImageInfoPtr newInfo, const DB::MD5& md5Sum );
     void updateCategories( DB::ImageInfoPtr XMLInfo, DB::ImageInfoPtr DBInfo, bool forceReplace );
 
 private:
@@ -72,6 +86,21 @@ private:
     QPointer<QEventLoop> m_eventLoop;
     ImportSettings m_settings;
     KimFileReader* m_kimFileReader;
+
+    struct Extraction
+    {
+        DB::FileName fileName;
+        QString md5;
+        QString failedFile;
+    };
+    QThreadPool* m_pool;
+    QAtomicInt m_canceled;
+    int m_extractionsPending;
+    bool m_extractionFailed;
+    QMutex m_extractedLock;
+    QList<Extraction> m_extracted;
+    // the MD5 sums computed while extracting, so the images don't need to be read again:
+    QHash<DB::FileName, DB::MD5> m_md5Sums;
 };
 
 }
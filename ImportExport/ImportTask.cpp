@@ -0,0 +1,158 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ImportTask.h"
+#include "ImportHandler.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QThread>
+#include <zlib.h>
+
+namespace
+{
+const qint64 CHUNKSIZE = 256 * 1024;
+}
+
+ImportExport::ImportTask::ImportTask( ImportHandler* handler, const DB::FileName& fileName, const QString& kimFile,
+                                      const KimFileReader::Location& location, const QString& destination, const QAtomicInt* canceled )
+    : m_handler( handler ), m_fileName( fileName ), m_kimFile( kimFile ), m_location( location ),
+      m_destination( destination ), m_canceled( canceled )
+{
+}
+
+void ImportExport::ImportTask::run()
+{
+    QThread::currentThread()->setPriority( QThread::LowPriority );
+
+    QString md5;
+    QString failedFile;
+    if ( !extract( &md5, &failedFile ) )
+        QFile::remove( m_destination );
+    m_handler->imageExtracted( m_fileName, md5, failedFile );
+}
+
+/**
+ * Copy the data of the entry to the destination, inflating it if it is deflated.
+ * Only one chunk of the compressed and one of the plain data are kept in memory at a time.
+ */
+bool ImportExport::ImportTask::extract( QString* md5, QString* failedFile )
+{
+    if ( *m_canceled )
+        return false;
+
+    QFile in( m_kimFile );
+    if ( !in.open( QIODevice::ReadOnly ) || !in.seek( m_location.offset ) ) {
+        *failedFile = m_kimFile;
+        return false;
+    }
+    QFile out( m_destination );
+    if ( !out.open( QIODevice::WriteOnly ) ) {
+        *failedFile = m_destination;
+        return false;
+    }
+
+    z_stream stream;
+    if ( m_location.deflated ) {
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        stream.next_in = Z_NULL;
+        stream.avail_in = 0;
+        // zip files store raw deflate data, without the zlib header:
+        if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK ) {
+            *failedFile = m_kimFile;
+            return false;
+        }
+    }
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    QByteArray plain( int( CHUNKSIZE ), Qt::Uninitialized );
+    qint64 remaining = m_location.compressedSize;
+    qint64 written = 0;
+    bool ok = true;
+    bool streamEnd = false;
+    while ( ok && remaining > 0 && !streamEnd ) {
+        if ( *m_canceled ) {
+            ok = false;
+            break;
+        }
+
+        const QByteArray chunk = in.read( qMin( remaining, CHUNKSIZE ) );
+        if ( chunk.isEmpty() ) {
+            *failedFile = m_kimFile;
+            ok = false;
+            break;
+        }
+        remaining -= chunk.size();
+
+        if ( !m_location.deflated ) {
+            hash.addData( chunk );
+            ok = out.write( chunk ) == chunk.size();
+            if ( !ok )
+                *failedFile = m_destination;
+            written += chunk.size();
+            continue;
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( chunk.constData() ) );
+        stream.avail_in = uInt( chunk.size() );
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>( plain.data() );
+            stream.avail_out = uInt( plain.size() );
+            const int result = inflate( &stream, Z_NO_FLUSH );
+            // Z_BUF_ERROR is not fatal, it only tells that the last call filled the output buffer
+            // with the input that was left, so nothing could be done this time. Truncated data is
+            // caught by comparing the number of bytes written with the size from the .kim file.
+            if ( result == Z_BUF_ERROR )
+                break;
+            if ( result != Z_OK && result != Z_STREAM_END ) {
+                *failedFile = m_kimFile;
+                ok = false;
+                break;
+            }
+            const int produced = plain.size() - int( stream.avail_out );
+            hash.addData( plain.constData(), produced );
+            if ( out.write( plain.constData(), produced ) != produced ) {
+                *failedFile = m_destination;
+                ok = false;
+                break;
+            }
+            written += produced;
+            streamEnd = ( result == Z_STREAM_END );
+        } while ( stream.avail_out == 0 && !streamEnd );
+    }
+
+    if ( m_location.deflated )
+        inflateEnd( &stream );
+
+    if ( ok && written != m_location.size ) {
+        // the .kim file is truncated or broken
+        *failedFile = m_kimFile;
+        ok = false;
+    }
+    out.close();
+    if ( ok && out.error() != QFile::NoError ) {
+        *failedFile = m_destination;
+        ok = false;
+    }
+
+    if ( ok )
+        *md5 = QString::fromLatin1( hash.result().toHex() );
+    return ok;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
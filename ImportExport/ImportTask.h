@@ -0,0 +1,60 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef IMPORTEXPORT_IMPORTTASK_H
+#define IMPORTEXPORT_IMPORTTASK_H
+
+#include "KimFileReader.h"
+#include <DB/FileName.h>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QString>
+
+namespace ImportExport
+{
+class ImportHandler;
+
+/**
+ * @brief The ImportTask extracts one image from the .kim file on a worker thread.
+ *
+ * The data is read from the .kim file in small chunks, inflated if needed, and written to the destination.
+ * The MD5 sum of the image is computed on the way, so the image doesn't need to be read again
+ * when it is added to the database.
+ */
+class ImportTask : public QRunnable
+{
+public:
+    ImportTask( ImportHandler* handler, const DB::FileName& fileName, const QString& kimFile,
+                const KimFileReader::Location& location, const QString& destination, const QAtomicInt* canceled );
+    void run() override;
+
+private:
+    bool extract( QString* md5, QString* failedFile );
+
+    ImportHandler* m_handler;
+    DB::FileName m_fileName;
+    QString m_kimFile;
+    KimFileReader::Location m_location;
+    QString m_destination;
+    const QAtomicInt* m_canceled;
+};
+
+}
+
+#endif /* IMPORTEXPORT_IMPORTTASK_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -19,105 +19,265 @@
 #include <QFileInfo>
 #include <klocale.h>
 #include <kmessagebox.h>
-#include <kzip.h>
+#include <zlib.h>
 #include "Utilities/Util.h"
 
+namespace
+{
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const quint32 END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+const int LOCAL_HEADER_SIZE = 30;
+const int CENTRAL_HEADER_SIZE = 46;
+const int END_OF_DIRECTORY_SIZE = 22;
+const int MAX_COMMENT_SIZE = 0xffff;
+const quint16 STORED = 0;
+const quint16 DEFLATED = 8;
+
+quint16 get16( const QByteArray& data, int pos )
+{
+    const uchar* bytes = reinterpret_cast<const uchar*>( data.constData() ) + pos;
+    return quint16( bytes[0] | ( bytes[1] << 8 ) );
+}
+
+quint32 get32( const QByteArray& data, int pos )
+{
+    return quint32( get16( data, pos ) ) | ( quint32( get16( data, pos + 2 ) ) << 16 );
+}
+
+QByteArray inflateData( const QByteArray& compressed, qint64 size )
+{
+    QByteArray result( int( size ), '\0' );
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( compressed.constData() ) );
+    stream.avail_in = uInt( compressed.size() );
+    if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK )
+        return QByteArray();
+
+    stream.next_out = reinterpret_cast<Bytef*>( result.data() );
+    stream.avail_out = uInt( result.size() );
+    const int status = inflate( &stream, Z_FINISH );
+    inflateEnd( &stream );
+    if ( status != Z_STREAM_END || stream.avail_out != 0 )
+        return QByteArray();
+    return result;
+}
+}
+
 ImportExport::KimFileReader::KimFileReader()
-    :m_zip(nullptr)
+    : m_map(nullptr)
+    , m_size(0)
+    , m_hasImages(false)
+    , m_hasThumbnails(false)
+    , m_reportedMissingThumbnail(false)
 {
 }
 
 bool ImportExport::KimFileReader::open( const QString& fileName )
 {
     m_fileName = fileName;
-    m_zip = new KZip( fileName );
-    if ( !m_zip->open( QIODevice::ReadOnly ) ) {
+    m_file.setFileName( fileName );
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
         KMessageBox::error( nullptr, i18n("Unable to open '%1' for reading.", fileName ), i18n("Error Importing Data") );
-        delete m_zip;
-    m_zip = nullptr;
         return false;
     }
 
-    m_dir = m_zip->directory();
-    if ( m_dir == nullptr ) {
+    // Mapping may fail, e.g. if the address space is too small for the file; read() falls back to plain reads then.
+    m_size = m_file.size();
+    m_map = m_file.map( 0, m_size );
+
+    if ( !readDirectory() ) {
         KMessageBox::error( nullptr, i18n( "Error reading directory contents of file %1; it is likely that the file is broken." , fileName ) );
-        delete m_zip;
-    m_zip = nullptr;
-    return false;
+        m_entries.clear();
+        return false;
     }
 
+    return true;
+}
+
+bool ImportExport::KimFileReader::readDirectory()
+{
+    // The end of central directory record is followed by the archive comment only, so search backwards for it.
+    const qint64 tailSize = qMin( m_size, qint64( END_OF_DIRECTORY_SIZE + MAX_COMMENT_SIZE ) );
+    const QByteArray tail = read( m_size - tailSize, tailSize );
+    int end = tail.size() - END_OF_DIRECTORY_SIZE;
+    while ( end >= 0 && get32( tail, end ) != END_OF_DIRECTORY_SIGNATURE )
+        --end;
+    if ( end < 0 )
+        return false;
+
+    const qint64 directorySize = get32( tail, end + 12 );
+    const qint64 directoryOffset = get32( tail, end + 16 );
+    if ( directoryOffset + directorySize > m_size )
+        return false;
+
+    const QByteArray directory = read( directoryOffset, directorySize );
+    if ( directory.size() != directorySize )
+        return false;
+    m_entries.reserve( get16( tail, end + 10 ) );
+
+    // The entry count of the end record is only 16 bits wide, so walk the directory itself instead of trusting it.
+    int pos = 0;
+    while ( pos + CENTRAL_HEADER_SIZE <= directory.size() ) {
+        if ( get32( directory, pos ) != CENTRAL_HEADER_SIGNATURE )
+            return false;
+
+        const int nameLength = get16( directory, pos + 28 );
+        const int extraLength = get16( directory, pos + 30 );
+        const int commentLength = get16( directory, pos + 32 );
+        if ( pos + CENTRAL_HEADER_SIZE + nameLength > directory.size() )
+            return false;
 
+        const QString name = QFile::decodeName( directory.mid( pos + CENTRAL_HEADER_SIZE, nameLength ) );
+        if ( !name.endsWith( QChar::fromLatin1( '/' ) ) ) {
+            Entry entry;
+            entry.method = get16( directory, pos + 10 );
+            entry.compressedSize = get32( directory, pos + 20 );
+            entry.size = get32( directory, pos + 24 );
+            entry.headerOffset = get32( directory, pos + 42 );
+            m_entries.insert( name, entry );
+
+            if ( name.startsWith( QString::fromLatin1( "Images/" ) ) )
+                m_hasImages = true;
+            else if ( name.startsWith( QString::fromLatin1( "Thumbnails/" ) ) )
+                m_hasThumbnails = true;
+        }
+        pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+    }
     return true;
 }
 
+QByteArray ImportExport::KimFileReader::read( qint64 offset, qint64 length )
+{
+    if ( offset < 0 || length < 0 || offset + length > m_size )
+        return QByteArray();
+
+    if ( m_map )
+        return QByteArray::fromRawData( reinterpret_cast<const char*>( m_map + offset ), int( length ) );
+
+    if ( !m_file.seek( offset ) )
+        return QByteArray();
+    return m_file.read( length );
+}
+
+bool ImportExport::KimFileReader::locate( const QString& name, Location* location )
+{
+    const QHash<QString, Entry>::const_iterator it = m_entries.constFind( name );
+    if ( it == m_entries.constEnd() )
+        return false;
+
+    // The local header may carry a different extra field than the central directory, so the data offset is read from it.
+    const QByteArray header = read( it->headerOffset, LOCAL_HEADER_SIZE );
+    if ( header.size() != LOCAL_HEADER_SIZE || get32( header, 0 ) != LOCAL_HEADER_SIGNATURE )
+        return false;
+
+    location->offset = it->headerOffset + LOCAL_HEADER_SIZE + get16( header, 26 ) + get16( header, 28 );
+    location->compressedSize = it->compressedSize;
+    location->size = it->size;
+    location->deflated = ( it->method == DEFLATED );
+    return ( it->method == STORED || it->method == DEFLATED ) && location->offset + location->compressedSize <= m_size;
+}
+
+QByteArray ImportExport::KimFileReader::data( const QString& name )
+{
+    Location location;
+    if ( !locate( name, &location ) )
+        return QByteArray();
+
+    return extract( location );
+}
+
+QByteArray ImportExport::KimFileReader::extract( const Location& location )
+{
+    const QByteArray raw = read( location.offset, location.compressedSize );
+    if ( !location.deflated || raw.isNull() )
+        return raw;
+    return inflateData( raw, location.size );
+}
+
 QByteArray ImportExport::KimFileReader::indexXML()
 {
-    const KArchiveEntry* indexxml = m_dir->entry( QString::fromLatin1( "index.xml" ) );
-    if ( indexxml == nullptr || ! indexxml->isFile() ) {
+    const QByteArray result = data( QString::fromLatin1( "index.xml" ) );
+    if ( result.isNull() ) {
         KMessageBox::error( nullptr, i18n( "Error reading index.xml file from %1; it is likely that the file is broken." , m_fileName ) );
         return QByteArray();
     }
+    return result;
+}
 
-    const KArchiveFile* file = static_cast<const KArchiveFile*>( indexxml );
-    return file->data();
+QString ImportExport::KimFileReader::fileName() const
+{
+    return m_fileName;
 }
 
 ImportExport::KimFileReader::~KimFileReader()
 {
-    delete m_zip;
+    if ( m_map )
+        m_file.unmap( m_map );
 }
 
-QPixmap ImportExport::KimFileReader::loadThumbnail( QString fileName )
+bool ImportExport::KimFileReader::hasThumbnails() const
 {
-    const KArchiveEntry* thumbnails = m_dir->entry( QString::fromLatin1( "Thumbnails" ) );
-    if( !thumbnails )
-        return QPixmap();
+    return m_hasThumbnails;
+}
 
-    if ( !thumbnails->isDirectory() ) {
-        KMessageBox::error( nullptr, i18n("Thumbnail item in export file was not a directory, this indicates that the file is broken.") );
+QPixmap ImportExport::KimFileReader::loadThumbnail( QString fileName )
+{
+    if( !m_hasThumbnails )
         return QPixmap();
-    }
-
-    const KArchiveDirectory* thumbnailDir = static_cast<const KArchiveDirectory*>( thumbnails );
 
     const QString ext = Utilities::isVideo( DB::FileName::fromRelativePath(fileName) ) ? QString::fromLatin1( "jpg" ) : QFileInfo( fileName ).completeSuffix();
     fileName = QString::fromLatin1("%1.%2").arg( Utilities::stripEndingForwardSlash( QFileInfo( fileName ).baseName() ) ).arg(ext);
-    const KArchiveEntry* fileEntry = thumbnailDir->entry( fileName );
-    if ( fileEntry == nullptr || !fileEntry->isFile() ) {
-        KMessageBox::error( nullptr, i18n("No thumbnail existed in export file for %1", fileName ) );
+    const QByteArray thumbnail = data( QString::fromLatin1( "Thumbnails/" ) + fileName );
+    if ( thumbnail.isNull() ) {
+        // thumbnails are loaded while scrolling through the import dialog, so only complain once.
+        if ( !m_reportedMissingThumbnail ) {
+            m_reportedMissingThumbnail = true;
+            KMessageBox::error( nullptr, i18n("No thumbnail existed in export file for %1", fileName ) );
+        }
         return QPixmap();
     }
 
-    const KArchiveFile* file = static_cast<const KArchiveFile*>( fileEntry );
-    QByteArray data = file->data();
     QPixmap pixmap;
-    pixmap.loadFromData( data );
+    pixmap.loadFromData( thumbnail );
     return pixmap;
 }
 
-QByteArray ImportExport::KimFileReader::loadImage( const QString& fileName )
+bool ImportExport::KimFileReader::locateImageEntry( const QString& fileName, Location* location )
 {
-    const KArchiveEntry* images = m_dir->entry( QString::fromLatin1( "Images" ) );
-    if ( !images ) {
+    if ( !m_hasImages ) {
         KMessageBox::error( nullptr, i18n("export file did not contain a Images subdirectory, this indicates that the file is broken") );
-        return QByteArray();
+        return false;
     }
 
-    if ( !images->isDirectory() ) {
-        KMessageBox::error( nullptr, i18n("Images item in export file was not a directory, this indicates that the file is broken") );
-        return QByteArray();
+    const QString name = QString::fromLatin1( "Images/" ) + fileName;
+    if ( !m_entries.contains( name ) ) {
+        KMessageBox::error( nullptr, i18n("No image existed in export file for %1", fileName ) );
+        return false;
     }
 
-    const KArchiveDirectory* imagesDir = static_cast<const KArchiveDirectory*>( images );
+    if ( !locate( name, location ) ) {
+        KMessageBox::error( nullptr, i18n("Unsupported compression of %1 in the export file", fileName ) );
+        return false;
+    }
+    return true;
+}
 
-    const KArchiveEntry* fileEntry = imagesDir->entry( fileName );
-    if ( fileEntry == nullptr || !fileEntry->isFile() ) {
-        KMessageBox::error( nullptr, i18n("No image existed in export file for %1", fileName ) );
+QByteArray ImportExport::KimFileReader::loadImage( const QString& fileName )
+{
+    Location location;
+    if ( !locateImageEntry( fileName, &location ) )
         return QByteArray();
-    }
 
-    const KArchiveFile* file = static_cast<const KArchiveFile*>( fileEntry );
-    QByteArray data = file->data();
-    return data;
+    return extract( location );
 }
+
+bool ImportExport::KimFileReader::locateImage( const QString& fileName, Location* location )
+{
+    return locateImageEntry( fileName, location );
+}
+
 // vi:expandtab:tabstop=4 shiftwidth=4:
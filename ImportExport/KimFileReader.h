@@ -17,28 +17,71 @@
 */
 #ifndef KIMFILEREADER_H
 #define KIMFILEREADER_H
+#include <QFile>
+#include <QHash>
 #include <QPixmap>
 #include <QString>
-class KArchiveDirectory;
-class KZip;
 
 namespace ImportExport {
 
+/**
+ * @brief The KimFileReader gives access to the files inside a .kim file, which is a zip archive.
+ *
+ * The archive is memory mapped, and its central directory is read once into a hash from the names of the
+ * files to their location, so looking up a file doesn't depend on the size of the archive.
+ * Files which are stored without compression are returned without copying them: the returned
+ * QByteArray refers to the mapped archive, and is only valid as long as the KimFileReader exists.
+ */
 class KimFileReader
 {
 public:
+    /**
+     * @brief The Location of the data of a file inside the .kim file.
+     * With it, the file can be extracted by reading the .kim file directly, e.g. from several threads at the same time.
+     */
+    struct Location
+    {
+        qint64 offset;
+        qint64 compressedSize;
+        qint64 size;
+        bool deflated; ///< stored as it is otherwise
+    };
+
     KimFileReader();
     ~KimFileReader();
     bool open(const QString& fileName);
+    QString fileName() const;
     QByteArray indexXML();
+    bool hasThumbnails() const;
     QPixmap loadThumbnail( QString fileName );
     QByteArray loadImage( const QString& fileName );
+    bool locateImage( const QString& fileName, Location* location );
 
 
 private:
+    struct Entry
+    {
+        qint64 headerOffset;
+        qint64 compressedSize;
+        qint64 size;
+        quint16 method;
+    };
+
+    bool readDirectory();
+    QByteArray read( qint64 offset, qint64 length );
+    bool locate( const QString& name, Location* location );
+    QByteArray data( const QString& name );
+    QByteArray extract( const Location& location );
+    bool locateImageEntry( const QString& fileName, Location* location );
+
     QString m_fileName;
-    KZip* m_zip;
-    const KArchiveDirectory* m_dir;
+    QFile m_file;
+    uchar* m_map;
+    qint64 m_size;
+    QHash<QString, Entry> m_entries;
+    bool m_hasImages;
+    bool m_hasThumbnails;
+    bool m_reportedMissingThumbnail;
 };
 
 }
@@ -16,10 +16,13 @@
    Boston, MA 02110-1301, USA.
 */
 #include "XMLHandler.h"
-#include <qdom.h>
+#include <QXmlStreamWriter>
 #include "Utilities/Util.h"
+#include "XMLDB/ElementWriter.h"
+#include "DB/ImageInfo.h"
 
 using Utilities::StringSet;
+using XMLDB::ElementWriter;
 
 /**
  * \class ImportExport::XMLHandler
@@ -27,96 +30,90 @@ using Utilities::StringSet;
  * reading and writing the index.xml file located in exported .kim file.
  * This class is a simple helper class which encapsulate the code needed for generating an index.xml for the export file.
  * There should never be a need to keep any instances around of this class, simply create one on the stack, and call
- * thee method \ref createIndexXML().
+ * thee method \ref writeIndexXML().
+ *
+ * The index is streamed to the device as it is generated, so it is never kept in memory as a whole.
  *
  * Notice, you will find a lot of duplicated code inhere from the XML database, there are two reasons for this
  * (1) In the long run the XML database ought to be an optional part (users might instead use, say an SQL database)
  * (2) To ensure that the .kim files are compatible both forth and back between versions, I'd rather keep that code
  * separate from the normal index.xml file, which might change with KPhotoAlbum versions to e.g. support compression.
  */
-QByteArray ImportExport::XMLHandler::createIndexXML(
+void ImportExport::XMLHandler::writeIndexXML(
+    QIODevice* out,
     const DB::FileNameList& images,
     const QString& baseUrl,
     ImageFileLocation location,
     Utilities::UniqFilenameMapper* nameMap)
 {
-    QDomDocument doc;
-    doc.appendChild( doc.createProcessingInstruction( QString::fromLatin1("xml"),
-                                                      QString::fromLatin1("version=\"1.0\" encoding=\"UTF-8\"") ) );
-
-    QDomElement top = doc.createElement( QString::fromLatin1( "KimDaBa-export" ) ); // Don't change, as this will make the files unreadable for KimDaBa 2.1 and back.
-    top.setAttribute( QString::fromLatin1( "location" ),
-                      location == Inline ? QString::fromLatin1( "inline" ) : QString::fromLatin1( "external" ) );
-    if ( !baseUrl.isEmpty() )
-        top.setAttribute( QString::fromLatin1( "baseurl" ), baseUrl );
-    doc.appendChild( top );
-
-
-    Q_FOREACH(const DB::FileName& fileName, images) {
-        const QString mappedFile = nameMap->uniqNameFor(fileName);
-        QDomElement elm = save(doc, fileName.info());
-        elm.setAttribute( QString::fromLatin1( "file" ), mappedFile );
-        top.appendChild( elm );
+    QXmlStreamWriter writer( out );
+    writer.setAutoFormatting( true );
+    writer.writeStartDocument();
+
+    {
+        ElementWriter dummy( writer, QString::fromLatin1( "KimDaBa-export" ) ); // Don't change, as this will make the files unreadable for KimDaBa 2.1 and back.
+        writer.writeAttribute( QString::fromLatin1( "location" ),
+                               location == Inline ? QString::fromLatin1( "inline" ) : QString::fromLatin1( "external" ) );
+        if ( !baseUrl.isEmpty() )
+            writer.writeAttribute( QString::fromLatin1( "baseurl" ), baseUrl );
+
+        Q_FOREACH(const DB::FileName& fileName, images) {
+            save( writer, fileName.info(), nameMap->uniqNameFor(fileName) );
+        }
     }
-    return doc.toByteArray();
+    writer.writeEndDocument();
 }
 
-QDomElement ImportExport::XMLHandler::save( QDomDocument doc, const DB::ImageInfoPtr& info )
+void ImportExport::XMLHandler::save( QXmlStreamWriter& writer, const DB::ImageInfoPtr& info, const QString& mappedFile )
 {
-    QDomElement elm = doc.createElement( QString::fromLatin1("image") );
-    elm.setAttribute( QString::fromLatin1("label"),  info->label() );
-    elm.setAttribute( QString::fromLatin1("description"), info->description() );
+    ElementWriter dummy( writer, QString::fromLatin1("image") );
+    writer.writeAttribute( QString::fromLatin1("label"),  info->label() );
+    writer.writeAttribute( QString::fromLatin1("description"), info->description() );
 
     DB::ImageDate date = info->date();
     QDateTime start = date.start();
     QDateTime end = date.end();
 
-    elm.setAttribute( QString::fromLatin1("yearFrom"), start.date().year() );
-    elm.setAttribute( QString::fromLatin1("monthFrom"),  start.date().month() );
-    elm.setAttribute( QString::fromLatin1("dayFrom"),  start.date().day() );
-    elm.setAttribute( QString::fromLatin1("hourFrom"), start.time().hour() );
-    elm.setAttribute( QString::fromLatin1("minuteFrom"), start.time().minute() );
-    elm.setAttribute( QString::fromLatin1("secondFrom"), start.time().second() );
+    writer.writeAttribute( QString::fromLatin1("yearFrom"), QString::number( start.date().year() ) );
+    writer.writeAttribute( QString::fromLatin1("monthFrom"),  QString::number( start.date().month() ) );
+    writer.writeAttribute( QString::fromLatin1("dayFrom"),  QString::number( start.date().day() ) );
+    writer.writeAttribute( QString::fromLatin1("hourFrom"), QString::number( start.time().hour() ) );
+    writer.writeAttribute( QString::fromLatin1("minuteFrom"), QString::number( start.time().minute() ) );
+    writer.writeAttribute( QString::fromLatin1("secondFrom"), QString::number( start.time().second() ) );
 
-    elm.setAttribute( QString::fromLatin1("yearTo"), end.date().year() );
-    elm.setAttribute( QString::fromLatin1("monthTo"),  end.date().month() );
-    elm.setAttribute( QString::fromLatin1("dayTo"),  end.date().day() );
+    writer.writeAttribute( QString::fromLatin1("yearTo"), QString::number( end.date().year() ) );
+    writer.writeAttribute( QString::fromLatin1("monthTo"),  QString::number( end.date().month() ) );
+    writer.writeAttribute( QString::fromLatin1("dayTo"),  QString::number( end.date().day() ) );
 
-    elm.setAttribute( QString::fromLatin1( "width" ), info->size().width() );
-    elm.setAttribute( QString::fromLatin1( "height" ), info->size().height() );
-    elm.setAttribute( QString::fromLatin1( "md5sum" ), info->MD5Sum().toHexString() );
-    elm.setAttribute( QString::fromLatin1( "angle" ), info->angle() );
+    writer.writeAttribute( QString::fromLatin1( "width" ), QString::number( info->size().width() ) );
+    writer.writeAttribute( QString::fromLatin1( "height" ), QString::number( info->size().height() ) );
+    writer.writeAttribute( QString::fromLatin1( "md5sum" ), info->MD5Sum().toHexString() );
+    writer.writeAttribute( QString::fromLatin1( "angle" ), QString::number( info->angle() ) );
+    writer.writeAttribute( QString::fromLatin1( "file" ), mappedFile );
 
-    writeCategories( doc, elm, info );
-
-    return elm;
+    writeCategories( writer, info );
 }
 
 
-void ImportExport::XMLHandler::writeCategories( QDomDocument doc, QDomElement root, const DB::ImageInfoPtr& info )
+void ImportExport::XMLHandler::writeCategories( QXmlStreamWriter& writer, const DB::ImageInfoPtr& info )
 {
-    QDomElement elm = doc.createElement( QString::fromLatin1("options") );
+    // the element is only written if there is any value at all:
+    ElementWriter options( writer, QString::fromLatin1("options"), false );
 
-    bool anyAtAll = false;
     QStringList grps = info->availableCategories();
     Q_FOREACH(const QString &name, grps ) {
-        QDomElement opt = doc.createElement( QString::fromLatin1("option") );
-        opt.setAttribute( QString::fromLatin1("name"),  name );
-
         StringSet items = info->itemsOfCategory(name);
-        bool any = false;
+        if ( items.isEmpty() )
+            continue;
+
+        options.writeStartElement();
+        ElementWriter opt( writer, QString::fromLatin1("option") );
+        writer.writeAttribute( QString::fromLatin1("name"),  name );
+
         Q_FOREACH( const QString &item, items ) {
-            QDomElement val = doc.createElement( QString::fromLatin1("value") );
-            val.setAttribute( QString::fromLatin1("value"), item );
-            opt.appendChild( val );
-            any = true;
-            anyAtAll = true;
+            ElementWriter val( writer, QString::fromLatin1("value") );
+            writer.writeAttribute( QString::fromLatin1("value"), item );
         }
-        if ( any )
-            elm.appendChild( opt );
     }
-
-    if ( anyAtAll )
-        root.appendChild( elm );
 }
 // vi:expandtab:tabstop=4 shiftwidth=4:
@@ -20,8 +20,9 @@
 #include <qstring.h>
 #include "Export.h"
 #include "DB/ImageInfoPtr.h"
-#include <qdom.h>
 
+class QIODevice;
+class QXmlStreamWriter;
 namespace Utilities { class UniqFilenameMapper; }
 namespace DB { class IdList; }
 
@@ -30,15 +31,16 @@ namespace ImportExport
 class XMLHandler
 {
 public:
-    QByteArray createIndexXML(
+    void writeIndexXML(
+        QIODevice* out,
         const DB::FileNameList& images,
         const QString& baseUrl,
         ImageFileLocation location,
         Utilities::UniqFilenameMapper* nameMap);
 
 protected:
-    QDomElement save( QDomDocument doc, const DB::ImageInfoPtr& info );
-    void writeCategories( QDomDocument doc, QDomElement elm, const DB::ImageInfoPtr& info );
+    void save( QXmlStreamWriter& writer, const DB::ImageInfoPtr& info, const QString& mappedFile );
+    void writeCategories( QXmlStreamWriter& writer, const DB::ImageInfoPtr& info );
 };
 
 }
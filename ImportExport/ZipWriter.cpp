@@ -0,0 +1,344 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ZipWriter.h"
+#include <QDateTime>
+#include <QIODevice>
+#include <zlib.h>
+
+namespace
+{
+const quint16 STORED = 0;
+const quint16 DEFLATED = 8;
+const quint16 VERSION = 20; // 2.0: deflate and directories
+// without ZIP64, all sizes and offsets are 32 bit, and the number of entries is 16 bit:
+const qint64 MAX_SIZE = 0xffffffff;
+const int MAX_ENTRIES = 0xffff;
+
+void put16( QByteArray& out, quint16 value )
+{
+    out.append( char( value & 0xff ) );
+    out.append( char( ( value >> 8 ) & 0xff ) );
+}
+
+void put32( QByteArray& out, quint32 value )
+{
+    put16( out, quint16( value & 0xffff ) );
+    put16( out, quint16( value >> 16 ) );
+}
+
+quint32 crcFor( const char* data, qint64 length, quint32 crc )
+{
+    return crc32( crc, reinterpret_cast<const Bytef*>( data ), uInt( length ) );
+}
+
+/**
+ * Set up a raw deflate stream, i.e. without the zlib header and checksum, as zip files store it.
+ */
+bool initDeflate( z_stream* stream )
+{
+    stream->zalloc = Z_NULL;
+    stream->zfree = Z_NULL;
+    stream->opaque = Z_NULL;
+    return deflateInit2( stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) == Z_OK;
+}
+}
+
+/**
+ * @brief The EntryDevice checksums and optionally deflates the data of a streamed entry on its way into the archive.
+ */
+class ImportExport::ZipWriter::EntryDevice : public QIODevice
+{
+public:
+    EntryDevice( ZipWriter* writer, bool compress )
+        : m_writer( writer ), m_deflate( compress ), m_crc( crc32( 0, Z_NULL, 0 ) ), m_size( 0 ), m_compressedSize( 0 ), m_ok( true )
+    {
+        if ( m_deflate )
+            m_ok = initDeflate( &m_stream );
+        open( QIODevice::WriteOnly );
+    }
+
+    bool finish()
+    {
+        if ( m_deflate ) {
+            m_ok = m_ok && deflateChunk( nullptr, 0, Z_FINISH );
+            deflateEnd( &m_stream );
+        }
+        close();
+        return m_ok;
+    }
+
+    quint32 crc() const { return m_crc; }
+    qint64 size() const { return m_size; }
+    qint64 compressedSize() const { return m_compressedSize; }
+    bool isDeflating() const { return m_deflate; }
+
+protected:
+    qint64 readData( char*, qint64 ) override
+    {
+        return -1;
+    }
+
+    qint64 writeData( const char* data, qint64 length ) override
+    {
+        if ( !m_ok )
+            return -1;
+
+        m_crc = crcFor( data, length, m_crc );
+        m_size += length;
+        if ( m_deflate )
+            m_ok = deflateChunk( data, length, Z_NO_FLUSH );
+        else {
+            m_ok = m_writer->writeRaw( data, length );
+            m_compressedSize += length;
+        }
+        return m_ok ? length : -1;
+    }
+
+private:
+    bool deflateChunk( const char* data, qint64 length, int flush )
+    {
+        char buffer[64 * 1024];
+        m_stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( data ) );
+        m_stream.avail_in = uInt( length );
+        int result;
+        do {
+            m_stream.next_out = reinterpret_cast<Bytef*>( buffer );
+            m_stream.avail_out = sizeof( buffer );
+            result = deflate( &m_stream, flush );
+            if ( result == Z_STREAM_ERROR )
+                return false;
+            const qint64 produced = sizeof( buffer ) - m_stream.avail_out;
+            if ( !m_writer->writeRaw( buffer, produced ) )
+                return false;
+            m_compressedSize += produced;
+        } while ( m_stream.avail_out == 0 || ( flush == Z_FINISH && result != Z_STREAM_END ) );
+        return true;
+    }
+
+    ZipWriter* m_writer;
+    bool m_deflate;
+    z_stream m_stream;
+    quint32 m_crc;
+    qint64 m_size;
+    qint64 m_compressedSize;
+    bool m_ok;
+};
+
+ImportExport::ZipWriter::ZipWriter( const QString& fileName )
+    : m_file( fileName ), m_dosTime( 0 ), m_dosDate( 0 ), m_entryDevice( nullptr ), m_ok( true ), m_tooLarge( false )
+{
+    // all entries are stamped with the time of the export:
+    const QDateTime now = QDateTime::currentDateTime();
+    m_dosTime = quint16( ( now.time().hour() << 11 ) | ( now.time().minute() << 5 ) | ( now.time().second() / 2 ) );
+    m_dosDate = quint16( ( ( now.date().year() - 1980 ) << 9 ) | ( now.date().month() << 5 ) | now.date().day() );
+}
+
+ImportExport::ZipWriter::~ZipWriter()
+{
+    delete m_entryDevice;
+}
+
+bool ImportExport::ZipWriter::open()
+{
+    m_ok = m_file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    return m_ok;
+}
+
+bool ImportExport::ZipWriter::close()
+{
+    Q_ASSERT( !m_entryDevice );
+
+    QByteArray directory;
+    for ( const CentralEntry& entry : m_entries ) {
+        put32( directory, 0x02014b50 );
+        put16( directory, VERSION | ( 3 << 8 ) ); // made by: unix
+        put16( directory, VERSION );
+        put16( directory, 0 ); // flags
+        put16( directory, entry.method );
+        put16( directory, m_dosTime );
+        put16( directory, m_dosDate );
+        put32( directory, entry.crc );
+        put32( directory, entry.compressedSize );
+        put32( directory, entry.size );
+        put16( directory, quint16( entry.name.size() ) );
+        put16( directory, 0 ); // extra field
+        put16( directory, 0 ); // comment
+        put16( directory, 0 ); // disk
+        put16( directory, 0 ); // internal attributes
+        put32( directory, quint32( 0100644 ) << 16 ); // external attributes: unix permissions
+        put32( directory, entry.offset );
+        directory.append( entry.name );
+    }
+
+    const quint32 offset = quint32( m_file.pos() );
+    const quint32 size = quint32( directory.size() );
+    put32( directory, 0x06054b50 );
+    put16( directory, 0 ); // disk
+    put16( directory, 0 ); // disk of the central directory
+    put16( directory, quint16( m_entries.count() ) );
+    put16( directory, quint16( m_entries.count() ) );
+    put32( directory, size );
+    put32( directory, offset );
+    put16( directory, 0 ); // comment
+
+    writeRaw( directory.constData(), directory.size() );
+    m_file.close();
+    return m_ok && m_file.error() == QFile::NoError;
+}
+
+ImportExport::ZipWriter::Entry ImportExport::ZipWriter::prepareEntry( const QString& name, const QByteArray& content, bool compress )
+{
+    Entry entry;
+    entry.name = name;
+    entry.size = quint32( content.size() );
+    entry.crc = crcFor( content.constData(), content.size(), crc32( 0, Z_NULL, 0 ) );
+
+    if ( compress && !content.isEmpty() ) {
+        z_stream stream;
+        if ( initDeflate( &stream ) ) {
+            QByteArray deflated;
+            deflated.resize( int( deflateBound( &stream, content.size() ) ) );
+            stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( content.constData() ) );
+            stream.avail_in = uInt( content.size() );
+            stream.next_out = reinterpret_cast<Bytef*>( deflated.data() );
+            stream.avail_out = uInt( deflated.size() );
+            const bool done = deflate( &stream, Z_FINISH ) == Z_STREAM_END;
+            deflated.resize( int( stream.total_out ) );
+            deflateEnd( &stream );
+            if ( done && deflated.size() < content.size() ) {
+                entry.data = deflated;
+                entry.deflated = true;
+                return entry;
+            }
+        }
+    }
+
+    entry.data = content;
+    return entry;
+}
+
+bool ImportExport::ZipWriter::writeEntry( const Entry& entry )
+{
+    Q_ASSERT( !m_entryDevice );
+    if ( !reserveEntry() )
+        return false;
+
+    CentralEntry central;
+    central.name = QFile::encodeName( entry.name );
+    central.method = entry.deflated ? DEFLATED : STORED;
+    central.crc = entry.crc;
+    central.compressedSize = quint32( entry.data.size() );
+    central.size = entry.size;
+    central.offset = quint32( m_file.pos() );
+
+    if ( !writeLocalHeader( central ) || !writeRaw( entry.data.constData(), entry.data.size() ) )
+        return false;
+    m_entries.append( central );
+    return true;
+}
+
+QIODevice* ImportExport::ZipWriter::beginEntry( const QString& name, bool compress )
+{
+    Q_ASSERT( !m_entryDevice );
+
+    // The sizes and checksum are not known yet, so they are filled into the local header by endEntry().
+    // If there is no room for another entry, the data written to the device is dropped, and endEntry() fails.
+    reserveEntry();
+    CentralEntry central;
+    central.name = QFile::encodeName( name );
+    central.method = compress ? DEFLATED : STORED;
+    central.crc = 0;
+    central.compressedSize = 0;
+    central.size = 0;
+    central.offset = quint32( m_file.pos() );
+    writeLocalHeader( central );
+    m_entries.append( central );
+
+    m_entryDevice = new EntryDevice( this, compress );
+    return m_entryDevice;
+}
+
+bool ImportExport::ZipWriter::endEntry()
+{
+    Q_ASSERT( m_entryDevice );
+
+    const bool ok = m_entryDevice->finish();
+    if ( m_entryDevice->size() > MAX_SIZE )
+        setTooLarge();
+    CentralEntry& central = m_entries.last();
+    central.crc = m_entryDevice->crc();
+    central.compressedSize = quint32( m_entryDevice->compressedSize() );
+    central.size = quint32( m_entryDevice->size() );
+    delete m_entryDevice;
+    m_entryDevice = nullptr;
+
+    QByteArray sizes;
+    put32( sizes, central.crc );
+    put32( sizes, central.compressedSize );
+    put32( sizes, central.size );
+    const qint64 end = m_file.pos();
+    m_ok = m_ok && m_file.seek( central.offset + 14 ) && writeRaw( sizes.constData(), sizes.size() ) && m_file.seek( end );
+    return ok && m_ok;
+}
+
+bool ImportExport::ZipWriter::writeLocalHeader( const CentralEntry& entry )
+{
+    QByteArray header;
+    put32( header, 0x04034b50 );
+    put16( header, VERSION );
+    put16( header, 0 ); // flags
+    put16( header, entry.method );
+    put16( header, m_dosTime );
+    put16( header, m_dosDate );
+    put32( header, entry.crc );
+    put32( header, entry.compressedSize );
+    put32( header, entry.size );
+    put16( header, quint16( entry.name.size() ) );
+    put16( header, 0 ); // extra field
+    header.append( entry.name );
+    return writeRaw( header.constData(), header.size() );
+}
+
+bool ImportExport::ZipWriter::isTooLarge() const
+{
+    return m_tooLarge;
+}
+
+bool ImportExport::ZipWriter::writeRaw( const char* data, qint64 length )
+{
+    // Nothing may end beyond 4 GiB, so that all offsets and sizes written into the headers fit into 32 bit:
+    if ( m_ok && m_file.pos() + length > MAX_SIZE )
+        setTooLarge();
+    m_ok = m_ok && m_file.write( data, length ) == length;
+    return m_ok;
+}
+
+bool ImportExport::ZipWriter::reserveEntry()
+{
+    if ( m_entries.count() >= MAX_ENTRIES )
+        setTooLarge();
+    return m_ok;
+}
+
+void ImportExport::ZipWriter::setTooLarge()
+{
+    m_tooLarge = true;
+    m_ok = false;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,121 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef IMPORTEXPORT_ZIPWRITER_H
+#define IMPORTEXPORT_ZIPWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+namespace ImportExport
+{
+
+/**
+ * @brief The ZipWriter writes the .kim file, which is a plain zip archive.
+ *
+ * Unlike KZip, the ZipWriter lets the expensive part of adding a file - computing the checksum and
+ * compressing it - be done up front by \ref prepareEntry, which may be called from any thread.
+ * The ZipWriter itself then only appends the prepared entries to the archive, one after the other.
+ *
+ * Entries which are too large to be kept in memory, like the index or videos, are written
+ * with \ref beginEntry instead, which compresses the data as it is written.
+ *
+ * The ZipWriter doesn't write ZIP64 archives, which neither \ref KimFileReader nor older versions
+ * of KPhotoAlbum could read. Writing fails instead once the archive would exceed the limits of
+ * a plain zip file (4 GiB, 65535 entries); \ref isTooLarge tells whether that was the reason.
+ *
+ * The ZipWriter itself must only be used from one thread at a time.
+ */
+class ZipWriter
+{
+public:
+    struct Entry
+    {
+        Entry() : crc( 0 ), size( 0 ), deflated( false ) {}
+        QString name;
+        QByteArray data; ///< the deflated data if \ref deflated is set, the plain data otherwise
+        quint32 crc;
+        quint32 size; ///< the size of the plain data
+        bool deflated;
+    };
+
+    explicit ZipWriter( const QString& fileName );
+    ~ZipWriter();
+
+    bool open();
+    /**
+     * @brief close writes the central directory, which completes the archive.
+     */
+    bool close();
+
+    /**
+     * @brief prepareEntry computes the checksum of the content, and deflates it if compress is set.
+     * The data is stored as it is if deflating does not make it smaller.
+     * This function is thread-safe.
+     */
+    static Entry prepareEntry( const QString& name, const QByteArray& content, bool compress );
+    bool writeEntry( const Entry& entry );
+
+    /**
+     * @brief beginEntry starts an entry whose data is then written to the returned device.
+     * The entry is completed by \ref endEntry; no other entry may be written in the meantime.
+     */
+    QIODevice* beginEntry( const QString& name, bool compress );
+    bool endEntry();
+
+    /**
+     * @brief isTooLarge tells whether writing failed because the archive would have become too large for the zip format.
+     */
+    bool isTooLarge() const;
+
+private:
+    class EntryDevice;
+    friend class EntryDevice;
+
+    struct CentralEntry
+    {
+        QByteArray name;
+        quint16 method;
+        quint32 crc;
+        quint32 compressedSize;
+        quint32 size;
+        quint32 offset;
+    };
+
+    bool writeLocalHeader( const CentralEntry& entry );
+    bool writeRaw( const char* data, qint64 length );
+    bool reserveEntry();
+    void setTooLarge();
+
+    QFile m_file;
+    QList<CentralEntry> m_entries;
+    quint16 m_dosTime;
+    quint16 m_dosDate;
+    EntryDevice* m_entryDevice;
+    bool m_ok;
+    bool m_tooLarge;
+};
+
+}
+
+#endif /* IMPORTEXPORT_ZIPWRITER_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -25,6 +25,7 @@ static MainWindow::DirtyIndicator* _instance = nullptr;
 bool MainWindow::DirtyIndicator::s_autoSaveDirty = false;
 bool MainWindow::DirtyIndicator::s_saveDirty = false;
 bool MainWindow::DirtyIndicator::s_suppressMarkDirty = false;
+int MainWindow::DirtyIndicator::s_changeCount = 0;
 
 MainWindow::DirtyIndicator::DirtyIndicator( QWidget* parent )
     :QLabel( parent )
@@ -45,6 +46,7 @@ void MainWindow::DirtyIndicator::suppressMarkDirty(bool state)
 
 void MainWindow::DirtyIndicator::markDirty()
 {
+    ++s_changeCount;
     if (MainWindow::DirtyIndicator::s_suppressMarkDirty) {
         return;
     }
@@ -58,6 +60,7 @@ void MainWindow::DirtyIndicator::markDirty()
 }
 
 void MainWindow::DirtyIndicator::markDirtySlot() {
+    ++s_changeCount;
     if (MainWindow::DirtyIndicator::s_suppressMarkDirty) {
         return;
     }
@@ -80,6 +83,11 @@ void MainWindow::DirtyIndicator::saved()
     setPixmap( QPixmap() );
 }
 
+int MainWindow::DirtyIndicator::changeCount()
+{
+    return s_changeCount;
+}
+
 bool MainWindow::DirtyIndicator::isSaveDirty() const
 {
     return s_saveDirty;
@@ -32,6 +32,11 @@ class DirtyIndicator :public QLabel
 public:
     static void markDirty();
     static void suppressMarkDirty(bool state);
+    /**
+     * @brief changeCount is increased whenever the database is marked dirty.
+     * Caches of data derived from the database can compare it to tell if they are still valid.
+     */
+    static int changeCount();
 
 public slots:
     void markDirtySlot();
@@ -53,6 +58,7 @@ private:
     static bool s_saveDirty;
 
     static bool s_suppressMarkDirty;
+    static int s_changeCount;
 };
 
 }
@@ -21,6 +21,7 @@
 #include <Utilities/Util.h>
 #include <BackgroundJobs/HandleVideoThumbnailRequestJob.h>
 #include <ImageManager/ThumbnailCache.h>
+#include <ImageManager/VideoFrameCache.h>
 #include "Window.h"
 #include <ThumbnailView/CellGeometry.h>
 
@@ -46,40 +47,28 @@ void UpdateVideoThumbnail::update(const DB::FileNameList& list, int direction)
 
 void UpdateVideoThumbnail::update(const DB::FileName &fileName, int direction)
 {
-    const DB::FileName baseImageName = BackgroundJobs::HandleVideoThumbnailRequestJob::pathForRequest(fileName);
-    QImage baseImage(baseImageName.absolute());
-
-    int frame = 0;
-    for (; frame < 10; ++frame) {
-        const DB::FileName frameFile = BackgroundJobs::HandleVideoThumbnailRequestJob::frameName(fileName, frame);
-        QImage frameImage(frameFile.absolute());
-        if (frameImage.isNull())
-            continue;
-        if ( baseImage == frameImage ) {
-            break;
-        }
-    }
+    ImageManager::VideoFrameCache* frameCache = ImageManager::VideoFrameCache::instance();
+    const QVector<QImage> frames = frameCache->lookup(fileName);
+    if ( frames.isEmpty() )
+        return;
 
-    const DB::FileName newImageName = nextExistingImage(fileName, frame, direction);
+    // Until the user picked one of the frames, the thumbnail is not any of them.
+    const int count = frames.count();
+    const int frame = frameCache->thumbnailFrame(fileName);
+    int next;
+    if ( frame < 0 || frame >= count )
+        next = direction > 0 ? 0 : count - 1;
+    else
+        next = (frame + count + direction) % count;
 
-    Utilities::copy(newImageName.absolute(),baseImageName.absolute());
+    const DB::FileName baseImageName = BackgroundJobs::HandleVideoThumbnailRequestJob::pathForRequest(fileName);
+    Utilities::saveImage(baseImageName, frames[next], "JPEG");
+    frameCache->setThumbnailFrame(fileName, next);
 
-    QImage image = QImage(newImageName.absolute()).scaled(ThumbnailView::CellGeometry::preferredIconSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation );
+    QImage image = frames[next].scaled(ThumbnailView::CellGeometry::preferredIconSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation );
     ImageManager::ThumbnailCache::instance()->insert(fileName,image);
     MainWindow::Window::theMainWindow()->reloadThumbnails();
 }
 
-DB::FileName UpdateVideoThumbnail::nextExistingImage(const DB::FileName &fileName, int frame, int direction)
-{
-    for (int i = 1; i <10; ++i) {
-        const int nextIndex = (frame + 10 + direction*i) % 10;
-        const DB::FileName file = BackgroundJobs::HandleVideoThumbnailRequestJob::frameName(fileName, nextIndex);
-        if ( file.exists() )
-            return file;
-    }
-    Q_ASSERT(false && "We should always find at least the current frame");
-    return DB::FileName();
-}
-
 } // namespace MainWindow
 // vi:expandtab:tabstop=4 shiftwidth=4:
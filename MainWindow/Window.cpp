@@ -18,6 +18,7 @@
 
 #include "Window.h"
 #include "ImageManager/ThumbnailCache.h"
+#include "ImageManager/VideoFrameCache.h"
 #include "ThumbnailView/ThumbnailFacade.h"
 #include <KActionCollection>
 #include "BreadcrumbViewer.h"
@@ -116,6 +117,7 @@
 #include "ThumbnailView/enums.h"
 #include "DB/MD5.h"
 #include "DB/MD5Map.h"
+#include "DB/ImageDirectoryWatcher.h"
 #include "StatusBar.h"
 #include <BackgroundTaskManager/JobManager.h>
 #include <BackgroundJobs/SearchForVideosWithoutLengthInfo.h>
@@ -221,6 +223,7 @@ MainWindow::Window::~Window()
 {
     DB::ImageDB::deleteInstance();
     ImageManager::ThumbnailCache::deleteInstance();
+    ImageManager::VideoFrameCache::deleteInstance();
 #ifdef HAVE_EXIV2
     Exif::Database::deleteInstance();
 #endif
@@ -237,6 +240,10 @@ void MainWindow::Window::delayedInit()
         DB::ImageDB::instance()->slotRescan();
     }
 
+    DB::ImageDirectoryWatcher* directoryWatcher = new DB::ImageDirectoryWatcher( this );
+    connect( Settings::SettingsData::instance(), SIGNAL(watchImageDirectoryChanged(bool)), directoryWatcher, SLOT(setEnabled(bool)) );
+    directoryWatcher->setEnabled( Settings::SettingsData::instance()->watchImageDirectory() );
+
     if ( !Settings::SettingsData::instance()->delayLoadingPlugins() ) {
         splash->message( i18n( "Loading Plug-ins" ) );
         loadPlugins();
@@ -855,6 +862,9 @@ void MainWindow::Window::setupMenuBar()
     a = actionCollection()->addAction( QString::fromLatin1("rescan"), DB::ImageDB::instance(), SLOT(slotRescan()) );
     a->setText( i18n("Rescan for Images and Videos") );
 
+    a = actionCollection()->addAction( QString::fromLatin1("fullRescan"), DB::ImageDB::instance(), SLOT(slotFullRescan()) );
+    a->setText( i18n("Rescan All Folders for Images and Videos") );
+
     KAction* recreateExif = actionCollection()->addAction( QString::fromLatin1( "recreateExifDB" ), this, SLOT(slotRecreateExifDB()) );
     recreateExif->setText( i18n("Recreate Exif Search Database") );
 
@@ -1735,9 +1745,10 @@ void MainWindow::Window::slotBuildThumbnails()
 
 void MainWindow::Window::slotBuildThumbnailsIfWanted()
 {
-    ImageManager::ThumbnailCache::instance()->flush();
+    // The thumbnail cache stores several sizes of each thumbnail, so only those that are too small need to be rebuilt:
+    ImageManager::ThumbnailCache::instance()->removeThumbnailsSmallerThan( Settings::SettingsData::instance()->thumbnailSize() );
     if ( ! Settings::SettingsData::instance()->incrementalThumbnails())
-        ImageManager::ThumbnailBuilder::instance()->buildAll( ImageManager::StartDelayed );
+        ImageManager::ThumbnailBuilder::instance()->buildMissing();
 }
 
 void MainWindow::Window::slotOrderIncr()
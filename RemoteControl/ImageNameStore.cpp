@@ -20,14 +20,42 @@
 #include "DB/ImageDB.h"
 
 namespace RemoteControl {
+
+namespace
+{
+/**
+ * A 32 bit FNV-1a hash. Unlike qHash, it is guaranteed to stay the same across Qt versions.
+ */
+quint32 stableHash(const QString& name)
+{
+    quint32 hash = 2166136261u;
+    for (const QChar& ch : name) {
+        hash ^= ch.unicode();
+        hash *= 16777619u;
+    }
+    return hash;
+}
+}
+
 ImageNameStore::ImageNameStore()
 {
     // To avoid delays when the user shows all images the first time, lets pull all images now.
-    for (const DB::FileName& fileName : DB::ImageDB::instance()->images()) {
-        m_lastId++;
-        m_idToNameMap.insert(m_lastId,fileName);
-        m_nameToIdMap.insert(fileName,m_lastId);
-    }
+    for (const DB::FileName& fileName : DB::ImageDB::instance()->images())
+        (*this)[fileName];
+}
+
+template <class Key>
+int ImageNameStore::insert(QHash<Key,int>& keyToId, QHash<int,Key>& idToKey, const Key& key, const QString& name)
+{
+    // Ids are positive, so they never clash with DISCOVERYID, and 0 is left out as that is the id of
+    // a default constructed command. On a collision, the next free id is used.
+    int id = int(stableHash(name) & 0x7fffffff);
+    while (id == 0 || idToKey.contains(id))
+        id = (id + 1) & 0x7fffffff;
+
+    keyToId.insert(key, id);
+    idToKey.insert(id, key);
+    return id;
 }
 
 DB::FileName ImageNameStore::operator[](int id)
@@ -38,12 +66,8 @@ DB::FileName ImageNameStore::operator[](int id)
 int ImageNameStore::operator[](const DB::FileName& fileName)
 {
     auto iterator = m_nameToIdMap.find(fileName);
-    if (iterator == m_nameToIdMap.end()) {
-        m_lastId++;
-        m_nameToIdMap.insert(fileName,m_lastId);
-        m_idToNameMap.insert(m_lastId, fileName);
-        return m_lastId;
-    }
+    if (iterator == m_nameToIdMap.end())
+        return insert(m_nameToIdMap, m_idToNameMap, fileName, fileName.relative());
     return *iterator;
 }
 
@@ -51,12 +75,8 @@ int ImageNameStore::idForCategory(const QString& category, const QString& item)
 {
     auto key = qMakePair(category,item);
     auto it = m_categoryToIdMap.find(key);
-    if (it == m_categoryToIdMap.end()) {
-        m_lastId++;
-        m_categoryToIdMap.insert(key,m_lastId);
-        m_idToCategoryMap.insert(m_lastId,key);
-        return m_lastId;
-    }
+    if (it == m_categoryToIdMap.end())
+        return insert(m_categoryToIdMap, m_idToCategoryMap, key, category + QChar::fromLatin1('/') + item);
     else
         return *it;
 }
@@ -25,6 +25,12 @@
 
 namespace RemoteControl {
 
+/**
+ * @brief The ImageNameStore maps images and category items to the ids used in the remote control protocol.
+ *
+ * The ids are derived from the names, so an image keeps its id across sessions, no matter which images
+ * were added or removed in the meantime.
+ */
 class ImageNameStore
 {
 public:
@@ -35,11 +41,13 @@ public:
     QPair<QString,QString> categoryForId(int id);
 
 private:
+    template <class Key>
+    int insert(QHash<Key,int>& keyToId, QHash<int,Key>& idToKey, const Key& key, const QString& name);
+
     QHash<int,DB::FileName> m_idToNameMap;
     QHash<DB::FileName,int> m_nameToIdMap;
     QHash<QPair<QString,QString>,int> m_categoryToIdMap;
     QHash<int,QPair<QString,QString>> m_idToCategoryMap;
-    int m_lastId = 0;
 };
 
 } // namespace RemoteControl
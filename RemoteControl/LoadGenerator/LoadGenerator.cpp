@@ -0,0 +1,399 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "LoadGenerator.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QUdpSocket>
+#include <algorithm>
+#include <cmath>
+
+namespace RemoteControl {
+
+namespace
+{
+const int SEARCH_PAGE_SIZE = 300;
+const int CATEGORIES_TO_BROWSE = 3;
+const int DETAILS_TO_REQUEST = 5;
+const int ANNOUNCE_INTERVAL = 500;
+
+// The same ports as in RemoteConnection
+const int UDPPORT = 23455;
+const int TCPPORT = 23456;
+
+QString commandName(CommandType type)
+{
+    switch (type) {
+    case CommandType::ThumbnailResult: return QString::fromLatin1("ThumbnailResult");
+    case CommandType::CategoryListResult: return QString::fromLatin1("CategoryListResult");
+    case CommandType::SearchRequest: return QString::fromLatin1("SearchRequest");
+    case CommandType::SearchResult: return QString::fromLatin1("SearchResult");
+    case CommandType::ThumbnailRequest: return QString::fromLatin1("ThumbnailRequest");
+    case CommandType::ThumbnailCancelRequest: return QString::fromLatin1("ThumbnailCancelRequest");
+    case CommandType::TimeCommand: return QString::fromLatin1("TimeCommand");
+    case CommandType::ImageDetailsRequest: return QString::fromLatin1("ImageDetailsRequest");
+    case CommandType::ImageDetailsResult: return QString::fromLatin1("ImageDetailsResult");
+    case CommandType::CategoryItemsResult: return QString::fromLatin1("CategoryItemsResult");
+    case CommandType::StaticImageRequest: return QString::fromLatin1("StaticImageRequest");
+    case CommandType::StaticImageResult: return QString::fromLatin1("StaticImageResult");
+    case CommandType::ToggleTokenRequest: return QString::fromLatin1("ToggleTokenRequest");
+    case CommandType::ThumbnailBatchRequest: return QString::fromLatin1("ThumbnailBatchRequest");
+    case CommandType::ThumbnailBatchResult: return QString::fromLatin1("ThumbnailBatchResult");
+    case CommandType::ImageSearchRequest: return QString::fromLatin1("ImageSearchRequest");
+    case CommandType::ImageSearchPageRequest: return QString::fromLatin1("ImageSearchPageRequest");
+    case CommandType::ImageSearchResult: return QString::fromLatin1("ImageSearchResult");
+    }
+    return QString::number(int(type));
+}
+
+/**
+ * The value below which the given fraction of the sorted values lie.
+ */
+qint64 percentile(const QList<qint64>& sorted, double fraction)
+{
+    if (sorted.isEmpty())
+        return 0;
+    const int index = int(std::ceil(fraction * sorted.count())) - 1;
+    return sorted[qBound(0, index, sorted.count() - 1)];
+}
+
+QString milliseconds(qint64 microseconds)
+{
+    return QString::number(microseconds / 1000.0, 'f', 2);
+}
+}
+
+LoadGenerator::LoadGenerator(const Options& options)
+    : m_options(options), m_server(new QTcpServer)
+{
+    m_clock.start();
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    delete m_socket;
+    delete m_server;
+}
+
+bool LoadGenerator::connectToKPhotoAlbum()
+{
+    if (!m_server->listen(QHostAddress::LocalHost, TCPPORT))
+        return false;
+
+    // Announce ourselves like the phone does, until KPhotoAlbum connects.
+    const QByteArray announcement = QString::fromLatin1("KPhotoAlbum %1").arg(VERSION).toUtf8();
+    QUdpSocket udpSocket;
+    for (int waited = 0; waited < m_options.timeout; waited += ANNOUNCE_INTERVAL) {
+        udpSocket.writeDatagram(announcement, QHostAddress::LocalHost, UDPPORT);
+        if (m_server->waitForNewConnection(ANNOUNCE_INTERVAL)) {
+            m_socket = m_server->nextPendingConnection();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoadGenerator::run()
+{
+    for (int session = 0; session < m_options.sessions && !m_failed; ++session)
+        runSession();
+    return !m_failed;
+}
+
+void LoadGenerator::runSession()
+{
+    // The home page
+    request(StaticImageRequest(m_options.iconSize), QString::fromLatin1("StaticImageRequest"), {CommandType::StaticImageResult});
+    std::unique_ptr<RemoteCommand> answer =
+            request(SearchRequest(SearchType::Categories, {}, m_options.iconSize), QString::fromLatin1("SearchRequest/Categories"),
+                    {CommandType::CategoryListResult});
+    if (!answer)
+        return;
+
+    const QList<QPair<QString,QString>> items = browseCategories(static_cast<CategoryListResult*>(answer.get())->categories);
+
+    // Scroll through all images, and then through the images of the items found while browsing, which narrows the search.
+    SearchPage search = searchImages({});
+    scrollThumbnails(search);
+    for (const auto& item : items) {
+        SearchInfo searchInfo;
+        searchInfo.addCategory(item.first);
+        searchInfo.addValue(item.second);
+        search = searchImages(searchInfo);
+        scrollThumbnails(search);
+    }
+
+    for (ImageId imageId : search.imageIds.mid(0, DETAILS_TO_REQUEST))
+        request(ImageDetailsRequest(imageId), QString::fromLatin1("ImageDetailsRequest"), {CommandType::ImageDetailsResult});
+}
+
+QList<QPair<QString,QString>> LoadGenerator::browseCategories(const QList<Category>& categories)
+{
+    QList<QPair<QString,QString>> result;
+    for (const Category& category : categories) {
+        if (!category.enabled || result.count() == CATEGORIES_TO_BROWSE)
+            continue;
+
+        SearchInfo searchInfo;
+        searchInfo.addCategory(category.name);
+        std::unique_ptr<RemoteCommand> answer =
+                request(SearchRequest(SearchType::CategoryItems, searchInfo), QString::fromLatin1("SearchRequest/CategoryItems"),
+                        {CommandType::SearchResult, CommandType::CategoryItemsResult});
+        if (!answer)
+            return result;
+
+        if (answer->commandType() == CommandType::CategoryItemsResult) {
+            const QStringList items = static_cast<CategoryItemsResult*>(answer.get())->items;
+            if (!items.isEmpty())
+                result.append(qMakePair(category.name, items.first()));
+        }
+        else {
+            // The icon view shows the first screen of items, their names arrive as the labels of the thumbnails.
+            const QList<ImageId> ids = static_cast<SearchResult*>(answer.get())->result;
+            requestThumbnails(ids.mid(0, m_options.thumbnailsPerScreen), m_options.iconSize, ViewType::CategoryItems);
+            waitForThumbnails();
+            if (!ids.isEmpty() && m_labels.contains(ids.first()))
+                result.append(qMakePair(category.name, m_labels.value(ids.first())));
+        }
+    }
+    return result;
+}
+
+LoadGenerator::SearchPage LoadGenerator::searchImages(const SearchInfo& searchInfo)
+{
+    SearchPage page;
+    std::unique_ptr<RemoteCommand> answer =
+            request(ImageSearchRequest(++m_searchId, searchInfo, SEARCH_PAGE_SIZE, m_completeSearch.searchId),
+                    QString::fromLatin1("ImageSearchRequest"), {CommandType::ImageSearchResult});
+    if (!answer)
+        return page;
+
+    const ImageSearchResult* result = static_cast<ImageSearchResult*>(answer.get());
+    page.searchId = result->searchId;
+    page.total = result->total;
+    page.imageIds = result->imageIds;
+    for (int i = 0; i < m_completeSearch.imageIds.count() && i/8 < result->baseMask.size(); ++i) {
+        if (result->baseMask[i/8] & (1 << (i%8)))
+            page.imageIds.append(m_completeSearch.imageIds[i]);
+    }
+
+    if (page.imageIds.count() == page.total)
+        m_completeSearch = page;
+    return page;
+}
+
+void LoadGenerator::scrollThumbnails(const SearchPage& search)
+{
+    QList<ImageId> loaded = search.imageIds;
+    int position = 0;
+    for (int step = 0; step < m_options.scrollSteps && position < search.total && !m_failed; ++step) {
+        // Like the view, fetch the next page before the screen reaches the end of the loaded ones.
+        while (position + 2 * m_options.thumbnailsPerScreen > loaded.count() && loaded.count() < search.total) {
+            std::unique_ptr<RemoteCommand> answer =
+                    request(ImageSearchPageRequest(search.searchId, loaded.count(), SEARCH_PAGE_SIZE),
+                            QString::fromLatin1("ImageSearchPageRequest"), {CommandType::ImageSearchResult});
+            if (!answer || static_cast<ImageSearchResult*>(answer.get())->imageIds.isEmpty())
+                return;
+            loaded.append(static_cast<ImageSearchResult*>(answer.get())->imageIds);
+        }
+
+        requestThumbnails(loaded.mid(position, m_options.thumbnailsPerScreen), m_options.thumbnailSize, ViewType::Thumbnails);
+        if (step % 3 == 2) {
+            // A fling: the screen is scrolled away before all of its thumbnails arrived.
+            readCommands(20);
+            cancelThumbnails();
+        }
+        else
+            waitForThumbnails();
+        position += m_options.thumbnailsPerScreen;
+    }
+    cancelThumbnails();
+}
+
+qint64 LoadGenerator::now() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void LoadGenerator::send(const RemoteCommand& command)
+{
+    if (!m_socket)
+        return;
+
+    // The same framing as RemoteConnection::sendCommand
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream stream(&buffer);
+    stream << (qint32) 0;
+    stream << (qint32) command.commandType();
+    command.encode(stream);
+    stream.device()->seek(0);
+    stream << (qint32) buffer.size();
+
+    m_socket->write(buffer.data());
+    m_socket->flush();
+
+    Statistics& statistics = m_statistics[commandName(command.commandType())];
+    statistics.sent++;
+    statistics.bytesSent += buffer.size();
+}
+
+std::unique_ptr<RemoteCommand> LoadGenerator::request(const RemoteCommand& command, const QString& name,
+                                                      std::initializer_list<CommandType> answers)
+{
+    const qint64 sentAt = now();
+    send(command);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_failed) {
+        for (auto it = m_inbox.begin(); it != m_inbox.end(); ++it) {
+            if (std::find(answers.begin(), answers.end(), (*it)->commandType()) != answers.end()) {
+                m_statistics[name].latencies.append(now() - sentAt);
+                std::unique_ptr<RemoteCommand> answer = std::move(*it);
+                m_inbox.erase(it);
+                return answer;
+            }
+        }
+        if (timer.elapsed() >= m_options.timeout || !readCommands(m_options.timeout - timer.elapsed()))
+            m_failed = true;
+    }
+    return nullptr;
+}
+
+void LoadGenerator::requestThumbnails(const QList<ImageId>& imageIds, int size, ViewType type)
+{
+    const qint64 sentAt = now();
+    for (ImageId imageId : imageIds)
+        m_pendingThumbnails.insert(qMakePair(imageId, int(type)), sentAt);
+    send(ThumbnailBatchRequest(imageIds, QSize(size, size), type, 80));
+}
+
+void LoadGenerator::cancelThumbnails()
+{
+    for (auto it = m_pendingThumbnails.constBegin(); it != m_pendingThumbnails.constEnd(); ++it) {
+        // The client only cancels thumbnails of images, see ImageStore::clientDeleted.
+        if (it.key().second == int(ViewType::Thumbnails))
+            send(ThumbnailCancelRequest(it.key().first, ViewType::Thumbnails));
+    }
+    m_pendingThumbnails.clear();
+}
+
+void LoadGenerator::waitForThumbnails()
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_pendingThumbnails.isEmpty() && !m_failed) {
+        if (timer.elapsed() >= m_options.timeout || !readCommands(m_options.timeout - timer.elapsed()))
+            m_failed = true;
+    }
+}
+
+bool LoadGenerator::readCommands(int msecs)
+{
+    if (!m_socket || m_socket->state() != QAbstractSocket::ConnectedState)
+        return false;
+    if (m_socket->bytesAvailable() == 0 && !m_socket->waitForReadyRead(qMax(1, msecs)))
+        return m_socket->state() == QAbstractSocket::ConnectedState;
+
+    // The same framing as RemoteConnection::dataReceived
+    QDataStream stream(m_socket);
+    while (true) {
+        if (m_length == -1) {
+            if (m_socket->bytesAvailable() < (qint64) sizeof(qint32))
+                return true;
+            stream >> m_length;
+            m_length -= sizeof(qint32);
+        }
+        if (m_socket->bytesAvailable() < m_length)
+            return true;
+
+        QByteArray data = m_socket->read(m_length);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream commandStream(&buffer);
+        qint32 id;
+        commandStream >> id;
+
+        std::unique_ptr<RemoteCommand> command = RemoteCommand::create(static_cast<CommandType>(id));
+        command->decode(commandStream);
+
+        Statistics& statistics = m_statistics[commandName(command->commandType())];
+        statistics.received++;
+        statistics.bytesReceived += m_length + sizeof(qint32);
+        m_length = -1;
+
+        handle(std::move(command));
+    }
+}
+
+void LoadGenerator::handle(std::unique_ptr<RemoteCommand> command)
+{
+    if (command->commandType() == CommandType::ThumbnailBatchResult) {
+        const ThumbnailBatchResult* result = static_cast<ThumbnailBatchResult*>(command.get());
+        for (const EncodedThumbnail& thumbnail : result->thumbnails)
+            thumbnailArrived(thumbnail.imageId, result->type, thumbnail.label);
+    }
+    else if (command->commandType() == CommandType::ThumbnailResult) {
+        const ThumbnailResult* result = static_cast<ThumbnailResult*>(command.get());
+        thumbnailArrived(result->imageId, result->type, result->label);
+    }
+    else
+        m_inbox.push_back(std::move(command));
+}
+
+void LoadGenerator::thumbnailArrived(ImageId imageId, ViewType type, const QString& label)
+{
+    if (!label.isEmpty())
+        m_labels.insert(imageId, label);
+
+    // Thumbnails that were canceled already may still arrive.
+    const QPair<ImageId, int> key = qMakePair(imageId, int(type));
+    if (m_pendingThumbnails.contains(key))
+        m_statistics[QString::fromLatin1("ThumbnailBatchRequest/image")].latencies.append(now() - m_pendingThumbnails.take(key));
+}
+
+void LoadGenerator::report(QTextStream& out) const
+{
+    out << qSetFieldWidth(30) << left << QString::fromLatin1("command") << right << qSetFieldWidth(10)
+        << QString::fromLatin1("sent") << QString::fromLatin1("received")
+        << QString::fromLatin1("kB sent") << QString::fromLatin1("kB recv")
+        << QString::fromLatin1("answers") << QString::fromLatin1("p50 ms") << QString::fromLatin1("p99 ms")
+        << qSetFieldWidth(0) << endl;
+
+    for (auto it = m_statistics.constBegin(); it != m_statistics.constEnd(); ++it) {
+        const Statistics& statistics = it.value();
+        QList<qint64> latencies = statistics.latencies;
+        std::sort(latencies.begin(), latencies.end());
+
+        out << qSetFieldWidth(30) << left << it.key() << right << qSetFieldWidth(10)
+            << statistics.sent << statistics.received
+            << QString::number(statistics.bytesSent / 1024.0, 'f', 1)
+            << QString::number(statistics.bytesReceived / 1024.0, 'f', 1)
+            << latencies.count()
+            << (latencies.isEmpty() ? QString() : milliseconds(percentile(latencies, 0.5)))
+            << (latencies.isEmpty() ? QString() : milliseconds(percentile(latencies, 0.99)))
+            << qSetFieldWidth(0) << endl;
+    }
+}
+
+} // namespace RemoteControl
+// vi:expandtab:tabstop=4 shiftwidth=4:
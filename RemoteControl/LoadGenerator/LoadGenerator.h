@@ -0,0 +1,113 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef REMOTECONTROL_LOADGENERATOR_H
+#define REMOTECONTROL_LOADGENERATOR_H
+
+#include "RemoteCommand.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+
+class QTcpServer;
+class QTcpSocket;
+class QTextStream;
+
+namespace RemoteControl {
+
+/**
+ * @brief The LoadGenerator plays the part of the Android client against a KPhotoAlbum on the same machine.
+ *
+ * It announces itself on the loopback interface just like the phone does on the network, accepts the connection
+ * from KPhotoAlbum, and replays browsing sessions: the home page, the categories and their items, image searches,
+ * and scrolling through the thumbnails with cancellations. For every type of command it collects the latency
+ * of the answers and the bytes on the wire, so changes to the protocol can be compared without a phone.
+ *
+ * Everything runs synchronously with the blocking socket functions, no event loop is needed.
+ */
+class LoadGenerator
+{
+public:
+    struct Options {
+        int sessions = 5;
+        int scrollSteps = 20;
+        int thumbnailsPerScreen = 24;
+        int thumbnailSize = 200;
+        int iconSize = 96;
+        int timeout = 10000; // milliseconds to wait for an answer
+    };
+
+    explicit LoadGenerator(const Options& options);
+    ~LoadGenerator();
+    bool connectToKPhotoAlbum();
+    bool run();
+    void report(QTextStream& out) const;
+
+private:
+    struct Statistics {
+        QList<qint64> latencies; // microseconds
+        int sent = 0;
+        int received = 0;
+        qint64 bytesSent = 0;
+        qint64 bytesReceived = 0;
+    };
+
+    struct SearchPage {
+        int searchId = -1;
+        int total = 0;
+        QList<ImageId> imageIds;
+    };
+
+    void runSession();
+    QList<QPair<QString,QString>> browseCategories(const QList<Category>& categories);
+    SearchPage searchImages(const SearchInfo& searchInfo);
+    void scrollThumbnails(const SearchPage& search);
+
+    void send(const RemoteCommand& command);
+    std::unique_ptr<RemoteCommand> request(const RemoteCommand& command, const QString& name,
+                                           std::initializer_list<CommandType> answers);
+    void requestThumbnails(const QList<ImageId>& imageIds, int size, ViewType type);
+    void cancelThumbnails();
+    void waitForThumbnails();
+    bool readCommands(int msecs);
+    void handle(std::unique_ptr<RemoteCommand> command);
+    void thumbnailArrived(ImageId imageId, ViewType type, const QString& label);
+    qint64 now() const;
+
+    Options m_options;
+    QTcpServer* m_server;
+    QTcpSocket* m_socket = nullptr;
+    QElapsedTimer m_clock;
+
+    qint32 m_length = -1;
+    std::deque<std::unique_ptr<RemoteCommand>> m_inbox;
+    QHash<QPair<ImageId, int>, qint64> m_pendingThumbnails; // the time each thumbnail was requested
+    QHash<ImageId, QString> m_labels;
+    QMap<QString, Statistics> m_statistics;
+    int m_searchId = 0;
+    SearchPage m_completeSearch; // the last search of which all ids are known, for narrowing it down
+    bool m_failed = false;
+};
+
+} // namespace RemoteControl
+
+#endif // REMOTECONTROL_LOADGENERATOR_H
+// vi:expandtab:tabstop=4 shiftwidth=4:
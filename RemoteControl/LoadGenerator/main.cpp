@@ -0,0 +1,97 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "LoadGenerator.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+
+namespace
+{
+void usage(QTextStream& out)
+{
+    out << "Usage: kphotoalbum-remote-benchmark [options]" << endl
+        << endl
+        << "Replays browsing sessions of the Android client against a KPhotoAlbum running on this machine," << endl
+        << "and reports the latency and traffic of every type of command." << endl
+        << "Enable the remote control in KPhotoAlbum before starting the benchmark." << endl
+        << endl
+        << "  --sessions <n>        number of browsing sessions (default 5)" << endl
+        << "  --scroll-steps <n>    screens of thumbnails to scroll through per search (default 20)" << endl
+        << "  --thumbnail-size <n>  size of the requested thumbnails in pixels (default 200)" << endl
+        << "  --timeout <ms>        time to wait for KPhotoAlbum and for every answer (default 10000)" << endl;
+}
+
+bool readValue(const QStringList& arguments, int& index, int& value)
+{
+    if (index + 1 >= arguments.count())
+        return false;
+    bool ok;
+    value = arguments[++index].toInt(&ok);
+    return ok && value > 0;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    // QImage needs the gui libraries, but no display is needed.
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    RemoteControl::LoadGenerator::Options options;
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.count(); ++i) {
+        const QString& argument = arguments[i];
+        bool ok = true;
+        if (argument == QString::fromLatin1("--sessions"))
+            ok = readValue(arguments, i, options.sessions);
+        else if (argument == QString::fromLatin1("--scroll-steps"))
+            ok = readValue(arguments, i, options.scrollSteps);
+        else if (argument == QString::fromLatin1("--thumbnail-size"))
+            ok = readValue(arguments, i, options.thumbnailSize);
+        else if (argument == QString::fromLatin1("--timeout"))
+            ok = readValue(arguments, i, options.timeout);
+        else if (argument == QString::fromLatin1("--help")) {
+            usage(out);
+            return 0;
+        }
+        else
+            ok = false;
+
+        if (!ok) {
+            usage(err);
+            return 1;
+        }
+    }
+
+    RemoteControl::LoadGenerator generator(options);
+    if (!generator.connectToKPhotoAlbum()) {
+        err << "KPhotoAlbum did not connect, is its remote control enabled?" << endl;
+        return 1;
+    }
+
+    const bool completed = generator.run();
+    generator.report(out);
+    if (!completed) {
+        err << "KPhotoAlbum did not answer in time, or closed the connection." << endl;
+        return 1;
+    }
+    return 0;
+}
+// vi:expandtab:tabstop=4 shiftwidth=4:
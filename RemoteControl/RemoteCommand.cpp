@@ -99,6 +99,11 @@ std::unique_ptr<RemoteCommand> RemoteCommand::create(CommandType id)
         ADDFACTORY(StaticImageRequest);
         ADDFACTORY(StaticImageResult);
         ADDFACTORY(ToggleTokenRequest);
+        ADDFACTORY(ThumbnailBatchRequest);
+        ADDFACTORY(ThumbnailBatchResult);
+        ADDFACTORY(ImageSearchRequest);
+        ADDFACTORY(ImageSearchPageRequest);
+        ADDFACTORY(ImageSearchResult);
     }
     Q_ASSERT(factories.contains(id));
     return factories[id]();
@@ -129,18 +134,21 @@ QDataStream& operator>>(QDataStream& stream, Category& category)
     return stream;
 }
 
-CategoryListResult::CategoryListResult()
-    : RemoteCommand(CommandType::CategoryListResult)
+CategoryListResult::CategoryListResult(int _generation, bool _unchanged)
+    : RemoteCommand(CommandType::CategoryListResult), generation(_generation), unchanged(_unchanged)
 {
     addSerializer(new Serializer<QList<Category>>(categories));
+    addSerializer(new Serializer<int>(generation));
+    addSerializer(new Serializer<bool>(unchanged));
 }
 
-SearchRequest::SearchRequest(SearchType _type, const SearchInfo& _searchInfo, int _size)
-    :RemoteCommand(CommandType::SearchRequest), type(_type), searchInfo(_searchInfo), size(_size)
+SearchRequest::SearchRequest(SearchType _type, const SearchInfo& _searchInfo, int _size, int _knownGeneration)
+    :RemoteCommand(CommandType::SearchRequest), type(_type), searchInfo(_searchInfo), size(_size), knownGeneration(_knownGeneration)
 {
     addSerializer(new Serializer<SearchType>(type));
     addSerializer(new Serializer<SearchInfo>(searchInfo));
     addSerializer(new Serializer<int>(size));
+    addSerializer(new Serializer<int>(knownGeneration));
 }
 
 SearchResult::SearchResult(SearchType _type, const QList<int>& _result)
@@ -243,3 +251,59 @@ ToggleTokenRequest::ToggleTokenRequest(ImageId _imageId, const QString& _token,
     addSerializer(new Serializer<QString>(token));
     addSerializer(new Serializer<State>(state));
 }
+
+ThumbnailBatchRequest::ThumbnailBatchRequest(const QList<ImageId>& _imageIds, const QSize& _size, ViewType _type, int _quality)
+    :RemoteCommand(CommandType::ThumbnailBatchRequest), imageIds(_imageIds), size(_size), type(_type), quality(_quality)
+{
+    addSerializer(new Serializer<QList<ImageId>>(imageIds));
+    addSerializer(new Serializer<QSize>(size));
+    addSerializer(new Serializer<ViewType>(type));
+    addSerializer(new Serializer<int>(quality));
+}
+
+QDataStream& operator<<(QDataStream& stream, const EncodedThumbnail& thumbnail)
+{
+    // The image data is already encoded, so unlike ThumbnailResult it is streamed with its length.
+    stream << thumbnail.imageId << thumbnail.label << thumbnail.data;
+    return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, EncodedThumbnail& thumbnail)
+{
+    stream >> thumbnail.imageId >> thumbnail.label >> thumbnail.data;
+    return stream;
+}
+
+ThumbnailBatchResult::ThumbnailBatchResult(ViewType _type, const QList<EncodedThumbnail>& _thumbnails)
+    :RemoteCommand(CommandType::ThumbnailBatchResult), type(_type), thumbnails(_thumbnails)
+{
+    addSerializer(new Serializer<ViewType>(type));
+    addSerializer(new Serializer<QList<EncodedThumbnail>>(thumbnails));
+}
+
+ImageSearchRequest::ImageSearchRequest(int _searchId, const SearchInfo& _searchInfo, int _pageSize, int _baseSearchId)
+    :RemoteCommand(CommandType::ImageSearchRequest), searchId(_searchId), searchInfo(_searchInfo), pageSize(_pageSize), baseSearchId(_baseSearchId)
+{
+    addSerializer(new Serializer<int>(searchId));
+    addSerializer(new Serializer<SearchInfo>(searchInfo));
+    addSerializer(new Serializer<int>(pageSize));
+    addSerializer(new Serializer<int>(baseSearchId));
+}
+
+ImageSearchPageRequest::ImageSearchPageRequest(int _searchId, int _offset, int _count)
+    :RemoteCommand(CommandType::ImageSearchPageRequest), searchId(_searchId), offset(_offset), count(_count)
+{
+    addSerializer(new Serializer<int>(searchId));
+    addSerializer(new Serializer<int>(offset));
+    addSerializer(new Serializer<int>(count));
+}
+
+ImageSearchResult::ImageSearchResult(int _searchId, int _total, int _offset, const QList<ImageId>& _imageIds)
+    :RemoteCommand(CommandType::ImageSearchResult), searchId(_searchId), total(_total), offset(_offset), imageIds(_imageIds)
+{
+    addSerializer(new Serializer<int>(searchId));
+    addSerializer(new Serializer<int>(total));
+    addSerializer(new Serializer<int>(offset));
+    addSerializer(new Serializer<QList<ImageId>>(imageIds));
+    addSerializer(new Serializer<QByteArray>(baseMask));
+}
@@ -36,7 +36,7 @@ namespace RemoteControl
 {
 class SerializerInterface;
 
-const int VERSION = 7;
+const int VERSION = 9;
 
 enum class CommandType {
     ThumbnailResult,
@@ -51,7 +51,12 @@ enum class CommandType {
     CategoryItemsResult,
     StaticImageRequest,
     StaticImageResult,
-    ToggleTokenRequest
+    ToggleTokenRequest,
+    ThumbnailBatchRequest,
+    ThumbnailBatchResult,
+    ImageSearchRequest,
+    ImageSearchPageRequest,
+    ImageSearchResult
 };
 
 
@@ -92,17 +97,20 @@ struct Category {
 class CategoryListResult :public RemoteCommand
 {
 public:
-    CategoryListResult();
+    CategoryListResult(int generation = {}, bool unchanged = {});
     QList<Category> categories;
+    int generation; // changes whenever the database changes
+    bool unchanged; // the client's cached categories are still valid, so categories is empty
 };
 
 class SearchRequest :public RemoteCommand
 {
 public:
-    SearchRequest(SearchType type = {}, const SearchInfo& searchInfo = {}, int size = {});
+    SearchRequest(SearchType type = {}, const SearchInfo& searchInfo = {}, int size = {}, int knownGeneration = -1);
     SearchType type;
     SearchInfo searchInfo;
     int size; // Only used for SearchType::Categories
+    int knownGeneration; // Only used for SearchType::Categories: generation of the client's cached categories, or -1
 };
 
 class SearchResult :public RemoteCommand
@@ -197,5 +205,72 @@ public:
     State state;
 };
 
+/**
+ * Request thumbnails for several images in one go. The server answers with ThumbnailBatchResults,
+ * each containing the thumbnails that were ready at the time it was sent.
+ */
+class ThumbnailBatchRequest :public RemoteCommand
+{
+public:
+    ThumbnailBatchRequest(const QList<ImageId>& imageIds = {}, const QSize& size = {}, ViewType type = {}, int quality = {});
+    QList<ImageId> imageIds;
+    QSize size;
+    ViewType type;
+    int quality; // JPEG quality, chosen by the client for its screen
+};
+
+struct EncodedThumbnail {
+    ImageId imageId;
+    QString label;
+    QByteArray data; // JPEG
+};
+
+class ThumbnailBatchResult :public RemoteCommand
+{
+public:
+    ThumbnailBatchResult(ViewType type = {}, const QList<EncodedThumbnail>& thumbnails = {});
+    ViewType type;
+    QList<EncodedThumbnail> thumbnails;
+};
+
+/**
+ * Search for images. The server answers with an ImageSearchResult containing the first page of the result,
+ * further pages are requested with ImageSearchPageRequests.
+ */
+class ImageSearchRequest :public RemoteCommand
+{
+public:
+    ImageSearchRequest(int searchId = {}, const SearchInfo& searchInfo = {}, int pageSize = {}, int baseSearchId = -1);
+    int searchId; // chosen by the client, to match the results to the request
+    SearchInfo searchInfo;
+    int pageSize; // 0 to get the complete result at once
+    int baseSearchId; // a search the client has the complete result of, or -1
+};
+
+class ImageSearchPageRequest :public RemoteCommand
+{
+public:
+    ImageSearchPageRequest(int searchId = {}, int offset = {}, int count = {});
+    int searchId;
+    int offset;
+    int count;
+};
+
+class ImageSearchResult :public RemoteCommand
+{
+public:
+    ImageSearchResult(int searchId = {}, int total = {}, int offset = {}, const QList<ImageId>& imageIds = {});
+    int searchId;
+    int total; // the number of images in the complete result
+    int offset; // the position of imageIds in the complete result
+    QList<ImageId> imageIds;
+    /**
+     * If the search narrows the base search, the complete result may be sent as one bit per image of the
+     * result of the base search instead, telling if the image is part of the new result.
+     * imageIds is empty then.
+     */
+    QByteArray baseMask;
+};
+
 }
 #endif // REMOTECOMMAND_H
@@ -20,8 +20,8 @@
 
 namespace RemoteControl {
 
-RemoteImageRequest::RemoteImageRequest(const DB::FileName& fileName, const QSize& size, int angle, ViewType type, RemoteInterface* client)
-    : ImageManager::ImageRequest(fileName, size, angle,client), m_interface(client), m_type(type)
+RemoteImageRequest::RemoteImageRequest(const DB::FileName& fileName, const QSize& size, int angle, ViewType type, RemoteInterface* client, int quality)
+    : ImageManager::ImageRequest(fileName, size, angle,client), m_interface(client), m_type(type), m_quality(quality)
 {
 }
 
@@ -35,4 +35,9 @@ ViewType RemoteImageRequest::type() const
     return m_type;
 }
 
+int RemoteImageRequest::quality() const
+{
+    return m_quality;
+}
+
 } // namespace RemoteControl
@@ -28,13 +28,18 @@ namespace RemoteControl {
 class RemoteImageRequest : public ImageManager::ImageRequest
 {
 public:
-    RemoteImageRequest(const DB::FileName& fileName, const QSize& size, int angle, ViewType type, RemoteInterface* client);
+    RemoteImageRequest(const DB::FileName& fileName, const QSize& size, int angle, ViewType type, RemoteInterface* client, int quality = -1);
     virtual bool stillNeeded() const;
     ViewType type() const;
+    /**
+     * The JPEG quality negotiated by a ThumbnailBatchRequest, or -1 if the image was requested with a ThumbnailRequest.
+     */
+    int quality() const;
 
 private:
     RemoteInterface* m_interface;
     ViewType m_type;
+    int m_quality;
 };
 
 } // namespace RemoteControl
@@ -26,7 +26,9 @@
 #include <QDebug>
 #include <QImage>
 #include <QPainter>
+#include <QSet>
 #include <QTcpSocket>
+#include <QThreadPool>
 
 #include <kiconloader.h>
 #include <KLocale>
@@ -40,16 +42,46 @@
 #include "DB/ImageInfoPtr.h"
 #include "DB/ImageSearchInfo.h"
 #include "ImageManager/AsyncLoader.h"
+#include "ImageManager/ThumbnailCache.h"
 #include "MainWindow/DirtyIndicator.h"
 #include "Utilities/Util.h"
 
 #include "RemoteCommand.h"
 #include "RemoteImageRequest.h"
 #include "Server.h"
+#include "ThumbnailEncoder.h"
 #include "Types.h"
 
 using namespace RemoteControl;
 
+namespace
+{
+// The range of JPEG qualities a client may ask for.
+const int MIN_QUALITY = 30;
+const int MAX_QUALITY = 95;
+
+// Limits the memory used by the caches of the category lists and items.
+const int MAX_CACHED_SEARCHES = 100;
+
+/**
+ * One bit per image of the base result, telling if it is part of the result.
+ * Returns a null array if the result is not a subset of the base result.
+ */
+QByteArray narrowingMask(const QList<ImageId>& base, const QList<ImageId>& result)
+{
+    const QSet<ImageId> included = result.toSet();
+    QByteArray mask((base.count() + 7) / 8, '\0');
+    int matched = 0;
+    for (int i = 0; i < base.count(); ++i) {
+        if (included.contains(base[i])) {
+            mask[i/8] = char(mask[i/8] | (1 << (i%8)));
+            ++matched;
+        }
+    }
+    return matched == result.count() ? mask : QByteArray();
+}
+}
+
 RemoteInterface& RemoteInterface::instance()
 {
     static RemoteInterface instance;
@@ -57,7 +89,7 @@ RemoteInterface& RemoteInterface::instance()
 }
 
 RemoteInterface::RemoteInterface(QObject *parent) :
-    QObject(parent), m_connection(new Server(this))
+    QObject(parent), m_connection(new Server(this)), m_encoderPool(new QThreadPool(this))
 {
     connect(m_connection, SIGNAL(gotCommand(RemoteCommand)), this, SLOT(handleCommand(RemoteCommand)));
     connect(m_connection, SIGNAL(connected()), this, SIGNAL(connected()));
@@ -65,6 +97,11 @@ RemoteInterface::RemoteInterface(QObject *parent) :
     connect(m_connection, SIGNAL(stoppedListening()), this, SIGNAL(stoppedListening()));
 }
 
+RemoteInterface::~RemoteInterface()
+{
+    m_encoderPool->waitForDone();
+}
+
 DB::ImageSearchInfo RemoteInterface::convert(const SearchInfo& searchInfo) const
 {
     DB::ImageSearchInfo dbSearchInfo;
@@ -79,8 +116,12 @@ DB::ImageSearchInfo RemoteInterface::convert(const SearchInfo& searchInfo) const
 
 void RemoteInterface::pixmapLoaded(ImageManager::ImageRequest* request, const QImage& image)
 {
-    m_connection->sendCommand(ThumbnailResult(m_imageNameStore[request->databaseFileName()], QString(),
-                              image, static_cast<RemoteImageRequest*>(request)->type()));
+    const RemoteImageRequest* remoteRequest = static_cast<RemoteImageRequest*>(request);
+    const ImageId imageId = m_imageNameStore[request->databaseFileName()];
+    if (remoteRequest->quality() == -1)
+        m_connection->sendCommand(ThumbnailResult(imageId, QString(), image, remoteRequest->type()));
+    else
+        m_encoderPool->start(new ThumbnailEncoder(this, imageId, QString(), image, remoteRequest->type(), remoteRequest->quality()));
 }
 
 bool RemoteInterface::requestStillNeeded(const DB::FileName& fileName)
@@ -117,6 +158,12 @@ void RemoteInterface::handleCommand(const RemoteCommand& command)
     }
     else if (command.commandType() == CommandType::ThumbnailRequest)
         requestThumbnail(static_cast<const ThumbnailRequest&>(command));
+    else if (command.commandType() == CommandType::ImageSearchRequest)
+        sendImageSearchResult(static_cast<const ImageSearchRequest&>(command));
+    else if (command.commandType() == CommandType::ImageSearchPageRequest)
+        sendImageSearchPage(static_cast<const ImageSearchPageRequest&>(command));
+    else if (command.commandType() == CommandType::ThumbnailBatchRequest)
+        requestThumbnails(static_cast<const ThumbnailBatchRequest&>(command));
     else if (command.commandType() == CommandType::ThumbnailCancelRequest)
         cancelRequest(static_cast<const ThumbnailCancelRequest&>(command));
     else if (command.commandType() == CommandType::ImageDetailsRequest)
@@ -128,11 +175,33 @@ void RemoteInterface::handleCommand(const RemoteCommand& command)
 }
 
 
+void RemoteInterface::validateCaches()
+{
+    const int generation = MainWindow::DirtyIndicator::changeCount();
+    if (generation != m_cacheGeneration || m_categoryListCache.count() + m_categoryItemsCache.count() > MAX_CACHED_SEARCHES) {
+        m_categoryListCache.clear();
+        m_categoryItemsCache.clear();
+        m_cacheGeneration = generation;
+    }
+}
+
 void RemoteInterface::sendCategoryNames(const SearchRequest& search)
 {
-    const DB::ImageSearchInfo dbSearchInfo = convert(search.searchInfo);
+    validateCaches();
+    if (search.knownGeneration == m_cacheGeneration) {
+        m_connection->sendCommand(CategoryListResult(m_cacheGeneration, true));
+        return;
+    }
+
+    CategoryListResult command(m_cacheGeneration);
+    const QByteArray key = search.searchInfo.key() + QByteArray::number(search.size);
+    if (m_categoryListCache.contains(key)) {
+        command.categories = m_categoryListCache.value(key);
+        m_connection->sendCommand(command);
+        return;
+    }
 
-    CategoryListResult command;
+    const DB::ImageSearchInfo dbSearchInfo = convert(search.searchInfo);
     for (const DB::CategoryPtr& category : DB::ImageDB::instance()->categoryCollection()->categories()) {
         if (category->type() == DB::Category::MediaTypeCategory)
             continue;
@@ -147,36 +216,43 @@ void RemoteInterface::sendCategoryNames(const SearchRequest& search)
         const QImage icon = category->icon(search.size, enabled ? KIconLoader::DefaultState : KIconLoader::DisabledState).toImage();
         command.categories.append({category->name(), icon, enabled, type});
     }
+    m_categoryListCache.insert(key, command.categories);
     m_connection->sendCommand(command);
 }
 
 void RemoteInterface::sendCategoryValues(const SearchRequest& search)
 {
-    const DB::ImageSearchInfo dbSearchInfo = convert(search.searchInfo);
     const QString categoryName = search.searchInfo.currentCategory();
 
     const DB::CategoryPtr category = DB::ImageDB::instance()->categoryCollection()->categoryForName(search.searchInfo.currentCategory());
 
-    Browser::FlatCategoryModel model(category, dbSearchInfo);
+    validateCaches();
+    const QByteArray key = search.searchInfo.key();
+    if (!m_categoryItemsCache.contains(key)) {
+        const DB::ImageSearchInfo dbSearchInfo = convert(search.searchInfo);
+        Browser::FlatCategoryModel model(category, dbSearchInfo);
+        m_categoryItemsCache.insert(key, model.m_items);
+    }
+    const QStringList items = m_categoryItemsCache.value(key);
 
     if (category->viewType() == DB::Category::IconView || category->viewType() == DB::Category::ThumbedIconView) {
         QList<int> result;
-        std::transform( model.m_items.begin(), model.m_items.end(), std::back_inserter(result),
+        std::transform( items.begin(), items.end(), std::back_inserter(result),
                         [this,categoryName] (const QString itemName) {
             return m_imageNameStore.idForCategory(categoryName,itemName);
         });
         m_connection->sendCommand(SearchResult(SearchType::CategoryItems, result));
     }
     else {
-        m_connection->sendCommand(CategoryItemsResult(model.m_items));
+        m_connection->sendCommand(CategoryItemsResult(items));
     }
 }
 
-void RemoteInterface::sendImageSearchResult(const SearchInfo& search)
+QList<ImageId> RemoteInterface::searchImages(const SearchInfo& search)
 {
     const DB::FileNameList files = DB::ImageDB::instance()->search(convert(search), true /* Require on disk */);
     DB::FileNameList stacksRemoved;
-    QList<int> result;
+    QList<ImageId> result;
 
     std::remove_copy_if(files.begin(), files.end(), std::back_inserter(stacksRemoved),
                         [] (const DB::FileName& file) {
@@ -190,8 +266,43 @@ void RemoteInterface::sendImageSearchResult(const SearchInfo& search)
                    [this](const DB::FileName& fileName) {
         return m_imageNameStore[fileName];
     });
+    return result;
+}
 
-    m_connection->sendCommand(SearchResult(SearchType::Images, result));
+void RemoteInterface::sendImageSearchResult(const SearchInfo& search)
+{
+    m_connection->sendCommand(SearchResult(SearchType::Images, searchImages(search)));
+}
+
+void RemoteInterface::sendImageSearchResult(const ImageSearchRequest& request)
+{
+    const QList<ImageId> result = searchImages(request.searchInfo);
+    const int pageSize = request.pageSize > 0 ? qMin(request.pageSize, result.count()) : result.count();
+    ImageSearchResult command(request.searchId, result.count(), 0);
+
+    // If the client has the result of the search this one narrows down, it only needs to know which of those images
+    // are left, which is cheaper to send than the ids of the page if the base result isn't much bigger.
+    const bool narrowsBase = request.baseSearchId != -1 && request.baseSearchId == m_lastSearchId
+            && request.searchInfo.narrows(m_lastSearch);
+    if (narrowsBase && (m_lastSearchResult.count() + 7) / 8 < pageSize * int(sizeof(ImageId)))
+        command.baseMask = narrowingMask(m_lastSearchResult, result);
+    if (command.baseMask.isNull())
+        command.imageIds = result.mid(0, pageSize);
+
+    m_lastSearchId = request.searchId;
+    m_lastSearch = request.searchInfo;
+    m_lastSearchResult = result;
+    m_connection->sendCommand(command);
+}
+
+void RemoteInterface::sendImageSearchPage(const ImageSearchPageRequest& request)
+{
+    // Only the last search is kept, the client isn't interested in the pages of older ones anymore.
+    if (request.searchId != m_lastSearchId)
+        return;
+
+    m_connection->sendCommand(ImageSearchResult(request.searchId, m_lastSearchResult.count(), request.offset,
+                                                m_lastSearchResult.mid(request.offset, request.count)));
 }
 
 void RemoteInterface::requestThumbnail(const ThumbnailRequest& command)
@@ -224,6 +335,81 @@ void RemoteInterface::requestThumbnail(const ThumbnailRequest& command)
     }
 }
 
+void RemoteInterface::requestThumbnails(const ThumbnailBatchRequest& command)
+{
+    const int quality = qBound(MIN_QUALITY, command.quality, MAX_QUALITY);
+    const int requestedSize = qMax(command.size.width(), command.size.height());
+
+    for (ImageId imageId : command.imageIds) {
+        if (command.type == ViewType::CategoryItems) {
+            auto tuple = m_imageNameStore.categoryForId(imageId);
+            const QString categoryName = tuple.first;
+            const QString itemName = tuple.second;
+
+            const DB::CategoryPtr category = DB::ImageDB::instance()->categoryCollection()->categoryForName(categoryName);
+            const QImage image = category->categoryImage( categoryName, itemName, command.size.width(), command.size.height()).toImage();
+            m_encoderPool->start(new ThumbnailEncoder(this, imageId, itemName, image, command.type, quality));
+            continue;
+        }
+
+        const DB::FileName fileName = m_imageNameStore[imageId];
+        m_activeReuqest.insert(fileName);
+
+        if (command.type == ViewType::Thumbnails) {
+            // Serve the thumbnail from the cache if possible. If it has about the right size,
+            // its JPEG data is sent as it is, otherwise it is scaled down on the encoder pool.
+            int levelSize = 0;
+            const QByteArray cached = ImageManager::ThumbnailCache::instance()->lookupRawData(fileName, command.size, &levelSize);
+            if (!cached.isEmpty() && levelSize >= requestedSize) {
+                if (levelSize < 2 * requestedSize)
+                    thumbnailEncoded(command.type, {imageId, QString(), cached});
+                else
+                    m_encoderPool->start(new ThumbnailEncoder(this, imageId, cached, command.size, command.type, quality));
+                continue;
+            }
+        }
+
+        const DB::ImageInfoPtr info = DB::ImageDB::instance()->info(fileName);
+        QSize size = command.size;
+        if (!size.isValid()) {
+            // Request for full screen image.
+            size = info->size();
+        }
+        ImageManager::AsyncLoader::instance()->load(
+                    new RemoteImageRequest(fileName, size, info->angle(), command.type, this, quality));
+    }
+}
+
+void RemoteInterface::thumbnailEncoded(ViewType type, const EncodedThumbnail& thumbnail)
+{
+    QMutexLocker locker(&m_encodedLock);
+    m_encoded.append(qMakePair(type, thumbnail));
+
+    // Everything encoded until the GUI thread gets to it goes into the same batch.
+    if (m_encoded.count() == 1)
+        QMetaObject::invokeMethod(this, "sendEncodedThumbnails", Qt::QueuedConnection);
+}
+
+void RemoteInterface::sendEncodedThumbnails()
+{
+    QList<QPair<ViewType, EncodedThumbnail>> encoded;
+    {
+        QMutexLocker locker(&m_encodedLock);
+        encoded.swap(m_encoded);
+    }
+
+    QMap<ViewType, QList<EncodedThumbnail>> batches;
+    for (const auto& item : encoded) {
+        // Skip images that the client canceled while they were loaded or encoded.
+        if (item.first != ViewType::CategoryItems && !m_activeReuqest.contains(m_imageNameStore[item.second.imageId]))
+            continue;
+        batches[item.first].append(item.second);
+    }
+
+    for (auto it = batches.constBegin(); it != batches.constEnd(); ++it)
+        m_connection->sendCommand(ThumbnailBatchResult(it.key(), it.value()));
+}
+
 void RemoteInterface::cancelRequest(const ThumbnailCancelRequest& command)
 {
     m_activeReuqest.remove(m_imageNameStore[command.imageId]);
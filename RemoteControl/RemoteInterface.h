@@ -24,9 +24,11 @@
 #include "DB/ImageSearchInfo.h"
 #include <QObject>
 #include <QHostAddress>
+#include <QMutex>
 #include "ImageManager/ImageClientInterface.h"
 
 class QHostAddress;
+class QThreadPool;
 
 namespace RemoteControl
 {
@@ -42,9 +44,15 @@ public:
     void listen();
     void stopListening();
     void connectTo(const QHostAddress& address);
+    /**
+     * @brief thumbnailEncoded queues a thumbnail for the next ThumbnailBatchResult.
+     * This method is thread-safe; the thumbnails are sent from the GUI thread.
+     */
+    void thumbnailEncoded(ViewType type, const EncodedThumbnail& thumbnail);
 
 private slots:
     void handleCommand(const RemoteCommand&);
+    void sendEncodedThumbnails();
 
 signals:
     void connected();
@@ -54,11 +62,17 @@ signals:
 
 private:
     explicit RemoteInterface(QObject *parent = 0);
+    ~RemoteInterface();
 
     void sendCategoryNames(const SearchRequest& searchInfo);
     void sendCategoryValues(const SearchRequest& search);
     void sendImageSearchResult(const SearchInfo& search);
+    void sendImageSearchResult(const ImageSearchRequest& request);
+    void sendImageSearchPage(const ImageSearchPageRequest& request);
+    QList<ImageId> searchImages(const SearchInfo& search);
+    void validateCaches();
     void requestThumbnail(const ThumbnailRequest& command);
+    void requestThumbnails(const ThumbnailBatchRequest& command);
     void cancelRequest(const ThumbnailCancelRequest& command);
     void sendImageDetails(const ImageDetailsRequest& command);
     void sendHomePageImages(const StaticImageRequest& command);
@@ -68,6 +82,19 @@ private:
     Server* m_connection;
     QSet<DB::FileName> m_activeReuqest;
     ImageNameStore m_imageNameStore;
+    QThreadPool* m_encoderPool;
+    QMutex m_encodedLock;
+    QList<QPair<ViewType, EncodedThumbnail>> m_encoded;
+
+    // The category lists and items of recent searches, valid as long as the database is unchanged.
+    int m_cacheGeneration = -1;
+    QHash<QByteArray, QList<Category>> m_categoryListCache;
+    QHash<QByteArray, QStringList> m_categoryItemsCache;
+
+    // The last image search, to serve its pages and to narrow it down.
+    int m_lastSearchId = -1;
+    SearchInfo m_lastSearch;
+    QList<ImageId> m_lastSearchResult;
 };
 
 }
@@ -71,4 +71,25 @@ QList<std::tuple<QString, QString> > RemoteControl::SearchInfo::values() const
     return result;
 }
 
+bool SearchInfo::narrows(const SearchInfo& other) const
+{
+    if (m_values.count() <= other.m_values.count())
+        return false;
+
+    const QList<std::tuple<QString, QString> > ownValues = values();
+    for (const auto& value : other.values()) {
+        if (!ownValues.contains(value))
+            return false;
+    }
+    return true;
+}
+
+QByteArray SearchInfo::key() const
+{
+    QByteArray result;
+    QDataStream stream(&result, QIODevice::WriteOnly);
+    stream << *this;
+    return result;
+}
+
 } // namespace RemoteControl
@@ -36,6 +36,15 @@ public:
     void clear();
     QString currentCategory() const;
     QList<std::tuple<QString,QString>> values() const;
+    /**
+     * @brief narrows tells if this search has all the values of the other search and more,
+     * so its result is a subset of the result of the other search.
+     */
+    bool narrows(const SearchInfo& other) const;
+    /**
+     * @brief key identifies the search, e.g. for caching its results.
+     */
+    QByteArray key() const;
 
     friend QDataStream& operator<<(QDataStream& stream, const SearchInfo& searchInfo);
     friend QDataStream& operator>>(QDataStream& stream, SearchInfo& searchInfo);
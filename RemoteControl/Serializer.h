@@ -20,23 +20,44 @@
 #define REMOTECONTROL_SERIALIZER_H
 
 #include <QObject>
+#include <QBuffer>
+#include <QImage>
+#include <QPainter>
 
 namespace RemoteControl {
 
 enum class BackgroundType { Transparent, NonTransparent };
 
-static void fastStreamImage(QDataStream& stream, const QImage& image, BackgroundType type)
+/**
+ * Write the image as JPEG. JPEG has no alpha channel, so transparent images are painted onto black first.
+ * A quality of -1 means the default quality of the JPEG writer.
+ */
+inline void writeJpeg(QIODevice* device, const QImage& image, BackgroundType type, int quality = -1)
 {
-    if (type == BackgroundType::Transparent) {
+    if (type == BackgroundType::Transparent && image.hasAlphaChannel()) {
         QImage result(image.width(), image.height(), QImage::Format_RGB32);
         result.fill(Qt::black);
         QPainter p(&result);
         p.drawImage(0,0, image);
         p.end();
-        result.save(stream.device(), "JPEG");
+        result.save(device, "JPEG", quality);
     }
     else
-        image.save(stream.device(), "JPEG");
+        image.save(device, "JPEG", quality);
+}
+
+inline void fastStreamImage(QDataStream& stream, const QImage& image, BackgroundType type)
+{
+    writeJpeg(stream.device(), image, type);
+}
+
+inline QByteArray encodeJpeg(const QImage& image, BackgroundType type, int quality)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    writeJpeg(&buffer, image, type, quality);
+    return data;
 }
 
 class SerializerInterface
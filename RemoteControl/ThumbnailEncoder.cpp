@@ -0,0 +1,46 @@
+/* Copyright (C) 2014 Jesper K. Pedersen <blackie@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "ThumbnailEncoder.h"
+#include "RemoteCommand.h"
+#include "RemoteInterface.h"
+#include "Serializer.h"
+
+namespace RemoteControl {
+
+ThumbnailEncoder::ThumbnailEncoder(RemoteInterface* interface, ImageId imageId, const QString& label, const QImage& image,
+                                   ViewType type, int quality)
+    : m_interface(interface), m_imageId(imageId), m_label(label), m_image(image), m_type(type), m_quality(quality)
+{
+}
+
+ThumbnailEncoder::ThumbnailEncoder(RemoteInterface* interface, ImageId imageId, const QByteArray& jpeg, const QSize& size,
+                                   ViewType type, int quality)
+    : m_interface(interface), m_imageId(imageId), m_jpeg(jpeg), m_size(size), m_type(type), m_quality(quality)
+{
+}
+
+void ThumbnailEncoder::run()
+{
+    if (m_image.isNull() && !m_jpeg.isEmpty())
+        m_image = QImage::fromData(m_jpeg, "JPEG").scaled(m_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    m_interface->thumbnailEncoded(m_type, {m_imageId, m_label, encodeJpeg(m_image, BackgroundType::NonTransparent, m_quality)});
+}
+
+} // namespace RemoteControl
@@ -0,0 +1,61 @@
+/* Copyright (C) 2014 Jesper K. Pedersen <blackie@kde.org>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef REMOTECONTROL_THUMBNAILENCODER_H
+#define REMOTECONTROL_THUMBNAILENCODER_H
+
+#include "Types.h"
+#include <QByteArray>
+#include <QImage>
+#include <QRunnable>
+#include <QSize>
+#include <QString>
+
+namespace RemoteControl {
+class RemoteInterface;
+
+/**
+ * @brief The ThumbnailEncoder encodes a thumbnail for a ThumbnailBatchResult on a worker thread,
+ * and hands it to the RemoteInterface, which sends it from the GUI thread.
+ */
+class ThumbnailEncoder : public QRunnable
+{
+public:
+    ThumbnailEncoder(RemoteInterface* interface, ImageId imageId, const QString& label, const QImage& image,
+                     ViewType type, int quality);
+    /**
+     * Encode a thumbnail which is too big for the request, scaling it down to the given size first.
+     */
+    ThumbnailEncoder(RemoteInterface* interface, ImageId imageId, const QByteArray& jpeg, const QSize& size,
+                     ViewType type, int quality);
+    void run() override;
+
+private:
+    RemoteInterface* m_interface;
+    ImageId m_imageId;
+    QString m_label;
+    QImage m_image;
+    QByteArray m_jpeg;
+    QSize m_size;
+    ViewType m_type;
+    int m_quality;
+};
+
+} // namespace RemoteControl
+
+#endif // REMOTECONTROL_THUMBNAILENCODER_H
@@ -43,6 +43,9 @@ Settings::FileVersionDetectionPage::FileVersionDetectionPage( QWidget* parent )
         m_searchForImagesOnStart = new QCheckBox( i18n("Search for new images and videos on startup"), generalBox );
         layout->addWidget(m_searchForImagesOnStart);
 
+        m_watchImageDirectory = new QCheckBox( i18n("Watch the image directory for new images and videos"), generalBox );
+        layout->addWidget(m_watchImageDirectory);
+
         m_ignoreFileExtension = new QCheckBox( i18n("Ignore file extensions when searching for new images and videos"), generalBox);
         layout->addWidget(m_ignoreFileExtension);
 
@@ -65,6 +68,10 @@ Settings::FileVersionDetectionPage::FileVersionDetectionPage( QWidget* parent )
                     "using <b>Maintenance->Rescan for new images</b></p>");
         m_searchForImagesOnStart->setWhatsThis( txt );
 
+        txt = i18n( "<p>If this option is set, KPhotoAlbum watches the image directory while it is running, "
+                    "and searches the directories in which files were added for new images and videos.</p>" );
+        m_watchImageDirectory->setWhatsThis( txt );
+
         txt = i18n( "<p>KPhotoAlbum will normally search new images and videos by their file extension. "
                     "If this option is set, <em>all</em> files neither in the database nor in the block list "
                     "will be checked by their Mime type, regardless of their extension. This will take "
@@ -181,6 +188,7 @@ Settings::FileVersionDetectionPage::FileVersionDetectionPage( QWidget* parent )
 Settings::FileVersionDetectionPage::~FileVersionDetectionPage()
 {
     delete m_searchForImagesOnStart;
+    delete m_watchImageDirectory;
     delete m_ignoreFileExtension;
     delete m_skipSymlinks;
     delete m_skipRawIfOtherMatches;
@@ -197,6 +205,7 @@ Settings::FileVersionDetectionPage::~FileVersionDetectionPage()
 void Settings::FileVersionDetectionPage::loadSettings( Settings::SettingsData* opt )
 {
     m_searchForImagesOnStart->setChecked( opt->searchForImagesOnStart() );
+    m_watchImageDirectory->setChecked( opt->watchImageDirectory() );
     m_ignoreFileExtension->setChecked( opt->ignoreFileExtension() );
     m_skipSymlinks->setChecked( opt->skipSymlinks() );
     m_skipRawIfOtherMatches->setChecked( opt->skipRawIfOtherMatches() );
@@ -213,6 +222,7 @@ void Settings::FileVersionDetectionPage::loadSettings( Settings::SettingsData* o
 void Settings::FileVersionDetectionPage::saveSettings( Settings::SettingsData* opt )
 {
     opt->setSearchForImagesOnStart( m_searchForImagesOnStart->isChecked() );
+    opt->setWatchImageDirectory( m_watchImageDirectory->isChecked() );
     opt->setIgnoreFileExtension( m_ignoreFileExtension->isChecked() );
     opt->setSkipSymlinks( m_skipSymlinks->isChecked() );
     opt->setSkipRawIfOtherMatches( m_skipRawIfOtherMatches->isChecked() );
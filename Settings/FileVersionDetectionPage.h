@@ -38,6 +38,7 @@ public:
 
 private:
     QCheckBox* m_searchForImagesOnStart;
+    QCheckBox* m_watchImageDirectory;
     QCheckBox* m_ignoreFileExtension;
     QCheckBox* m_skipSymlinks;
     QCheckBox* m_skipRawIfOtherMatches;
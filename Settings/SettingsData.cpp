@@ -174,6 +174,7 @@ property_copy( listenForAndroidDevicesOnStartup, setListenForAndroidDevicesOnSta
 getValueFunc( QSize,histogramSize,  General,QSize(15,30) )
 getValueFunc( ViewSortType,viewSortType,  General,(int)SortLastUse )
 getValueFunc( AnnotationDialog::MatchType, matchType,  General,(int)AnnotationDialog::MatchFromWordStart )
+getValueFunc( bool,watchImageDirectory,  General,false )
 
 void SettingsData::setHistogramSize( const QSize& size )
 {
@@ -184,6 +185,15 @@ void SettingsData::setHistogramSize( const QSize& size )
     emit histogramSizeChanged( size );
 }
 
+void SettingsData::setWatchImageDirectory( const bool watch )
+{
+    if ( watch == watchImageDirectory() )
+        return;
+
+    setValue( "General", "watchImageDirectory", watch );
+    emit watchImageDirectoryChanged( watch );
+}
+
 void SettingsData::setViewSortType( const ViewSortType tp )
 {
     if ( tp == viewSortType() )
@@ -362,6 +372,7 @@ property_copy( untaggedImagesTagVisible, setUntaggedImagesTagVisible, bool, Gene
     property_sset( exifForViewer, setExifForViewer,          Exif, StringSet()                            )
     property_sset( exifForDialog, setExifForDialog,          Exif, Exif::Info::instance()->standardKeys() )
     property_ref ( iptcCharset  , setIptcCharset  , QString, Exif, QString()                 )
+    property_copy( useExifColumnCache, setUseExifColumnCache, bool, Exif, true                 )
 #endif
 
 /////////////////////
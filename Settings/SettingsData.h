@@ -78,6 +78,7 @@ public:
     property_copy( ignoreFileExtension   , setIgnoreFileExtension   , bool );
     property_copy( skipSymlinks          , setSkipSymlinks          , bool );
     property_copy( skipRawIfOtherMatches , setSkipRawIfOtherMatches , bool );
+    property_copy( watchImageDirectory   , setWatchImageDirectory   , bool );
     property_copy( useRawThumbnail       , setUseRawThumbnail       , bool );
     property_copy( useRawThumbnailSize   , setUseRawThumbnailSize   , QSize );
     property_copy( useCompressedIndexXML , setUseCompressedIndexXML , bool );
@@ -171,6 +172,7 @@ public:
     property_ref( exifForViewer, setExifForViewer, StringSet );
     property_ref( exifForDialog, setExifForDialog, StringSet );
     property_ref( iptcCharset  , setIptcCharset  , QString   );
+    property_copy( useExifColumnCache, setUseExifColumnCache, bool );
 #endif
 
     /////////////////////////
@@ -244,6 +246,7 @@ signals:
     void histogramSizeChanged( const QSize& );
     void thumbnailSizeChanged( int );
     void actualThumbnailSizeChanged( int );
+    void watchImageDirectoryChanged( bool );
 
 private:
     SettingsData( const QString& imageDirectory  );
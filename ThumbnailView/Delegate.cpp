@@ -37,10 +37,12 @@ void ThumbnailView::Delegate::paint( QPainter* painter, const QStyleOptionViewIt
     if ( widget()->isGridResizing())
         return;
 
-    if ( index.data( Qt::DecorationRole ).value<QPixmap>().isNull() )
+    // fetch the pixmap only once, as this might involve loading and scaling the thumbnail:
+    const QPixmap pixmap = index.data( Qt::DecorationRole ).value<QPixmap>();
+    if ( pixmap.isNull() )
         return;
 
-    paintCellPixmap( painter, option, index );
+    paintCellPixmap( painter, option, index, pixmap );
     paintCellText( painter, option, index );
 }
 
@@ -58,10 +60,8 @@ void ThumbnailView::Delegate::paintCellBackground( QPainter* painter, const QRec
     }
 }
 
-void ThumbnailView::Delegate::paintCellPixmap( QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index ) const
+void ThumbnailView::Delegate::paintCellPixmap( QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index, const QPixmap& pixmap ) const
 {
-    const QPixmap pixmap = index.data( Qt::DecorationRole ).value<QPixmap>();
-
     const QRect pixmapRect = cellGeometryInfo()->iconGeometry( pixmap ).translated(option.rect.topLeft());
     paintBoundingRect( painter, pixmapRect, index );
     painter->drawPixmap( pixmapRect, pixmap );
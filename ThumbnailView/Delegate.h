@@ -33,7 +33,7 @@ public:
 
 private:
     void paintCellBackground( QPainter* painter, const QRect& rect ) const;
-    void paintCellPixmap( QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index ) const;
+    void paintCellPixmap( QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index, const QPixmap& pixmap ) const;
     void paintVideoInfo( QPainter* painter, const QRect& pixmapRect, const QModelIndex& index ) const;
     void paintCellText( QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index ) const;
     void paintBoundingRect( QPainter* painter, const QRect& pixmapRect, const QModelIndex& index  ) const;
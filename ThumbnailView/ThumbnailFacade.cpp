@@ -17,6 +17,7 @@
 */
 #include "ThumbnailFacade.h"
 #include "ImageManager/ThumbnailCache.h"
+#include "ImageManager/VideoFrameCache.h"
 #include <BackgroundJobs/HandleVideoThumbnailRequestJob.h>
 
 #include "Settings/SettingsData.h"
@@ -175,6 +176,7 @@ void ThumbnailView::ThumbnailFacade::slotRecreateThumbnail()
     Q_FOREACH( const DB::FileName& fileName, widget()->selection( NoExpandCollapsedStacks )) {
         ImageManager::ThumbnailCache::instance()->removeThumbnail( fileName );
         BackgroundJobs::HandleVideoThumbnailRequestJob::removeFullScaleFrame(fileName);
+        ImageManager::VideoFrameCache::instance()->setThumbnailFrame(fileName, -1);
         m_model->updateCell(fileName);
     }
 }
@@ -30,12 +30,40 @@
 #include <DB/FileName.h>
 #include <KIcon>
 #include <KLocale>
+#include <QTimer>
+
+namespace {
+// enough for several screens full of large thumbnails:
+constexpr int SCALED_PIXMAP_CACHE_SIZE_KB = 128 * 1024;
+// screens of thumbnails that are loaded ahead of the scrolling direction when not scrolling:
+constexpr int PREFETCH_SCREENS_AHEAD = 2;
+// ... and at most, when scrolling fast:
+constexpr int MAX_PREFETCH_SCREENS_AHEAD = 8;
+// the time (in seconds) it should take to scroll through the thumbnails that are loaded ahead:
+constexpr double PREFETCH_SECONDS_AHEAD = 1.0;
+// screens of thumbnails that are loaded in the opposite direction:
+constexpr int PREFETCH_SCREENS_BEHIND = 1;
+// the number of cached thumbnails that are scaled for painting per event loop iteration:
+constexpr int WARM_PIXMAPS_PER_ITERATION = 4;
+}
 
 ThumbnailView::ThumbnailModel::ThumbnailModel( ThumbnailFactory* factory)
     : ThumbnailComponent( factory ),
-      m_sortDirection( Settings::SettingsData::instance()->showNewestThumbnailFirst() ? NewestFirst : OldestFirst )
+      m_sortDirection( Settings::SettingsData::instance()->showNewestThumbnailFirst() ? NewestFirst : OldestFirst ),
+      m_firstVisibleRow( -1 ),
+      m_lastVisibleRow( -1 ),
+      m_prefetchFirstRow( 0 ),
+      m_prefetchLastRow( -1 ),
+      m_scrollSpeed( 0 )
 {
     connect( DB::ImageDB::instance(), SIGNAL(imagesDeleted(DB::FileNameList)), this, SLOT(imagesDeletedFromDB(DB::FileNameList)) );
+    connect( ImageManager::ThumbnailCache::instance(), SIGNAL(thumbnailUpdated(DB::FileName)), this, SLOT(thumbnailUpdated(DB::FileName)) );
+    connect( ImageManager::ThumbnailCache::instance(), SIGNAL(cacheFlushed()), this, SLOT(clearScaledPixmapCache()) );
+    m_scaledPixmapCache.setMaxCost( SCALED_PIXMAP_CACHE_SIZE_KB );
+
+    m_warmTimer = new QTimer( this );
+    m_warmTimer->setSingleShot( true );
+    connect( m_warmTimer, SIGNAL(timeout()), this, SLOT(warmScaledPixmaps()) );
     m_ImagePlaceholder = KIcon( QLatin1String("image-x-generic") ).pixmap( cellGeometryInfo()->preferredIconSize() );
     m_VideoPlaceholder = KIcon( QLatin1String("video-x-generic") ).pixmap( cellGeometryInfo()->preferredIconSize() );
 }
@@ -109,6 +137,12 @@ void ThumbnailView::ThumbnailModel::updateDisplayModel()
 
     updateIndexCache();
 
+    // the rows have changed, so everything needs to be requested again:
+    m_prefetchFirstRow = 0;
+    m_prefetchLastRow = -1;
+    m_warmQueue.clear();
+    updatePrefetchWindow();
+
     emit collapseAllStacksEnabled( m_expandedStacks.size() > 0);
     emit expandAllStacksEnabled( m_allStacks.size() != model()->m_expandedStacks.size() );
     reset();
@@ -151,7 +185,6 @@ void ThumbnailView::ThumbnailModel::setImageList(const DB::FileNameList& items)
             m_allStacks << info->stackId();
     }
     updateDisplayModel();
-    preloadThumbnails();
 }
 
 // TODO(hzeller) figure out if this should return the m_imageList or m_displayList.
@@ -170,10 +203,21 @@ void ThumbnailView::ThumbnailModel::imagesDeletedFromDB( const DB::FileNameList&
     Q_FOREACH( const DB::FileName& fileName, list ) {
         m_displayList.removeAll(fileName);
         m_imageList.removeAll(fileName);
+        m_scaledPixmapCache.remove(fileName);
     }
     updateDisplayModel();
 }
 
+void ThumbnailView::ThumbnailModel::thumbnailUpdated( const DB::FileName& fileName )
+{
+    m_scaledPixmapCache.remove( fileName );
+}
+
+void ThumbnailView::ThumbnailModel::clearScaledPixmapCache()
+{
+    m_scaledPixmapCache.clear();
+}
+
 
 int ThumbnailView::ThumbnailModel::indexOf(const DB::FileName& fileName)
 {
@@ -289,8 +333,9 @@ void ThumbnailView::ThumbnailModel::requestThumbnail( const DB::FileName& fileNa
     DB::ImageInfoPtr imageInfo = fileName.info();
     if ( imageInfo.isNull() )
         return;
-    // request the thumbnail in the size that is set in the settings, not in the current grid size:
-    const QSize cellSize = cellGeometryInfo()->baseIconSize();
+    // request the thumbnail big enough for all levels of the thumbnail cache, not in the current grid size:
+    const int buildSize = ImageManager::ThumbnailCache::thumbnailBuildSize();
+    const QSize cellSize( buildSize, buildSize );
     const int angle = imageInfo->angle();
     const int row = indexOf(fileName);
     ThumbnailRequest* request
@@ -418,9 +463,25 @@ QPixmap ThumbnailView::ThumbnailModel::pixmap( const DB::FileName& fileName ) co
     if (imageInfo == DB::ImageInfoPtr(nullptr) )
         return QPixmap();
 
+    // the scaled pixmaps are only valid for the current grid size:
+    const QSize iconSize = cellGeometryInfo()->preferredIconSize();
+    if ( iconSize != m_scaledPixmapSize ) {
+        m_scaledPixmapCache.clear();
+        m_scaledPixmapSize = iconSize;
+    }
+
+    const ScaledPixmap* scaled = m_scaledPixmapCache.object( fileName );
+    if ( scaled && scaled->angle == imageInfo->angle() )
+        return scaled->pixmap;
+
     if ( ImageManager::ThumbnailCache::instance()->contains( fileName ) ) {
         // the cached thumbnail needs to be scaled to the actual thumbnail size:
-        return ImageManager::ThumbnailCache::instance()->lookup( fileName ).scaled( cellGeometryInfo()->preferredIconSize(), Qt::KeepAspectRatio );
+        const QPixmap pixmap = ImageManager::ThumbnailCache::instance()->lookup( fileName, iconSize ).scaled( iconSize, Qt::KeepAspectRatio );
+        if ( !pixmap.isNull() ) {
+            const int cost = qMax( 1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024 );
+            m_scaledPixmapCache.insert( fileName, new ScaledPixmap{ pixmap, imageInfo->angle() }, cost );
+        }
+        return pixmap;
     }
 
     const_cast<ThumbnailView::ThumbnailModel*>(this)->requestThumbnail( fileName, ImageManager::ThumbnailVisible );
@@ -432,7 +493,12 @@ QPixmap ThumbnailView::ThumbnailModel::pixmap( const DB::FileName& fileName ) co
 
 bool ThumbnailView::ThumbnailModel::thumbnailStillNeeded( int row ) const
 {
-    return ( row >= m_firstVisibleRow && row <= m_lastVisibleRow );
+    return ( row >= m_prefetchFirstRow && row <= m_prefetchLastRow );
+}
+
+void ThumbnailView::ThumbnailModel::setScrollSpeed( double linesPerSecond )
+{
+    m_scrollSpeed = linesPerSecond;
 }
 
 void ThumbnailView::ThumbnailModel::updateVisibleRowInfo()
@@ -443,22 +509,94 @@ void ThumbnailView::ThumbnailModel::updateVisibleRowInfo()
     m_lastVisibleRow = qMin(m_firstVisibleRow + columns*(rows+1), rowCount(QModelIndex()));
 
     // the cellGeometry has changed -> update placeholders
-    m_ImagePlaceholder = KIcon( QLatin1String("image-x-generic") ).pixmap( cellGeometryInfo()->preferredIconSize() );
-    m_VideoPlaceholder = KIcon( QLatin1String("video-x-generic") ).pixmap( cellGeometryInfo()->preferredIconSize() );
+    if ( m_placeholderSize != cellGeometryInfo()->preferredIconSize() ) {
+        m_placeholderSize = cellGeometryInfo()->preferredIconSize();
+        m_ImagePlaceholder = KIcon( QLatin1String("image-x-generic") ).pixmap( m_placeholderSize );
+        m_VideoPlaceholder = KIcon( QLatin1String("video-x-generic") ).pixmap( m_placeholderSize );
+    }
+
+    updatePrefetchWindow();
 }
 
-void ThumbnailView::ThumbnailModel::preloadThumbnails()
+void ThumbnailView::ThumbnailModel::updatePrefetchWindow()
 {
-    // FIXME: it would make a lot of sense to merge preloadThumbnails() with pixmap()
-    // and maybe also move the caching stuff into the ImageManager
-    Q_FOREACH( const DB::FileName& fileName, m_displayList) {
+    const int count = imageCount();
+    if ( count == 0 ) {
+        m_prefetchFirstRow = 0;
+        m_prefetchLastRow = -1;
+        return;
+    }
+
+    const int firstVisible = qBound( 0, m_firstVisibleRow, count - 1 );
+    const int lastVisible = qBound( firstVisible, m_lastVisibleRow, count - 1 );
+    const int columns = qMax( 1, widget()->width() / cellGeometryInfo()->cellSize().width() );
+    const int screen = qMax( columns, lastVisible - firstVisible + 1 );
+    const int linesPerScreen = qMax( 1, screen / columns );
+
+    // the faster the user scrolls, the further ahead thumbnails are needed:
+    const double screensAhead = qMin( double(MAX_PREFETCH_SCREENS_AHEAD),
+                                      PREFETCH_SCREENS_AHEAD + qAbs( m_scrollSpeed ) * PREFETCH_SECONDS_AHEAD / linesPerScreen );
+    const int ahead = int( screensAhead * screen );
+    const int behind = PREFETCH_SCREENS_BEHIND * screen;
+    const bool forward = m_scrollSpeed >= 0;
+
+    const int oldFirst = m_prefetchFirstRow;
+    const int oldLast = m_prefetchLastRow;
+    m_prefetchFirstRow = qMax( 0, firstVisible - ( forward ? behind : ahead ) );
+    m_prefetchLastRow = qMin( count - 1, lastVisible + ( forward ? ahead : behind ) );
+
+    // Requests for rows that dropped out of the window are discarded by the AsyncLoader (see thumbnailStillNeeded()).
+    // Only rows that entered the window need to be requested; the nearest ones first.
+    if ( forward ) {
+        prefetchRows( lastVisible + 1, m_prefetchLastRow, ImageManager::ThumbnailPrefetch, oldFirst, oldLast );
+        prefetchRows( firstVisible - 1, m_prefetchFirstRow, ImageManager::ThumbnailInvisible, oldFirst, oldLast );
+    } else {
+        prefetchRows( firstVisible - 1, m_prefetchFirstRow, ImageManager::ThumbnailPrefetch, oldFirst, oldLast );
+        prefetchRows( lastVisible + 1, m_prefetchLastRow, ImageManager::ThumbnailInvisible, oldFirst, oldLast );
+    }
+
+    if ( !m_warmQueue.isEmpty() )
+        m_warmTimer->start( 0 );
+}
+
+void ThumbnailView::ThumbnailModel::prefetchRows( int from, int to, ImageManager::Priority priority, int oldFirst, int oldLast )
+{
+    const int step = from <= to ? 1 : -1;
+    for ( int row = from; row != to + step; row += step ) {
+        if ( row >= oldFirst && row <= oldLast )
+            continue;
+
+        const DB::FileName fileName = m_displayList.at( row );
         if ( fileName.isNull() )
             continue;
 
-        if ( ImageManager::ThumbnailCache::instance()->contains( fileName ) )
+        if ( ImageManager::ThumbnailCache::instance()->contains( fileName ) ) {
+            // the thumbnail is there, but still needs to be decoded and scaled before it can be painted:
+            if ( priority == ImageManager::ThumbnailPrefetch )
+                m_warmQueue.enqueue( row );
+        } else {
+            requestThumbnail( fileName, priority );
+        }
+    }
+}
+
+void ThumbnailView::ThumbnailModel::warmScaledPixmaps()
+{
+    // Do only a few at a time, so scrolling stays responsive:
+    for ( int i = 0; i < WARM_PIXMAPS_PER_ITERATION && !m_warmQueue.isEmpty(); ) {
+        const int row = m_warmQueue.dequeue();
+        if ( !thumbnailStillNeeded( row ) )
+            continue;
+
+        const DB::FileName fileName = m_displayList.at( row );
+        if ( m_scaledPixmapCache.contains( fileName ) || !ImageManager::ThumbnailCache::instance()->contains( fileName ) )
             continue;
-        const_cast<ThumbnailView::ThumbnailModel*>(this)->requestThumbnail( fileName, ImageManager::ThumbnailInvisible );
+        (void) pixmap( fileName );
+        ++i;
     }
+
+    if ( !m_warmQueue.isEmpty() )
+        m_warmTimer->start( 0 );
 }
 
 // vi:expandtab:tabstop=4 shiftwidth=4:
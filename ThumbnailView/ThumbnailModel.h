@@ -24,9 +24,13 @@
 #include "ThumbnailView/enums.h"
 #include "DB/ImageInfo.h"
 #include "enums.h"
+#include <QCache>
 #include <QPixmap>
+#include <QQueue>
 #include <DB/FileNameList.h>
 
+class QTimer;
+
 namespace ThumbnailView
 {
 class ThumbnailFactory;
@@ -81,6 +85,12 @@ public:
     void updateIndexCache();
     void setSortDirection( SortDirection );
     QPixmap pixmap( const DB::FileName& fileName ) const;
+    /**
+     * @brief setScrollSpeed tells the model how fast the user is scrolling.
+     * A positive speed means scrolling towards the end of the list.
+     * The speed determines how far ahead thumbnails are loaded.
+     */
+    void setScrollSpeed( double linesPerSecond );
 
 public slots:
     void updateVisibleRowInfo();
@@ -93,10 +103,14 @@ signals:
 
 private: // Methods
     void requestThumbnail( const DB::FileName& mediaId, const ImageManager::Priority priority );
-    void preloadThumbnails();
+    void updatePrefetchWindow();
+    void prefetchRows( int from, int to, ImageManager::Priority priority, int oldFirst, int oldLast );
 
 private slots:
     void imagesDeletedFromDB( const DB::FileNameList& );
+    void thumbnailUpdated( const DB::FileName& );
+    void clearScaledPixmapCache();
+    void warmScaledPixmaps();
 
 
 private: // Instance variables.
@@ -142,11 +156,36 @@ private: // Instance variables.
     int m_firstVisibleRow;
     int m_lastVisibleRow;
 
+    /**
+     * The rows for which thumbnails are loaded: the visible rows, plus a few screens
+     * in the direction the user is scrolling to, and a screen in the other direction.
+     * Requests for rows outside of this window are dropped by the AsyncLoader.
+     */
+    int m_prefetchFirstRow;
+    int m_prefetchLastRow;
+    double m_scrollSpeed;
+    /// rows ahead whose thumbnails are cached, but not yet scaled for painting
+    QQueue<int> m_warmQueue;
+    QTimer* m_warmTimer;
+
     DB::FileName m_overrideFileName;
     QPixmap m_overrideImage;
     // placeholder pixmaps to be displayed before thumbnails are loaded:
     QPixmap m_ImagePlaceholder;
     QPixmap m_VideoPlaceholder;
+
+    /**
+     * Thumbnails scaled to the current grid size, ready to be painted.
+     * The cost of an entry is its size in KiB.
+     */
+    struct ScaledPixmap
+    {
+        QPixmap pixmap;
+        int angle;
+    };
+    mutable QCache<DB::FileName, ScaledPixmap> m_scaledPixmapCache;
+    mutable QSize m_scaledPixmapSize;
+    QSize m_placeholderSize;
 };
 
 }
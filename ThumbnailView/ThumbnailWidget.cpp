@@ -50,6 +50,11 @@
  */
 using Utilities::StringSet;
 
+namespace {
+// scroll events further apart than this are considered to be a new scroll movement:
+const int SCROLL_PAUSE_MS = 300;
+}
+
 ThumbnailView::ThumbnailWidget::ThumbnailWidget( ThumbnailFactory* factory)
     :QListView(),
      ThumbnailComponent( factory ),
@@ -91,10 +96,44 @@ ThumbnailView::ThumbnailWidget::ThumbnailWidget( ThumbnailFactory* factory)
 
     setDragEnabled(false); // We run our own dragging, so disable QListView's version.
 
-    connect( verticalScrollBar(), SIGNAL(valueChanged(int)), model(), SLOT(updateVisibleRowInfo()) );
+    m_lastScrollValue = verticalScrollBar()->value();
+    m_scrollSpeed = 0;
+    m_lastScrollTime.start();
+    m_scrollStopTimer = new QTimer(this);
+    m_scrollStopTimer->setSingleShot(true);
+    m_scrollStopTimer->setInterval( SCROLL_PAUSE_MS );
+    connect( m_scrollStopTimer, SIGNAL(timeout()), this, SLOT(scrollStopped()) );
+    connect( verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(scrollPositionChanged(int)) );
     setupDateChangeTimer();
 }
 
+void ThumbnailView::ThumbnailWidget::scrollPositionChanged( int value )
+{
+    const int elapsed = m_lastScrollTime.restart();
+    const int cellHeight = cellGeometryInfo()->cellSize().height();
+    if ( elapsed > 0 && elapsed < SCROLL_PAUSE_MS && cellHeight > 0 ) {
+        const double linesPerSecond = double( value - m_lastScrollValue ) / cellHeight * 1000.0 / elapsed;
+        // smooth out the jitter of individual scroll events:
+        m_scrollSpeed = 0.7 * m_scrollSpeed + 0.3 * linesPerSecond;
+    } else {
+        // only the direction is known for the first event of a movement, so assume slow scrolling:
+        m_scrollSpeed = ( value >= m_lastScrollValue ) ? 1.0 : -1.0;
+    }
+    m_lastScrollValue = value;
+
+    model()->setScrollSpeed( m_scrollSpeed );
+    model()->updateVisibleRowInfo();
+    m_scrollStopTimer->start();
+}
+
+void ThumbnailView::ThumbnailWidget::scrollStopped()
+{
+    // Without this, the speed of the last movement would keep the model preloading far ahead while the view stands still:
+    m_scrollSpeed = 0;
+    model()->setScrollSpeed( m_scrollSpeed );
+    model()->updateVisibleRowInfo();
+}
+
 bool ThumbnailView::ThumbnailWidget::isGridResizing() const
 {
     return m_mouseHandler->isResizingGrid() || m_wheelResizing || m_externallyResizing;
@@ -25,6 +25,7 @@
 #include "SelectionInteraction.h"
 #include "ThumbnailView/enums.h"
 #include <QScopedPointer>
+#include <QTime>
 #include "VideoThumbnailCycler.h"
 
 class QTimer;
@@ -102,6 +103,8 @@ private slots:
     void emitDateChange();
     void scheduleDateChangeSignal();
     void emitSelectionChangedSignal();
+    void scrollPositionChanged( int value );
+    void scrollStopped();
 
 private:
     friend class GridResizeInteraction;
@@ -143,6 +146,15 @@ private:
     friend class ThumbnailModel;
     KeyboardEventHandler* m_keyboardHandler;
     QScopedPointer<VideoThumbnailCycler> m_videoThumbnailCycler;
+
+    /**
+     * Used to estimate how fast the user is scrolling, so the model can load thumbnails far enough ahead.
+     */
+    QTime m_lastScrollTime;
+    int m_lastScrollValue;
+    double m_scrollSpeed;
+    /// resets the scroll speed once scrolling has stopped
+    QTimer* m_scrollStopTimer;
 };
 
 }
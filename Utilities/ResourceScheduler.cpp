@@ -0,0 +1,169 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ResourceScheduler.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+
+#ifndef Q_OS_WIN
+#include <sys/stat.h>
+#endif
+
+Utilities::ResourceScheduler::Token::Token()
+    : m_priority(Background), m_device(-1), m_valid(false)
+{
+}
+
+bool Utilities::ResourceScheduler::Token::isValid() const
+{
+    return m_valid;
+}
+
+Utilities::ResourceScheduler::ResourceScheduler()
+    : m_cpuSlots( qMax( 1, QThread::idealThreadCount() ) )
+{
+    m_cpuUsed[Foreground] = 0;
+    m_cpuUsed[Background] = 0;
+}
+
+Utilities::ResourceScheduler* Utilities::ResourceScheduler::instance()
+{
+    // The loader threads may ask for the scheduler, so make sure it is created in a thread-safe manner:
+    static ResourceScheduler scheduler;
+    return &scheduler;
+}
+
+int Utilities::ResourceScheduler::cpuSlots() const
+{
+    return m_cpuSlots;
+}
+
+Utilities::ResourceScheduler::Token Utilities::ResourceScheduler::tryAcquire( Priority priority, const QString& path, bool* ioBlocked )
+{
+    const qint64 device = path.isEmpty() ? -1 : deviceFor( path );
+    QMutexLocker locker( &m_lock );
+    if ( ioBlocked )
+        *ioBlocked = false;
+
+    if ( priority == Foreground ) {
+        if ( m_cpuUsed[Foreground] >= m_cpuSlots )
+            return Token();
+        if ( device != -1 && m_ioUsed[Foreground].value( device ) >= IOSLOTS ) {
+            if ( ioBlocked )
+                *ioBlocked = true;
+            return Token();
+        }
+    } else {
+        const int backgroundSlots = qMax( 1, m_cpuSlots - 1 );
+        if ( m_cpuUsed[Foreground] + m_cpuUsed[Background] >= backgroundSlots )
+            return Token();
+        if ( device != -1 && m_ioUsed[Foreground].value( device ) + m_ioUsed[Background].value( device ) >= IOSLOTS ) {
+            if ( ioBlocked )
+                *ioBlocked = true;
+            return Token();
+        }
+    }
+
+    ++m_cpuUsed[priority];
+    if ( device != -1 )
+        ++m_ioUsed[priority][device];
+
+    Token token;
+    token.m_priority = priority;
+    token.m_device = device;
+    token.m_valid = true;
+    return token;
+}
+
+void Utilities::ResourceScheduler::release( Token& token )
+{
+    if ( !token.m_valid )
+        return;
+
+    {
+        QMutexLocker locker( &m_lock );
+        --m_cpuUsed[token.m_priority];
+        if ( token.m_device != -1 && --m_ioUsed[token.m_priority][token.m_device] == 0 )
+            m_ioUsed[token.m_priority].remove( token.m_device );
+    }
+    token.m_valid = false;
+    token.m_device = -1;
+    notifyListeners();
+}
+
+void Utilities::ResourceScheduler::releaseIO( Token& token )
+{
+    if ( !token.m_valid || token.m_device == -1 )
+        return;
+
+    {
+        QMutexLocker locker( &m_lock );
+        if ( --m_ioUsed[token.m_priority][token.m_device] == 0 )
+            m_ioUsed[token.m_priority].remove( token.m_device );
+    }
+    token.m_device = -1;
+    notifyListeners();
+}
+
+void Utilities::ResourceScheduler::notifyListeners()
+{
+    QList< std::function<void()> > listeners;
+    {
+        QMutexLocker locker( &m_lock );
+        listeners = m_listeners;
+    }
+
+    // The listeners may take their own locks, which must never be done while holding ours.
+    for ( const auto& listener : listeners )
+        listener();
+}
+
+void Utilities::ResourceScheduler::addReleaseListener( const std::function<void()>& listener )
+{
+    QMutexLocker locker( &m_lock );
+    m_listeners.append( listener );
+}
+
+qint64 Utilities::ResourceScheduler::deviceFor( const QString& path )
+{
+    const QString directory = QFileInfo( path ).absolutePath();
+    {
+        QMutexLocker locker( &m_lock );
+        QHash<QString, qint64>::const_iterator it = m_devices.constFind( directory );
+        if ( it != m_devices.constEnd() )
+            return it.value();
+    }
+
+    // A stalled mount must only block the caller asking for it, so stat() without holding the lock.
+    qint64 device = 0;
+#ifndef Q_OS_WIN
+    struct stat info;
+    if ( ::stat( QFile::encodeName( directory ).constData(), &info ) == 0 )
+        device = static_cast<qint64>( info.st_dev );
+#endif
+    // Browsing through many directories must not make the cache grow without bounds.
+    // Starting over is cheap: it is refilled with one stat() per directory.
+    QMutexLocker locker( &m_lock );
+    if ( m_devices.count() >= MAX_CACHED_DEVICES )
+        m_devices.clear();
+    m_devices.insert( directory, device );
+    return device;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,117 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef UTILITIES_RESOURCESCHEDULER_H
+#define UTILITIES_RESOURCESCHEDULER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <functional>
+
+namespace Utilities
+{
+
+/**
+   \brief Hands out CPU and disk I/O slots to the threads doing heavy work.
+
+   The image loader threads (\ref ImageManager::AsyncLoader) and the background jobs
+   (\ref BackgroundTaskManager::JobManager) acquire a \ref Token from the scheduler before they start
+   decoding an image or running a job, and release it when done. A token stands for one CPU slot
+   and, if a path is given, one I/O slot on the device the path is stored on. Work that is done
+   reading before it is done computing gives back the I/O slot early with \ref releaseIO.
+
+   There is one CPU slot per core, and \ref IOSLOTS slots per device, so work on different disks
+   does not wait for each other, while a single disk is not hit by more readers than it can serve.
+
+   Foreground work (what the user is looking at right now) preempts background work: foreground tokens
+   only compete with other foreground tokens, so running background work never blocks them, while
+   background tokens count all tokens and leave one CPU slot to the foreground.
+   The threads doing background work run at idle priority, so the operating system gives the CPU
+   to the foreground work while both are running.
+
+   The scheduler is thread-safe. Blocked callers can register a listener with \ref addReleaseListener
+   to learn when it is worth trying again.
+**/
+class ResourceScheduler
+{
+public:
+    enum Priority { Foreground, Background };
+
+    class Token
+    {
+    public:
+        Token();
+        bool isValid() const;
+    private:
+        friend class ResourceScheduler;
+        Priority m_priority;
+        qint64 m_device;
+        bool m_valid;
+    };
+
+    static ResourceScheduler* instance();
+
+    /**
+     * @brief cpuSlots is the number of threads that may do CPU bound work at the same time.
+     */
+    int cpuSlots() const;
+
+    /**
+     * @brief tryAcquire returns a valid token if there are enough resources for work of the given priority.
+     * @param path the file the work reads, or an empty string if the work does not do any I/O worth scheduling.
+     * @param ioBlocked if given, it is set when a CPU slot was available, but no I/O slot on the device of the path,
+     * i.e. when work on another device might still get a token.
+     */
+    Token tryAcquire( Priority priority, const QString& path = QString(), bool* ioBlocked = nullptr );
+    void release( Token& token );
+    /**
+     * @brief releaseIO gives back the I/O slot of the token, while keeping its CPU slot.
+     */
+    void releaseIO( Token& token );
+
+    /**
+     * @brief addReleaseListener registers a function which is called whenever a token is released.
+     * The function is called on the thread that releases the token, without any locks held.
+     */
+    void addReleaseListener( const std::function<void()>& listener );
+
+private:
+    ResourceScheduler();
+    // takes m_lock itself, so it must be called without holding it:
+    qint64 deviceFor( const QString& path );
+    void notifyListeners();
+
+    enum { IOSLOTS = 2 };
+    // the number of directories whose device is remembered at most:
+    enum { MAX_CACHED_DEVICES = 1024 };
+
+    mutable QMutex m_lock;
+    const int m_cpuSlots;
+    int m_cpuUsed[2];
+    QHash<qint64, int> m_ioUsed[2];
+    // cache of the device of each directory, to save a stat() per file:
+    QHash<QString, qint64> m_devices;
+    QList< std::function<void()> > m_listeners;
+};
+
+}
+
+#endif /* UTILITIES_RESOURCESCHEDULER_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
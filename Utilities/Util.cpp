@@ -45,6 +45,7 @@
 
 extern "C" {
 #include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -508,6 +509,8 @@ extern "C"
 namespace Utilities
 {
     bool loadJPEG(QImage *img, FILE* inputFile, QSize* fullSize, int dim );
+    bool loadJPEGRegion( QImage* img, FILE* inputFile, QSize* fullSize, const QRect& region, int scaleDenominator,
+                         const std::function<void()>& skipped );
 }
 
 bool Utilities::loadJPEG(QImage *img, const DB::FileName& imageFile, QSize* fullSize, int dim)
@@ -520,6 +523,18 @@ bool Utilities::loadJPEG(QImage *img, const DB::FileName& imageFile, QSize* full
     return ok;
 }
 
+bool Utilities::loadJPEG(QImage *img, const QByteArray& data, QSize* fullSize, int dim)
+{
+    if ( data.isEmpty() )
+        return false;
+    FILE* inputFile = fmemopen( const_cast<char*>( data.constData() ), data.size(), "rb" );
+    if(!inputFile)
+        return false;
+    bool ok = loadJPEG( img, inputFile, fullSize, dim );
+    fclose(inputFile);
+    return ok;
+}
+
 bool Utilities::loadJPEG(QImage *img, FILE* inputFile, QSize* fullSize, int dim )
 {
     struct jpeg_decompress_struct    cinfo;
@@ -610,6 +625,114 @@ bool Utilities::loadJPEG(QImage *img, FILE* inputFile, QSize* fullSize, int dim
     return true;
 }
 
+bool Utilities::loadJPEGRegion( QImage* img, const DB::FileName& imageFile, QSize* fullSize, const QRect& region, int scaleDenominator,
+                                const std::function<void()>& skipped )
+{
+    FILE* inputFile=fopen( QFile::encodeName(imageFile.absolute()), "rb");
+    if(!inputFile)
+        return false;
+    bool ok = loadJPEGRegion( img, inputFile, fullSize, region, scaleDenominator, skipped );
+    fclose(inputFile);
+    return ok;
+}
+
+bool Utilities::loadJPEGRegion( QImage* img, FILE* inputFile, QSize* fullSize, const QRect& region, int scaleDenominator,
+                                const std::function<void()>& skipped )
+{
+    struct jpeg_decompress_struct    cinfo;
+    struct myjpeg_error_mgr jerr;
+    QVector<uchar> lineBuffer;
+
+    cinfo.err             = jpeg_std_error(&jerr);
+    cinfo.err->error_exit = myjpeg_error_exit;
+
+    if (setjmp(jerr.setjmp_buffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, inputFile);
+    jpeg_read_header(&cinfo, TRUE);
+    *fullSize = QSize( cinfo.image_width, cinfo.image_height );
+
+    // CMYK images are left to the full image decoder.
+    if ( cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK ) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    cinfo.out_color_space = ( cinfo.jpeg_color_space == JCS_GRAYSCALE ) ? JCS_GRAYSCALE : JCS_RGB;
+
+    // libjpeg can scale by 1/2, 1/4 and 1/8 while decoding
+    cinfo.scale_num=1;
+    cinfo.scale_denom=qBound( 1, scaleDenominator, 8 );
+
+    jpeg_start_decompress(&cinfo);
+
+    // Map the region to the pixels of the scaled output.
+    const QRect clipped = region & QRect( 0, 0, cinfo.image_width, cinfo.image_height );
+    const double sx = double( cinfo.output_width ) / cinfo.image_width;
+    const double sy = double( cinfo.output_height ) / cinfo.image_height;
+    const int x0 = floor( clipped.left() * sx );
+    const int y0 = floor( clipped.top() * sy );
+    const int x1 = qMin<int>( cinfo.output_width, ceil( ( clipped.right() + 1 ) * sx ) );
+    const int y1 = qMin<int>( cinfo.output_height, ceil( ( clipped.bottom() + 1 ) * sy ) );
+    if ( clipped.isEmpty() || x1 <= x0 || y1 <= y0 ) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    *img = QImage( x1 - x0, y1 - y0, QImage::Format_RGB32 );
+    if ( img->isNull() ) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    JDIMENSION xOffset = 0;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && LIBJPEG_TURBO_VERSION_NUMBER >= 1005000
+    // Only decode the columns we need (rounded to whole iMCUs by libjpeg),
+    // and skip the rows above the region without decoding them.
+    xOffset = x0;
+    JDIMENSION cropWidth = x1 - x0;
+    jpeg_crop_scanline( &cinfo, &xOffset, &cropWidth );
+    if ( y0 > 0 )
+        jpeg_skip_scanlines( &cinfo, y0 );
+#endif
+    bool skippedReported = false;
+
+    // Decode one line at a time, so memory use is bounded by the region.
+    lineBuffer.resize( cinfo.output_width * cinfo.output_components );
+    JSAMPROW line = lineBuffer.data();
+    const int skip = ( x0 - xOffset ) * cinfo.output_components;
+    while ( (int) cinfo.output_scanline < y1 ) {
+        const int y = cinfo.output_scanline;
+        jpeg_read_scanlines( &cinfo, &line, 1 );
+        if ( y < y0 )
+            continue;
+        if ( !skippedReported ) {
+            skippedReported = true;
+            if ( skipped )
+                skipped();
+        }
+
+        const uchar* in = line + skip;
+        QRgb* out = (QRgb*)( img->scanLine( y - y0 ) );
+        if ( cinfo.output_components == 3 ) {
+            for ( int i = 0; i < img->width(); ++i, in += 3 )
+                out[i] = qRgb( in[0], in[1], in[2] );
+        }
+        else {
+            for ( int i = 0; i < img->width(); ++i, ++in )
+                out[i] = qRgb( in[0], in[0], in[0] );
+        }
+    }
+
+    // The rows below the region are not needed, so don't finish decompression.
+    jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
 bool Utilities::isJPEG( const DB::FileName& fileName )
 {
     QString format= QString::fromLocal8Bit( QImageReader::imageFormat( fileName.relative() ) );
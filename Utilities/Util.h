@@ -28,6 +28,7 @@
 #include "DB/ImageInfoList.h"
 #include <stdio.h>
 #include "DB/MD5.h"
+#include <functional>
 
 namespace DB
 {
@@ -54,6 +55,11 @@ bool isRAW( const DB::FileName& fileName );
 QString locateDataFile(const QString& fileName);
 QString readFile( const QString& fileName );
 bool loadJPEG(QImage *img, const DB::FileName& imageFile, QSize* fullSize, int dim=-1);
+// skipped is called once the rows above the region are read; only the region itself is read from the file after that.
+bool loadJPEGRegion( QImage* img, const DB::FileName& imageFile, QSize* fullSize, const QRect& region, int scaleDenominator,
+                     const std::function<void()>& skipped = std::function<void()>() );
+// the same as loadJPEG(), for a JPEG file that was read into memory already:
+bool loadJPEG(QImage *img, const QByteArray& data, QSize* fullSize, int dim=-1);
 bool isJPEG( const DB::FileName& fileName );
 
 QString stripEndingForwardSlash( const QString& fileName );
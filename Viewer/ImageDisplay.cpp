@@ -17,6 +17,8 @@
 */
 
 #include "ImageDisplay.h"
+#include "ViewPreloadRequest.h"
+#include "ViewTileRequest.h"
 #include <qpainter.h>
 #include <QPaintEvent>
 #include <QResizeEvent>
@@ -30,7 +32,9 @@
 #include <qapplication.h>
 #include <math.h>
 #include "DB/ImageDB.h"
+#include "Utilities/Util.h"
 #include <qtimer.h>
+#include <QThread>
 #include <QDebug>
 
 /**
@@ -67,12 +71,31 @@
 
    To propagate the cache, we need to know which direction the
    images are viewed in, which is the job of the instance variable _forward.
+
+   The preloader keeps a window of decoded images around the current one,
+   mostly ahead in viewing direction. The window is sized so that the
+   images arrive before they are needed: it grows when loading an image
+   takes longer than the time the user (or the slideshow) spends on each
+   image, and it is capped by the viewer cache size setting. Several
+   images are requested in parallel, and requests that fall out of the
+   window are dropped by the loader.
 */
 
+namespace
+{
+// Edge length of a deep zoom tile, in decoded pixels
+const int TILESIZE = 512;
+}
+
 Viewer::ImageDisplay::ImageDisplay( QWidget* parent)
-    :AbstractDisplay( parent ), m_reloadImageInProgress( false ), m_forward(true), m_curIndex(0),m_busy( false ),
+    :AbstractDisplay( parent ), m_cacheBytes(0), m_imageCount(0), m_preloadAhead(1), m_preloadBehind(0),
+    m_slideShowInterval(0), m_lastPreloadFinished(0), m_lastNavigation(-1),
+    m_averageLoadTime(300), m_navigationInterval(1000), m_averageFrameBytes(0),
+    m_tiled(false), m_tileGeneration(0), m_tileLevel(0),
+    m_reloadImageInProgress( false ), m_forward(true), m_curIndex(0),m_busy( false ),
     m_cursorHiding(true)
 {
+    m_clock.start();
     m_viewHandler = new ViewHandler( this );
 
     setMouseTracking( true );
@@ -146,7 +169,7 @@ void Viewer::ImageDisplay::mouseReleaseEvent( QMouseEvent* event )
     enableCursorHiding();
     showCursor();
 
-    m_cache.remove( m_curIndex );
+    removeFromCache( m_curIndex );
     QMouseEvent e( event->type(), mapPos( event->pos() ), event->button(), event->buttons(), event->modifiers() );
     double ratio = sizeRatio( QSize(m_zEnd.x()-m_zStart.x(), m_zEnd.y()-m_zStart.y()), size() );
     bool block = m_viewHandler->mouseReleaseEvent( &e, event->pos(), ratio );
@@ -161,21 +184,24 @@ bool Viewer::ImageDisplay::setImage( DB::ImageInfoPtr info, bool forward )
 {
     m_info = info;
     m_loadedImage = QImage();
+    resetTiles();
 
-    // Find the index of the current image
-    m_curIndex = 0;
-    Q_FOREACH( const DB::FileName &filename, m_imageList) {
-        if ( filename == info->fileName() )
-            break;
-        ++m_curIndex;
-    }
+    m_curIndex = indexOf( info->fileName() );
+
+    // Track how fast the user is moving through the images. Long pauses
+    // are capped so that a single break doesn't shrink the window for good.
+    const qint64 now = m_clock.elapsed();
+    if ( m_lastNavigation >= 0 )
+        m_navigationInterval = 0.7 * m_navigationInterval + 0.3 * qMin<qint64>( now - m_lastNavigation, 5000 );
+    m_lastNavigation = now;
 
     if ( m_cache.contains(m_curIndex) && m_cache[m_curIndex].angle == info->angle()) {
         const ViewPreloadInfo& found = m_cache[m_curIndex];
         m_loadedImage = found.img;
+        info->setSize( found.size );
+        updateTiledMode();
         updateZoomPoints( Settings::SettingsData::instance()->viewerStandardSize(), found.img.size() );
         cropAndScale();
-        info->setSize( found.size );
         emit imageReady();
     }
     else {
@@ -191,7 +217,7 @@ bool Viewer::ImageDisplay::setImage( DB::ImageInfoPtr info, bool forward )
 void Viewer::ImageDisplay::resizeEvent( QResizeEvent* event )
 {
     ImageManager::AsyncLoader::instance()->stop( this, ImageManager::StopOnlyNonPriorityLoads );
-    m_cache.clear();
+    clearCache();
     if ( m_info ) {
         cropAndScale();
         if ( event->size().width() > 1.5*this->m_loadedImage.size().width() || event->size().height() > 1.5*this->m_loadedImage.size().height() )
@@ -223,7 +249,7 @@ QPoint Viewer::ImageDisplay::offset( int logicalWidth, int logicalHeight, int ph
 
 void Viewer::ImageDisplay::zoom( QPoint p1, QPoint p2 )
 {
-    m_cache.remove( m_curIndex );
+    removeFromCache( m_curIndex );
     normalize( p1, p2 );
 
     double ratio;
@@ -312,7 +338,10 @@ void Viewer::ImageDisplay::cropAndScale()
         return;
     }
 
-    if ( m_zStart != QPoint(0,0) || m_zEnd != QPoint( m_loadedImage.width(), m_loadedImage.height() ) ) {
+    if ( m_tiled && composeTiles() ) {
+        // m_croppedAndScaledImg now holds the zoom window, composed from tiles.
+    }
+    else if ( m_zStart != QPoint(0,0) || m_zEnd != QPoint( m_loadedImage.width(), m_loadedImage.height() ) ) {
         m_croppedAndScaledImg = m_loadedImage.copy( m_zStart.x(), m_zStart.y(), m_zEnd.x() - m_zStart.x(), m_zEnd.y() - m_zStart.y() );
     }
     else
@@ -524,6 +553,21 @@ void Viewer::ImageDisplay::pixmapLoaded(ImageManager::ImageRequest* request, con
     const int angle = request->angle();
     const bool loadedOK = request->loadedOK();
 
+    if ( dynamic_cast<ViewTileRequest*>( request ) ) {
+        tileLoaded( request, image );
+        return;
+    }
+
+    ViewPreloadRequest* preloadRequest = dynamic_cast<ViewPreloadRequest*>( request );
+    if ( preloadRequest && m_pendingPreloads.contains( preloadRequest->index() ) ) {
+        // With several requests in flight, the time between two finished
+        // loads approximates the time it takes us to provide one image.
+        const qint64 now = m_clock.elapsed();
+        const qint64 loadTime = now - qMax( m_pendingPreloads.take( preloadRequest->index() ).started, m_lastPreloadFinished );
+        m_averageLoadTime = 0.7 * m_averageLoadTime + 0.3 * loadTime;
+        m_lastPreloadFinished = now;
+    }
+
     if ( loadedOK && fileName == m_info->fileName() ) {
         if ( fullSize.isValid() && !m_info->size().isValid() )
             m_info->setSize( fullSize );
@@ -544,40 +588,144 @@ void Viewer::ImageDisplay::pixmapLoaded(ImageManager::ImageRequest* request, con
         }
 
         m_loadedImage = image;
+        updateTiledMode();
         cropAndScale();
         emit imageReady();
     }
     else {
-        if ( imgSize != size() )
-            return; // Might be an old preload version, or a loaded version that never made it in time
+        if ( imgSize != requestedSize() ) {
+            // Might be an old preload version, or a loaded version that never made it in time
+            updatePreload();
+            return;
+        }
 
-        ViewPreloadInfo info( image, fullSize, angle );
-        m_cache.insert( indexOf(fileName), info );
+        const int index = indexOf( fileName );
+        if ( index >= 0 ) {
+            if ( loadedOK )
+                insertIntoCache( index, ViewPreloadInfo( image, fullSize, angle ) );
+            else if ( preloadRequest )
+                // Don't try a broken image over and over again.
+                m_failedPreloads.insert( index );
+        }
         updatePreload();
     }
     unbusy();
     emit possibleChange();
 }
 
+void Viewer::ImageDisplay::requestCanceled()
+{
+    // Preloads are only canceled once they fell out of the preload window.
+    updatePreload();
+}
+
 void Viewer::ImageDisplay::setImageList( const DB::FileNameList& list )
 {
+    ImageManager::AsyncLoader::instance()->stop( this, ImageManager::StopOnlyNonPriorityLoads );
     m_imageList = list;
-    m_cache.clear();
+    m_imageCount = list.count();
+    m_indexMap.clear();
+    m_indexMap.reserve( m_imageCount );
+    for ( int i = 0; i < m_imageCount; ++i ) {
+        // The first occurrence wins, just like a linear search would.
+        if ( !m_indexMap.contains( list[i] ) )
+            m_indexMap.insert( list[i], i );
+    }
+    clearCache();
+}
+
+void Viewer::ImageDisplay::setSlideShowInterval( int msecs )
+{
+    m_slideShowInterval = msecs;
+    updatePreload();
+}
+
+/**
+ * Return how many steps ahead of the current image (in viewing direction) the image at \p index is.
+ * Images behind the current one have a negative distance.
+ */
+int Viewer::ImageDisplay::preloadDistance( int index ) const
+{
+    int distance = m_forward ? index - m_curIndex : m_curIndex - index;
+    // The slideshow starts over at the first image after the last one.
+    if ( m_slideShowInterval > 0 && distance < -m_preloadBehind )
+        distance += m_imageCount;
+    return distance;
+}
+
+/**
+ * Is the image at \p index still within the preload window?
+ */
+bool Viewer::ImageDisplay::preloadStillNeeded( int index ) const
+{
+    const int distance = preloadDistance( index );
+    return distance >= -m_preloadBehind && distance <= m_preloadAhead;
+}
+
+qint64 Viewer::ImageDisplay::cacheBudget() const
+{
+    return Settings::SettingsData::instance()->viewerCacheSize() * 1024LL * 1024LL;
+}
+
+/**
+ * The part of the viewer cache that is not taken up by deep zoom tiles.
+ */
+qint64 Viewer::ImageDisplay::preloadBudget() const
+{
+    return qMax<qint64>( 0, cacheBudget() - m_tiles.totalCost() * 1024LL );
+}
+
+void Viewer::ImageDisplay::updatePreloadWindow()
+{
+    // Estimate the size of a decoded image from what we have loaded so far,
+    // and fall back to the window size at 4 bytes per pixel.
+    const double frameBytes = m_averageFrameBytes > 0 ? m_averageFrameBytes : qMax( 1, width() * height() * 4 );
+    const int budgetFrames = (int) qMin<qint64>( m_imageCount, preloadBudget() / frameBytes );
+
+    // Number of images the user moves past while we load a single one. Keep
+    // twice that many ahead, so a slow image doesn't leave a blank screen.
+    const double interval = m_slideShowInterval > 0 ? m_slideShowInterval : qMax( 50.0, m_navigationInterval );
+    const int needed = 2 * (int) ceil( m_averageLoadTime / interval ) + 1;
+
+    // Keep the previous image around while browsing, people tend to go back one image.
+    const int behind = ( m_slideShowInterval > 0 ) ? 0 : 1;
+    m_preloadAhead = qBound( 0, needed, budgetFrames - 1 - behind );
+    m_preloadBehind = qBound( 0, behind, budgetFrames - 1 - m_preloadAhead );
 }
 
 void Viewer::ImageDisplay::updatePreload()
 {
-    // cacheSize: number of images at current window dimensions (at 4 byte per pixel)
-    const int cacheSize = (int)
-            ((long long) ( Settings::SettingsData::instance()->viewerCacheSize() * 1024LL * 1024LL ) / (width()*height()*4));
-    bool cacheFull = (m_cache.count() > cacheSize);
+    updatePreloadWindow();
+
+    // Requests outside the window are dropped by the image loader.
+    for ( QHash<int,PendingPreload>::iterator it = m_pendingPreloads.begin(); it != m_pendingPreloads.end(); ) {
+        if ( preloadStillNeeded( it.key() ) )
+            ++it;
+        else {
+            it->needed->fetchAndStoreRelease( 0 );
+            it = m_pendingPreloads.erase( it );
+        }
+    }
+    trimCache();
+
+    if ( m_curIndex < 0 || m_curIndex >= m_imageCount )
+        return;
 
-    int incr = ( m_forward ? 1 : -1 );
-    int nextOnesInCache = 0;
-    // Iterate from the current image in the direction of the viewing
-    for ( int i = m_curIndex+incr; cacheSize ; i += incr ) {
-        if ( m_forward ? ( i >= (int) m_imageList.count() ) : (i < 0) )
-            break;
+    // Keep as many requests in flight as the image loader has threads.
+    const int maxParallel = qMax( 1, qMin( 3, QThread::idealThreadCount() ) );
+
+    // Walk the window from the current image outwards, first ahead and then behind.
+    const int windowSize = m_preloadAhead + m_preloadBehind;
+    for ( int step = 1; step <= windowSize && m_pendingPreloads.count() < maxParallel; ++step ) {
+        const int distance = ( step <= m_preloadAhead ) ? step : m_preloadAhead - step;
+        int i = m_curIndex + ( m_forward ? distance : -distance );
+        if ( m_slideShowInterval > 0 )
+            i = ( i % m_imageCount + m_imageCount ) % m_imageCount;
+        else if ( i < 0 || i >= m_imageCount )
+            continue;
+
+        if ( i == m_curIndex || m_cache.contains(i) || m_pendingPreloads.contains(i) || m_failedPreloads.contains(i) )
+            continue;
 
         DB::ImageInfoPtr info = DB::ImageDB::instance()->info(m_imageList[i]);
         if ( !info ) {
@@ -585,57 +733,73 @@ void Viewer::ImageDisplay::updatePreload()
             return;
         }
 
-        if ( m_cache.contains(i) ) {
-            nextOnesInCache++;
-            if ( nextOnesInCache >= ceil(cacheSize/2.0) && cacheFull ) {
-                // Ok enough images in cache
-                return;
-            }
-        }
-        else {
-            requestImage( info );
-
-            if ( cacheFull ) {
-                // The cache was full, we need to delete an item from the cache.
-
-                // First try to find an item from the direction we came from
-                for ( int j = ( m_forward ? 0 : m_imageList.count() -1 );
-                      j != m_curIndex;
-                      j += ( m_forward ? 1 : -1 ) ) {
-                    if ( m_cache.contains(j) ) {
-                        m_cache.remove(j);
-                        return;
-                    }
-                }
-
-                // OK We found no item in the direction we came from (think of home/end keys)
-                for ( int j = ( m_forward ? m_imageList.count() -1 : 0 );
-                      j != m_curIndex;
-                      j += ( m_forward ? -1 : 1 ) ) {
-                    if ( m_cache.contains(j) ) {
-                        m_cache.remove(j);
-                        return;
-                    }
-                }
-
-                Q_ASSERT( false ); // We should never get here.
-            }
+        PendingPreload preload;
+        preload.started = m_clock.elapsed();
+        preload.needed = QSharedPointer<QAtomicInt>( new QAtomicInt( 1 ) );
+        if ( requestImage( info, false, preload.needed ) )
+            m_pendingPreloads.insert( i, preload );
+    }
+}
 
-            return;
-        }
+void Viewer::ImageDisplay::insertIntoCache( int index, const ViewPreloadInfo& info )
+{
+    removeFromCache( index );
+    m_cache.insert( index, info );
+
+    const int bytes = info.img.byteCount();
+    m_cacheBytes += bytes;
+    m_averageFrameBytes = ( m_averageFrameBytes > 0 ) ? 0.7 * m_averageFrameBytes + 0.3 * bytes : bytes;
+    trimCache();
+}
+
+void Viewer::ImageDisplay::removeFromCache( int index )
+{
+    QMap<int,ViewPreloadInfo>::iterator it = m_cache.find( index );
+    if ( it != m_cache.end() ) {
+        m_cacheBytes -= it->img.byteCount();
+        m_cache.erase( it );
     }
 }
 
+void Viewer::ImageDisplay::clearCache()
+{
+    m_cache.clear();
+    m_cacheBytes = 0;
+    Q_FOREACH( const PendingPreload& preload, m_pendingPreloads ) {
+        preload.needed->fetchAndStoreRelease( 0 );
+    }
+    m_pendingPreloads.clear();
+    m_failedPreloads.clear();
+}
 
-int Viewer::ImageDisplay::indexOf( const DB::FileName& fileName )
+/**
+ * Evict images until the cache fits into the viewer cache size.
+ * Images outside the preload window go first, then the ones farthest away,
+ * where images behind the current one count double.
+ */
+void Viewer::ImageDisplay::trimCache()
 {
-    int i = 0;
-    Q_FOREACH( const DB::FileName &name, m_imageList ) {
-        if ( name == fileName )
-            break;
-        ++i;
+    const qint64 budget = preloadBudget();
+    while ( m_cacheBytes > budget && !m_cache.isEmpty() ) {
+        int victim = -1;
+        qint64 worstRank = -1;
+        for ( QMap<int,ViewPreloadInfo>::const_iterator it = m_cache.constBegin(); it != m_cache.constEnd(); ++it ) {
+            const int distance = preloadDistance( it.key() );
+            qint64 rank = ( distance < 0 ) ? -2LL * distance : distance;
+            if ( !preloadStillNeeded( it.key() ) )
+                rank += 2LL * m_imageCount + 1;
+            if ( rank > worstRank ) {
+                worstRank = rank;
+                victim = it.key();
+            }
+        }
+        removeFromCache( victim );
     }
-    return i;
+}
+
+int Viewer::ImageDisplay::indexOf( const DB::FileName& fileName ) const
+{
+    return m_indexMap.value( fileName, -1 );
 }
 
 void Viewer::ImageDisplay::busy()
@@ -691,6 +855,10 @@ void Viewer::ImageDisplay::updateZoomPoints( const Settings::StandardViewSize ty
 
 void Viewer::ImageDisplay::potentialyLoadFullSize()
 {
+    // In deep zoom mode, cropAndScale() loads the visible tiles instead.
+    if ( m_tiled )
+        return;
+
     if ( m_info->size() != m_loadedImage.size() ) {
         ImageManager::ImageRequest* request = new ImageManager::ImageRequest( m_info->fileName(), QSize(-1,-1), m_info->angle(), this );
         request->setPriority( ImageManager::Viewer );
@@ -713,17 +881,218 @@ double Viewer::ImageDisplay::sizeRatio( const QSize& baseSize, const QSize& newS
     return res;
 }
 
-void Viewer::ImageDisplay::requestImage( const DB::ImageInfoPtr& info, bool priority )
+/**
+ * The size images are requested at. In natural size mode the image is loaded as it is.
+ */
+QSize Viewer::ImageDisplay::requestedSize() const
+{
+    if ( Settings::SettingsData::instance()->viewerStandardSize() == Settings::NaturalSize )
+        return QSize(-1,-1);
+    return size();
+}
+
+bool Viewer::ImageDisplay::requestImage( const DB::ImageInfoPtr& info, bool priority, const QSharedPointer<QAtomicInt>& preloadNeeded )
 {
     Settings::StandardViewSize viewSize = Settings::SettingsData::instance()->viewerStandardSize();
-    QSize s = size();
-    if ( viewSize == Settings::NaturalSize )
-        s = QSize(-1,-1);
+    const QSize s = requestedSize();
 
-    ImageManager::ImageRequest* request = new ImageManager::ImageRequest( info->fileName(), s, info->angle(), this );
+    ImageManager::ImageRequest* request;
+    if ( priority ) {
+        request = new ImageManager::ImageRequest( info->fileName(), s, info->angle(), this );
+        request->setPriority( ImageManager::Viewer );
+    }
+    else
+        request = new ViewPreloadRequest( indexOf( info->fileName() ), info->fileName(), s, info->angle(), this, preloadNeeded );
     request->setUpScale( viewSize == Settings::FullSize );
-    request->setPriority( priority ? ImageManager::Viewer : ImageManager::ViewerPreload );
-    ImageManager::AsyncLoader::instance()->load( request );
+    if ( !ImageManager::AsyncLoader::instance()->load( request ) ) {
+        delete request;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Huge JPEGs are shown in deep zoom mode: The image loaded for the view
+ * (m_loadedImage) stays at the fitted resolution, and zooming in decodes only
+ * the visible tiles, at the smallest libjpeg scale that still provides
+ * enough pixels. Decoding the full image instead would take seconds and
+ * could eat up gigabytes of memory.
+ */
+void Viewer::ImageDisplay::updateTiledMode()
+{
+    m_tiled = false;
+    if ( !m_info || !m_info->size().isValid() || m_loadedImage.isNull() )
+        return;
+
+    // Anything that fits easily into the viewer cache is simply decoded at full size.
+    const QSize fullSize = m_info->size();
+    if ( 4LL * fullSize.width() * fullSize.height() <= cacheBudget() / 2 )
+        return;
+
+    m_tiled = Utilities::isJPEG( m_info->fileName() );
+}
+
+void Viewer::ImageDisplay::resetTiles()
+{
+    ++m_tileGeneration;
+    m_tiled = false;
+    m_tileLevel = 0;
+    m_tileRange = QRect();
+    m_tiles.clear();
+    m_pendingTiles.clear();
+}
+
+bool Viewer::ImageDisplay::tileStillNeeded( int generation, const TileKey& key ) const
+{
+    return generation == m_tileGeneration && key.level == m_tileLevel && m_tileRange.contains( key.column, key.row );
+}
+
+QSize Viewer::ImageDisplay::unrotatedFullSize() const
+{
+    const int angle = ( m_info->angle() + 360 ) % 360;
+    if ( angle == 90 || angle == 270 )
+        return QSize( m_info->size().height(), m_info->size().width() );
+    return m_info->size();
+}
+
+/**
+ * Return the transformation from the pixels of the unrotated image at full
+ * size to the pixels of m_loadedImage, which is rotated and scaled.
+ */
+QTransform Viewer::ImageDisplay::fullSizeToLoadedImage() const
+{
+    QTransform rotation;
+    rotation.rotate( m_info->angle() );
+    const QRectF bounds = rotation.mapRect( QRectF( QPointF(0,0), unrotatedFullSize() ) );
+
+    return rotation
+        * QTransform::fromTranslate( -bounds.left(), -bounds.top() )
+        * QTransform::fromScale( m_loadedImage.width() / bounds.width(), m_loadedImage.height() / bounds.height() );
+}
+
+QRect Viewer::ImageDisplay::tileRegion( const TileKey& key ) const
+{
+    const int span = TILESIZE * key.level;
+    return QRect( key.column * span, key.row * span, span, span ) & QRect( QPoint(0,0), unrotatedFullSize() );
+}
+
+/**
+ * Compose the zoom window into m_croppedAndScaledImg from the tiles we
+ * have, and request the missing ones. Until they arrive, the fitted image
+ * is shown upscaled in their place.
+ * Returns false if the fitted image has enough resolution for the zoom
+ * window, in which case no tiles are needed.
+ */
+bool Viewer::ImageDisplay::composeTiles()
+{
+    const QRect window( m_zStart, QSize( m_zEnd.x() - m_zStart.x(), m_zEnd.y() - m_zStart.y() ) );
+    if ( window.isEmpty() )
+        return false;
+    const QTransform toLoaded = fullSizeToLoadedImage();
+
+    // Screen pixels per pixel of the full size image.
+    const double loadedPerFull = toLoaded.mapRect( QRectF( 0, 0, 1, 1 ) ).width();
+    const double screenPerFull = sizeRatio( window.size(), size() ) * loadedPerFull;
+
+    // Pick the coarsest level that is at most a factor sqrt(2) below the screen resolution.
+    int level = 1;
+    while ( level < 8 && 1.0 / ( 2 * level ) >= screenPerFull / M_SQRT2 )
+        level *= 2;
+
+    if ( loadedPerFull >= 1.0 / level ) {
+        m_tileRange = QRect();
+        m_pendingTiles.clear();
+        return false;
+    }
+
+    const QRect visible = toLoaded.inverted().mapRect( QRectF( window ) ).toAlignedRect() & QRect( QPoint(0,0), unrotatedFullSize() );
+    if ( visible.isEmpty() )
+        return false;
+
+    const int span = TILESIZE * level;
+    const QRect range( QPoint( visible.left() / span, visible.top() / span ), QPoint( visible.right() / span, visible.bottom() / span ) );
+    if ( level != m_tileLevel || range != m_tileRange ) {
+        m_tileLevel = level;
+        m_tileRange = range;
+        // Tiles out of sight are dropped by the image loader.
+        for ( QSet<TileKey>::iterator it = m_pendingTiles.begin(); it != m_pendingTiles.end(); ) {
+            if ( tileStillNeeded( m_tileGeneration, *it ) )
+                ++it;
+            else
+                it = m_pendingTiles.erase( it );
+        }
+    }
+
+    // The tile cache shares the viewer cache with the preloader, but must at least hold two screens of tiles.
+    const int tileCost = TILESIZE * TILESIZE * 4 / 1024;
+    m_tiles.setMaxCost( qMax<qint64>( cacheBudget() / 4 / 1024, 2 * range.width() * range.height() * tileCost ) );
+
+    // Draw the zoom window at the resolution of the tile level.
+    const double canvasPerLoaded = 1.0 / ( loadedPerFull * level );
+    QImage canvas( qMax( 1, (int) ceil( window.width() * canvasPerLoaded ) ),
+                   qMax( 1, (int) ceil( window.height() * canvasPerLoaded ) ), QImage::Format_RGB32 );
+    if ( canvas.isNull() )
+        return false;
+    canvas.fill( Qt::black );
+
+    const QTransform loadedToCanvas = QTransform::fromTranslate( -window.left(), -window.top() )
+        * QTransform::fromScale( canvasPerLoaded, canvasPerLoaded );
+
+    QPainter painter( &canvas );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+    painter.setTransform( loadedToCanvas );
+    painter.drawImage( QPointF(0,0), m_loadedImage );
+
+    painter.setTransform( toLoaded * loadedToCanvas );
+    for ( int row = range.top(); row <= range.bottom(); ++row ) {
+        for ( int column = range.left(); column <= range.right(); ++column ) {
+            const TileKey key( level, column, row );
+            const QImage* tile = m_tiles.object( key );
+            if ( tile )
+                painter.drawImage( QRectF( tileRegion( key ) ), *tile );
+            else
+                requestTile( key );
+        }
+    }
+    painter.end();
+
+    m_croppedAndScaledImg = canvas;
+    return true;
+}
+
+void Viewer::ImageDisplay::requestTile( const TileKey& key )
+{
+    if ( m_pendingTiles.contains( key ) )
+        return;
+
+    const QRect region = tileRegion( key );
+    const QSize tileSize( ( region.width() + key.level - 1 ) / key.level, ( region.height() + key.level - 1 ) / key.level );
+    ViewTileRequest* request = new ViewTileRequest( m_tileGeneration, key, region, m_info->fileName(), tileSize, this );
+    if ( ImageManager::AsyncLoader::instance()->load( request ) )
+        m_pendingTiles.insert( key );
+    else
+        delete request;
+}
+
+void Viewer::ImageDisplay::tileLoaded( ImageManager::ImageRequest* request, const QImage& image )
+{
+    ViewTileRequest* tileRequest = static_cast<ViewTileRequest*>( request );
+    if ( tileRequest->generation() != m_tileGeneration )
+        return;
+
+    const TileKey key = tileRequest->key();
+    m_pendingTiles.remove( key );
+
+    if ( !request->loadedOK() ) {
+        // libjpeg could not decode the region (e.g. a CMYK image), so fall back to the full size image.
+        m_tiled = false;
+        potentialyLoadFullSize();
+        return;
+    }
+
+    m_tiles.insert( key, new QImage( image ), qMax( 1, image.byteCount() / 1024 ) );
+    if ( tileStillNeeded( m_tileGeneration, key ) )
+        cropAndScale();
 }
 
 void Viewer::ImageDisplay::hideEvent(QHideEvent *)
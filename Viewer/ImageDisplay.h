@@ -26,6 +26,13 @@
 #include "ImageManager/ImageClientInterface.h"
 #include <qimage.h>
 #include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QTransform>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QAtomicInt>
 #include "DB/ImageInfoPtr.h"
 #include "AbstractDisplay.h"
 #include "Settings/SettingsData.h"
@@ -52,6 +59,30 @@ struct ViewPreloadInfo
     int angle;
 };
 
+/**
+ * @brief Identifies a tile of the image shown in deep zoom mode.
+ * Tiles are square blocks of the unrotated image at full size, decoded
+ * at 1/level of the full resolution.
+ */
+struct TileKey
+{
+    TileKey() : level(0), column(0), row(0) {}
+    TileKey( int level, int column, int row )
+        : level(level), column(column), row(row) {}
+    bool operator==( const TileKey& other ) const
+    {
+        return level == other.level && column == other.column && row == other.row;
+    }
+    int level;
+    int column;
+    int row;
+};
+
+inline uint qHash( const TileKey& key )
+{
+    return ::qHash( key.level ) ^ ::qHash( key.column << 8 ) ^ ::qHash( key.row << 20 );
+}
+
 class ImageDisplay :public Viewer::AbstractDisplay, public ImageManager::ImageClientInterface {
 Q_OBJECT
 public:
@@ -59,8 +90,21 @@ public:
     bool setImage( DB::ImageInfoPtr info, bool forward );
     QImage currentViewAsThumbnail() const;
     void pixmapLoaded(ImageManager::ImageRequest* request, const QImage& image) override;
+    void requestCanceled() override;
     void setImageList( const DB::FileNameList& list );
 
+    /**
+     * @brief Tell the preloader that a slideshow is running.
+     * @param msecs the slideshow interval, or 0 if no slideshow is running.
+     */
+    void setSlideShowInterval( int msecs );
+
+    /**
+     * @brief Is the tile still visible in the current image?
+     * This is called from the image loader threads.
+     */
+    bool tileStillNeeded( int generation, const TileKey& key ) const;
+
     void filterNone();
     void filterSelected();
     bool filterMono();
@@ -98,8 +142,19 @@ protected:
     void xformPainter( QPainter* );
     void cropAndScale();
     void updatePreload();
-    int indexOf( const DB::FileName& fileName );
-    void requestImage( const DB::ImageInfoPtr& info, bool priority = false );
+    void updatePreloadWindow();
+    int preloadDistance( int index ) const;
+    bool preloadStillNeeded( int index ) const;
+    QSize requestedSize() const;
+    qint64 cacheBudget() const;
+    qint64 preloadBudget() const;
+    void insertIntoCache( int index, const ViewPreloadInfo& info );
+    void removeFromCache( int index );
+    void clearCache();
+    void trimCache();
+    int indexOf( const DB::FileName& fileName ) const;
+    bool requestImage( const DB::ImageInfoPtr& info, bool priority = false,
+                       const QSharedPointer<QAtomicInt>& preloadNeeded = QSharedPointer<QAtomicInt>() );
 
     /** display zoom factor in title of display window */
     void updateZoomCaption();
@@ -116,7 +171,27 @@ protected:
     void potentialyLoadFullSize();
     double sizeRatio( const QSize& baseSize, const QSize& newSize ) const;
 
+    void updateTiledMode();
+    void resetTiles();
+    QSize unrotatedFullSize() const;
+    QTransform fullSizeToLoadedImage() const;
+    QRect tileRegion( const TileKey& key ) const;
+    bool composeTiles();
+    void requestTile( const TileKey& key );
+    void tileLoaded( ImageManager::ImageRequest* request, const QImage& image );
+
 private:
+    /**
+     * A preload in flight. The image loader threads only look at the needed
+     * flag, which is cleared once the index leaves the preload window.
+     */
+    struct PendingPreload
+    {
+        PendingPreload() : started(0) {}
+        qint64 started;
+        QSharedPointer<QAtomicInt> needed;
+    };
+
     QImage m_loadedImage;
     QImage m_croppedAndScaledImg;
 
@@ -127,7 +202,33 @@ private:
     QPoint m_zEnd;
 
     QMap<int,ViewPreloadInfo> m_cache;
+    qint64 m_cacheBytes;
     DB::FileNameList m_imageList;
+    QHash<DB::FileName,int> m_indexMap;
+    int m_imageCount;
+
+    // The preload window is [m_curIndex - m_preloadBehind, m_curIndex + m_preloadAhead]
+    // in viewing direction, sized from the load time and the navigation rate.
+    int m_preloadAhead;
+    int m_preloadBehind;
+    int m_slideShowInterval;
+    QHash<int,PendingPreload> m_pendingPreloads;
+    // Indices that failed to load, they are not requested again until the cache is cleared.
+    QSet<int> m_failedPreloads;
+    QElapsedTimer m_clock;
+    qint64 m_lastPreloadFinished;
+    qint64 m_lastNavigation;
+    double m_averageLoadTime;
+    double m_navigationInterval;
+    double m_averageFrameBytes;
+
+    // Deep zoom: huge images are shown from tiles decoded on demand.
+    bool m_tiled;
+    int m_tileGeneration;
+    int m_tileLevel;
+    QRect m_tileRange;
+    QCache<TileKey,QImage> m_tiles;
+    QSet<TileKey> m_pendingTiles;
     QMap<QString, DB::ImageInfoPtr> m_loadMap;
     bool m_reloadImageInProgress;
     int m_forward;
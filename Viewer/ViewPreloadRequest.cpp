@@ -0,0 +1,37 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ViewPreloadRequest.h"
+#include "ImageDisplay.h"
+
+Viewer::ViewPreloadRequest::ViewPreloadRequest( int index, const DB::FileName& fileName, const QSize& size, int angle, ImageDisplay* client,
+                                                 const QSharedPointer<QAtomicInt>& needed )
+    : ImageManager::ImageRequest( fileName, size, angle, client ), m_needed( needed ), m_index( index )
+{
+    setPriority( ImageManager::ViewerPreload );
+}
+
+bool Viewer::ViewPreloadRequest::stillNeeded() const
+{
+    return int( *m_needed ) != 0;
+}
+
+int Viewer::ViewPreloadRequest::index() const
+{
+    return m_index;
+}
+// vi:expandtab:tabstop=4 shiftwidth=4:
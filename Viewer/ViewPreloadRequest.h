@@ -0,0 +1,52 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef VIEWPRELOADREQUEST_H
+#define VIEWPRELOADREQUEST_H
+#include "ImageManager/ImageRequest.h"
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+namespace Viewer
+{
+class ImageDisplay;
+
+/**
+ * @brief An image request issued by the viewer preloader.
+ * The request is dropped from the load queue once its index has left the
+ * preload window of the ImageDisplay (e.g. after jumping with home/end).
+ * The ImageDisplay tells so by clearing the needed flag, as the window itself
+ * must not be read from the image loader threads.
+ */
+class ViewPreloadRequest : public ImageManager::ImageRequest
+{
+public:
+    ViewPreloadRequest( int index, const DB::FileName& fileName, const QSize& size, int angle, ImageDisplay* client,
+                        const QSharedPointer<QAtomicInt>& needed );
+    bool stillNeeded() const override;
+    int index() const;
+
+private:
+    QSharedPointer<QAtomicInt> m_needed;
+    int m_index;
+};
+
+}
+
+#endif /* VIEWPRELOADREQUEST_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,41 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "ViewTileRequest.h"
+
+Viewer::ViewTileRequest::ViewTileRequest( int generation, const TileKey& key, const QRect& region, const DB::FileName& fileName, const QSize& size, ImageDisplay* client )
+    : ImageManager::ImageRequest( fileName, size, 0, client ), m_display( client ), m_generation( generation ), m_key( key )
+{
+    setRegion( region );
+    setPriority( ImageManager::Viewer );
+}
+
+bool Viewer::ViewTileRequest::stillNeeded() const
+{
+    return m_display->tileStillNeeded( m_generation, m_key );
+}
+
+int Viewer::ViewTileRequest::generation() const
+{
+    return m_generation;
+}
+
+Viewer::TileKey Viewer::ViewTileRequest::key() const
+{
+    return m_key;
+}
+// vi:expandtab:tabstop=4 shiftwidth=4:
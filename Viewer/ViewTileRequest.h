@@ -0,0 +1,49 @@
+/* Copyright (C) 2016 The KPhotoAlbum Development Team
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef VIEWTILEREQUEST_H
+#define VIEWTILEREQUEST_H
+#include "ImageManager/ImageRequest.h"
+#include "ImageDisplay.h"
+
+namespace Viewer
+{
+
+/**
+ * @brief Request for a single tile of a huge image, used for deep zoom in the viewer.
+ * The request is dropped from the load queue once the tile is no longer
+ * visible, or the viewer has moved on to another image.
+ */
+class ViewTileRequest : public ImageManager::ImageRequest
+{
+public:
+    ViewTileRequest( int generation, const TileKey& key, const QRect& region, const DB::FileName& fileName, const QSize& size, ImageDisplay* client );
+    bool stillNeeded() const override;
+    int generation() const;
+    TileKey key() const;
+
+private:
+    const ImageDisplay* const m_display;
+    int m_generation;
+    TileKey m_key;
+};
+
+}
+
+#endif /* VIEWTILEREQUEST_H */
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
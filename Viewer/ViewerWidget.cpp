@@ -719,6 +719,7 @@ bool Viewer::ViewerWidget::close( bool alsoDelete)
 
     m_slideShowTimer->stop();
     m_isRunningSlideShow = false;
+    m_imageDisplay->setSlideShowInterval( 0 );
     return QWidget::close();
     if ( alsoDelete )
         deleteLater();
@@ -872,6 +873,7 @@ void Viewer::ViewerWidget::slotStartStopSlideShow()
     if ( wasRunningSlideShow ) {
         m_startStopSlideShow->setText( i18nc("@action:inmenu","Run Slideshow") );
         m_slideShowTimer->stop();
+        m_imageDisplay->setSlideShowInterval( 0 );
         if ( m_list.count() != 1 )
             m_speedDisplay->end();
         inhibitScreenSaver(false);
@@ -880,6 +882,7 @@ void Viewer::ViewerWidget::slotStartStopSlideShow()
         m_startStopSlideShow->setText( i18nc("@action:inmenu","Stop Slideshow") );
         if ( currentInfo()->mediaType() != DB::Video )
             m_slideShowTimer->start( m_slideShowPause );
+        m_imageDisplay->setSlideShowInterval( m_slideShowPause );
         m_speedDisplay->start();
         inhibitScreenSaver(true);
     }
@@ -931,6 +934,8 @@ void Viewer::ViewerWidget::changeSlideShowInterval( int delta )
     m_speedDisplay->display( m_slideShowPause );
     if (m_slideShowTimer->isActive() )
         m_slideShowTimer->start( m_slideShowPause );
+    if ( m_isRunningSlideShow )
+        m_imageDisplay->setSlideShowInterval( m_slideShowPause );
 }
 
 
@@ -36,6 +36,7 @@
 #   include "Exif/Database.h"
 #endif
 #include <DB/FileName.h>
+#include <DB/DirectorySnapshot.h>
 #include <QDebug>
 
 using Utilities::StringSet;
@@ -48,6 +49,7 @@ XMLDB::Database::Database( const QString& configFile ):
     FileReader reader( this );
     reader.read( configFile );
     m_nextStackId = reader.nextStackId();
+    DB::DirectorySnapshot::setDatabaseFile( configFile );
 
     connect( categoryCollection(), SIGNAL(itemRemoved(DB::Category*,QString)),
              this, SLOT(deleteItem(DB::Category*,QString)) );
@@ -159,6 +161,8 @@ void XMLDB::Database::deleteList(const DB::FileNameList& list)
 #endif
         m_images.remove( inf );
     }
+    // make sure the next search for new files will find the files again if they are still on disk:
+    DB::DirectorySnapshot::invalidate( list );
     emit totalChanged( m_images.count() );
     emit imagesDeleted(list);
     emit dirty();
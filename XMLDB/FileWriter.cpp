@@ -22,6 +22,7 @@
 #include <qfile.h>
 
 #include "Database.h"
+#include "DB/DirectorySnapshot.h"
 #include "MainWindow/Window.h"
 #include "NumberedBackup.h"
 #include "Utilities/List.h"
@@ -110,6 +111,8 @@ void XMLDB::FileWriter::save( const QString& fileName, bool isAutoSave )
         return;
     }
     // State: index.xml has the current version.
+    if ( !isAutoSave )
+        DB::DirectorySnapshot::databaseSaved();
 }
 
 void XMLDB::FileWriter::saveCategories( QXmlStreamWriter& writer )
@@ -16,9 +16,13 @@
   Its main interface is the method \ref ImageManager::ExtractOneVideoFrame::extract "extract(filename,offset,receiver,slot)".
   The callback is done using the slot provided. The offset is seconds from the beginning of the video.
 
-  \ref BackgroundJobs::ExtractOneThumbnailJob is a \ref BackgroundTaskManager::JobInterface "background job" for extracting a single
-  thumbnail. It is given the video file and the offset as parameters (this time in the range 0 to 9).
-  The result is stored in the .videoThumbnails directory.
+  The ten frames used for thumbnail cycling are extracted by \ref ImageManager::VideoFrameExtractor, which runs mplayer once per video.
+  mplayer steps through the video and pipes the raw frames back, and reports the length of the video on the way.
+  \ref BackgroundJobs::ExtractVideoFramesJob is a \ref BackgroundTaskManager::JobInterface "background job" around it,
+  which stores the frames in the \ref ImageManager::VideoFrameCache and the length in the database.
+  The cache packs the frames of each video into a single JPEG strip inside memory mapped chunk files,
+  so all ten frames of a video are read with a single decode. Frames stored as individual files by older
+  versions are migrated into the cache when they are first looked up.
 
   \ref BackgroundJobs::HandleVideoThumbnailRequestJob is a \ref BackgroundTaskManager::JobInterface "background job" for extracting a thumbnail
   for the thumbnail viewer. It's interface uses \ref ImageManager::ImageRequest "ImageRequest's",
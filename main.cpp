@@ -30,6 +30,10 @@
 #include <klocale.h>
 #include <kdebug.h>
 #include "RemoteControl/RemoteInterface.h"
+#include <config-kpa-exiv2.h>
+#ifdef HAVE_EXIV2
+#  include <exiv2/xmp.hpp>
+#endif
 
 #include "version.h"
 
@@ -73,6 +77,12 @@ int main( int argc, char** argv ) {
 
     KApplication app;
 
+#ifdef HAVE_EXIV2
+    // Exif data is read and written on worker threads, e.g. when searching for new images,
+    // which requires the XMP parser to be initialized on the main thread first.
+    Exiv2::XmpParser::initialize();
+#endif
+
     new MainWindow::SplashScreen();
 
     // FIXME: There is no point in using try here, because exceptions